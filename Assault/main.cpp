@@ -1,8 +1,11 @@
 #include "overdrive.h"
 
 
+#include "render/renderer.h"
 #include "render/renderstate.h"
 #include "render/shaderprogram.h"
+#include "render/program_binary_cache.h"
+#include "render/shader_compiler.h"
 #include "render/vertexbuffer.h"
 #include "render/indexbuffer.h"
 #include "render/vertexarray.h"
@@ -12,12 +15,15 @@
 #include "render/shape_sphere.h"
 #include "render/texture2d.h"
 #include "render/texturecube.h"
+#include "render/texture_streamer.h"
+#include "render/resources.h"
 #include "render/defaultShaders.h"
 
 #include <iostream>
 #include <boost/math/constants/constants.hpp>
 
 #include "util/csv.h"
+#include "util/asset_pack.h"
 
 using namespace overdrive;
 
@@ -28,11 +34,15 @@ class Test :
 public:
 	int counter = 0;
 	render::RenderState mRenderState;
-	render::Texture2D mTexture;
-	render::ShaderProgram mProgram;
+	std::unique_ptr<render::Renderer> mRenderer;
+	util::AssetPack mAssetPack;
+	std::unique_ptr<render::TextureStreamer> mTextureStreamer;
+	render::ShaderProgramCache mPrograms;
+	render::StreamedTexture mTexture;
+	render::ShaderProgramCache::Handle mProgram;
 	
-	render::TextureCube mSkyBoxTexture;
-	render::ShaderProgram mSkyBoxProgram;
+	render::StreamedTexture mSkyBoxTexture;
+	render::ShaderProgramCache::Handle mSkyBoxProgram;
 	std::unique_ptr<render::shape::Cube> mSkyBox;
 
 	scene::Camera mCamera;
@@ -90,15 +100,23 @@ public:
 			}
 		)";
 
-		mProgram.attachShader(render::DefaultShader<render::attributes::PositionNormalTexCoord>::getVertexShader(), render::eShaderType::VERTEX);
-		mProgram.attachShader(render::DefaultShader<render::attributes::PositionNormalTexCoord>::getFragmentShader(), render::eShaderType::FRAGMENT);
-		mProgram.link();
-		mProgram.bind();
+		// compiled programs are kept on disk, the second run only has to load them
+		render::ProgramBinaryCache shaderCache("shaders.cache");
 
-		mSkyBoxProgram.attachShader(skybox_vertex_shader, render::eShaderType::VERTEX);
-		mSkyBoxProgram.attachShader(skybox_fragment_shader, render::eShaderType::FRAGMENT);
-		mSkyBoxProgram.link();
-		mSkyBoxProgram.bind();
+		// the driver compiles these while the textures below are loaded
+		render::ShaderCompiler shaderCompiler(&shaderCache);
+
+		// the renderer merges the spheres into a single instanced draw
+		// (programs are shared through the cache, asking for the same sources again yields the same program)
+		mProgram = render::loadShaderProgram(mPrograms, shaderCompiler, {
+			{ render::eShaderType::VERTEX, render::DefaultShader<render::attributes::PositionNormalTexCoord>::getInstancedVertexShader() },
+			{ render::eShaderType::FRAGMENT, render::DefaultShader<render::attributes::PositionNormalTexCoord>::getFragmentShader() }
+		});
+
+		mSkyBoxProgram = render::loadShaderProgram(mPrograms, shaderCompiler, {
+			{ render::eShaderType::VERTEX, skybox_vertex_shader },
+			{ render::eShaderType::FRAGMENT, skybox_fragment_shader }
+		});
 
 		mCamera.setPosition(0.0f, 0.0f, 1.0f);
 		mCamera.setProjection(boost::math::float_constants::pi * 0.25f, 1.0f, 0.1f, 100.0f);
@@ -108,6 +126,8 @@ public:
 		mCamera.setViewportWindow(mainWindow);
 		mainWindow->getMouse()->setCursorState(input::Mouse::eCursorState::DISABLED); // hide that cursor
 
+		mRenderer = std::make_unique<render::Renderer>(mainWindow);
+
 		mCube = std::make_unique<render::shape::Cube>(1.0f);
 		mSphere = std::make_unique<render::shape::Sphere>();
 
@@ -115,19 +135,46 @@ public:
 			115.0f // far plane should end up at the center of the skybox cube
 		); // [NOTE] the skybox cube should be smaller than the far clipping plane; 
 
-		mTexture = render::loadTexture2D("assets/image/test_pattern_001.png");
+		// decoded on the job system and uploaded over the first couple of frames, placeholders are shown until then
+		mTextureStreamer = std::make_unique<render::TextureStreamer>(mEngine->getJobSystem());
+
+		// cooked textures (see cookAssets.bat) are uploaded straight from the pack, without decoding them
+		if (boost::filesystem::exists("assets.pack")) {
+			mAssetPack.open("assets.pack");
+			mTextureStreamer->setAssetPack(&mAssetPack);
+		}
+
+		mTexture = mTextureStreamer->load2D("assets/image/test_pattern_001.png");
 		
-		mSkyBoxTexture = render::loadTextureCube(
+		// faces go in +x, -x, +y, -y, +z, -z order (the order of the GL_TEXTURE_CUBE_MAP_* targets)
+		mSkyBoxTexture = mTextureStreamer->loadCube(
 			"assets/image/skybox_px.png",
-			"assets/image/skybox_py.png",
-			"assets/image/skybox_pz.png",
 			"assets/image/skybox_nx.png",
+			"assets/image/skybox_py.png",
 			"assets/image/skybox_ny.png",
+			"assets/image/skybox_pz.png",
 			"assets/image/skybox_nz.png"
 		);
-		
-		//mSkyBoxTexture = render::loadTextureCube("assets/image/skybox_px.png");
-		gLog << mProgram;
+
+		shaderCompiler.finishAll();
+
+		if (!mProgram->isLinked() || !mSkyBoxProgram->isLinked())
+			throw std::runtime_error("Failed to build shader programs");
+
+		gLog << shaderCache.getStats();
+
+		mProgram->bind();
+
+		// these stay the same, the renderer takes care of view/projection and the instance data
+		mProgram->setUniform("uLightDirection", glm::vec4(0.2, -1, 0.5, 1));
+		mProgram->setUniform("uLightAmbient", glm::vec4(0.1, 0.1, 0.1, 1.0));
+		mProgram->setUniform("uLightDiffuse", glm::vec4(0.85, 0.85, 0.85, 1.0));
+		mProgram->setUniform("uTexture", 0);
+
+		mSkyBoxProgram->bind();
+		mSkyBoxProgram->setUniform("uCubeMap", 0);
+
+		gLog << *mProgram;
 	}
 
 	virtual void update() override {
@@ -190,40 +237,48 @@ public:
 
 		mRenderState.clear();
 
-		// render that skybox
-		mSkyBoxProgram.bind();
-		mSkyBoxProgram.setUniform("uView", mCamera.getView());
-		mSkyBoxProgram.setUniform("uProjection", mCamera.getProjection());
-		mSkyBoxProgram.setUniform("uModel", glm::translate(mCamera.getPosition()));
-		
-		mSkyBoxTexture.bind(0);
-		mSkyBoxProgram.setUniform("uCubeMap", 0);
-		
-		mSkyBox->draw();
+		mTextureStreamer->update();
 
-		// render the cubes
-		mProgram.bind();
-		mProgram.setUniform("uView", mCamera.getView());
-		mProgram.setUniform("uProjection", mCamera.getProjection());
+		mRenderer->setCamera(mCamera);
 
-		mProgram.setUniform("uLightDirection", glm::vec4(0.2, -1, 0.5, 1));
-		mProgram.setUniform("uLightAmbient", glm::vec4(0.1, 0.1, 0.1, 1.0));
-		mProgram.setUniform("uLightDiffuse", glm::vec4(0.85, 0.85, 0.85, 1.0));
-		
-		mTexture.bind(0);
-		mProgram.setUniform("uTexture", 0);
+		// render that skybox (the sky pass is executed after the solid geometry)
+		render::TextureBinding skyBoxTexture(mSkyBoxTexture.getTarget(), mSkyBoxTexture.getHandle(), 0);
+
+		render::DrawCommand skyBox;
+		skyBox.mProgram = mSkyBoxProgram.get();
+		skyBox.mVAO = &mSkyBox->getVAO();
+		skyBox.mModel = glm::translate(mCamera.getPosition());
+		skyBox.mTextures = &skyBoxTexture;
+		skyBox.mNumTextures = 1;
+
+		mRenderer->submit(skyBox, render::eRenderPass::SKY);
+
+		// render the spheres
+		render::TextureBinding sphereTexture(mTexture.getTarget(), mTexture.getHandle(), 0);
+
+		render::DrawCommand sphere;
+		sphere.mProgram = mProgram.get();
+		sphere.mVAO = &mSphere->getVAO();
+		sphere.mTextures = &sphereTexture;
+		sphere.mNumTextures = 1;
 		
-		// draw the cube at 100 different locations
+		// draw the sphere at 100 different locations
 		for (int i = 0; i < 10; ++i)
 			for (int j = 0; j < 10; ++j) {
-				mProgram.setUniform("uModel", glm::translate(glm::vec3(2 * (i - 5), 0, 2 * (j - 5))));
+				sphere.mModel = glm::translate(glm::vec3(2 * (i - 5), 0, 2 * (j - 5)));
 
-				mSphere->draw();
-				//mCube->draw();
+				mRenderer->submit(sphere);
 			}
+
+		mRenderer->flush();
 	}
 
 	virtual void shutdown() override {
+		gLog << mTextureStreamer->getStats();
+		mTextureStreamer.reset(); // waits for decode jobs that are still running
+
+		gLog << mPrograms.getStats();
+
 		System::shutdown();
 	}
 
@@ -234,7 +289,7 @@ public:
 			break;
 
 		case GLFW_KEY_F1:
-			gLog << mProgram;
+			gLog << *mProgram;
 			break;
 		}
 	}
@@ -0,0 +1,506 @@
+#include "block_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#define OVERDRIVE_COOKER_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace overdrive {
+	namespace cooker {
+		namespace {
+			// BC7 interpolation weights for 4-bit indices
+			const int WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			// texels as separate channel arrays, so that 4 texels can be processed at once
+			struct Block {
+				alignas(16) float mChannels[4][16]; // r, g, b, a
+			};
+
+			void loadBlock(const uint8_t texels[64], Block& result) {
+				for (int i = 0; i < 16; ++i)
+					for (int channel = 0; channel < 4; ++channel)
+						result.mChannels[channel][i] = texels[i * 4 + channel];
+			}
+
+			// result[i] = dot(texel[i] - origin, axis), over the first numChannels channels
+			void project(
+				const Block& block,
+				const float origin[4],
+				const float axis[4],
+				int numChannels,
+				float result[16]
+			) {
+#ifdef OVERDRIVE_COOKER_SSE2
+				for (int i = 0; i < 16; i += 4) {
+					__m128 sum = _mm_setzero_ps();
+
+					for (int channel = 0; channel < numChannels; ++channel) {
+						__m128 delta = _mm_sub_ps(_mm_load_ps(&block.mChannels[channel][i]), _mm_set1_ps(origin[channel]));
+						sum = _mm_add_ps(sum, _mm_mul_ps(delta, _mm_set1_ps(axis[channel])));
+					}
+
+					_mm_storeu_ps(result + i, sum);
+				}
+#else
+				for (int i = 0; i < 16; ++i) {
+					float sum = 0.0f;
+
+					for (int channel = 0; channel < numChannels; ++channel)
+						sum += (block.mChannels[channel][i] - origin[channel]) * axis[channel];
+
+					result[i] = sum;
+				}
+#endif
+			}
+
+			// mean and principal axis (power iteration on the covariance matrix); the axis is 0 for uniform blocks
+			void getPrincipalAxis(const Block& block, int numChannels, float mean[4], float axis[4]) {
+				for (int channel = 0; channel < 4; ++channel) {
+					float sum = 0.0f;
+
+					for (int i = 0; i < 16; ++i)
+						sum += block.mChannels[channel][i];
+
+					mean[channel] = sum / 16.0f;
+					axis[channel] = 0.0f;
+				}
+
+				float covariance[4][4] = {};
+
+				for (int i = 0; i < 16; ++i)
+					for (int a = 0; a < numChannels; ++a)
+						for (int b = 0; b < numChannels; ++b)
+							covariance[a][b] +=
+								(block.mChannels[a][i] - mean[a]) *
+								(block.mChannels[b][i] - mean[b]);
+
+				// start with the channel that varies the most
+				int start = 0;
+
+				for (int channel = 1; channel < numChannels; ++channel)
+					if (covariance[channel][channel] > covariance[start][start])
+						start = channel;
+
+				if (covariance[start][start] <= 0.0f)
+					return;
+
+				float vec[4] = {};
+
+				for (int channel = 0; channel < numChannels; ++channel)
+					vec[channel] = covariance[start][channel];
+
+				for (int iteration = 0; iteration < 8; ++iteration) {
+					float next[4] = {};
+					float largest = 0.0f;
+
+					for (int a = 0; a < numChannels; ++a) {
+						for (int b = 0; b < numChannels; ++b)
+							next[a] += covariance[a][b] * vec[b];
+
+						largest = std::max(largest, std::abs(next[a]));
+					}
+
+					if (largest <= 0.0f)
+						return;
+
+					for (int channel = 0; channel < numChannels; ++channel)
+						vec[channel] = next[channel] / largest;
+				}
+
+				float length = 0.0f;
+
+				for (int channel = 0; channel < numChannels; ++channel)
+					length += vec[channel] * vec[channel];
+
+				length = std::sqrt(length);
+
+				for (int channel = 0; channel < numChannels; ++channel)
+					axis[channel] = vec[channel] / length;
+			}
+
+			void getRange(const float values[16], float& minimum, float& maximum) {
+				minimum = *std::min_element(values, values + 16);
+				maximum = *std::max_element(values, values + 16);
+			}
+
+			int roundToInt(float value, int minimum, int maximum) {
+				return std::min(std::max(static_cast<int>(std::floor(value + 0.5f)), minimum), maximum);
+			}
+
+			// ----- BC1 color blocks -----
+			uint16_t to565(const float color[3]) {
+				int r = roundToInt(color[0] * (31.0f / 255.0f), 0, 31);
+				int g = roundToInt(color[1] * (63.0f / 255.0f), 0, 63);
+				int b = roundToInt(color[2] * (31.0f / 255.0f), 0, 31);
+
+				return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+			}
+
+			void from565(uint16_t value, float color[4]) {
+				int r = (value >> 11) & 31;
+				int g = (value >> 5) & 63;
+				int b = value & 31;
+
+				color[0] = static_cast<float>((r << 3) | (r >> 2));
+				color[1] = static_cast<float>((g << 2) | (g >> 4));
+				color[2] = static_cast<float>((b << 3) | (b >> 2));
+				color[3] = 0.0f;
+			}
+
+			// picks the closest of the 4 palette entries (4-color mode, color0 > color1); yields the squared error
+			float selectColorIndices(const Block& block, uint16_t color0, uint16_t color1, uint32_t& indices) {
+				float palette[4][4];
+
+				from565(color0, palette[0]);
+				from565(color1, palette[1]);
+
+				for (int channel = 0; channel < 3; ++channel) {
+					palette[2][channel] = (2.0f * palette[0][channel] + palette[1][channel]) / 3.0f;
+					palette[3][channel] = (palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f;
+				}
+
+				float axis[4] = {};
+				float lengthSq = 0.0f;
+
+				for (int channel = 0; channel < 3; ++channel) {
+					axis[channel] = palette[1][channel] - palette[0][channel];
+					lengthSq += axis[channel] * axis[channel];
+				}
+
+				indices = 0;
+
+				if (lengthSq > 0.0f)
+					for (int channel = 0; channel < 3; ++channel)
+						axis[channel] *= 3.0f / lengthSq;
+
+				// position along the line from color0 (0) to color1 (3)
+				float positions[16];
+				project(block, palette[0], axis, 3, positions);
+
+				static const uint32_t order[4] = { 0, 2, 3, 1 };
+				float error = 0.0f;
+
+				for (int i = 0; i < 16; ++i) {
+					uint32_t index = (lengthSq > 0.0f) ? order[roundToInt(positions[i], 0, 3)] : 0;
+
+					indices |= index << (2 * i);
+
+					for (int channel = 0; channel < 3; ++channel) {
+						float delta = block.mChannels[channel][i] - palette[index][channel];
+						error += delta * delta;
+					}
+				}
+
+				return error;
+			}
+
+			// makes sure color0 > color1 (4-color mode), the indices are swapped along with the endpoints
+			void orderColors(uint16_t& color0, uint16_t& color1, uint32_t& indices) {
+				if (color0 > color1)
+					return;
+
+				if (color0 == color1) {
+					indices = 0; // both endpoints are the same color
+					return;
+				}
+
+				std::swap(color0, color1);
+				indices ^= 0x55555555; // 0 <-> 1, 2 <-> 3
+			}
+
+			// least squares fit of the endpoints to the current index assignment
+			bool refineColors(const Block& block, uint32_t indices, uint16_t& color0, uint16_t& color1) {
+				static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f }; // of color0, per index
+
+				float aa = 0.0f;
+				float ab = 0.0f;
+				float bb = 0.0f;
+				float ax[3] = {};
+				float bx[3] = {};
+
+				for (int i = 0; i < 16; ++i) {
+					float alpha = weights[(indices >> (2 * i)) & 3];
+					float beta = 1.0f - alpha;
+
+					aa += alpha * alpha;
+					ab += alpha * beta;
+					bb += beta * beta;
+
+					for (int channel = 0; channel < 3; ++channel) {
+						ax[channel] += alpha * block.mChannels[channel][i];
+						bx[channel] += beta * block.mChannels[channel][i];
+					}
+				}
+
+				float determinant = aa * bb - ab * ab;
+
+				if (std::abs(determinant) < 1e-6f)
+					return false;
+
+				float endpoint0[3];
+				float endpoint1[3];
+
+				for (int channel = 0; channel < 3; ++channel) {
+					endpoint0[channel] = (bb * ax[channel] - ab * bx[channel]) / determinant;
+					endpoint1[channel] = (aa * bx[channel] - ab * ax[channel]) / determinant;
+				}
+
+				color0 = to565(endpoint0);
+				color1 = to565(endpoint1);
+
+				return true;
+			}
+
+			void compressColorBlock(const Block& block, uint8_t result[8]) {
+				float mean[4];
+				float axis[4];
+				float positions[16];
+				float minimum;
+				float maximum;
+
+				getPrincipalAxis(block, 3, mean, axis);
+				project(block, mean, axis, 3, positions);
+				getRange(positions, minimum, maximum);
+
+				// inset the range a little, the extremes rarely deserve an endpoint of their own
+				float inset = (maximum - minimum) / 16.0f;
+				minimum += inset;
+				maximum -= inset;
+
+				float endpoint0[3];
+				float endpoint1[3];
+
+				for (int channel = 0; channel < 3; ++channel) {
+					endpoint0[channel] = mean[channel] + maximum * axis[channel];
+					endpoint1[channel] = mean[channel] + minimum * axis[channel];
+				}
+
+				uint16_t color0 = to565(endpoint0);
+				uint16_t color1 = to565(endpoint1);
+				uint32_t indices;
+
+				if (color0 < color1)
+					std::swap(color0, color1);
+
+				float error = selectColorIndices(block, color0, color1, indices);
+
+				uint16_t refined0 = color0;
+				uint16_t refined1 = color1;
+
+				if (refineColors(block, indices, refined0, refined1)) {
+					if (refined0 < refined1)
+						std::swap(refined0, refined1);
+
+					uint32_t refinedIndices;
+					float refinedError = selectColorIndices(block, refined0, refined1, refinedIndices);
+
+					if (refinedError < error) {
+						color0 = refined0;
+						color1 = refined1;
+						indices = refinedIndices;
+					}
+				}
+
+				orderColors(color0, color1, indices);
+
+				result[0] = static_cast<uint8_t>(color0 & 0xFF);
+				result[1] = static_cast<uint8_t>(color0 >> 8);
+				result[2] = static_cast<uint8_t>(color1 & 0xFF);
+				result[3] = static_cast<uint8_t>(color1 >> 8);
+
+				for (int i = 0; i < 4; ++i)
+					result[4 + i] = static_cast<uint8_t>(indices >> (8 * i));
+			}
+
+			// ----- BC4 alpha blocks (8 interpolated values) -----
+			void compressAlphaBlock(const uint8_t texels[64], uint8_t result[8]) {
+				int minimum = 255;
+				int maximum = 0;
+
+				for (int i = 0; i < 16; ++i) {
+					minimum = std::min<int>(minimum, texels[i * 4 + 3]);
+					maximum = std::max<int>(maximum, texels[i * 4 + 3]);
+				}
+
+				result[0] = static_cast<uint8_t>(maximum);
+				result[1] = static_cast<uint8_t>(minimum);
+
+				uint64_t bits = 0;
+
+				if (maximum > minimum) {
+					float scale = 7.0f / (maximum - minimum);
+
+					for (int i = 0; i < 16; ++i) {
+						// step 0 is the minimum (index 1), step 7 the maximum (index 0), the rest are interpolated
+						int step = roundToInt((texels[i * 4 + 3] - minimum) * scale, 0, 7);
+						uint64_t index = (step == 0) ? 1 : ((step == 7) ? 0 : (8 - step));
+
+						bits |= index << (3 * i);
+					}
+				}
+
+				for (int i = 0; i < 6; ++i)
+					result[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+			}
+
+			// ----- BC7 -----
+			class BitWriter {
+			public:
+				explicit BitWriter(uint8_t* data):
+					mData(data),
+					mPosition(0)
+				{
+				}
+
+				void write(uint32_t value, int numBits) {
+					for (int i = 0; i < numBits; ++i, ++mPosition)
+						if ((value >> i) & 1)
+							mData[mPosition / 8] |= static_cast<uint8_t>(1 << (mPosition % 8));
+				}
+
+			private:
+				uint8_t* mData;
+				int mPosition;
+			};
+
+			struct Mode6Candidate {
+				int mEndpoints[2][4];	// 7 bits per channel
+				int mPBits[2];
+				uint8_t mIndices[16];
+				float mError;
+			};
+
+			void evaluateMode6(const Block& block, const float endpoints[2][4], Mode6Candidate& candidate) {
+				float decoded[2][4];
+
+				for (int i = 0; i < 2; ++i)
+					for (int channel = 0; channel < 4; ++channel) {
+						float value = std::min(std::max(endpoints[i][channel], 0.0f), 255.0f);
+
+						candidate.mEndpoints[i][channel] = roundToInt((value - candidate.mPBits[i]) * 0.5f, 0, 127);
+						decoded[i][channel] = static_cast<float>((candidate.mEndpoints[i][channel] << 1) | candidate.mPBits[i]);
+					}
+
+				float axis[4];
+				float lengthSq = 0.0f;
+
+				for (int channel = 0; channel < 4; ++channel) {
+					axis[channel] = decoded[1][channel] - decoded[0][channel];
+					lengthSq += axis[channel] * axis[channel];
+				}
+
+				if (lengthSq > 0.0f)
+					for (int channel = 0; channel < 4; ++channel)
+						axis[channel] *= 15.0f / lengthSq;
+
+				float positions[16];
+				project(block, decoded[0], axis, 4, positions);
+
+				candidate.mError = 0.0f;
+
+				for (int i = 0; i < 16; ++i) {
+					int index = (lengthSq > 0.0f) ? roundToInt(positions[i], 0, 15) : 0;
+					int weight = WEIGHTS_4[index];
+
+					candidate.mIndices[i] = static_cast<uint8_t>(index);
+
+					for (int channel = 0; channel < 4; ++channel) {
+						int value0 = static_cast<int>(decoded[0][channel]);
+						int value1 = static_cast<int>(decoded[1][channel]);
+						int value = ((64 - weight) * value0 + weight * value1 + 32) >> 6;
+
+						float delta = block.mChannels[channel][i] - value;
+						candidate.mError += delta * delta;
+					}
+				}
+			}
+		}
+
+		void compressBlockBC1(const uint8_t texels[64], uint8_t block[8]) {
+			Block soa;
+			loadBlock(texels, soa);
+
+			compressColorBlock(soa, block);
+		}
+
+		void compressBlockBC3(const uint8_t texels[64], uint8_t block[16]) {
+			Block soa;
+			loadBlock(texels, soa);
+
+			compressAlphaBlock(texels, block);
+			compressColorBlock(soa, block + 8);
+		}
+
+		void compressBlockBC7(const uint8_t texels[64], uint8_t block[16]) {
+			Block soa;
+			loadBlock(texels, soa);
+
+			float mean[4];
+			float axis[4];
+			float positions[16];
+			float minimum;
+			float maximum;
+
+			getPrincipalAxis(soa, 4, mean, axis);
+			project(soa, mean, axis, 4, positions);
+			getRange(positions, minimum, maximum);
+
+			float endpoints[2][4];
+
+			for (int channel = 0; channel < 4; ++channel) {
+				endpoints[0][channel] = mean[channel] + minimum * axis[channel];
+				endpoints[1][channel] = mean[channel] + maximum * axis[channel];
+			}
+
+			// try all p-bit combinations, keep the one with the lowest error
+			Mode6Candidate best = {};
+			best.mError = -1.0f;
+
+			for (int pbits = 0; pbits < 4; ++pbits) {
+				Mode6Candidate candidate;
+
+				candidate.mPBits[0] = pbits & 1;
+				candidate.mPBits[1] = pbits >> 1;
+
+				evaluateMode6(soa, endpoints, candidate);
+
+				if ((best.mError < 0.0f) || (candidate.mError < best.mError))
+					best = candidate;
+			}
+
+			// the most significant bit of the first index is implied to be 0
+			if (best.mIndices[0] >= 8) {
+				for (int channel = 0; channel < 4; ++channel)
+					std::swap(best.mEndpoints[0][channel], best.mEndpoints[1][channel]);
+
+				std::swap(best.mPBits[0], best.mPBits[1]);
+
+				for (int i = 0; i < 16; ++i)
+					best.mIndices[i] = static_cast<uint8_t>(15 - best.mIndices[i]);
+			}
+
+			std::memset(block, 0, 16);
+
+			BitWriter writer(block);
+
+			writer.write(1 << 6, 7); // mode 6
+
+			for (int channel = 0; channel < 4; ++channel) {
+				writer.write(best.mEndpoints[0][channel], 7);
+				writer.write(best.mEndpoints[1][channel], 7);
+			}
+
+			writer.write(best.mPBits[0], 1);
+			writer.write(best.mPBits[1], 1);
+
+			writer.write(best.mIndices[0], 3);
+
+			for (int i = 1; i < 16; ++i)
+				writer.write(best.mIndices[i], 4);
+		}
+	}
+}
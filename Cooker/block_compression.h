@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace overdrive {
+	namespace cooker {
+		/*
+			Block compression encoders for 4x4 texel blocks.
+
+			Input is always 16 RGBA8 texels in row-major order (64 bytes); blocks at the edge of a
+			texture should be padded by repeating the last row/column.
+
+			~ BC1 (DXT1):	8 bytes, RGB 5:6:5 endpoints along the principal axis, refined with a least squares fit
+			~ BC3 (DXT5):	16 bytes, a BC4 alpha block followed by a BC1 color block
+			~ BC7:			16 bytes, mode 6 only (RGBA 7.7.7.7 + p-bit endpoints, 4-bit indices)
+
+			[NOTE] BC7 mode 6 is the fast subset many real-time encoders use; the other modes (partitions,
+				   separate rotation of alpha) would improve blocks with several distinct colors
+			[NOTE] the texel projections use SSE2 when available
+		*/
+		void compressBlockBC1(const uint8_t texels[64], uint8_t block[8]);
+		void compressBlockBC3(const uint8_t texels[64], uint8_t block[16]);
+		void compressBlockBC7(const uint8_t texels[64], uint8_t block[16]);
+	}
+}
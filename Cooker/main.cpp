@@ -0,0 +1,376 @@
+#include "texture_cooker.h"
+
+#include "core/job_system.h"
+#include "util/asset_pack.h"
+#include "util/mapped_file.h"
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+	Offline asset cooker; collects asset directories into a single pack file (see util::AssetPack), or
+	converts a directory of images into loose GPU-ready textures.
+
+	Usage:
+		Cooker [options] <output pack> <directory>[=<prefix>] ...
+		Cooker [options] --textures <input directory> <output directory>
+
+		Cooker x64/Release/assets.pack assets=assets Overdrive/Shaders=Shaders
+		Cooker --format=bc7 --dds --textures assets/image x64/Release/textures
+
+	Options:
+		--no-compression	don't LZ4 compress text assets
+		--format=<encoding>	rgba8, bc1, bc3, bc7 or auto (default; bc1 for opaque images, bc7 otherwise)
+		--dds				write DDS instead of KTX textures
+		--cache=<directory>	where cooked textures are cached (default: <output>.cache)
+		--no-cache			always cook every texture
+		--threads=<count>	worker threads (default: one per hardware thread)
+
+	Every file is stored under <prefix>/<path relative to the directory>, so the runtime can keep using
+	the paths it would use for loose files.
+
+	~ images (png, jpg, tga, bmp, psd, gif) are cooked by a TextureCooker: full mip chain, block compressed,
+	  in parallel; they are never LZ4 compressed, to allow zero-copy uploads
+	~ text assets (shaders, configuration) are LZ4 compressed
+	~ everything else is stored as-is
+*/
+
+using namespace overdrive;
+
+namespace {
+	struct Options {
+		bool mAllowCompression = true;
+		bool mUseCache = true;
+		bool mIsTextureMode = false;
+		size_t mNumThreads = 0;
+		cooker::eTextureEncoding mEncoding = cooker::eTextureEncoding::AUTO;
+		cooker::eTextureContainer mContainer = cooker::eTextureContainer::KTX;
+		boost::filesystem::path mCacheDirectory;
+	};
+
+	struct Source {
+		boost::filesystem::path mDirectory;
+		std::string mPrefix;
+	};
+
+	struct CookedImage {
+		bool mIsCooked = false;
+		std::vector<char> mData;
+		std::string mError;
+	};
+
+	bool isImage(const std::string& extension) {
+		static const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif" };
+
+		for (auto ext : extensions)
+			if (extension == ext)
+				return true;
+
+		return false;
+	}
+
+	bool isText(const std::string& extension) {
+		static const char* extensions[] = { ".glsl", ".vert", ".frag", ".geom", ".tesc", ".tese", ".comp", ".cfg", ".csv", ".txt", ".json", ".xml" };
+
+		for (auto ext : extensions)
+			if (extension == ext)
+				return true;
+
+		return false;
+	}
+
+	bool parseCount(const std::string& text, size_t& result) {
+		// plain decimal digits; a handful of them is plenty for a thread count (and can't overflow)
+		if (text.empty() || (text.size() > 4))
+			return false;
+
+		result = 0;
+
+		for (char c : text) {
+			if ((c < '0') || (c > '9'))
+				return false;
+
+			result = result * 10 + (c - '0');
+		}
+
+		return true;
+	}
+
+	std::string getExtension(const boost::filesystem::path& p) {
+		return boost::algorithm::to_lower_copy(p.extension().string());
+	}
+
+	// strips trailing separators, so the relative paths come out right
+	boost::filesystem::path trimDirectory(const std::string& directory) {
+		return boost::algorithm::trim_right_copy_if(
+			boost::filesystem::path(directory).generic_string(),
+			boost::is_any_of("/")
+		);
+	}
+
+	std::string getRelativeName(const boost::filesystem::path& directory, const boost::filesystem::path& file) {
+		return file.generic_string().substr(directory.generic_string().size() + 1);
+	}
+
+	std::vector<boost::filesystem::path> listFiles(const boost::filesystem::path& directory) {
+		using namespace boost::filesystem;
+
+		std::vector<path> result;
+
+		for (recursive_directory_iterator it(directory), end; it != end; ++it)
+			if (is_regular_file(it->status()))
+				result.push_back(it->path());
+
+		// keeps the output the same between runs
+		std::sort(result.begin(), result.end());
+
+		return result;
+	}
+
+	// cooks all images among the files, one job each; the entries of other files are left empty
+	std::vector<CookedImage> cookImages(
+		core::JobSystem& jobSystem,
+		cooker::TextureCooker& textureCooker,
+		const std::vector<boost::filesystem::path>& files,
+		const Options& options
+	) {
+		std::vector<CookedImage> result(files.size());
+		core::JobHandle handle;
+
+		for (size_t i = 0; i < files.size(); ++i) {
+			if (!isImage(getExtension(files[i])))
+				continue;
+
+			jobSystem.schedule([&, i] {
+				try {
+					util::MappedFile mapping(files[i]);
+
+					result[i].mIsCooked = textureCooker.cook(
+						mapping.getData(),
+						mapping.getSize(),
+						cooker::getDefaultSettings(files[i], options.mEncoding),
+						result[i].mData
+					);
+
+					if (!result[i].mIsCooked)
+						result[i].mError = "can't be decoded";
+				}
+				catch (const std::exception& ex) {
+					result[i].mError = ex.what();
+				}
+			}, handle);
+		}
+
+		jobSystem.wait(handle);
+
+		return result;
+	}
+
+	void cookDirectory(
+		core::JobSystem& jobSystem,
+		cooker::TextureCooker& textureCooker,
+		const Source& source,
+		const Options& options,
+		util::AssetPackWriter& writer
+	) {
+		auto files = listFiles(source.mDirectory);
+		auto images = cookImages(jobSystem, textureCooker, files, options);
+
+		for (size_t i = 0; i < files.size(); ++i) {
+			std::string name = getRelativeName(source.mDirectory, files[i]);
+
+			if (!source.mPrefix.empty())
+				name = source.mPrefix + "/" + name;
+
+			if (images[i].mIsCooked) {
+				writer.add(name, images[i].mData.data(), images[i].mData.size(), false);
+				std::cout << "  " << name << " (texture, " << (images[i].mData.size() / 1024) << " KB)\n";
+				continue;
+			}
+
+			if (!images[i].mError.empty())
+				std::cout << "  " << name << ": " << images[i].mError << ", stored as-is\n";
+
+			bool compress = options.mAllowCompression && isText(getExtension(files[i]));
+
+			util::MappedFile mapping(files[i]);
+
+			writer.add(name, mapping.getData(), mapping.getSize(), compress);
+			std::cout << "  " << name << (compress ? " (compressed)\n" : "\n");
+		}
+	}
+
+	// writes every image as <output>/<relative path>.ktx (or .dds), other files are skipped; false if any image failed
+	bool cookTextures(
+		core::JobSystem& jobSystem,
+		cooker::TextureCooker& textureCooker,
+		const boost::filesystem::path& input,
+		const boost::filesystem::path& output,
+		const Options& options
+	) {
+		auto files = listFiles(input);
+		auto images = cookImages(jobSystem, textureCooker, files, options);
+
+		bool isSuccessful = true;
+
+		for (size_t i = 0; i < files.size(); ++i) {
+			std::string name = getRelativeName(input, files[i]);
+
+			if (!images[i].mIsCooked) {
+				if (!images[i].mError.empty()) {
+					std::cout << "  " << name << ": " << images[i].mError << "\n";
+					isSuccessful = false;
+				}
+
+				continue;
+			}
+
+			auto target = output / name;
+			target.replace_extension((options.mContainer == cooker::eTextureContainer::DDS) ? ".dds" : ".ktx");
+
+			boost::filesystem::create_directories(target.parent_path());
+
+			std::ofstream file(target.string(), std::ios::binary);
+			file.write(images[i].mData.data(), static_cast<std::streamsize>(images[i].mData.size()));
+
+			if (!file) {
+				std::cout << "  " << name << ": failed to write " << target << "\n";
+				isSuccessful = false;
+				continue;
+			}
+
+			std::cout << "  " << name << " (" << (images[i].mData.size() / 1024) << " KB)\n";
+		}
+
+		return isSuccessful;
+	}
+
+	bool parseOptions(int argc, char* argv[], Options& options, std::vector<std::string>& arguments) {
+		for (int i = 1; i < argc; ++i) {
+			std::string argument = argv[i];
+
+			if (argument == "--no-compression")
+				options.mAllowCompression = false;
+			else if (argument == "--no-cache")
+				options.mUseCache = false;
+			else if (argument == "--dds")
+				options.mContainer = cooker::eTextureContainer::DDS;
+			else if (argument == "--textures")
+				options.mIsTextureMode = true;
+			else if (boost::algorithm::starts_with(argument, "--cache="))
+				options.mCacheDirectory = argument.substr(8);
+			else if (boost::algorithm::starts_with(argument, "--threads=")) {
+				if (!parseCount(argument.substr(10), options.mNumThreads)) {
+					std::cerr << "Invalid thread count: " << argument.substr(10) << "\n";
+					return false;
+				}
+			}
+			else if (boost::algorithm::starts_with(argument, "--format=")) {
+				if (!cooker::parseTextureEncoding(argument.substr(9), options.mEncoding)) {
+					std::cerr << "Unknown texture format: " << argument.substr(9) << "\n";
+					return false;
+				}
+			}
+			else if (boost::algorithm::starts_with(argument, "--")) {
+				std::cerr << "Unknown option: " << argument << "\n";
+				return false;
+			}
+			else
+				arguments.push_back(argument);
+		}
+
+		if (options.mIsTextureMode)
+			return (arguments.size() == 2);
+		else
+			return (arguments.size() >= 2);
+	}
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	std::vector<std::string> arguments;
+
+	if (!parseOptions(argc, argv, options, arguments)) {
+		std::cerr
+			<< "Usage: Cooker [options] <output pack> <directory>[=<prefix>] ...\n"
+			<< "       Cooker [options] --textures <input directory> <output directory>\n"
+			<< "Options: --no-compression --format=<rgba8|bc1|bc3|bc7|auto> --dds --cache=<directory> --no-cache --threads=<count>\n";
+		return 1;
+	}
+
+	try {
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// the pack file, or the texture directory
+		boost::filesystem::path output = trimDirectory(arguments[options.mIsTextureMode ? 1 : 0]);
+
+		if (!options.mUseCache)
+			options.mCacheDirectory.clear();
+		else if (options.mCacheDirectory.empty())
+			options.mCacheDirectory = output.string() + ".cache";
+
+		// [NOTE] images are decoded on the job fibers, and the stbi jpeg decoder keeps its tables on the stack
+		core::JobSystem jobSystem(options.mNumThreads, 1024 * 1024);
+		cooker::TextureCooker textureCooker(jobSystem, options.mCacheDirectory);
+
+		bool isSuccessful = true;
+
+		if (options.mIsTextureMode) {
+			auto input = trimDirectory(arguments[0]);
+
+			std::cout << "Cooking textures from " << input << " to " << output << "\n";
+
+			isSuccessful = cookTextures(jobSystem, textureCooker, input, output, options);
+		}
+		else {
+			util::AssetPackWriter writer;
+
+			for (size_t i = 1; i < arguments.size(); ++i) {
+				Source source;
+
+				auto separator = arguments[i].find('=');
+				source.mDirectory = trimDirectory(arguments[i].substr(0, separator));
+
+				if (separator == std::string::npos)
+					source.mPrefix = source.mDirectory.filename().generic_string();
+				else
+					source.mPrefix = arguments[i].substr(separator + 1);
+
+				std::cout << "Cooking " << source.mDirectory << " as " << source.mPrefix << "\n";
+
+				cookDirectory(jobSystem, textureCooker, source, options, writer);
+			}
+
+			writer.save(output);
+
+			std::cout
+				<< "Wrote " << writer.getNumAssets() << " assets to " << output << " ("
+				<< (writer.getNumBytes() / 1024) << " KB, "
+				<< (writer.getNumOriginalBytes() / 1024) << " KB uncompressed)\n";
+		}
+
+		auto stats = textureCooker.getStats();
+		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+
+		std::cout
+			<< "Textures: "
+			<< stats.mNumCooked << " cooked, "
+			<< stats.mNumCached << " cached, "
+			<< stats.mNumFailed << " failed ("
+			<< (stats.mNumSourceBytes / 1024) << " KB -> " << (stats.mNumResultBytes / 1024) << " KB) in "
+			<< duration.count() << " ms on " << jobSystem.getNumWorkers() << " threads\n";
+
+		return isSuccessful ? 0 : 1;
+	}
+	catch (const std::exception& ex) {
+		std::cerr << "Cooking failed: " << ex.what() << "\n";
+		return 1;
+	}
+}
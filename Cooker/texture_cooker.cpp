@@ -0,0 +1,426 @@
+#include "texture_cooker.h"
+#include "block_compression.h"
+
+#include "opengl.h"
+#include "util/deleters.h"
+#include "util/mapped_file.h"
+#include "util/string_hash.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace overdrive {
+	namespace cooker {
+		namespace {
+			const int ROWS_PER_JOB = 32;		// texel rows per mip filter job
+			const int BLOCK_ROWS_PER_JOB = 8;	// block rows per encoder job
+
+			// splits [0, count) into ranges of at most rangeSize, runs each range as a job and waits for all of them
+			template <typename tFunction>
+			void parallelFor(core::JobSystem& jobSystem, int count, int rangeSize, const tFunction& fn) {
+				core::JobHandle handle;
+
+				for (int begin = 0; begin < count; begin += rangeSize) {
+					int end = std::min(begin + rangeSize, count);
+
+					jobSystem.schedule([&fn, begin, end] { fn(begin, end); }, handle);
+				}
+
+				jobSystem.wait(handle);
+			}
+
+			float srgbToLinear(uint8_t value) {
+				static const std::vector<float> table = [] {
+					std::vector<float> result(256);
+
+					for (int i = 0; i < 256; ++i) {
+						float c = i / 255.0f;
+						result[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+					}
+
+					return result;
+				}();
+
+				return table[value];
+			}
+
+			uint8_t linearToSrgb(float value) {
+				float c = std::min(std::max(value, 0.0f), 1.0f);
+				c = (c <= 0.0031308f) ? (c * 12.92f) : (1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f);
+
+				return static_cast<uint8_t>(c * 255.0f + 0.5f);
+			}
+
+			uint8_t toUnorm(float value) {
+				return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+
+			// a mip level, both as filtered linear values (4 floats per texel) and as RGBA8
+			struct MipLevel {
+				int mWidth = 0;
+				int mHeight = 0;
+				std::vector<float> mLinear;
+				std::vector<uint8_t> mTexels;
+			};
+
+			void toLinear(core::JobSystem& jobSystem, const MipLevel& level, bool isColor, std::vector<float>& result) {
+				result.resize(static_cast<size_t>(level.mWidth) * level.mHeight * 4);
+
+				parallelFor(jobSystem, level.mHeight, ROWS_PER_JOB, [&](int begin, int end) {
+					for (size_t i = static_cast<size_t>(begin) * level.mWidth * 4; i < static_cast<size_t>(end) * level.mWidth * 4; ++i) {
+						bool isAlpha = ((i % 4) == 3);
+
+						result[i] = (isColor && !isAlpha) ?
+							srgbToLinear(level.mTexels[i]) :
+							(level.mTexels[i] / 255.0f);
+					}
+				});
+			}
+
+			// 2x2 box filter in linear space; odd dimensions repeat the last row/column
+			void downsample(core::JobSystem& jobSystem, const MipLevel& source, bool isColor, MipLevel& result) {
+				result.mWidth = std::max(source.mWidth / 2, 1);
+				result.mHeight = std::max(source.mHeight / 2, 1);
+				result.mLinear.resize(static_cast<size_t>(result.mWidth) * result.mHeight * 4);
+				result.mTexels.resize(result.mLinear.size());
+
+				parallelFor(jobSystem, result.mHeight, ROWS_PER_JOB, [&](int begin, int end) {
+					for (int y = begin; y < end; ++y) {
+						int y0 = std::min(y * 2, source.mHeight - 1);
+						int y1 = std::min(y * 2 + 1, source.mHeight - 1);
+
+						for (int x = 0; x < result.mWidth; ++x) {
+							int x0 = std::min(x * 2, source.mWidth - 1);
+							int x1 = std::min(x * 2 + 1, source.mWidth - 1);
+
+							size_t destination = (static_cast<size_t>(y) * result.mWidth + x) * 4;
+
+							for (int channel = 0; channel < 4; ++channel) {
+								float value = 0.25f * (
+									source.mLinear[(static_cast<size_t>(y0) * source.mWidth + x0) * 4 + channel] +
+									source.mLinear[(static_cast<size_t>(y0) * source.mWidth + x1) * 4 + channel] +
+									source.mLinear[(static_cast<size_t>(y1) * source.mWidth + x0) * 4 + channel] +
+									source.mLinear[(static_cast<size_t>(y1) * source.mWidth + x1) * 4 + channel]
+								);
+
+								result.mLinear[destination + channel] = value;
+								result.mTexels[destination + channel] = (isColor && (channel != 3)) ?
+									linearToSrgb(value) :
+									toUnorm(value);
+							}
+						}
+					}
+				});
+			}
+
+			void encodeLevel(
+				core::JobSystem& jobSystem,
+				const MipLevel& level,
+				eTextureEncoding encoding,
+				uint8_t* destination
+			) {
+				if (encoding == eTextureEncoding::RGBA8) {
+					std::memcpy(destination, level.mTexels.data(), level.mTexels.size());
+					return;
+				}
+
+				int numBlocksX = (level.mWidth + 3) / 4;
+				int numBlocksY = (level.mHeight + 3) / 4;
+				size_t blockSize = (encoding == eTextureEncoding::BC1) ? 8 : 16;
+
+				parallelFor(jobSystem, numBlocksY, BLOCK_ROWS_PER_JOB, [&](int begin, int end) {
+					uint8_t texels[64];
+
+					for (int blockY = begin; blockY < end; ++blockY) {
+						for (int blockX = 0; blockX < numBlocksX; ++blockX) {
+							// blocks that stick out of the level repeat the last row/column
+							for (int y = 0; y < 4; ++y) {
+								int sourceY = std::min(blockY * 4 + y, level.mHeight - 1);
+
+								for (int x = 0; x < 4; ++x) {
+									int sourceX = std::min(blockX * 4 + x, level.mWidth - 1);
+
+									std::memcpy(
+										texels + (y * 4 + x) * 4,
+										level.mTexels.data() + (static_cast<size_t>(sourceY) * level.mWidth + sourceX) * 4,
+										4
+									);
+								}
+							}
+
+							uint8_t* block = destination + (static_cast<size_t>(blockY) * numBlocksX + blockX) * blockSize;
+
+							switch (encoding) {
+							case eTextureEncoding::BC1: compressBlockBC1(texels, block); break;
+							case eTextureEncoding::BC3: compressBlockBC3(texels, block); break;
+							default:					compressBlockBC7(texels, block); break;
+							}
+						}
+					}
+				});
+			}
+
+			bool isOpaque(const std::vector<uint8_t>& texels) {
+				for (size_t i = 3; i < texels.size(); i += 4)
+					if (texels[i] != 255)
+						return false;
+
+				return true;
+			}
+
+			gli::format getFormat(eTextureEncoding encoding) {
+				switch (encoding) {
+				case eTextureEncoding::BC1: return gli::FORMAT_RGB_DXT1_UNORM_BLOCK8;
+				case eTextureEncoding::BC3: return gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16;
+				case eTextureEncoding::BC7: return gli::FORMAT_RGBA_BP_UNORM_BLOCK16;
+				default:					return gli::FORMAT_RGBA8_UNORM_PACK8;
+				}
+			}
+		}
+
+		TextureCooker::TextureCooker(
+			core::JobSystem& jobSystem,
+			const boost::filesystem::path& cacheDirectory
+		):
+			mJobSystem(jobSystem),
+			mCacheDirectory(cacheDirectory)
+		{
+			if (!mCacheDirectory.empty())
+				boost::filesystem::create_directories(mCacheDirectory);
+		}
+
+		bool TextureCooker::cook(
+			const void* data,
+			size_t numBytes,
+			const TextureCookSettings& settings,
+			std::vector<char>& result
+		) {
+			boost::filesystem::path cachePath;
+
+			if (!mCacheDirectory.empty()) {
+				uint32_t parameters[] = {
+					COOKER_VERSION,
+					static_cast<uint32_t>(settings.mEncoding),
+					static_cast<uint32_t>(settings.mContainer),
+					settings.mIsColor ? 1u : 0u,
+					settings.mGenerateMips ? 1u : 0u
+				};
+
+				uint64_t key = util::hashBytes(data, numBytes);
+				key = util::hashBytes(parameters, sizeof(parameters), key);
+
+				cachePath = getCachePath(key, settings.mContainer);
+
+				if (readCache(cachePath, result)) {
+					std::lock_guard<std::mutex> lock(mStatsMutex);
+
+					++mStats.mNumCached;
+					mStats.mNumSourceBytes += numBytes;
+					mStats.mNumResultBytes += result.size();
+
+					return true;
+				}
+			}
+
+			MipLevel level;
+			int numChannels = 0;
+
+			std::unique_ptr<stbi_uc[], util::FreeHelper> pixels(
+				stbi_load_from_memory(
+					static_cast<const stbi_uc*>(data),
+					static_cast<int>(numBytes),
+					&level.mWidth,
+					&level.mHeight,
+					&numChannels,
+					4 // always expand to RGBA, 3-channel textures are padded by the driver anyway
+				)
+			);
+
+			if (!pixels) {
+				std::lock_guard<std::mutex> lock(mStatsMutex);
+				++mStats.mNumFailed;
+
+				return false;
+			}
+
+			level.mTexels.assign(pixels.get(), pixels.get() + static_cast<size_t>(level.mWidth) * level.mHeight * 4);
+			pixels.reset();
+
+			eTextureEncoding encoding = settings.mEncoding;
+
+			if (encoding == eTextureEncoding::AUTO)
+				encoding = isOpaque(level.mTexels) ? eTextureEncoding::BC1 : eTextureEncoding::BC7;
+
+			gli::texture2D::texelcoord_type extent(level.mWidth, level.mHeight);
+
+			gli::texture2D texture = settings.mGenerateMips ?
+				gli::texture2D(getFormat(encoding), extent) :
+				gli::texture2D(getFormat(encoding), extent, 1);
+
+			for (size_t i = 0; i < texture.levels(); ++i) {
+				if (i > 0) {
+					if (i == 1)
+						toLinear(mJobSystem, level, settings.mIsColor, level.mLinear);
+
+					MipLevel next;
+					downsample(mJobSystem, level, settings.mIsColor, next);
+					level = std::move(next);
+				}
+
+				encodeLevel(mJobSystem, level, encoding, static_cast<uint8_t*>(texture.data(0, 0, i)));
+			}
+
+			result.clear();
+
+			bool isSaved = (settings.mContainer == eTextureContainer::DDS) ?
+				gli::save_dds(texture, result) :
+				gli::save_ktx(texture, result);
+
+			if (!isSaved) {
+				std::lock_guard<std::mutex> lock(mStatsMutex);
+				++mStats.mNumFailed;
+
+				return false;
+			}
+
+			if (!cachePath.empty())
+				writeCache(cachePath, result);
+
+			std::lock_guard<std::mutex> lock(mStatsMutex);
+
+			++mStats.mNumCooked;
+			mStats.mNumSourceBytes += numBytes;
+			mStats.mNumResultBytes += result.size();
+
+			return true;
+		}
+
+		TextureCooker::Stats TextureCooker::getStats() const {
+			std::lock_guard<std::mutex> lock(mStatsMutex);
+			return mStats;
+		}
+
+		boost::filesystem::path TextureCooker::getCachePath(uint64_t key, eTextureContainer container) const {
+			static const char digits[] = "0123456789abcdef";
+
+			std::string name(16, '0');
+
+			for (int i = 0; i < 16; ++i)
+				name[15 - i] = digits[(key >> (4 * i)) & 0xF];
+
+			name += (container == eTextureContainer::DDS) ? ".dds" : ".ktx";
+
+			return mCacheDirectory / name;
+		}
+
+		bool TextureCooker::readCache(const boost::filesystem::path& p, std::vector<char>& result) const {
+			boost::system::error_code ec;
+
+			if (!boost::filesystem::is_regular_file(p, ec))
+				return false;
+
+			try {
+				util::MappedFile file(p);
+
+				result.assign(file.getChars(), file.getChars() + file.getSize());
+			}
+			catch (const std::exception&) {
+				return false; // treat an unreadable entry as a miss, it will be overwritten
+			}
+
+			return !result.empty();
+		}
+
+		void TextureCooker::writeCache(const boost::filesystem::path& p, const std::vector<char>& data) const {
+			boost::system::error_code ec;
+
+			// several jobs may write the same entry, so every writer gets its own temporary file
+			auto temporary = mCacheDirectory / boost::filesystem::unique_path("%%%%-%%%%-%%%%-%%%%.tmp", ec);
+
+			if (ec)
+				return;
+
+			{
+				std::ofstream file(temporary.string(), std::ios::binary);
+
+				file.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+				if (!file) {
+					file.close();
+					boost::filesystem::remove(temporary, ec);
+
+					return;
+				}
+			}
+
+			boost::filesystem::rename(temporary, p, ec);
+
+			if (ec)
+				boost::filesystem::remove(temporary, ec);
+		}
+
+		std::vector<uint8_t> generateMipLevel(
+			core::JobSystem& jobSystem,
+			const uint8_t* texels,
+			int width,
+			int height,
+			bool isColor
+		) {
+			MipLevel source;
+			MipLevel result;
+
+			source.mWidth = width;
+			source.mHeight = height;
+			source.mTexels.assign(texels, texels + static_cast<size_t>(width) * height * 4);
+
+			toLinear(jobSystem, source, isColor, source.mLinear);
+			downsample(jobSystem, source, isColor, result);
+
+			return std::move(result.mTexels);
+		}
+
+		TextureCookSettings getDefaultSettings(const boost::filesystem::path& p, eTextureEncoding encoding) {
+			static const char* normalMapSuffixes[] = { "_n", "_normal", "_nrm" };
+
+			TextureCookSettings result;
+			result.mEncoding = encoding;
+
+			std::string stem = boost::algorithm::to_lower_copy(p.stem().string());
+
+			for (auto suffix : normalMapSuffixes)
+				if (boost::algorithm::ends_with(stem, suffix))
+					result.mIsColor = false;
+
+			return result;
+		}
+
+		bool parseTextureEncoding(const std::string& name, eTextureEncoding& result) {
+			static const struct {
+				const char* mName;
+				eTextureEncoding mEncoding;
+			} encodings[] = {
+				{ "rgba8", eTextureEncoding::RGBA8 },
+				{ "bc1", eTextureEncoding::BC1 },
+				{ "bc3", eTextureEncoding::BC3 },
+				{ "bc7", eTextureEncoding::BC7 },
+				{ "auto", eTextureEncoding::AUTO }
+			};
+
+			std::string lowered = boost::algorithm::to_lower_copy(name);
+
+			for (const auto& item : encodings) {
+				if (lowered == item.mName) {
+					result = item.mEncoding;
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "core/job_system.h"
+
+#include <boost/filesystem.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace overdrive {
+	namespace cooker {
+		enum class eTextureEncoding {
+			RGBA8,	// uncompressed
+			BC1,	// RGB, 4 bits per texel
+			BC3,	// RGBA, 8 bits per texel
+			BC7,	// RGBA, 8 bits per texel, better quality than BC3
+			AUTO	// BC1 for opaque images, BC7 otherwise
+		};
+
+		enum class eTextureContainer {
+			KTX,
+			DDS
+		};
+
+		struct TextureCookSettings {
+			eTextureEncoding mEncoding = eTextureEncoding::AUTO;
+			eTextureContainer mContainer = eTextureContainer::KTX;
+			bool mIsColor = true;		// sRGB encoded data; mips are filtered in linear space
+			bool mGenerateMips = true;
+		};
+
+		/*
+			Turns source images (anything stbi can decode) into GPU-ready textures that gli::load and
+			render::parseTextureFile accept directly.
+
+			~ mip levels are generated with a 2x2 box filter, in linear space for color data
+			~ each level is block compressed (see block_compression.h) or stored as RGBA8
+			~ the rows of every level are split over jobs, cook() can itself be called from jobs
+			~ results are cached on disk by content hash, so unchanged images are only cooked once
+
+			Usage:
+				core::JobSystem jobs;
+				TextureCooker cooker(jobs, "x64/Release/texture.cache");
+
+				std::vector<char> ktx;
+				if (cooker.cook(data, numBytes, TextureCookSettings(), ktx))
+					...
+
+			[NOTE] the stored format is always UNORM (the runtime doesn't create sRGB textures yet);
+				   only the filtering is gamma-correct
+			[NOTE] cache entries are keyed on the source bytes, the settings and COOKER_VERSION -- bump
+				   the version whenever the output of the cooker changes
+		*/
+		class TextureCooker {
+		public:
+			static const uint32_t COOKER_VERSION = 1;
+
+			struct Stats {
+				size_t mNumCooked = 0;
+				size_t mNumCached = 0;	// served from the cache
+				size_t mNumFailed = 0;	// couldn't be decoded
+				size_t mNumSourceBytes = 0;
+				size_t mNumResultBytes = 0;
+			};
+
+			explicit TextureCooker(
+				core::JobSystem& jobSystem,
+				const boost::filesystem::path& cacheDirectory = boost::filesystem::path() // empty disables the cache
+			);
+
+			bool cook( // false if the source can't be decoded; thread safe
+				const void* data,
+				size_t numBytes,
+				const TextureCookSettings& settings,
+				std::vector<char>& result
+			);
+
+			Stats getStats() const;
+
+		private:
+			boost::filesystem::path getCachePath(uint64_t key, eTextureContainer container) const;
+			bool readCache(const boost::filesystem::path& p, std::vector<char>& result) const;
+			void writeCache(const boost::filesystem::path& p, const std::vector<char>& data) const; // best effort
+
+			core::JobSystem& mJobSystem;
+			boost::filesystem::path mCacheDirectory;
+
+			mutable std::mutex mStatsMutex;
+			Stats mStats;
+		};
+
+		// the next mip level of an RGBA8 image, filtered the same way cook() does (max(width / 2, 1) by max(height / 2, 1))
+		std::vector<uint8_t> generateMipLevel(
+			core::JobSystem& jobSystem,
+			const uint8_t* texels,
+			int width,
+			int height,
+			bool isColor
+		);
+
+		// color textures unless the file name marks a normal map (*_n.png, *_normal.png, *_nrm.png)
+		TextureCookSettings getDefaultSettings(const boost::filesystem::path& p, eTextureEncoding encoding);
+
+		bool parseTextureEncoding(const std::string& name, eTextureEncoding& result); // rgba8, bc1, bc3, bc7, auto
+	}
+}
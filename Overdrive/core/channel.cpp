@@ -0,0 +1,56 @@
+#include "stdafx.h"
+#include "channel.h"
+#include "frame_allocator.h"
+#include <algorithm>
+#include <mutex>
+
+namespace overdrive {
+	namespace core {
+		namespace {
+			struct PostedRegistry {
+				std::mutex mMutex;
+				std::vector<detail::PostedQueue*> mQueues;
+			};
+
+			PostedRegistry& getRegistry() {
+				static PostedRegistry result;
+				return result;
+			}
+		}
+
+		void Channel::dispatchPosted(const std::string& syncPoint) {
+			auto& registry = getRegistry();
+
+			FrameVector<detail::PostedQueue*> queues(FrameAllocator::local().getResource());
+
+			{
+				std::lock_guard<std::mutex> lock(registry.mMutex);
+				queues.assign(registry.mQueues.begin(), registry.mQueues.end());
+			}
+
+			for (auto queue : queues)
+				if (queue->getSyncPoint() == syncPoint)
+					queue->dispatchPosted();
+		}
+
+		namespace detail {
+			void registerPostedQueue(PostedQueue* queue) {
+				auto& registry = getRegistry();
+
+				std::lock_guard<std::mutex> lock(registry.mMutex);
+				registry.mQueues.push_back(queue);
+			}
+
+			void unregisterPostedQueue(PostedQueue* queue) {
+				auto& registry = getRegistry();
+
+				std::lock_guard<std::mutex> lock(registry.mMutex);
+
+				auto it = std::find(registry.mQueues.begin(), registry.mQueues.end(), queue);
+
+				if (it != registry.mQueues.end())
+					registry.mQueues.erase(it);
+			}
+		}
+	}
+}
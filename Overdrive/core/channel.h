@@ -1,7 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 namespace overdrive {
 	namespace core {
+		/*
+			broadcast() delivers a message immediately, on the calling thread.
+			post() queues the message instead; queued messages are delivered by dispatchPosted(), which the
+			Engine calls once per frame on the main thread (message types can be assigned to a named sync point
+			instead, those are only delivered when that sync point is dispatched explicitly).
+
+			Handlers that accept a MessageBatch<T> receive all queued messages of a type in a single call,
+			other handlers get called once per message.
+		*/
 		struct Channel {
 			template <typename tMessage, typename tHandler>
 			static void add(tHandler* handler);
@@ -17,7 +29,40 @@ namespace overdrive {
 
 			template <typename tMessage>
 			static void broadcast(const tMessage& message);
+
+			template <typename tMessage>
+			static void post(const tMessage& message);
+
+			template <typename tMessage>
+			static void setSyncPoint(const std::string& syncPoint); // an empty name means 'once per frame' (default)
+
+			static void dispatchPosted(const std::string& syncPoint = std::string());
 		};
+
+		// contiguous range of queued messages, handed to handlers that support batches
+		template <typename tMessage>
+		struct MessageBatch {
+			const tMessage* begin() const;
+			const tMessage* end() const;
+			size_t size() const;
+			const tMessage& operator[](size_t index) const;
+
+			const tMessage* mMessages;
+			size_t mCount;
+		};
+
+		namespace detail {
+			class PostedQueue {
+			public:
+				virtual ~PostedQueue() = default;
+
+				virtual void dispatchPosted() = 0;
+				virtual std::string getSyncPoint() const = 0;
+			};
+
+			void registerPostedQueue(PostedQueue* queue);
+			void unregisterPostedQueue(PostedQueue* queue);
+		}
 	}
 
 	// [NOTE] This *can* be used as a base class, but it is not required
@@ -31,4 +76,4 @@ namespace overdrive {
 	};
 }
 
-#include "channel.inl"
\ No newline at end of file
+#include "channel.inl"
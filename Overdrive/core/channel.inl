@@ -29,6 +29,37 @@ namespace overdrive {
 		void Channel::broadcast(const T& message) {
 			ChannelQueue<T>::instance().broadcast(message);
 		}
+
+		template <typename T>
+		void Channel::post(const T& message) {
+			ChannelQueue<T>::instance().post(message);
+		}
+
+		template <typename T>
+		void Channel::setSyncPoint(const std::string& syncPoint) {
+			ChannelQueue<T>::instance().setSyncPoint(syncPoint);
+		}
+
+		// ----- MessageBatch -----
+		template <typename T>
+		const T* MessageBatch<T>::begin() const {
+			return mMessages;
+		}
+
+		template <typename T>
+		const T* MessageBatch<T>::end() const {
+			return mMessages + mCount;
+		}
+
+		template <typename T>
+		size_t MessageBatch<T>::size() const {
+			return mCount;
+		}
+
+		template <typename T>
+		const T& MessageBatch<T>::operator[](size_t index) const {
+			return mMessages[index];
+		}
 	}
 
 	template <typename T>
@@ -1,16 +1,42 @@
 #pragma once
 
-#include <vector>
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
+#include "../util/spinlock.h"
 
 namespace overdrive {
 	namespace core {
+		/*
+			Broadcasting reads an immutable snapshot of the handler list, without taking a lock or allocating.
+			Adding or removing handlers copies the list and publishes the copy atomically; the old list is
+			reclaimed once all broadcasts that might still be reading it have finished (simple two-counter RCU).
+
+			[NOTE] adding/removing a handler outside of a broadcast waits for broadcasts (of the same message type)
+			       on other threads to finish; it doesn't hold any lock while waiting, so those handlers may add or
+			       remove handlers themselves. A handler should still not block on a thread that is modifying the
+			       same channel. Changes made from within a handler never wait, their old lists are reclaimed by
+			       the next change made outside of a broadcast.
+
+			Posted messages go into a ring buffer owned by the posting thread (single producer, the dispatching
+			thread is the only consumer). When a ring is full, messages spill into a locked overflow list until
+			the next dispatch. Dispatching collects all rings into one contiguous array and hands that to each handler.
+
+			[NOTE] posted messages must be default-constructible and copy-assignable (the rings are preallocated)
+			[NOTE] the ring of a thread that exits is released by the next dispatch, after its messages are delivered
+		*/
 		template <typename tMessage>
-		class ChannelQueue {
+		class ChannelQueue:
+			public detail::PostedQueue
+		{
 		private:
 			ChannelQueue();
 
 		public:
+			~ChannelQueue();
+
 			static ChannelQueue& instance();
 
 			template <typename tHandler>
@@ -24,16 +50,93 @@ namespace overdrive {
 
 			void broadcast(const tMessage& message);
 
+			void post(const tMessage& message);
+			virtual void dispatchPosted() override;
+
+			void setSyncPoint(const std::string& syncPoint);
+			virtual std::string getSyncPoint() const override;
+
 		private:
-			typedef std::function<void(const tMessage&)> Handler;
+			struct Handler {
+				void (*mFunction)(void* object, const tMessage& message);
+				void (*mBatchFunction)(void* object, const MessageBatch<tMessage>& batch);
+				void* mObject;
+			};
+
+			class PostRing {
+			public:
+				static const size_t CAPACITY = 256; // must be a power of two
+
+				PostRing();
+
+				void push(const tMessage& message); // owning thread only
+				void drain(std::vector<tMessage>& output); // dispatching thread only
+
+				void abandon(); // the owning thread exited, nothing will be pushed anymore
+				bool isAbandoned() const;
+
+			private:
+				std::vector<tMessage> mMessages;
+				std::atomic<size_t> mHead; // next message to be consumed
+				std::atomic<size_t> mTail; // next free slot
+
+				util::Spinlock mOverflowLock;
+				std::vector<tMessage> mOverflow;
+				std::atomic<bool> mIsOverflowing; // keeps messages in order until the overflow is drained
+				std::atomic<bool> mIsAbandoned;
+			};
+
+			// marks the ring as abandoned when its thread exits
+			struct ThreadRing {
+				~ThreadRing();
+
+				PostRing* mRing = nullptr;
+			};
+
+			typedef std::vector<Handler> HandlerList;
 			typedef std::mutex Mutex;
 			typedef std::lock_guard<Mutex> ScopedLock;
-			
-			std::mutex mMutex;
-			std::vector<Handler> mHandlers;
-			std::vector<void*> mOriginalPointers;
+
+			template <typename tHandler>
+			static void invoke(void* object, const tMessage& message);
+
+			template <typename tHandler>
+			static void invokeBatch(void* object, const MessageBatch<tMessage>& batch);
+
+			PostRing* getThreadRing();
+
+			struct ReadGuard {
+				ReadGuard(const ChannelQueue* queue);
+				~ReadGuard();
+
+				const ChannelQueue* mQueue;
+				size_t mSlot;
+			};
+
+			static int& broadcastDepth(); // per thread, used to detect changes made from within a handler
+
+			void publish(HandlerList* newList); // requires mMutex to be held
+			void reclaim(); // deletes retired lists once no broadcast can be reading them; mMutex must *not* be held
+			void synchronize() const; // waits until all broadcasts that started before the call are done
+
+			std::atomic<HandlerList*> mHandlers;
+
+			mutable std::atomic<size_t> mEpoch;
+			mutable std::atomic<size_t> mReaders[2];
+
+			Mutex mMutex; // serializes modifications
+			std::vector<HandlerList*> mRetired; // lists that may still be in use by a broadcast, guarded by mMutex
+			Mutex mSyncMutex; // serializes grace periods, never taken from within a broadcast
+
+			mutable Mutex mRingMutex; // guards registration of new rings and the sync point name
+			std::vector<std::unique_ptr<PostRing>> mRings;
+			std::string mSyncPoint;
+			bool mIsRegistered;
+
+			Mutex mDispatchMutex;
+			std::vector<tMessage> mPosted; // staging area, re-used between dispatches
 		};
 	}
 }
 
-#include "channel_queue.inl"
\ No newline at end of file
+#include "channel_queue.inl"
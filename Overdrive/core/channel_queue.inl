@@ -2,11 +2,156 @@
 
 #include "channel_queue.h"
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
 
 namespace overdrive {
 	namespace core {
+		namespace detail {
+			// detects whether a handler can take a MessageBatch
+			template <typename tHandler, typename tMessage, typename = void>
+			struct AcceptsBatch:
+				std::false_type
+			{
+			};
+
+			template <typename tHandler, typename tMessage>
+			struct AcceptsBatch<
+				tHandler,
+				tMessage,
+				decltype(std::declval<tHandler&>()(std::declval<const MessageBatch<tMessage>&>()), void())
+			>:
+				std::true_type
+			{
+			};
+
+			template <typename tHandler, typename tMessage>
+			void deliverBatch(tHandler* handler, const MessageBatch<tMessage>& batch, std::true_type) {
+				(*handler)(batch);
+			}
+
+			template <typename tHandler, typename tMessage>
+			void deliverBatch(tHandler* handler, const MessageBatch<tMessage>& batch, std::false_type) {
+				for (const auto& message : batch)
+					(*handler)(message);
+			}
+		}
+
+		// ----- ChannelQueue::PostRing -----
 		template <typename T>
-		ChannelQueue<T>::ChannelQueue() {
+		ChannelQueue<T>::PostRing::PostRing():
+			mMessages(CAPACITY),
+			mHead(0),
+			mTail(0),
+			mIsOverflowing(false),
+			mIsAbandoned(false)
+		{
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::PostRing::push(const T& message) {
+			size_t tail = mTail.load(std::memory_order_relaxed);
+
+			bool isFull = (tail - mHead.load(std::memory_order_acquire) == CAPACITY);
+
+			if (isFull || mIsOverflowing.load(std::memory_order_acquire)) {
+				std::lock_guard<util::Spinlock> lock(mOverflowLock);
+
+				mOverflow.push_back(message);
+				mIsOverflowing.store(true, std::memory_order_release);
+
+				return;
+			}
+
+			mMessages[tail & (CAPACITY - 1)] = message;
+			mTail.store(tail + 1, std::memory_order_release);
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::PostRing::drain(std::vector<T>& output) {
+			size_t head = mHead.load(std::memory_order_relaxed);
+			size_t tail = mTail.load(std::memory_order_acquire);
+
+			for (; head != tail; ++head)
+				output.push_back(mMessages[head & (CAPACITY - 1)]);
+
+			mHead.store(head, std::memory_order_release);
+
+			// anything in the overflow was posted after the messages in the ring
+			if (mIsOverflowing.load(std::memory_order_acquire)) {
+				std::lock_guard<util::Spinlock> lock(mOverflowLock);
+
+				output.insert(output.end(), mOverflow.begin(), mOverflow.end());
+				mOverflow.clear();
+				mIsOverflowing.store(false, std::memory_order_release);
+			}
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::PostRing::abandon() {
+			mIsAbandoned.store(true, std::memory_order_release);
+		}
+
+		template <typename T>
+		bool ChannelQueue<T>::PostRing::isAbandoned() const {
+			return mIsAbandoned.load(std::memory_order_acquire);
+		}
+
+		// ----- ChannelQueue::ThreadRing -----
+		template <typename T>
+		ChannelQueue<T>::ThreadRing::~ThreadRing() {
+			if (mRing)
+				mRing->abandon();
+		}
+
+		// ----- ChannelQueue::ReadGuard -----
+		template <typename T>
+		ChannelQueue<T>::ReadGuard::ReadGuard(const ChannelQueue* queue):
+			mQueue(queue)
+		{
+			while (true) {
+				size_t epoch = queue->mEpoch.load();
+				mSlot = epoch & 1;
+
+				queue->mReaders[mSlot].fetch_add(1);
+
+				// if a writer flipped the epoch in the meantime it may not have seen us, so try again
+				if (queue->mEpoch.load() == epoch)
+					break;
+
+				queue->mReaders[mSlot].fetch_sub(1);
+			}
+
+			++broadcastDepth();
+		}
+
+		template <typename T>
+		ChannelQueue<T>::ReadGuard::~ReadGuard() {
+			--broadcastDepth();
+			mQueue->mReaders[mSlot].fetch_sub(1);
+		}
+
+		// ----- ChannelQueue -----
+		template <typename T>
+		ChannelQueue<T>::ChannelQueue():
+			mHandlers(new HandlerList),
+			mEpoch(0),
+			mIsRegistered(false)
+		{
+			mReaders[0] = 0;
+			mReaders[1] = 0;
+		}
+
+		template <typename T>
+		ChannelQueue<T>::~ChannelQueue() {
+			if (mIsRegistered)
+				detail::unregisterPostedQueue(this);
+
+			delete mHandlers.load();
+
+			for (auto list : mRetired)
+				delete list;
 		}
 
 		template <typename T>
@@ -18,55 +163,214 @@ namespace overdrive {
 		template <typename T>
 		template <typename U>
 		void ChannelQueue<T>::add(U* handler) {
-			ScopedLock lock(mMutex);
+			{
+				ScopedLock lock(mMutex);
+
+				auto newList = new HandlerList(*mHandlers.load());
+				newList->push_back(Handler{
+					&ChannelQueue::invoke<U>,
+					&ChannelQueue::invokeBatch<U>,
+					handler
+				});
 
-			mHandlers.push_back([handler](const T& message) { (*handler)(message); });
-			mOriginalPointers.push_back(handler);
+				publish(newList);
+			}
+
+			reclaim();
 		}
 
 		template <typename T>
 		template <typename U>
 		void ChannelQueue<T>::remove(U* handler) {
-			using namespace std;
+			{
+				ScopedLock lock(mMutex);
 
-			ScopedLock lock(mMutex);
+				const HandlerList* current = mHandlers.load();
+				void* object = handler;
 
-			auto it = find(begin(mOriginalPointers), end(mOriginalPointers), handler);
-			if (it == end(mOriginalPointers))
-				throw std::runtime_error("Tried to remove a handler that was not registered");
+				auto it = std::find_if(
+					current->begin(),
+					current->end(),
+					[object](const Handler& h) { return h.mObject == object; }
+				);
 
-			auto idx = it - begin(mOriginalPointers);
+				if (it == current->end())
+					throw std::runtime_error("Tried to remove a handler that was not registered");
 
-			mHandlers.erase(mHandlers.begin() + idx);
-			mOriginalPointers.erase(it);
+				auto newList = new HandlerList;
+				newList->reserve(current->size() - 1);
+				newList->insert(newList->end(), current->begin(), it);
+				newList->insert(newList->end(), it + 1, current->end());
+
+				publish(newList);
+			}
+
+			reclaim();
 		}
 
 		template <typename T>
 		void ChannelQueue<T>::removeAll() {
-			ScopedLock lock(mMutex);
+			{
+				ScopedLock lock(mMutex);
+
+				publish(new HandlerList);
+			}
 
-			mHandlers.clear();
-			mOriginalPointers.clear();
+			reclaim();
 		}
 
 		template <typename T>
 		size_t ChannelQueue<T>::getNumHandlers() const {
-			ScopedLock lock(mMutex);
-			return mHandlers.size();
+			ReadGuard guard(this);
+			return mHandlers.load()->size();
 		}
 
 		template <typename T>
 		void ChannelQueue<T>::broadcast(const T& message) {
-			std::vector<Handler> localQueue;
-			localQueue.reserve(mHandlers.size());
+			ReadGuard guard(this);
+
+			const HandlerList* handlers = mHandlers.load();
+
+			for (const auto& handler : *handlers)
+				handler.mFunction(handler.mObject, message);
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::post(const T& message) {
+			static_assert(std::is_default_constructible<T>::value, "Posted messages must be default-constructible");
+			static_assert(std::is_copy_assignable<T>::value, "Posted messages must be copy-assignable");
+
+			getThreadRing()->push(message);
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::dispatchPosted() {
+			ScopedLock dispatchLock(mDispatchMutex);
+
+			mPosted.clear();
+
+			{
+				ScopedLock lock(mRingMutex);
+
+				for (auto it = mRings.begin(); it != mRings.end();) {
+					// check before draining, so everything the thread pushed before exiting is drained as well
+					bool isAbandoned = (*it)->isAbandoned();
+
+					(*it)->drain(mPosted);
+
+					if (isAbandoned)
+						it = mRings.erase(it);
+					else
+						++it;
+				}
+			}
+
+			if (mPosted.empty())
+				return;
+
+			MessageBatch<T> batch{ mPosted.data(), mPosted.size() };
+
+			ReadGuard guard(this);
+
+			const HandlerList* handlers = mHandlers.load();
+
+			for (const auto& handler : *handlers)
+				handler.mBatchFunction(handler.mObject, batch);
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::setSyncPoint(const std::string& syncPoint) {
+			ScopedLock lock(mRingMutex);
+			mSyncPoint = syncPoint;
+		}
+
+		template <typename T>
+		std::string ChannelQueue<T>::getSyncPoint() const {
+			ScopedLock lock(mRingMutex);
+			return mSyncPoint;
+		}
+
+		template <typename T>
+		template <typename U>
+		void ChannelQueue<T>::invoke(void* object, const T& message) {
+			(*static_cast<U*>(object))(message);
+		}
+
+		template <typename T>
+		template <typename U>
+		void ChannelQueue<T>::invokeBatch(void* object, const MessageBatch<T>& batch) {
+			detail::deliverBatch(
+				static_cast<U*>(object),
+				batch,
+				detail::AcceptsBatch<U, T>()
+			);
+		}
+
+		template <typename T>
+		typename ChannelQueue<T>::PostRing* ChannelQueue<T>::getThreadRing() {
+			static thread_local ThreadRing local;
+
+			if (!local.mRing) {
+				ScopedLock lock(mRingMutex);
+
+				mRings.push_back(std::make_unique<PostRing>());
+				local.mRing = mRings.back().get();
+
+				if (!mIsRegistered) {
+					detail::registerPostedQueue(this);
+					mIsRegistered = true;
+				}
+			}
+
+			return local.mRing;
+		}
+
+		template <typename T>
+		int& ChannelQueue<T>::broadcastDepth() {
+			static thread_local int depth = 0;
+			return depth;
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::publish(HandlerList* newList) {
+			mRetired.push_back(mHandlers.exchange(newList));
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::reclaim() {
+			// when called from within a handler our own broadcast is still reading, so defer the cleanup
+			if (broadcastDepth() > 0)
+				return;
+
+			std::vector<HandlerList*> retired;
 
 			{
 				ScopedLock lock(mMutex);
-				localQueue = mHandlers;
+				retired.swap(mRetired);
+			}
+
+			if (retired.empty())
+				return;
+
+			// lists retired after the swap are left for the next reclaim, so modifications don't have to wait for us
+			{
+				ScopedLock lock(mSyncMutex);
+				synchronize();
 			}
 
-			for (auto& handler: localQueue)
-				handler(message);
+			for (auto list : retired)
+				delete list;
+		}
+
+		template <typename T>
+		void ChannelQueue<T>::synchronize() const {
+			// two grace periods; after the second one every broadcast that could have seen a retired list is done
+			for (int i = 0; i < 2; ++i) {
+				size_t previous = mEpoch.fetch_add(1) & 1;
+
+				while (mReaders[previous].load() != 0)
+					std::this_thread::yield();
+			}
 		}
 	}
-}
\ No newline at end of file
+}
@@ -1,9 +1,12 @@
 #include "stdafx.h"
 #include "engine.h"
 #include "channel.h"
+#include "frame_allocator.h"
 #include "logger.h"
 #include "../app/application.h"
 #include "../opengl.h"
+#include <cassert>
+#include <functional>
 
 namespace {
 	std::string intepretGLFWerrorcode(int code) {
@@ -30,7 +33,8 @@ namespace {
 namespace overdrive {
 	namespace core {
 		Engine::Engine():
-			mRunning(false)
+			mRunning(false),
+			mFrameGraphDirty(true)
 		{
 			Channel::add<OnStop>(this);
 		}
@@ -60,6 +64,8 @@ namespace overdrive {
 
 				mSystemLookup[s->getName()] = s.get();
 				mSystems.push_back(std::move(s));
+
+				mFrameGraphDirty = true;
 			}
 			else {
 				auto ptr = s.release();
@@ -96,6 +102,7 @@ namespace overdrive {
 				s->shutdown();
 
 				mSystems.erase(it);
+				mFrameGraphDirty = true;
 
 				for (auto jt = mSystemLookup.begin(); jt != mSystemLookup.end(); ++jt) {
 					if (jt->second == s) {
@@ -123,6 +130,24 @@ namespace overdrive {
 			return true;
 		}
 
+		bool intersects(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+			for (const auto& resource : a)
+				if (std::find(b.begin(), b.end(), resource) != b.end())
+					return true;
+
+			return false;
+		}
+
+		bool conflicting(const System* a, const System* b) {
+			if (!a->hasDeclaredAccess() || !b->hasDeclaredAccess())
+				return true;
+
+			return
+				intersects(a->getWrites(), b->getWrites()) ||
+				intersects(a->getWrites(), b->getReads()) ||
+				intersects(a->getReads(), b->getWrites());
+		}
+
 		void Engine::run() {
 			initialize();
 
@@ -130,9 +155,11 @@ namespace overdrive {
 
 			while (mRunning) {
 				mClock.update();
+				FrameAllocator::nextFrameAll();
+				mJobSystem->tryFence(); // skipped while a job that ran on the main thread is still alive
 
-				for (auto& system: mSystems)
-					system->update();
+				updateSystems();
+				Channel::dispatchPosted();
 
 				if (mApplication)
 					mApplication->update();
@@ -142,7 +169,9 @@ namespace overdrive {
 				mApplication->shutdown();
 
 			for (auto it = mInitOrder.rbegin(); it != mInitOrder.rend(); ++it)
-				(*it)->shutdown();			
+				(*it)->shutdown();
+
+			mJobSystem.reset();
 		}
 
 		void Engine::stop() {
@@ -153,6 +182,11 @@ namespace overdrive {
 			return mClock;
 		}
 
+		JobSystem& Engine::getJobSystem() {
+			assert(mJobSystem);
+			return *mJobSystem;
+		}
+
 		void Engine::operator()(const OnStop&) {
 			mRunning = false;
 		}
@@ -162,6 +196,8 @@ namespace overdrive {
 
 			initLibraries();
 
+			mJobSystem = std::make_unique<JobSystem>();
+
 			{
 				// consolidate settings, load configuration and apply them
 
@@ -222,6 +258,94 @@ namespace overdrive {
 			}
 		}
 
+		void Engine::buildFrameGraph() {
+			size_t numSystems = mSystems.size();
+
+			mFrameGraph.clear();
+			mFrameGraph.resize(numSystems);
+			mFramePending.reset(new std::atomic<size_t>[numSystems]);
+
+			for (size_t i = 0; i < numSystems; ++i) {
+				auto& node = mFrameGraph[i];
+
+				node.mSystem = mSystems[i].get();
+				node.mMainThread = !node.mSystem->hasDeclaredAccess();
+				node.mNumPredecessors = 0;
+
+				// conflicting systems are updated in the order in which they were added
+				for (size_t j = 0; j < i; ++j) {
+					if (conflicting(mFrameGraph[j].mSystem, node.mSystem)) {
+						mFrameGraph[j].mSuccessors.push_back(i);
+						++node.mNumPredecessors;
+					}
+				}
+			}
+
+			mFrameGraphDirty = false;
+		}
+
+		void Engine::updateSystems() {
+			if (mFrameGraphDirty)
+				buildFrameGraph();
+
+			size_t numSystems = mFrameGraph.size();
+			std::atomic<size_t> numCompleted(0);
+			JobHandle frameJobs;
+
+			std::function<void(size_t)> complete;
+
+			auto launch = [&](size_t idx) {
+				mJobSystem->schedule([&, idx] {
+					mFrameGraph[idx].mSystem->update();
+					complete(idx);
+				}, frameJobs);
+			};
+
+			complete = [&](size_t idx) {
+				for (auto successor : mFrameGraph[idx].mSuccessors) {
+					if (
+						(mFramePending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) &&
+						(!mFrameGraph[successor].mMainThread)
+					)
+						launch(successor);
+				}
+
+				numCompleted.fetch_add(1, std::memory_order_release);
+			};
+
+			for (size_t i = 0; i < numSystems; ++i)
+				mFramePending[i].store(mFrameGraph[i].mNumPredecessors, std::memory_order_relaxed);
+
+			for (size_t i = 0; i < numSystems; ++i)
+				if ((mFrameGraph[i].mNumPredecessors == 0) && (!mFrameGraph[i].mMainThread))
+					launch(i);
+
+			// the main thread updates the systems that require it, and helps out with the rest in the meantime
+			FrameVector<char> started(numSystems, false, FrameAllocator::local().getResource());
+
+			while (numCompleted.load(std::memory_order_acquire) < numSystems) {
+				bool progress = false;
+
+				for (size_t i = 0; i < numSystems; ++i) {
+					if (
+						(mFrameGraph[i].mMainThread) &&
+						(!started[i]) &&
+						(mFramePending[i].load(std::memory_order_acquire) == 0)
+					) {
+						started[i] = true;
+						mFrameGraph[i].mSystem->update();
+						complete(i);
+						progress = true;
+					}
+				}
+
+				if (!progress && !mJobSystem->tryRunJob())
+					std::this_thread::yield();
+			}
+
+			mJobSystem->wait(frameJobs);
+		}
+
 		void Engine::initLibraries() {
 			// [NOTE] GLEW requires an active openGL context, so it cannot be initialized here
 			//        it is initialized in the Video subsystem instead
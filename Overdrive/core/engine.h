@@ -6,6 +6,7 @@
 #include "system.h"
 #include "settings.h"
 #include "clock.h"
+#include "job_system.h"
 
 namespace overdrive {
 	namespace app {
@@ -38,6 +39,7 @@ namespace overdrive {
 			void stop();
 
 			const Clock& getClock() const;
+			JobSystem& getJobSystem();
 
 			// ----- Signals -----
 			struct OnStop {};
@@ -52,6 +54,18 @@ namespace overdrive {
 			void initLibraries(); 
 			void shutdownLibraries();
 
+			// systems are ordered in a dependency graph based on the resources they read/write,
+			// independent systems are updated in parallel via the job system
+			void buildFrameGraph();
+			void updateSystems();
+
+			struct FrameNode {
+				System* mSystem;
+				bool mMainThread; // systems without declared access are updated on the main thread
+				size_t mNumPredecessors;
+				std::vector<size_t> mSuccessors;
+			};
+
 			SystemList mSystems;
 			SystemMapping mSystemLookup;
 			Settings mSettings;
@@ -61,6 +75,11 @@ namespace overdrive {
 			std::unique_ptr<app::Application> mApplication;
 
 			std::vector<System*> mInitOrder; // order in which the systems were initialized
+
+			std::unique_ptr<JobSystem> mJobSystem;
+			std::vector<FrameNode> mFrameGraph;
+			std::unique_ptr<std::atomic<size_t>[]> mFramePending; // number of unfinished predecessors per node (reset every frame)
+			bool mFrameGraphDirty;
 		};
 	}
 }
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+namespace overdrive {
+	namespace core {
+		/*
+			Thin wrapper around platform fibers (cooperatively scheduled execution contexts)
+			Windows uses the native fiber API, linux uses ucontext.
+
+			A thread must be converted to a fiber before it can switch to other fibers;
+			switchTo should only be called from the fiber that is currently running on the calling thread.
+
+			[NOTE] the entry point of a fiber must never return, switch to another fiber instead
+			[NOTE] fibers may be resumed on a different thread than they were suspended on, so don't
+			       hold on to thread-local data across a switch
+		*/
+		class Fiber {
+		public:
+			typedef void (*EntryPoint)(void* userData);
+
+			Fiber(EntryPoint entry, void* userData, size_t stackSize);
+			~Fiber();
+
+			Fiber(const Fiber&) = delete;
+			Fiber& operator = (const Fiber&) = delete;
+
+			static std::unique_ptr<Fiber> convertCurrentThread(); // the thread is restored when the resulting Fiber is destroyed
+
+			void switchTo(Fiber& target);
+
+			struct Context; // platform-specific
+
+		private:
+			Fiber(); // used for thread conversion
+
+			std::unique_ptr<Context> mContext;
+		};
+	}
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "fiber.h"
+#include "../preprocessor.h"
+
+#if OVERDRIVE_PLATFORM == OVERDRIVE_PLATFORM_LINUX
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+namespace overdrive {
+	namespace core {
+		struct Fiber::Context {
+			ucontext_t mContext;
+
+			void* mStack = nullptr;
+			size_t mStackSize = 0; // includes the guard page
+
+			EntryPoint mEntry = nullptr;
+			void* mUserData = nullptr;
+		};
+
+		namespace {
+			// makecontext only passes int arguments, so the context pointer is split in two
+			void fiberStart(unsigned int lo, unsigned int hi) {
+				auto address = (static_cast<uintptr_t>(hi) << 32) | static_cast<uintptr_t>(lo);
+				auto context = reinterpret_cast<Fiber::Context*>(address);
+
+				context->mEntry(context->mUserData);
+			}
+		}
+
+		Fiber::Fiber():
+			mContext(std::make_unique<Context>())
+		{
+		}
+
+		Fiber::Fiber(
+			EntryPoint entry,
+			void* userData,
+			size_t stackSize
+		):
+			mContext(std::make_unique<Context>())
+		{
+			size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+			// round up to whole pages, add a guard page at the bottom to catch stack overflows
+			stackSize = ((stackSize + pageSize - 1) / pageSize) * pageSize + pageSize;
+
+			void* stack = mmap(
+				nullptr,
+				stackSize,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS,
+				-1,
+				0
+			);
+
+			if (stack == MAP_FAILED)
+				throw std::runtime_error("Failed to allocate fiber stack");
+
+			if (mprotect(stack, pageSize, PROT_NONE) != 0) {
+				// without the guard page an overflow silently corrupts whatever is mapped below the stack
+				int error = errno;
+				munmap(stack, stackSize);
+
+				throw std::runtime_error(std::string("Failed to protect fiber stack guard page: ") + std::strerror(error));
+			}
+
+			mContext->mStack = stack;
+			mContext->mStackSize = stackSize;
+			mContext->mEntry = entry;
+			mContext->mUserData = userData;
+
+			getcontext(&mContext->mContext);
+
+			mContext->mContext.uc_stack.ss_sp = stack;
+			mContext->mContext.uc_stack.ss_size = stackSize;
+			mContext->mContext.uc_link = nullptr;
+
+			auto address = reinterpret_cast<uintptr_t>(mContext.get());
+
+			makecontext(
+				&mContext->mContext,
+				reinterpret_cast<void(*)()>(&fiberStart),
+				2,
+				static_cast<unsigned int>(address & 0xFFFFFFFF),
+				static_cast<unsigned int>(address >> 32)
+			);
+		}
+
+		Fiber::~Fiber() {
+			if (mContext->mStack)
+				munmap(mContext->mStack, mContext->mStackSize);
+		}
+
+		std::unique_ptr<Fiber> Fiber::convertCurrentThread() {
+			// the context of a converted thread is filled in when switching away from it
+			return std::unique_ptr<Fiber>(new Fiber);
+		}
+
+		void Fiber::switchTo(Fiber& target) {
+			swapcontext(&mContext->mContext, &target.mContext->mContext);
+		}
+	}
+}
+
+#endif
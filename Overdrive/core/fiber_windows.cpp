@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "fiber.h"
+#include "../preprocessor.h"
+
+#if OVERDRIVE_PLATFORM == OVERDRIVE_PLATFORM_WINDOWS
+
+#include "../util/exception_windows.h"
+
+namespace overdrive {
+	namespace core {
+		struct Fiber::Context {
+			LPVOID mHandle = nullptr;
+			bool mIsConvertedThread = false;
+			bool mOwnsConversion = false; // if the thread already was a fiber, leave it that way
+
+			EntryPoint mEntry = nullptr;
+			void* mUserData = nullptr;
+		};
+
+		namespace {
+			void WINAPI fiberStart(LPVOID parameter) {
+				auto context = static_cast<Fiber::Context*>(parameter);
+				context->mEntry(context->mUserData);
+			}
+		}
+
+		Fiber::Fiber():
+			mContext(std::make_unique<Context>())
+		{
+		}
+
+		Fiber::Fiber(
+			EntryPoint entry,
+			void* userData,
+			size_t stackSize
+		):
+			mContext(std::make_unique<Context>())
+		{
+			mContext->mEntry = entry;
+			mContext->mUserData = userData;
+			// only reserve the stack, pages are committed as it grows (the guard page is managed by the OS)
+			mContext->mHandle = ::CreateFiberEx(0, stackSize, 0, &fiberStart, mContext.get());
+
+			if (!mContext->mHandle)
+				throw util::WinException();
+		}
+
+		Fiber::~Fiber() {
+			if (mContext->mIsConvertedThread) {
+				if (mContext->mOwnsConversion)
+					::ConvertFiberToThread();
+			}
+			else if (mContext->mHandle)
+				::DeleteFiber(mContext->mHandle);
+		}
+
+		std::unique_ptr<Fiber> Fiber::convertCurrentThread() {
+			std::unique_ptr<Fiber> result(new Fiber);
+
+			result->mContext->mIsConvertedThread = true;
+
+			if (::IsThreadAFiber())
+				result->mContext->mHandle = ::GetCurrentFiber();
+			else {
+				result->mContext->mHandle = ::ConvertThreadToFiber(nullptr);
+				result->mContext->mOwnsConversion = true;
+			}
+
+			if (!result->mContext->mHandle)
+				throw util::WinException();
+
+			return result;
+		}
+
+		void Fiber::switchTo(Fiber& target) {
+			::SwitchToFiber(target.mContext->mHandle);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include "stdafx.h"
+#include "frame_allocator.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+
+namespace overdrive {
+	namespace core {
+		namespace {
+			// the current frame number and the stats of the per-thread allocators
+			struct Registry {
+				std::atomic<uint64_t> mFrame{ 0 };
+
+				std::mutex mMutex;
+				AllocatorStats mFrameStats;		// allocators advanced during the current frame
+				AllocatorStats mLastFrameStats;
+
+				static Registry& instance() {
+					static Registry result;
+					return result;
+				}
+			};
+
+			struct ThreadAllocator {
+				ThreadAllocator(size_t numFrames):
+					mAllocator(FrameAllocator::DEFAULT_FRAME_SIZE, numFrames),
+					mFrame(Registry::instance().mFrame.load(std::memory_order_acquire))
+				{
+				}
+
+				// owner thread only
+				void advance(uint64_t frame) {
+					auto& registry = Registry::instance();
+
+					{
+						std::lock_guard<std::mutex> lock(registry.mMutex);
+						registry.mFrameStats += mAllocator.getStats();
+					}
+
+					// missing a couple of frames only needs a single pass over the buffered frames
+					uint64_t numFrames = std::min<uint64_t>(frame - mFrame, mAllocator.getNumFrames());
+
+					for (uint64_t i = 0; i < numFrames; ++i)
+						mAllocator.nextFrame();
+
+					mFrame = frame;
+				}
+
+				FrameAllocator mAllocator;
+				uint64_t mFrame; // the frame the allocator was last advanced to
+			};
+
+			// created on first use, so fence() doesn't allocate frames for threads that never use them
+			struct ThreadAllocators {
+				std::unique_ptr<ThreadAllocator> mLocal;
+				std::unique_ptr<ThreadAllocator> mBuffered;
+			};
+
+			thread_local ThreadAllocators tAllocators;
+		}
+
+		// ----- FrameAllocator::Resource -----
+		FrameAllocator::Resource::Resource(FrameAllocator* owner):
+			mOwner(owner)
+		{
+		}
+
+		void* FrameAllocator::Resource::do_allocate(size_t numBytes, size_t alignment) {
+			return mOwner->allocate(numBytes, alignment);
+		}
+
+		void FrameAllocator::Resource::do_deallocate(void*, size_t, size_t) {
+			// released when the frame is recycled
+		}
+
+		bool FrameAllocator::Resource::do_is_equal(const MemoryResource& other) const noexcept {
+			return this == &other;
+		}
+
+		// ----- FrameAllocator -----
+		FrameAllocator::FrameAllocator(
+			size_t bytesPerFrame,
+			size_t numFrames
+		):
+			mCurrentFrame(0),
+			mResource(this)
+		{
+			assert(numFrames > 0);
+
+			for (size_t i = 0; i < numFrames; ++i)
+				mFrames.push_back(std::make_unique<LinearAllocator>(bytesPerFrame));
+		}
+
+		void* FrameAllocator::allocate(size_t numBytes, size_t alignment) {
+			return mFrames[mCurrentFrame]->allocate(numBytes, alignment);
+		}
+
+		void FrameAllocator::nextFrame() {
+			mCurrentFrame = (mCurrentFrame + 1) % mFrames.size();
+			mFrames[mCurrentFrame]->reset();
+		}
+
+		size_t FrameAllocator::getNumFrames() const {
+			return mFrames.size();
+		}
+
+		const AllocatorStats& FrameAllocator::getStats() const {
+			return mFrames[mCurrentFrame]->getStats();
+		}
+
+		FrameAllocator::MemoryResource* FrameAllocator::getResource() {
+			return &mResource;
+		}
+
+		FrameAllocator& FrameAllocator::local() {
+			if (!tAllocators.mLocal)
+				tAllocators.mLocal = std::make_unique<ThreadAllocator>(1);
+
+			return tAllocators.mLocal->mAllocator;
+		}
+
+		FrameAllocator& FrameAllocator::localBuffered() {
+			if (!tAllocators.mBuffered)
+				tAllocators.mBuffered = std::make_unique<ThreadAllocator>(2);
+
+			return tAllocators.mBuffered->mAllocator;
+		}
+
+		void FrameAllocator::nextFrameAll() {
+			auto& registry = Registry::instance();
+
+			{
+				std::lock_guard<std::mutex> lock(registry.mMutex);
+
+				registry.mLastFrameStats = registry.mFrameStats;
+				registry.mFrameStats = AllocatorStats();
+			}
+
+			registry.mFrame.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		void FrameAllocator::fence() {
+			uint64_t frame = Registry::instance().mFrame.load(std::memory_order_acquire);
+
+			if (tAllocators.mLocal && (tAllocators.mLocal->mFrame != frame))
+				tAllocators.mLocal->advance(frame);
+
+			if (tAllocators.mBuffered && (tAllocators.mBuffered->mFrame != frame))
+				tAllocators.mBuffered->advance(frame);
+		}
+
+		AllocatorStats FrameAllocator::getLastFrameStats() {
+			auto& registry = Registry::instance();
+			std::lock_guard<std::mutex> lock(registry.mMutex);
+
+			return registry.mLastFrameStats;
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "linear_allocator.h"
+#include <boost/container/pmr/memory_resource.hpp>
+#include <boost/container/pmr/vector.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace overdrive {
+	namespace core {
+		/*
+			Scratch memory that only lives for a limited number of frames. Memory allocated during a frame
+			stays valid until nextFrame() has been called numFrames times, after which it is reused wholesale
+			(no destructors are run, so only put trivially destructible things in here or clean up manually).
+
+			local() and localBuffered() provide a per-thread instance. The Engine starts a new frame with
+			nextFrameAll(), but the per-thread instances are only advanced by their own thread, once it
+			reaches a fence() -- a point where it no longer refers to frame memory of earlier frames.
+			JobSystem workers fence between jobs, as long as no job that ran on them is still alive (a long
+			running background job keeps the memory of the workers it ran on valid until it finishes).
+			Containers can use the memory through getResource(), for example:
+
+				FrameVector<Entity*> visible(FrameAllocator::local().getResource());
+
+			[NOTE] a FrameAllocator is not threadsafe, a per-thread instance is only used by its own thread
+			[NOTE] threads that aren't owned by the JobSystem have to call fence() themselves, otherwise their
+			       per-thread instances are never recycled
+		*/
+		class FrameAllocator {
+		public:
+			typedef boost::container::pmr::memory_resource MemoryResource;
+
+			static const size_t DEFAULT_FRAME_SIZE = 1024 * 1024; // 1MB, grows when exceeded
+
+			explicit FrameAllocator(
+				size_t bytesPerFrame = DEFAULT_FRAME_SIZE,
+				size_t numFrames = 1
+			);
+
+			FrameAllocator(const FrameAllocator&) = delete;
+			FrameAllocator& operator = (const FrameAllocator&) = delete;
+
+			void* allocate(size_t numBytes, size_t alignment = alignof(std::max_align_t));
+
+			template <typename T>
+			T* allocate(size_t count); // uninitialized storage for count T's
+
+			void nextFrame(); // releases the memory of the oldest frame
+
+			size_t getNumFrames() const;
+			const AllocatorStats& getStats() const; // for the current frame
+			MemoryResource* getResource();
+
+			static FrameAllocator& local();			// valid until the next frame
+			static FrameAllocator& localBuffered(); // valid until the end of the next frame
+
+			static void nextFrameAll(); // starts the next frame, per-thread allocators catch up at their next fence
+			static void fence(); // advances the per-thread allocators of the calling thread to the current frame
+			static AllocatorStats getLastFrameStats(); // combined stats of the per-thread allocators that were advanced during the previous frame
+
+		private:
+			class Resource:
+				public MemoryResource
+			{
+			public:
+				explicit Resource(FrameAllocator* owner);
+
+			protected:
+				virtual void* do_allocate(size_t numBytes, size_t alignment) override;
+				virtual void do_deallocate(void* p, size_t numBytes, size_t alignment) override;
+				virtual bool do_is_equal(const MemoryResource& other) const noexcept override;
+
+			private:
+				FrameAllocator* mOwner;
+			};
+
+			std::vector<std::unique_ptr<LinearAllocator>> mFrames;
+			size_t mCurrentFrame;
+			Resource mResource;
+		};
+
+		template <typename T>
+		using FrameVector = boost::container::pmr::vector<T>;
+	}
+}
+
+#include "frame_allocator.inl"
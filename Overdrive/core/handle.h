@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace overdrive {
+	namespace core {
+		/*
+			Generational handle into a Pool. The generation of a live object is always odd, so a
+			default-constructed handle never refers to anything.
+		*/
+		template <typename T>
+		struct Handle {
+			uint32_t mIndex = 0;
+			uint32_t mGeneration = 0;
+
+			bool isNull() const;
+			explicit operator bool() const;
+
+			bool operator == (const Handle& h) const;
+			bool operator != (const Handle& h) const;
+		};
+	}
+}
+
+namespace std {
+	template <typename T>
+	struct hash<overdrive::core::Handle<T>> {
+		size_t operator()(const overdrive::core::Handle<T>& h) const;
+	};
+}
+
+#include "handle.inl"
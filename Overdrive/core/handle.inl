@@ -0,0 +1,36 @@
+#pragma once
+
+#include "handle.h"
+
+namespace overdrive {
+	namespace core {
+		template <typename T>
+		bool Handle<T>::isNull() const {
+			return mGeneration == 0;
+		}
+
+		template <typename T>
+		Handle<T>::operator bool() const {
+			return !isNull();
+		}
+
+		template <typename T>
+		bool Handle<T>::operator == (const Handle& h) const {
+			return
+				(mIndex == h.mIndex) &&
+				(mGeneration == h.mGeneration);
+		}
+
+		template <typename T>
+		bool Handle<T>::operator != (const Handle& h) const {
+			return !(*this == h);
+		}
+	}
+}
+
+namespace std {
+	template <typename T>
+	size_t hash<overdrive::core::Handle<T>>::operator()(const overdrive::core::Handle<T>& h) const {
+		return std::hash<uint64_t>()((static_cast<uint64_t>(h.mGeneration) << 32) | h.mIndex);
+	}
+}
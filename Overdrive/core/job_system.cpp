@@ -0,0 +1,466 @@
+#include "stdafx.h"
+#include "job_system.h"
+#include "frame_allocator.h"
+#include "logger.h"
+#include "../preprocessor.h"
+#include <algorithm>
+#include <cassert>
+
+namespace overdrive {
+	namespace core {
+		namespace {
+			thread_local JobSystem* tCurrentJobSystem = nullptr;
+			thread_local size_t tCurrentWorkerIndex = JobSystem::NOT_A_WORKER;
+			thread_local void* tCurrentThreadState = nullptr;
+			thread_local char tThreadContext; // only the address is used
+
+			// [NOTE] a fiber may resume on a different thread than the one it was suspended on; the compiler
+			//        is allowed to cache the address of a thread_local across the switch, so always
+			//        re-fetch them through functions that cannot be inlined
+			NOINLINE void* fetchThreadState() {
+				return tCurrentThreadState;
+			}
+
+			NOINLINE size_t fetchWorkerIndex(const JobSystem* system) {
+				if (tCurrentJobSystem == system)
+					return tCurrentWorkerIndex;
+
+				return JobSystem::NOT_A_WORKER;
+			}
+
+			const size_t FIBERS_PER_WORKER = 4; // initial pool size, grows on demand
+		}
+
+		// ----- JobHandle -----
+		JobHandle::JobHandle():
+			mCounter(std::make_shared<std::atomic<int>>(0))
+		{
+		}
+
+		bool JobHandle::isDone() const {
+			return (mCounter->load(std::memory_order_acquire) == 0);
+		}
+
+		int JobHandle::getNumPending() const {
+			return mCounter->load(std::memory_order_acquire);
+		}
+
+		bool JobHandle::operator == (const JobHandle& handle) const {
+			return mCounter == handle.mCounter;
+		}
+
+		bool JobHandle::operator != (const JobHandle& handle) const {
+			return mCounter != handle.mCounter;
+		}
+
+		// ----- JobSystem::WorkQueue -----
+		void JobSystem::WorkQueue::push(Task&& task) {
+			std::lock_guard<util::Spinlock> lock(mLock);
+			mTasks.push_back(std::move(task));
+		}
+
+		bool JobSystem::WorkQueue::pop(Task& task) {
+			std::lock_guard<util::Spinlock> lock(mLock);
+
+			if (mTasks.empty())
+				return false;
+
+			task = std::move(mTasks.back());
+			mTasks.pop_back();
+
+			return true;
+		}
+
+		bool JobSystem::WorkQueue::steal(Task& task) {
+			std::lock_guard<util::Spinlock> lock(mLock);
+
+			if (mTasks.empty())
+				return false;
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+
+			return true;
+		}
+
+		// ----- JobSystem -----
+		JobSystem::JobSystem(
+			size_t numThreads,
+			size_t fiberStackSize
+		):
+			mIsDone(false),
+			mNumQueued(0),
+			mNextQueue(0),
+			mFiberStackSize(fiberStackSize),
+			mNumWaiting(0)
+		{
+			if (numThreads == 0)
+				numThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+			for (size_t i = 0; i < numThreads; ++i)
+				mQueues.push_back(std::make_unique<WorkQueue>());
+
+			for (size_t i = 0; i < numThreads * FIBERS_PER_WORKER; ++i)
+				releaseFiber(acquireFiber());
+
+			// the calling thread is worker 0
+			mMainThreadState = std::make_unique<ThreadState>();
+			mMainThreadState->mThreadFiber = Fiber::convertCurrentThread();
+
+			tCurrentJobSystem = this;
+			tCurrentWorkerIndex = 0;
+			tCurrentThreadState = mMainThreadState.get();
+
+			for (size_t i = 1; i < numThreads; ++i)
+				mThreads.emplace_back(&JobSystem::workerThread, this, i);
+
+			gLog << "JobSystem started with " << numThreads << " workers";
+		}
+
+		JobSystem::~JobSystem() {
+			{
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+				mIsDone = true;
+			}
+
+			mWakeCondition.notify_all();
+
+			for (auto& thread : mThreads)
+				thread.join();
+
+			if (!mWaitingFibers.empty())
+				gLogWarning << "JobSystem shut down with " << mWaitingFibers.size() << " jobs still waiting";
+
+			if (tCurrentJobSystem == this) {
+				tCurrentJobSystem = nullptr;
+				tCurrentWorkerIndex = NOT_A_WORKER;
+				tCurrentThreadState = nullptr;
+			}
+		}
+
+		JobHandle JobSystem::schedule(Job job) {
+			JobHandle result;
+			schedule(std::move(job), result);
+			return result;
+		}
+
+		void JobSystem::schedule(Job job, JobHandle& handle) {
+			handle.mCounter->fetch_add(1, std::memory_order_relaxed);
+
+			push(Task{ std::move(job), handle.mCounter });
+		}
+
+		void JobSystem::wait(const JobHandle& handle) {
+			auto state = static_cast<ThreadState*>(fetchThreadState());
+
+			if ((getCurrentWorkerIndex() != NOT_A_WORKER) && state && state->mCurrent) {
+				// running on a job fiber, park it until the handle is done
+				while (!handle.isDone()) {
+					auto self = state->mCurrent;
+
+					state->mSwitchReason = eSwitchReason::WAITING;
+					state->mWaitCounter = handle.mCounter;
+
+					self->mFiber->switchTo(*state->mThreadFiber);
+
+					// we may have been resumed by another worker
+					state = static_cast<ThreadState*>(fetchThreadState());
+				}
+
+				return;
+			}
+
+			while (!handle.isDone()) {
+				if (!tryRunJob())
+					std::this_thread::yield();
+			}
+		}
+
+		bool JobSystem::tryRunJob() {
+			auto state = static_cast<ThreadState*>(fetchThreadState());
+
+			if ((getCurrentWorkerIndex() == NOT_A_WORKER) || !state || state->mCurrent) {
+				// no scheduler fiber available, run inline
+				Task task;
+
+				if (!takeTask(task))
+					return false;
+
+				execute(task);
+				return true;
+			}
+
+			JobFiber* fiber = takeResumableFiber();
+
+			if (!fiber) {
+				Task task;
+
+				if (!takeTask(task))
+					return false;
+
+				fiber = acquireFiber();
+				fiber->mTask = std::move(task);
+			}
+
+			runFiber(state, fiber);
+
+			return true;
+		}
+
+		void JobSystem::hold(JobHandle& handle) {
+			handle.mCounter->fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void JobSystem::release(JobHandle& handle) {
+			bool completed = (handle.mCounter->fetch_sub(1, std::memory_order_release) == 1);
+
+			// same as a finished job, a parked fiber may be waiting for this
+			if (completed && (mNumWaiting.load(std::memory_order_acquire) > 0))
+				wake();
+		}
+
+		bool JobSystem::tryFence() {
+			auto state = static_cast<ThreadState*>(fetchThreadState());
+
+			if ((getCurrentWorkerIndex() != NOT_A_WORKER) && state) {
+				if (state->mCurrent || (state->mNumLiveJobs.load(std::memory_order_acquire) > 0))
+					return false;
+			}
+
+			FrameAllocator::fence();
+
+			return true;
+		}
+
+		size_t JobSystem::getNumWorkers() const {
+			return mQueues.size();
+		}
+
+		size_t JobSystem::getCurrentWorkerIndex() const {
+			return fetchWorkerIndex(this);
+		}
+
+		size_t JobSystem::getNumFibers() const {
+			return mFibers.size();
+		}
+
+		const void* JobSystem::getCurrentContext() {
+			auto state = static_cast<ThreadState*>(fetchThreadState());
+
+			if (state && state->mCurrent)
+				return state->mCurrent;
+
+			return &tThreadContext;
+		}
+
+		void JobSystem::fiberEntry(void* jobFiber) {
+			auto self = static_cast<JobFiber*>(jobFiber);
+			self->mOwner->fiberLoop(self);
+		}
+
+		void JobSystem::fiberLoop(JobFiber* self) {
+			// pooled fibers are re-used, this never returns
+			while (true) {
+				execute(self->mTask);
+				self->mTask = Task();
+
+				auto state = static_cast<ThreadState*>(fetchThreadState());
+				state->mSwitchReason = eSwitchReason::FINISHED;
+
+				self->mFiber->switchTo(*state->mThreadFiber);
+			}
+		}
+
+		bool JobSystem::takeTask(Task& task) {
+			size_t numQueues = mQueues.size();
+			size_t self = getCurrentWorkerIndex();
+
+			bool found = false;
+
+			if (self != NOT_A_WORKER)
+				found = mQueues[self]->pop(task);
+			else
+				self = 0;
+
+			// steal from the other workers, starting with the next one over
+			for (size_t i = 1; (i <= numQueues) && !found; ++i)
+				found = mQueues[(self + i) % numQueues]->steal(task);
+
+			if (found)
+				mNumQueued.fetch_sub(1, std::memory_order_relaxed);
+
+			return found;
+		}
+
+		void JobSystem::push(Task&& task) {
+			size_t idx = getCurrentWorkerIndex();
+
+			if (idx == NOT_A_WORKER)
+				idx = mNextQueue.fetch_add(1, std::memory_order_relaxed) % mQueues.size();
+
+			mQueues[idx]->push(std::move(task));
+			mNumQueued.fetch_add(1, std::memory_order_release);
+
+			wake();
+		}
+
+		void JobSystem::execute(Task& task) {
+			try {
+				task.mJob();
+			}
+			catch (std::exception& ex) {
+				gLogError << "Exception thrown from job: " << ex.what();
+			}
+			catch (...) {
+				gLogError << "Unknown exception thrown from job";
+			}
+
+			bool completed = (task.mCounter->fetch_sub(1, std::memory_order_release) == 1);
+
+			// some parked fiber may be waiting for this
+			if (completed && (mNumWaiting.load(std::memory_order_acquire) > 0))
+				wake();
+		}
+
+		void JobSystem::wake() {
+			{
+				// [NOTE] the lock is required to prevent a lost wakeup between a worker checking
+				//        the predicate and actually going to sleep
+				std::lock_guard<std::mutex> lock(mSleepMutex);
+			}
+
+			mWakeCondition.notify_one();
+		}
+
+		void JobSystem::runFiber(ThreadState* state, JobFiber* fiber) {
+			if (std::find(fiber->mVisited.begin(), fiber->mVisited.end(), state) == fiber->mVisited.end()) {
+				fiber->mVisited.push_back(state);
+				state->mNumLiveJobs.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			state->mCurrent = fiber;
+			state->mSwitchReason = eSwitchReason::NONE;
+
+			state->mThreadFiber->switchTo(*fiber->mFiber);
+
+			// the fiber switched back to us; the thread fiber itself never migrates between threads
+			state->mCurrent = nullptr;
+
+			switch (state->mSwitchReason) {
+			case eSwitchReason::FINISHED:
+				for (auto visited : fiber->mVisited)
+					visited->mNumLiveJobs.fetch_sub(1, std::memory_order_release);
+
+				fiber->mVisited.clear();
+				releaseFiber(fiber);
+				break;
+
+			case eSwitchReason::WAITING:
+				{
+					// [NOTE] the fiber is only made available for resuming after its context was saved
+					std::lock_guard<util::Spinlock> lock(mWaitLock);
+					mWaitingFibers.push_back(WaitingFiber{ fiber, std::move(state->mWaitCounter) });
+					mNumWaiting.fetch_add(1, std::memory_order_release);
+				}
+
+				// the handle may have completed before the fiber was parked
+				wake();
+				break;
+
+			default:
+				assert(false);
+			}
+
+			state->mSwitchReason = eSwitchReason::NONE;
+		}
+
+		JobSystem::JobFiber* JobSystem::acquireFiber() {
+			{
+				std::lock_guard<util::Spinlock> lock(mFiberLock);
+
+				if (!mFreeFibers.empty()) {
+					auto result = mFreeFibers.back();
+					mFreeFibers.pop_back();
+					return result;
+				}
+			}
+
+			auto fiber = std::make_unique<JobFiber>();
+			fiber->mOwner = this;
+			fiber->mFiber = std::make_unique<Fiber>(&JobSystem::fiberEntry, fiber.get(), mFiberStackSize);
+
+			auto result = fiber.get();
+
+			std::lock_guard<util::Spinlock> lock(mFiberLock);
+			mFibers.push_back(std::move(fiber));
+
+			return result;
+		}
+
+		void JobSystem::releaseFiber(JobFiber* fiber) {
+			std::lock_guard<util::Spinlock> lock(mFiberLock);
+			mFreeFibers.push_back(fiber);
+		}
+
+		JobSystem::JobFiber* JobSystem::takeResumableFiber() {
+			if (mNumWaiting.load(std::memory_order_acquire) == 0)
+				return nullptr;
+
+			std::lock_guard<util::Spinlock> lock(mWaitLock);
+
+			for (auto it = mWaitingFibers.begin(); it != mWaitingFibers.end(); ++it) {
+				if (it->mCounter->load(std::memory_order_acquire) == 0) {
+					auto result = it->mFiber;
+
+					*it = std::move(mWaitingFibers.back());
+					mWaitingFibers.pop_back();
+					mNumWaiting.fetch_sub(1, std::memory_order_release);
+
+					return result;
+				}
+			}
+
+			return nullptr;
+		}
+
+		bool JobSystem::hasResumableFiber() {
+			if (mNumWaiting.load(std::memory_order_acquire) == 0)
+				return false;
+
+			std::lock_guard<util::Spinlock> lock(mWaitLock);
+
+			for (const auto& waiting : mWaitingFibers)
+				if (waiting.mCounter->load(std::memory_order_acquire) == 0)
+					return true;
+
+			return false;
+		}
+
+		void JobSystem::workerThread(size_t workerIndex) {
+			ThreadState state;
+			state.mThreadFiber = Fiber::convertCurrentThread();
+
+			tCurrentJobSystem = this;
+			tCurrentWorkerIndex = workerIndex;
+			tCurrentThreadState = &state;
+
+			while (!mIsDone) {
+				tryFence();
+
+				if (tryRunJob())
+					continue;
+
+				std::unique_lock<std::mutex> lock(mSleepMutex);
+
+				mWakeCondition.wait(lock, [this] {
+					return
+						mIsDone ||
+						(mNumQueued.load(std::memory_order_acquire) > 0) ||
+						hasResumableFiber();
+				});
+			}
+
+			tCurrentThreadState = nullptr;
+		}
+	}
+}
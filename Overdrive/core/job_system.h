@@ -0,0 +1,185 @@
+#pragma once
+
+#include "fiber.h"
+#include "../util/spinlock.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace overdrive {
+	namespace core {
+		/*
+			A JobHandle tracks completion of one or more scheduled jobs (it's a shared counter of
+			jobs that haven't finished yet). Multiple jobs can be grouped under a single handle by
+			passing it along to JobSystem::schedule.
+		*/
+		class JobHandle {
+		public:
+			JobHandle(); // creates a handle without any pending jobs
+
+			bool isDone() const;
+			int getNumPending() const;
+
+			bool operator == (const JobHandle& handle) const; // refers to the same group of jobs
+			bool operator != (const JobHandle& handle) const;
+
+		private:
+			friend class JobSystem;
+
+			std::shared_ptr<std::atomic<int>> mCounter;
+		};
+
+		/*
+			Work-stealing job scheduler
+
+			Every worker owns a deque of jobs. The owner pushes and pops at the back (LIFO, which tends
+			to keep the working set hot in cache), idle workers steal from the front of other deques.
+			The thread that creates the JobSystem is registered as worker 0; it doesn't get its own OS
+			thread but executes jobs whenever it waits on a handle (or calls tryRunJob).
+
+			Jobs are executed on fibers from a pool. When a job waits on a handle that isn't done yet,
+			its fiber is parked and the worker continues with other jobs; the parked fiber is resumed
+			(by whichever worker gets to it first) once the handle completes. This allows long chains
+			of jobs waiting on each other without tying up OS threads.
+
+			[NOTE] the deques are guarded by spinlocks rather than being lock-free (Chase-Lev);
+			       contention on a single deque is low because stealing is spread over all workers
+			[NOTE] jobs must not throw -- exceptions are caught and logged, the job is considered done
+			[NOTE] threads that aren't owned by the JobSystem (and jobs that call tryRunJob directly)
+			       execute jobs inline instead of on a fiber
+			[NOTE] a job may continue on a different worker after waiting, so re-query anything per-thread
+			       (getCurrentWorkerIndex, FrameAllocator::local) after every wait
+			[NOTE] fiber stacks default to 1 MB, which is only reserved address space until it is touched;
+			       a job that overflows its stack hits a guard page and crashes
+		*/
+		class JobSystem {
+		public:
+			typedef std::function<void()> Job;
+
+			static const size_t NOT_A_WORKER = ~size_t(0);
+
+			explicit JobSystem(
+				size_t numThreads = 0,				// 0 -> one thread per hardware thread (including the calling thread)
+				size_t fiberStackSize = 1024 * 1024	// image decoders (stbi) keep large tables on the stack
+			);
+			~JobSystem();
+
+			JobSystem(const JobSystem&) = delete;
+			JobSystem& operator = (const JobSystem&) = delete;
+
+			JobHandle schedule(Job job);
+			void schedule(Job job, JobHandle& handle); // adds the job to an existing handle
+
+			void wait(const JobHandle& handle); // parks the current job (or executes other jobs) while waiting
+			bool tryRunJob(); // executes a single pending job (if there is one), yields whether a job was run
+
+			// keeps a handle pending until it is released, so work that doesn't run as a job can be waited on as well
+			void hold(JobHandle& handle);
+			void release(JobHandle& handle);
+
+			// advances the FrameAllocators of the calling thread, unless a job that ran on it hasn't finished yet
+			// (it may still refer to their memory); workers do this by themselves between jobs
+			bool tryFence();
+
+			size_t getNumWorkers() const; // includes the thread that created the JobSystem
+			size_t getCurrentWorkerIndex() const; // yields NOT_A_WORKER when called from a thread not owned by this JobSystem
+			size_t getNumFibers() const;
+
+			// identifies what is running on the calling thread: the fiber of the current job, or the thread itself
+			// outside of jobs (jobs that are executed inline share the identity of whatever they interrupted)
+			static const void* getCurrentContext();
+
+		private:
+			struct Task {
+				Job mJob;
+				std::shared_ptr<std::atomic<int>> mCounter;
+			};
+
+			class WorkQueue {
+			public:
+				void push(Task&& task);
+				bool pop(Task& task);	// back of the queue, owner only
+				bool steal(Task& task);	// front of the queue, other workers
+
+			private:
+				util::Spinlock mLock;
+				std::deque<Task> mTasks;
+			};
+
+			struct ThreadState;
+
+			struct JobFiber {
+				JobSystem* mOwner;
+				std::unique_ptr<Fiber> mFiber;
+				Task mTask;
+
+				std::vector<ThreadState*> mVisited; // threads the current job ran on, it may refer to their frame memory
+			};
+
+			struct WaitingFiber {
+				JobFiber* mFiber;
+				std::shared_ptr<std::atomic<int>> mCounter;
+			};
+
+			enum class eSwitchReason {
+				NONE,
+				FINISHED,
+				WAITING
+			};
+
+			// per-thread scheduling state, the thread itself acts as the scheduler fiber
+			struct ThreadState {
+				std::unique_ptr<Fiber> mThreadFiber;
+				JobFiber* mCurrent = nullptr;
+
+				eSwitchReason mSwitchReason = eSwitchReason::NONE;
+				std::shared_ptr<std::atomic<int>> mWaitCounter;
+
+				std::atomic<size_t> mNumLiveJobs{ 0 }; // jobs that ran on this thread and haven't finished yet
+			};
+
+			static void fiberEntry(void* jobFiber);
+			void fiberLoop(JobFiber* self);
+
+			bool takeTask(Task& task);
+			void push(Task&& task);
+			void execute(Task& task);
+			void wake();
+
+			void runFiber(ThreadState* state, JobFiber* fiber);
+			JobFiber* acquireFiber();
+			void releaseFiber(JobFiber* fiber);
+			JobFiber* takeResumableFiber();
+			bool hasResumableFiber();
+
+			void workerThread(size_t workerIndex);
+
+			std::vector<std::unique_ptr<WorkQueue>> mQueues;
+			std::vector<std::thread> mThreads;
+
+			std::atomic<bool> mIsDone;
+			std::atomic<size_t> mNumQueued;
+			std::atomic<size_t> mNextQueue; // round-robin distribution for jobs scheduled from outside threads
+
+			size_t mFiberStackSize;
+			util::Spinlock mFiberLock;
+			std::vector<std::unique_ptr<JobFiber>> mFibers;
+			std::vector<JobFiber*> mFreeFibers;
+
+			util::Spinlock mWaitLock;
+			std::vector<WaitingFiber> mWaitingFibers;
+			std::atomic<size_t> mNumWaiting;
+
+			std::unique_ptr<ThreadState> mMainThreadState;
+
+			std::mutex mSleepMutex;
+			std::condition_variable mWakeCondition;
+		};
+	}
+}
@@ -0,0 +1,118 @@
+#include "stdafx.h"
+#include "linear_allocator.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace overdrive {
+	namespace core {
+		namespace {
+			size_t alignUp(size_t value, size_t alignment) {
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+		}
+
+		// ----- AllocatorStats -----
+		AllocatorStats& AllocatorStats::operator += (const AllocatorStats& stats) {
+			mNumAllocations += stats.mNumAllocations;
+			mNumBytesAllocated += stats.mNumBytesAllocated;
+			mNumOverflows += stats.mNumOverflows;
+			mPeakBytes += stats.mPeakBytes;
+			mTotalAllocations += stats.mTotalAllocations;
+			mNumResets += stats.mNumResets;
+
+			return *this;
+		}
+
+		std::ostream& operator << (std::ostream& os, const AllocatorStats& stats) {
+			os
+				<< stats.mNumAllocations << " allocations, "
+				<< stats.mNumBytesAllocated << " bytes, "
+				<< stats.mNumOverflows << " overflows (peak "
+				<< stats.mPeakBytes << " bytes)";
+
+			return os;
+		}
+
+		// ----- LinearAllocator -----
+		LinearAllocator::LinearAllocator(size_t capacity):
+			mBuffer(new char[capacity]),
+			mCapacity(capacity),
+			mOffset(0)
+		{
+		}
+
+		LinearAllocator::~LinearAllocator() {
+			for (auto block : mOverflow)
+				delete[] block;
+		}
+
+		void* LinearAllocator::allocate(size_t numBytes, size_t alignment) {
+			assert((alignment & (alignment - 1)) == 0); // alignment should be a power of two
+
+			++mStats.mNumAllocations;
+			++mStats.mTotalAllocations;
+
+			auto base = reinterpret_cast<uintptr_t>(mBuffer.get());
+			size_t start = alignUp(base + mOffset, alignment) - base;
+
+			if (start + numBytes <= mCapacity) {
+				mStats.mNumBytesAllocated += (start + numBytes) - mOffset;
+				mOffset = start + numBytes;
+			}
+			else {
+				// doesn't fit, use the heap until the next reset
+				++mStats.mNumOverflows;
+				mStats.mNumBytesAllocated += numBytes + alignment;
+
+				char* block = new char[numBytes + alignment];
+				mOverflow.push_back(block);
+
+				auto address = reinterpret_cast<uintptr_t>(block);
+				return block + (alignUp(address, alignment) - address);
+			}
+
+			mStats.mPeakBytes = std::max(mStats.mPeakBytes, mStats.mNumBytesAllocated);
+
+			return mBuffer.get() + start;
+		}
+
+		void LinearAllocator::reset() {
+			mStats.mPeakBytes = std::max(mStats.mPeakBytes, mStats.mNumBytesAllocated);
+
+			if (!mOverflow.empty()) {
+				for (auto block : mOverflow)
+					delete[] block;
+
+				mOverflow.clear();
+
+				// grow to the next power of two that would have fit everything (an empty block starts at a single byte)
+				size_t capacity = std::max<size_t>(mCapacity, 1);
+				while (capacity < mStats.mPeakBytes)
+					capacity *= 2;
+
+				mBuffer.reset(new char[capacity]);
+				mCapacity = capacity;
+			}
+
+			mOffset = 0;
+
+			mStats.mNumAllocations = 0;
+			mStats.mNumBytesAllocated = 0;
+			mStats.mNumOverflows = 0;
+			++mStats.mNumResets;
+		}
+
+		size_t LinearAllocator::getCapacity() const {
+			return mCapacity;
+		}
+
+		size_t LinearAllocator::getNumBytesUsed() const {
+			return mOffset;
+		}
+
+		const AllocatorStats& LinearAllocator::getStats() const {
+			return mStats;
+		}
+	}
+}
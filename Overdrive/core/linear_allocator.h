@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace overdrive {
+	namespace core {
+		struct AllocatorStats {
+			size_t mNumAllocations = 0;		// since the last reset
+			size_t mNumBytesAllocated = 0;	// since the last reset (includes alignment padding)
+			size_t mNumOverflows = 0;		// allocations that didn't fit and went to the heap, since the last reset
+			size_t mPeakBytes = 0;			// highest usage between two resets
+			size_t mTotalAllocations = 0;	// lifetime
+			size_t mNumResets = 0;			// lifetime
+
+			AllocatorStats& operator += (const AllocatorStats& stats);
+		};
+
+		std::ostream& operator << (std::ostream& os, const AllocatorStats& stats);
+
+		/*
+			Bump allocator over a single block of memory. Individual allocations cannot be freed,
+			everything is released at once with reset(). No destructors are called.
+
+			When the block is exhausted allocations fall back to the heap (and are released on reset);
+			the next reset grows the block so that it fits the peak usage.
+
+			[NOTE] not threadsafe, use one per thread
+		*/
+		class LinearAllocator {
+		public:
+			explicit LinearAllocator(size_t capacity);
+			~LinearAllocator();
+
+			LinearAllocator(const LinearAllocator&) = delete;
+			LinearAllocator& operator = (const LinearAllocator&) = delete;
+
+			void* allocate(size_t numBytes, size_t alignment = alignof(std::max_align_t));
+
+			template <typename T>
+			T* allocate(size_t count); // uninitialized storage for count T's
+
+			void reset();
+
+			size_t getCapacity() const;
+			size_t getNumBytesUsed() const;
+			const AllocatorStats& getStats() const;
+
+		private:
+			std::unique_ptr<char[]> mBuffer;
+			size_t mCapacity;
+			size_t mOffset;
+
+			std::vector<char*> mOverflow;
+			AllocatorStats mStats;
+		};
+	}
+}
+
+#include "linear_allocator.inl"
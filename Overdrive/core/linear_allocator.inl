@@ -0,0 +1,12 @@
+#pragma once
+
+#include "linear_allocator.h"
+
+namespace overdrive {
+	namespace core {
+		template <typename T>
+		T* LinearAllocator::allocate(size_t count) {
+			return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		}
+	}
+}
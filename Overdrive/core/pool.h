@@ -0,0 +1,83 @@
+#pragma once
+
+#include "handle.h"
+#include "../util/spinlock.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace overdrive {
+	namespace core {
+		/*
+			Fixed-size object pool. Objects live in chunks of tChunkSize slots that are never moved or
+			freed while the pool exists, so both handles and pointers remain stable. Freed slots are
+			recycled through an intrusive free list; every slot carries a generation counter that is
+			bumped on create and destroy, so a stale handle is detected with a single compare.
+
+			create() and destroy() are lock-free (a tagged free list head prevents ABA), except when a new chunk
+			has to be added. get() never locks. Concurrent destroys of the same handle are resolved by a CAS on
+			the generation, only one of them succeeds.
+
+			[NOTE] destroying an object while another thread is still using it is not detected
+			[NOTE] a slot whose generation counter is exhausted is retired instead of wrapping around (which
+			       would make ancient handles valid again); that costs one slot per 2^31 reuses
+		*/
+		template <typename T, size_t tChunkSize = 1024>
+		class Pool {
+		public:
+			static const size_t MAX_CHUNKS = 4096;
+
+			Pool();
+			~Pool();
+
+			Pool(const Pool&) = delete;
+			Pool& operator = (const Pool&) = delete;
+
+			template <typename... tArgs>
+			Handle<T> create(tArgs&&... args);
+			void destroy(Handle<T> handle); // throws on a stale handle (including one that another thread destroyed first)
+
+			bool isValid(Handle<T> handle) const;
+			T* get(Handle<T> handle) const; // nullptr if the handle is stale
+
+			size_t getSize() const;		// number of live objects
+			size_t getCapacity() const;	// number of allocated slots
+
+			template <typename tFunction>
+			void forEach(tFunction&& fn); // fn(Handle<T>, T&), in slot order
+
+		private:
+			static const uint32_t NONE = 0xFFFFFFFF;
+			static const uint32_t MAX_GENERATION = 0xFFFFFFFF;
+
+			struct Slot {
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type mStorage;
+				std::atomic<uint32_t> mGeneration; // odd while alive
+				std::atomic<uint32_t> mNextFree;
+
+				T* getObject();
+			};
+
+			struct Chunk {
+				Slot mSlots[tChunkSize];
+			};
+
+			Slot* getSlot(uint32_t index) const; // nullptr if out of range
+
+			uint32_t popFree();
+			void pushFree(uint32_t first, uint32_t last); // pushes an already linked chain
+			uint32_t grow(); // adds a chunk and returns one of its slots
+
+			std::unique_ptr<Chunk> mChunks[MAX_CHUNKS];
+			std::atomic<size_t> mNumChunks;
+
+			std::atomic<uint64_t> mFreeHead; // [tag:32][index:32]
+			std::atomic<size_t> mSize;
+
+			util::Spinlock mGrowLock;
+		};
+	}
+}
+
+#include "pool.inl"
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "pool.h"
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace overdrive {
+	namespace core {
+		namespace detail {
+			inline uint64_t packFreeHead(uint32_t tag, uint32_t index) {
+				return (static_cast<uint64_t>(tag) << 32) | index;
+			}
+
+			inline uint32_t freeHeadIndex(uint64_t head) {
+				return static_cast<uint32_t>(head);
+			}
+
+			inline uint32_t freeHeadTag(uint64_t head) {
+				return static_cast<uint32_t>(head >> 32);
+			}
+		}
+
+		// ----- Pool::Slot -----
+		template <typename T, size_t N>
+		T* Pool<T, N>::Slot::getObject() {
+			return reinterpret_cast<T*>(&mStorage);
+		}
+
+		// ----- Pool -----
+		template <typename T, size_t N>
+		Pool<T, N>::Pool():
+			mNumChunks(0),
+			mFreeHead(detail::packFreeHead(0, NONE)),
+			mSize(0)
+		{
+		}
+
+		template <typename T, size_t N>
+		Pool<T, N>::~Pool() {
+			forEach([](Handle<T>, T& object) {
+				object.~T();
+			});
+		}
+
+		template <typename T, size_t N>
+		template <typename... tArgs>
+		Handle<T> Pool<T, N>::create(tArgs&&... args) {
+			uint32_t index = popFree();
+
+			if (index == NONE)
+				index = grow();
+
+			Slot* slot = getSlot(index);
+
+			try {
+				new (&slot->mStorage) T(std::forward<tArgs>(args)...);
+			}
+			catch (...) {
+				pushFree(index, index);
+				throw;
+			}
+
+			Handle<T> result;
+			result.mIndex = index;
+			result.mGeneration = slot->mGeneration.fetch_add(1, std::memory_order_release) + 1;
+
+			mSize.fetch_add(1, std::memory_order_relaxed);
+
+			return result;
+		}
+
+		template <typename T, size_t N>
+		void Pool<T, N>::destroy(Handle<T> handle) {
+			Slot* slot = getSlot(handle.mIndex);
+
+			// claiming the slot by bumping the generation first makes sure only one thread destroys the object
+			uint32_t generation = handle.mGeneration;
+
+			if (
+				(!slot) ||
+				(handle.isNull()) ||
+				(!slot->mGeneration.compare_exchange_strong(generation, generation + 1, std::memory_order_acq_rel))
+			)
+				throw std::runtime_error("Tried to destroy an object through a stale handle");
+
+			slot->getObject()->~T();
+
+			mSize.fetch_sub(1, std::memory_order_relaxed);
+
+			// the generation wrapped to 0, retire the slot
+			if (handle.mGeneration == MAX_GENERATION)
+				return;
+
+			pushFree(handle.mIndex, handle.mIndex);
+		}
+
+		template <typename T, size_t N>
+		bool Pool<T, N>::isValid(Handle<T> handle) const {
+			return get(handle) != nullptr;
+		}
+
+		template <typename T, size_t N>
+		T* Pool<T, N>::get(Handle<T> handle) const {
+			Slot* slot = getSlot(handle.mIndex);
+
+			if (
+				(!slot) ||
+				(handle.isNull()) ||
+				(slot->mGeneration.load(std::memory_order_acquire) != handle.mGeneration)
+			)
+				return nullptr;
+
+			return slot->getObject();
+		}
+
+		template <typename T, size_t N>
+		size_t Pool<T, N>::getSize() const {
+			return mSize.load(std::memory_order_relaxed);
+		}
+
+		template <typename T, size_t N>
+		size_t Pool<T, N>::getCapacity() const {
+			return mNumChunks.load(std::memory_order_acquire) * N;
+		}
+
+		template <typename T, size_t N>
+		template <typename tFunction>
+		void Pool<T, N>::forEach(tFunction&& fn) {
+			size_t numChunks = mNumChunks.load(std::memory_order_acquire);
+
+			for (size_t i = 0; i < numChunks; ++i) {
+				Chunk* chunk = mChunks[i].get();
+
+				for (size_t j = 0; j < N; ++j) {
+					Slot& slot = chunk->mSlots[j];
+					uint32_t generation = slot.mGeneration.load(std::memory_order_acquire);
+
+					if (generation & 1) {
+						Handle<T> handle;
+						handle.mIndex = static_cast<uint32_t>(i * N + j);
+						handle.mGeneration = generation;
+
+						fn(handle, *slot.getObject());
+					}
+				}
+			}
+		}
+
+		template <typename T, size_t N>
+		typename Pool<T, N>::Slot* Pool<T, N>::getSlot(uint32_t index) const {
+			size_t chunk = index / N;
+
+			if (chunk >= mNumChunks.load(std::memory_order_acquire))
+				return nullptr;
+
+			return &mChunks[chunk]->mSlots[index % N];
+		}
+
+		template <typename T, size_t N>
+		uint32_t Pool<T, N>::popFree() {
+			uint64_t head = mFreeHead.load(std::memory_order_acquire);
+
+			while (true) {
+				uint32_t index = detail::freeHeadIndex(head);
+
+				if (index == NONE)
+					return NONE;
+
+				// if another thread pops this slot first the tag will have changed and the CAS fails
+				uint32_t next = getSlot(index)->mNextFree.load(std::memory_order_relaxed);
+				uint64_t newHead = detail::packFreeHead(detail::freeHeadTag(head) + 1, next);
+
+				if (mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_acq_rel, std::memory_order_acquire))
+					return index;
+			}
+		}
+
+		template <typename T, size_t N>
+		void Pool<T, N>::pushFree(uint32_t first, uint32_t last) {
+			Slot* lastSlot = getSlot(last);
+			uint64_t head = mFreeHead.load(std::memory_order_relaxed);
+
+			while (true) {
+				lastSlot->mNextFree.store(detail::freeHeadIndex(head), std::memory_order_relaxed);
+				uint64_t newHead = detail::packFreeHead(detail::freeHeadTag(head) + 1, first);
+
+				if (mFreeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+					return;
+			}
+		}
+
+		template <typename T, size_t N>
+		uint32_t Pool<T, N>::grow() {
+			std::lock_guard<util::Spinlock> lock(mGrowLock);
+
+			// another thread may have grown the pool while we were waiting
+			uint32_t index = popFree();
+			if (index != NONE)
+				return index;
+
+			size_t chunkIndex = mNumChunks.load(std::memory_order_relaxed);
+
+			if (chunkIndex >= MAX_CHUNKS)
+				throw std::runtime_error("Pool capacity exceeded");
+
+			std::unique_ptr<Chunk> chunk(new Chunk);
+			uint32_t base = static_cast<uint32_t>(chunkIndex * N);
+
+			for (size_t i = 0; i < N; ++i) {
+				chunk->mSlots[i].mGeneration.store(0, std::memory_order_relaxed);
+				chunk->mSlots[i].mNextFree.store(base + static_cast<uint32_t>(i) + 1, std::memory_order_relaxed);
+			}
+
+			mChunks[chunkIndex] = std::move(chunk);
+			mNumChunks.store(chunkIndex + 1, std::memory_order_release);
+
+			// keep the first slot, the rest goes onto the free list in one go
+			if (N > 1)
+				pushFree(base + 1, base + static_cast<uint32_t>(N) - 1);
+
+			return base;
+		}
+	}
+}
@@ -0,0 +1,26 @@
+#include "stdafx.h"
+#include "resource_cache.h"
+
+namespace overdrive {
+	namespace core {
+		std::ostream& operator << (std::ostream& os, const ResourceCacheStats& stats) {
+			size_t numRequests = stats.mNumHits + stats.mNumMisses;
+
+			os
+				<< "Resource cache: "
+				<< stats.mNumHits << "/" << numRequests << " hits ("
+				<< stats.mNumWaits << " waited, "
+				<< stats.mNumFailed << " failed, "
+				<< stats.mNumEvicted << " evicted), "
+				<< stats.mNumResources << " resources, "
+				<< (stats.mNumBytes / 1024) << " KB";
+
+			if (stats.mBudget != ~size_t(0)) // not unlimited
+				os << " of " << (stats.mBudget / 1024) << " KB";
+
+			os << " (" << (stats.mNumBytesInUse / 1024) << " KB in use)";
+
+			return os;
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "job_system.h"
+#include "../util/string_hash.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace overdrive {
+	namespace core {
+		struct ResourceCacheStats {
+			size_t mNumHits = 0;		// includes requests that waited for a load in progress
+			size_t mNumMisses = 0;
+			size_t mNumWaits = 0;		// hits that had to wait for another thread (or job) to finish loading
+			size_t mNumFailed = 0;		// loads that threw
+			size_t mNumEvicted = 0;
+
+			size_t mNumResources = 0;	// loaded and still cached
+			size_t mNumBytes = 0;		// memory used by the cached resources
+			size_t mNumBytesInUse = 0;	// ... of which is referenced outside of the cache
+			size_t mBudget = 0;
+		};
+
+		/*
+			Shares loaded resources (textures, shader programs, meshes...) between everything that asks for
+			the same key (see makeResourceKey), and keeps them around for a while after they're released.
+
+			~ get() yields a shared handle; asking for the same key again yields the same resource
+			~ concurrent requests for a key that is still loading wait for that load instead of starting another;
+			  if the load throws, every waiting request gets the exception and nothing is cached
+			~ the memory used by a resource is given by getMemoryUsage(const T&), found by argument dependent lookup;
+			  while the total exceeds the budget, resources that aren't referenced outside of the cache are
+			  evicted, least recently used first
+
+			Usage:
+				ResourceCache<Texture2D> textures(256 * 1024 * 1024);
+
+				auto texture = textures.get(makeResourceKey("assets/image/test_pattern_001.png"), [] {
+					return std::make_unique<Texture2D>(loadTexture2D("assets/image/test_pattern_001.png"));
+				});
+
+			[NOTE] resources that are still referenced are never evicted, so the total may exceed the budget for a while
+			[NOTE] the loader runs on the thread that called get(), without holding the lock -- resources that
+				   need the openGL context must be requested from the openGL thread
+			[NOTE] evicted resources are destroyed on the thread that triggered the eviction
+			[NOTE] with a JobSystem, a job that waits for another load is parked (see JobSystem::wait); without one,
+				   waiting blocks the calling thread
+			[NOTE] a loader must not request its own key (directly or through another loader) -- that would wait
+				   for itself, so get() throws instead. Loads are told apart by JobSystem::getCurrentContext, so
+				   different jobs on the same worker thread can still wait for each other
+			[NOTE] the size of a resource is taken when its loader returns; call refresh() for resources that
+				   grow afterwards (such as programs that are still being built by a ShaderCompiler)
+		*/
+		template <typename T>
+		class ResourceCache {
+		public:
+			typedef std::shared_ptr<T> Handle;
+			typedef std::function<std::unique_ptr<T>()> Loader;
+			typedef ResourceCacheStats Stats;
+
+			static const size_t UNLIMITED = ~size_t(0);
+
+			explicit ResourceCache(
+				size_t budget = UNLIMITED, // in bytes
+				JobSystem* jobSystem = nullptr
+			);
+			~ResourceCache();
+
+			ResourceCache(const ResourceCache&) = delete;
+			ResourceCache& operator = (const ResourceCache&) = delete;
+
+			Handle get(uint64_t key, const Loader& loader);	// loads on a miss; rethrows exceptions of the loader
+			Handle find(uint64_t key);						// nullptr unless the resource is loaded; counts as a use
+			bool contains(uint64_t key) const;				// loaded or loading
+			void refresh(uint64_t key);						// queries the memory usage of a loaded resource again
+
+			void setBudget(size_t numBytes); // evicts right away if needed
+			size_t getBudget() const;
+
+			void trim();	// evicts until the budget is met (or nothing unreferenced is left)
+			size_t purge();	// evicts every resource that isn't referenced outside of the cache, yields how many
+
+			Stats getStats() const;
+
+		private:
+			typedef std::list<uint64_t> RecentList;
+
+			struct Entry {
+				Handle mResource;					// nullptr while loading
+				std::shared_future<Handle> mLoad;	// valid while loading
+				JobHandle mLoading;					// pending while loading, so jobs can be parked on it
+				const void* mLoader = nullptr;		// JobSystem::getCurrentContext of the load, while loading
+				size_t mNumBytes = 0;
+				typename RecentList::iterator mRecent;
+			};
+
+			// the lock must be held; evicted resources are moved into released, so they can be destroyed after unlocking
+			void touch(Entry& entry);
+			void evict(size_t budget, std::vector<Handle>& released);
+
+			mutable std::mutex mMutex;
+			JobSystem* mJobSystem;
+
+			std::unordered_map<uint64_t, Entry> mEntries;
+			RecentList mRecent; // keys of the loaded entries, most recently used first
+
+			size_t mBudget;
+			size_t mNumBytes;
+			Stats mStats; // counters only, the rest is filled in by getStats
+		};
+
+		// combines a path with any number of parameters (strings or trivially copyable values) into a cache key
+		// [NOTE] structs are hashed byte for byte, so make sure they don't contain (uninitialized) padding
+		template <typename... tParams>
+		uint64_t makeResourceKey(const std::string& path, const tParams&... params);
+
+		std::ostream& operator << (std::ostream& os, const ResourceCacheStats& stats);
+	}
+}
+
+#include "resource_cache.inl"
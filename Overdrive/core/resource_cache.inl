@@ -0,0 +1,301 @@
+#pragma once
+
+#include "resource_cache.h"
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace overdrive {
+	namespace core {
+		namespace detail {
+			inline uint64_t hashResourceParams(uint64_t hash) {
+				return hash;
+			}
+
+			inline uint64_t hashResourceParam(uint64_t hash, const std::string& param) {
+				// the length keeps ("ab", "c") and ("a", "bc") apart
+				uint64_t length = param.size();
+
+				hash = util::hashBytes(&length, sizeof(length), hash);
+				return util::hashBytes(param.data(), param.size(), hash);
+			}
+
+			inline uint64_t hashResourceParam(uint64_t hash, const char* param) {
+				return hashResourceParam(hash, std::string(param));
+			}
+
+			template <typename tParam>
+			uint64_t hashResourceParam(uint64_t hash, const tParam& param) {
+				static_assert(std::is_trivially_copyable<tParam>::value, "Resource key parameters must be strings or trivially copyable");
+
+				return util::hashBytes(&param, sizeof(param), hash);
+			}
+
+			template <typename tParam, typename... tRest>
+			uint64_t hashResourceParams(uint64_t hash, const tParam& param, const tRest&... rest) {
+				return hashResourceParams(hashResourceParam(hash, param), rest...);
+			}
+		}
+
+		template <typename T>
+		ResourceCache<T>::ResourceCache(
+			size_t budget,
+			JobSystem* jobSystem
+		):
+			mJobSystem(jobSystem),
+			mBudget(budget),
+			mNumBytes(0)
+		{
+		}
+
+		template <typename T>
+		ResourceCache<T>::~ResourceCache() {
+			// handles that are still out there keep their resource alive, the cache just lets go of it
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			mEntries.clear();
+			mRecent.clear();
+		}
+
+		template <typename T>
+		typename ResourceCache<T>::Handle ResourceCache<T>::get(uint64_t key, const Loader& loader) {
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			auto it = mEntries.find(key);
+
+			if (it != mEntries.end()) {
+				++mStats.mNumHits;
+
+				if (it->second.mResource) {
+					touch(it->second);
+					return it->second.mResource;
+				}
+
+				// a loader that asks for its own key would wait for itself forever
+				if (it->second.mLoader == JobSystem::getCurrentContext())
+					throw std::runtime_error("Recursive request for a resource that is still being loaded");
+
+				// someone else is loading it
+				++mStats.mNumWaits;
+
+				auto load = it->second.mLoad;
+				auto loading = it->second.mLoading;
+				lock.unlock();
+
+				if (mJobSystem)
+					mJobSystem->wait(loading);
+
+				return load.get(); // rethrows if that load failed
+			}
+
+			++mStats.mNumMisses;
+
+			std::promise<Handle> promise;
+
+			Entry& entry = mEntries[key];
+			entry.mLoad = promise.get_future().share();
+			entry.mLoader = JobSystem::getCurrentContext();
+
+			JobHandle loading = entry.mLoading;
+
+			if (mJobSystem)
+				mJobSystem->hold(loading);
+
+			lock.unlock();
+
+			Handle resource;
+			size_t numBytes = 0;
+
+			try {
+				resource = Handle(loader());
+
+				if (!resource)
+					throw std::runtime_error("Resource loader didn't yield a resource");
+
+				numBytes = getMemoryUsage(*resource);
+			}
+			catch (...) {
+				lock.lock();
+
+				mEntries.erase(key);
+				++mStats.mNumFailed;
+
+				lock.unlock();
+
+				promise.set_exception(std::current_exception());
+
+				if (mJobSystem)
+					mJobSystem->release(loading);
+
+				throw;
+			}
+
+			std::vector<Handle> released;
+
+			lock.lock();
+
+			// [NOTE] the entry can't have been removed while loading, purge/evict skip entries without a resource
+			Entry& loaded = mEntries[key];
+
+			loaded.mResource = resource;
+			loaded.mLoad = std::shared_future<Handle>();
+			loaded.mLoading = JobHandle();
+			loaded.mLoader = nullptr;
+			loaded.mNumBytes = numBytes;
+			loaded.mRecent = mRecent.insert(mRecent.begin(), key);
+
+			mNumBytes += numBytes;
+
+			evict(mBudget, released);
+
+			lock.unlock();
+
+			promise.set_value(resource);
+
+			if (mJobSystem)
+				mJobSystem->release(loading);
+
+			return resource;
+		}
+
+		template <typename T>
+		typename ResourceCache<T>::Handle ResourceCache<T>::find(uint64_t key) {
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			auto it = mEntries.find(key);
+
+			if ((it == mEntries.end()) || !it->second.mResource)
+				return Handle();
+
+			touch(it->second);
+
+			return it->second.mResource;
+		}
+
+		template <typename T>
+		bool ResourceCache<T>::contains(uint64_t key) const {
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			return (mEntries.find(key) != mEntries.end());
+		}
+
+		template <typename T>
+		void ResourceCache<T>::refresh(uint64_t key) {
+			std::vector<Handle> released;
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			auto it = mEntries.find(key);
+
+			if ((it == mEntries.end()) || !it->second.mResource)
+				return; // still loading, the size is taken once the loader returns
+
+			Handle resource = it->second.mResource;
+
+			lock.unlock();
+
+			size_t numBytes = getMemoryUsage(*resource);
+
+			lock.lock();
+
+			it = mEntries.find(key);
+
+			// it may have been evicted (or replaced) in the meantime
+			if ((it == mEntries.end()) || (it->second.mResource != resource))
+				return;
+
+			mNumBytes = mNumBytes - it->second.mNumBytes + numBytes;
+			it->second.mNumBytes = numBytes;
+
+			resource.reset(); // so it can be evicted right away
+			evict(mBudget, released);
+		}
+
+		template <typename T>
+		void ResourceCache<T>::setBudget(size_t numBytes) {
+			std::vector<Handle> released;
+
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			mBudget = numBytes;
+			evict(mBudget, released);
+		}
+
+		template <typename T>
+		size_t ResourceCache<T>::getBudget() const {
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			return mBudget;
+		}
+
+		template <typename T>
+		void ResourceCache<T>::trim() {
+			std::vector<Handle> released;
+
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			evict(mBudget, released);
+		}
+
+		template <typename T>
+		size_t ResourceCache<T>::purge() {
+			std::vector<Handle> released;
+
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			evict(0, released);
+
+			return released.size();
+		}
+
+		template <typename T>
+		typename ResourceCache<T>::Stats ResourceCache<T>::getStats() const {
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			Stats result = mStats;
+
+			result.mNumResources = mRecent.size();
+			result.mNumBytes = mNumBytes;
+			result.mBudget = mBudget;
+
+			for (const auto& item : mEntries)
+				if (item.second.mResource && (item.second.mResource.use_count() > 1))
+					result.mNumBytesInUse += item.second.mNumBytes;
+
+			return result;
+		}
+
+		template <typename T>
+		void ResourceCache<T>::touch(Entry& entry) {
+			mRecent.splice(mRecent.begin(), mRecent, entry.mRecent);
+		}
+
+		template <typename T>
+		void ResourceCache<T>::evict(size_t budget, std::vector<Handle>& released) {
+			auto it = mRecent.end();
+
+			while (((mNumBytes > budget) || (budget == 0)) && (it != mRecent.begin())) {
+				--it;
+
+				auto entry = mEntries.find(*it);
+
+				// only the cache refers to it
+				if (entry->second.mResource.use_count() == 1) {
+					mNumBytes -= entry->second.mNumBytes;
+					++mStats.mNumEvicted;
+
+					released.push_back(std::move(entry->second.mResource));
+
+					mEntries.erase(entry);
+					it = mRecent.erase(it);
+				}
+			}
+		}
+
+		template <typename... tParams>
+		uint64_t makeResourceKey(const std::string& path, const tParams&... params) {
+			uint64_t hash = util::hashBytes(nullptr, 0); // FNV offset basis
+
+			return detail::hashResourceParams(detail::hashResourceParam(hash, path), params...);
+		}
+	}
+}
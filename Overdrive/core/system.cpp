@@ -32,5 +32,27 @@ namespace overdrive {
 		const std::vector<std::string>& System::getDependencies() const {
 			return mDependencies;
 		}
+
+		void System::addRead(const std::string& resource) {
+			if (std::find(mReads.begin(), mReads.end(), resource) == mReads.end())
+				mReads.push_back(resource);
+		}
+
+		void System::addWrite(const std::string& resource) {
+			if (std::find(mWrites.begin(), mWrites.end(), resource) == mWrites.end())
+				mWrites.push_back(resource);
+		}
+
+		const std::vector<std::string>& System::getReads() const {
+			return mReads;
+		}
+
+		const std::vector<std::string>& System::getWrites() const {
+			return mWrites;
+		}
+
+		bool System::hasDeclaredAccess() const {
+			return !(mReads.empty() && mWrites.empty());
+		}
 	}
 }
\ No newline at end of file
@@ -29,6 +29,14 @@ namespace overdrive {
 			void addDependency(const std::string& name);
 			const std::vector<std::string>& getDependencies() const;
 
+			// used to determine which systems can be updated concurrently
+			// [NOTE] a system that doesn't declare any access is assumed to touch everything; it is updated on the main thread
+			void addRead(const std::string& resource);
+			void addWrite(const std::string& resource);
+			const std::vector<std::string>& getReads() const;
+			const std::vector<std::string>& getWrites() const;
+			bool hasDeclaredAccess() const;
+
 		protected:
 			Channel mChannel;
 			Engine* mEngine; // this is set by the Engine before initializing the system
@@ -37,6 +45,8 @@ namespace overdrive {
 		private:
 			std::string mName;
 			std::vector<std::string> mDependencies; 
+			std::vector<std::string> mReads;
+			std::vector<std::string> mWrites;
 		};
 	}
 }
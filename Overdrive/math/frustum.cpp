@@ -4,12 +4,74 @@
 namespace overdrive {
 	namespace math {
 		Frustum::Frustum() {
+			extract(glm::mat4());
+		}
+
+		Frustum::Frustum(const glm::mat4& viewProjection) {
+			extract(viewProjection);
+		}
+
+		void Frustum::extract(const glm::mat4& viewProjection) {
+			// Gribb/Hartmann: every plane is the sum or difference of the 4th row and one of the other rows
+			const glm::mat4& m = viewProjection;
+
+			glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+			glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+			glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+			glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+			auto makePlane = [](const glm::vec4& coefficients) {
+				glm::vec3 normal(coefficients);
+				float length = glm::length(normal);
+
+				return Plane(normal / length, coefficients.w / length);
+			};
+
+			mPlanes[static_cast<int>(eCubePlane::FRONT)]	= makePlane(row3 + row2); // near
+			mPlanes[static_cast<int>(eCubePlane::BACK)]		= makePlane(row3 - row2); // far
+			mPlanes[static_cast<int>(eCubePlane::TOP)]		= makePlane(row3 - row1);
+			mPlanes[static_cast<int>(eCubePlane::BOTTOM)]	= makePlane(row3 + row1);
+			mPlanes[static_cast<int>(eCubePlane::LEFT)]		= makePlane(row3 + row0);
+			mPlanes[static_cast<int>(eCubePlane::RIGHT)]	= makePlane(row3 - row0);
 		}
 
 		const Plane& Frustum::getPlane(eCubePlane id) const {
 			return mPlanes[static_cast<int>(id)];
 		}
 
+		eVolumetricIntersection Frustum::classifySphere(const glm::vec3& center, float radius) const {
+			auto result = eVolumetricIntersection::INSIDE;
+
+			for (const auto& plane : mPlanes) {
+				float distance = plane.getDistance(center);
+
+				if (distance < -radius)
+					return eVolumetricIntersection::OUTSIDE;
+
+				if (distance < radius)
+					result = eVolumetricIntersection::OVERLAPPING;
+			}
+
+			return result;
+		}
+
+		eVolumetricIntersection Frustum::classifyBox(const glm::vec3& center, const glm::vec3& extents) const {
+			auto result = eVolumetricIntersection::INSIDE;
+
+			for (const auto& plane : mPlanes) {
+				float distance = plane.getDistance(center);
+				float radius = glm::dot(glm::abs(plane.getNormal()), extents); // projected extents
+
+				if (distance < -radius)
+					return eVolumetricIntersection::OUTSIDE;
+
+				if (distance < radius)
+					result = eVolumetricIntersection::OVERLAPPING;
+			}
+
+			return result;
+		}
+
 		std::ostream& operator << (std::ostream& os, const eCubePlane& plane) {
 			switch (plane) {
 			case eCubePlane::FRONT: 
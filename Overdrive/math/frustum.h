@@ -15,12 +15,22 @@ namespace overdrive {
 			RIGHT
 		};
 
+		/*
+			Plane normals point inwards, so points inside the frustum have a positive distance to every plane.
+			For culling large numbers of objects at once, see frustum_culling.h
+		*/
 		class Frustum {
 		public:
 			Frustum(); // defaults to orthogonal cube with planes at +1 and -1 from the origin
+			explicit Frustum(const glm::mat4& viewProjection);
+
+			void extract(const glm::mat4& viewProjection); // yields world space planes for a (projection * view) matrix
 
 			const Plane& getPlane(eCubePlane id) const;
 
+			eVolumetricIntersection classifySphere(const glm::vec3& center, float radius) const;
+			eVolumetricIntersection classifyBox(const glm::vec3& center, const glm::vec3& extents) const; // axis-aligned
+
 		protected:
 			Plane mPlanes[6];
 		};
@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include "frustum_culling.h"
+#include "../preprocessor.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(OVERDRIVE_AVX)
+	#include <immintrin.h>
+#elif defined(OVERDRIVE_SSE)
+	#include <emmintrin.h>
+#endif
+
+namespace overdrive {
+	namespace math {
+		namespace {
+			// frustum planes in SoA form, every coefficient splatted for the SIMD paths
+			struct PlaneSet {
+				float mNormalX[6];
+				float mNormalY[6];
+				float mNormalZ[6];
+				float mDistance[6];
+			};
+
+			PlaneSet makePlaneSet(const Frustum& frustum) {
+				PlaneSet result;
+
+				for (int i = 0; i < 6; ++i) {
+					const Plane& plane = frustum.getPlane(static_cast<eCubePlane>(i));
+
+					result.mNormalX[i] = plane.getNormal().x;
+					result.mNormalY[i] = plane.getNormal().y;
+					result.mNormalZ[i] = plane.getNormal().z;
+					result.mDistance[i] = plane.getDistance();
+				}
+
+				return result;
+			}
+
+			void setBit(uint32_t* mask, size_t index, bool value) {
+				if (value)
+					mask[index / 32] |= (1u << (index % 32));
+			}
+
+			// scalar version, for the remainder that doesn't fill a SIMD register
+			void classify(
+				const PlaneSet& planes,
+				float x, float y, float z,
+				float ex, float ey, float ez, // extents; pass the radius as ex for spheres and zero for the others
+				bool isBox,
+				bool& isVisible,
+				bool& isInside
+			) {
+				isVisible = true;
+				isInside = true;
+
+				for (int i = 0; i < 6; ++i) {
+					float distance =
+						planes.mNormalX[i] * x +
+						planes.mNormalY[i] * y +
+						planes.mNormalZ[i] * z +
+						planes.mDistance[i];
+
+					float radius = isBox ?
+						std::abs(planes.mNormalX[i]) * ex + std::abs(planes.mNormalY[i]) * ey + std::abs(planes.mNormalZ[i]) * ez :
+						ex;
+
+					if (distance < -radius) {
+						isVisible = false;
+						isInside = false;
+						return;
+					}
+
+					if (distance < radius)
+						isInside = false;
+				}
+			}
+
+#if defined(OVERDRIVE_AVX)
+			const size_t LANES = 8;
+
+			// yields the visible and inside bits for 8 volumes
+			void classifyLanes(
+				const PlaneSet& planes,
+				const float* x, const float* y, const float* z,
+				const float* ex, const float* ey, const float* ez, // ey/ez are nullptr for spheres
+				unsigned int& visibleBits,
+				unsigned int& insideBits
+			) {
+				__m256 cx = _mm256_loadu_ps(x);
+				__m256 cy = _mm256_loadu_ps(y);
+				__m256 cz = _mm256_loadu_ps(z);
+				__m256 rx = _mm256_loadu_ps(ex);
+				__m256 ry = ey ? _mm256_loadu_ps(ey) : _mm256_setzero_ps();
+				__m256 rz = ez ? _mm256_loadu_ps(ez) : _mm256_setzero_ps();
+
+				__m256 signMask = _mm256_set1_ps(-0.0f);
+				__m256 outside = _mm256_setzero_ps();
+				__m256 overlapping = _mm256_setzero_ps();
+
+				for (int i = 0; i < 6; ++i) {
+					__m256 nx = _mm256_set1_ps(planes.mNormalX[i]);
+					__m256 ny = _mm256_set1_ps(planes.mNormalY[i]);
+					__m256 nz = _mm256_set1_ps(planes.mNormalZ[i]);
+
+					__m256 distance = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+						_mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(planes.mDistance[i]))
+					);
+
+					__m256 radius;
+
+					if (ey)
+						radius = _mm256_add_ps(
+							_mm256_add_ps(
+								_mm256_mul_ps(_mm256_andnot_ps(signMask, nx), rx),
+								_mm256_mul_ps(_mm256_andnot_ps(signMask, ny), ry)
+							),
+							_mm256_mul_ps(_mm256_andnot_ps(signMask, nz), rz)
+						);
+					else
+						radius = rx;
+
+					__m256 negRadius = _mm256_xor_ps(radius, signMask);
+
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, negRadius, _CMP_LT_OQ));
+					overlapping = _mm256_or_ps(overlapping, _mm256_cmp_ps(distance, radius, _CMP_LT_OQ));
+				}
+
+				unsigned int outsideBits = static_cast<unsigned int>(_mm256_movemask_ps(outside));
+				visibleBits = ~outsideBits & 0xFF;
+				insideBits = ~static_cast<unsigned int>(_mm256_movemask_ps(overlapping)) & visibleBits;
+			}
+#elif defined(OVERDRIVE_SSE)
+			const size_t LANES = 4;
+
+			// yields the visible and inside bits for 4 volumes
+			void classifyLanes(
+				const PlaneSet& planes,
+				const float* x, const float* y, const float* z,
+				const float* ex, const float* ey, const float* ez, // ey/ez are nullptr for spheres
+				unsigned int& visibleBits,
+				unsigned int& insideBits
+			) {
+				__m128 cx = _mm_loadu_ps(x);
+				__m128 cy = _mm_loadu_ps(y);
+				__m128 cz = _mm_loadu_ps(z);
+				__m128 rx = _mm_loadu_ps(ex);
+				__m128 ry = ey ? _mm_loadu_ps(ey) : _mm_setzero_ps();
+				__m128 rz = ez ? _mm_loadu_ps(ez) : _mm_setzero_ps();
+
+				__m128 signMask = _mm_set1_ps(-0.0f);
+				__m128 outside = _mm_setzero_ps();
+				__m128 overlapping = _mm_setzero_ps();
+
+				for (int i = 0; i < 6; ++i) {
+					__m128 nx = _mm_set1_ps(planes.mNormalX[i]);
+					__m128 ny = _mm_set1_ps(planes.mNormalY[i]);
+					__m128 nz = _mm_set1_ps(planes.mNormalZ[i]);
+
+					__m128 distance = _mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+						_mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes.mDistance[i]))
+					);
+
+					__m128 radius;
+
+					if (ey)
+						radius = _mm_add_ps(
+							_mm_add_ps(
+								_mm_mul_ps(_mm_andnot_ps(signMask, nx), rx),
+								_mm_mul_ps(_mm_andnot_ps(signMask, ny), ry)
+							),
+							_mm_mul_ps(_mm_andnot_ps(signMask, nz), rz)
+						);
+					else
+						radius = rx;
+
+					__m128 negRadius = _mm_xor_ps(radius, signMask);
+
+					outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+					overlapping = _mm_or_ps(overlapping, _mm_cmplt_ps(distance, radius));
+				}
+
+				unsigned int outsideBits = static_cast<unsigned int>(_mm_movemask_ps(outside));
+				visibleBits = ~outsideBits & 0xF;
+				insideBits = ~static_cast<unsigned int>(_mm_movemask_ps(overlapping)) & visibleBits;
+			}
+#else
+			const size_t LANES = 0;
+#endif
+
+			size_t cull(
+				const Frustum& frustum,
+				const float* x, const float* y, const float* z,
+				const float* ex, const float* ey, const float* ez,
+				size_t count,
+				uint32_t* visible,
+				uint32_t* inside
+			) {
+				PlaneSet planes = makePlaneSet(frustum);
+
+				std::memset(visible, 0, getMaskSize(count) * sizeof(uint32_t));
+
+				if (inside)
+					std::memset(inside, 0, getMaskSize(count) * sizeof(uint32_t));
+
+				size_t numVisible = 0;
+				size_t i = 0;
+
+#if defined(OVERDRIVE_SSE) || defined(OVERDRIVE_AVX)
+				// LANES divides 32, so a group never straddles two mask words
+				for (; i + LANES <= count; i += LANES) {
+					unsigned int visibleBits;
+					unsigned int insideBits;
+
+					classifyLanes(
+						planes,
+						x + i, y + i, z + i,
+						ex + i,
+						ey ? ey + i : nullptr,
+						ez ? ez + i : nullptr,
+						visibleBits,
+						insideBits
+					);
+
+					visible[i / 32] |= (visibleBits << (i % 32));
+
+					if (inside)
+						inside[i / 32] |= (insideBits << (i % 32));
+
+					// popcount without relying on compiler intrinsics
+					for (unsigned int bits = visibleBits; bits; bits &= bits - 1)
+						++numVisible;
+				}
+#else
+				(void)LANES;
+#endif
+
+				for (; i < count; ++i) {
+					bool isVisible;
+					bool isInside;
+
+					classify(
+						planes,
+						x[i], y[i], z[i],
+						ex[i], ey ? ey[i] : 0.0f, ez ? ez[i] : 0.0f,
+						ey != nullptr,
+						isVisible,
+						isInside
+					);
+
+					setBit(visible, i, isVisible);
+
+					if (inside)
+						setBit(inside, i, isInside);
+
+					if (isVisible)
+						++numVisible;
+				}
+
+				return numVisible;
+			}
+		}
+
+		size_t getMaskSize(size_t count) {
+			return (count + 31) / 32;
+		}
+
+		size_t cullSpheres(
+			const Frustum& frustum,
+			const SphereBatch& spheres,
+			uint32_t* visible,
+			uint32_t* inside
+		) {
+			return cull(
+				frustum,
+				spheres.mCenterX, spheres.mCenterY, spheres.mCenterZ,
+				spheres.mRadius, nullptr, nullptr,
+				spheres.mCount,
+				visible,
+				inside
+			);
+		}
+
+		size_t cullBoxes(
+			const Frustum& frustum,
+			const BoxBatch& boxes,
+			uint32_t* visible,
+			uint32_t* inside
+		) {
+			return cull(
+				frustum,
+				boxes.mCenterX, boxes.mCenterY, boxes.mCenterZ,
+				boxes.mExtentX, boxes.mExtentY, boxes.mExtentZ,
+				boxes.mCount,
+				visible,
+				inside
+			);
+		}
+
+		eVolumetricIntersection getIntersection(
+			const uint32_t* visible,
+			const uint32_t* inside,
+			size_t index
+		) {
+			uint32_t bit = 1u << (index % 32);
+
+			if (!(visible[index / 32] & bit))
+				return eVolumetricIntersection::OUTSIDE;
+
+			if (inside && (inside[index / 32] & bit))
+				return eVolumetricIntersection::INSIDE;
+
+			return eVolumetricIntersection::OVERLAPPING;
+		}
+	}
+}
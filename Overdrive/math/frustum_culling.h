@@ -0,0 +1,63 @@
+#pragma once
+
+#include "frustum.h"
+#include "intersection.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace overdrive {
+	namespace math {
+		/*
+			Batch culling against a Frustum. Bounding volumes are passed in SoA form (one array per component),
+			so that 4 (SSE) or 8 (AVX) volumes can be tested against a plane in one go.
+
+			Results are written to bitmasks with one bit per volume (bit i of word i / 32), which need to hold
+			at least getMaskSize(count) words:
+				- visible: the volume is not completely outside
+				- inside:  the volume is completely inside (optional, useful for skipping tests on children)
+
+			Together these encode an eVolumetricIntersection per volume, see getIntersection().
+		*/
+		struct SphereBatch {
+			const float* mCenterX;
+			const float* mCenterY;
+			const float* mCenterZ;
+			const float* mRadius;
+			size_t mCount;
+		};
+
+		struct BoxBatch { // axis-aligned boxes
+			const float* mCenterX;
+			const float* mCenterY;
+			const float* mCenterZ;
+			const float* mExtentX; // half size
+			const float* mExtentY;
+			const float* mExtentZ;
+			size_t mCount;
+		};
+
+		size_t getMaskSize(size_t count); // number of 32-bit words needed for count volumes
+
+		// yield the number of visible volumes
+		size_t cullSpheres(
+			const Frustum& frustum,
+			const SphereBatch& spheres,
+			uint32_t* visible,
+			uint32_t* inside = nullptr
+		);
+
+		size_t cullBoxes(
+			const Frustum& frustum,
+			const BoxBatch& boxes,
+			uint32_t* visible,
+			uint32_t* inside = nullptr
+		);
+
+		// without an inside mask, visible volumes are reported as OVERLAPPING
+		eVolumetricIntersection getIntersection(
+			const uint32_t* visible,
+			const uint32_t* inside,
+			size_t index
+		);
+	}
+}
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "simd.h"
+#include "../preprocessor.h"
+
+#if defined(OVERDRIVE_AVX)
+	#include <immintrin.h>
+#elif defined(OVERDRIVE_SSE)
+	#include <xmmintrin.h>
+#endif
+
+namespace overdrive {
+	namespace math {
+		void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result) {
+			const float* lhs = &a[0][0];
+			const float* rhs = &b[0][0];
+			float* out = &result[0][0];
+
+#if defined(OVERDRIVE_AVX)
+			// two result columns at a time; every column of a is duplicated in both lanes
+			__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 0));
+			__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 4));
+			__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 8));
+			__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 12));
+
+			__m256 b01 = _mm256_loadu_ps(rhs + 0);
+			__m256 b23 = _mm256_loadu_ps(rhs + 8);
+
+			__m256 r01 = _mm256_mul_ps(a0, _mm256_permute_ps(b01, 0x00));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_permute_ps(b01, 0x55)));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_permute_ps(b01, 0xAA)));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_permute_ps(b01, 0xFF)));
+
+			__m256 r23 = _mm256_mul_ps(a0, _mm256_permute_ps(b23, 0x00));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_permute_ps(b23, 0x55)));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_permute_ps(b23, 0xAA)));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_permute_ps(b23, 0xFF)));
+
+			_mm256_storeu_ps(out + 0, r01);
+			_mm256_storeu_ps(out + 8, r23);
+#elif defined(OVERDRIVE_SSE)
+			__m128 a0 = _mm_loadu_ps(lhs + 0);
+			__m128 a1 = _mm_loadu_ps(lhs + 4);
+			__m128 a2 = _mm_loadu_ps(lhs + 8);
+			__m128 a3 = _mm_loadu_ps(lhs + 12);
+
+			__m128 columns[4];
+
+			for (int i = 0; i < 4; ++i) {
+				__m128 column = _mm_loadu_ps(rhs + i * 4);
+
+				__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0)));
+				r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1))));
+				r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2))));
+				r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3))));
+
+				columns[i] = r;
+			}
+
+			for (int i = 0; i < 4; ++i)
+				_mm_storeu_ps(out + i * 4, columns[i]);
+#else
+			(void)lhs;
+			(void)rhs;
+			(void)out;
+
+			result = a * b;
+#endif
+		}
+
+		void compose(
+			const glm::vec3& position,
+			const glm::quat& orientation,
+			const glm::vec3& scale,
+			glm::mat4& result
+		) {
+			// rotation matrix straight from the quaternion, with the scale folded into the columns
+			float xx = orientation.x * orientation.x;
+			float yy = orientation.y * orientation.y;
+			float zz = orientation.z * orientation.z;
+			float xy = orientation.x * orientation.y;
+			float xz = orientation.x * orientation.z;
+			float yz = orientation.y * orientation.z;
+			float wx = orientation.w * orientation.x;
+			float wy = orientation.w * orientation.y;
+			float wz = orientation.w * orientation.z;
+
+#if defined(OVERDRIVE_SSE)
+			float* out = &result[0][0];
+
+			_mm_storeu_ps(out + 0, _mm_mul_ps(
+				_mm_setr_ps(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f),
+				_mm_set1_ps(scale.x)
+			));
+
+			_mm_storeu_ps(out + 4, _mm_mul_ps(
+				_mm_setr_ps(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f),
+				_mm_set1_ps(scale.y)
+			));
+
+			_mm_storeu_ps(out + 8, _mm_mul_ps(
+				_mm_setr_ps(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f),
+				_mm_set1_ps(scale.z)
+			));
+
+			_mm_storeu_ps(out + 12, _mm_setr_ps(position.x, position.y, position.z, 1.0f));
+#else
+			result[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+			result[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+			result[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+			result[3] = glm::vec4(position, 1.0f);
+#endif
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "../opengl.h"
+
+namespace overdrive {
+	namespace math {
+		// SIMD versions of some hot matrix operations; these fall back to plain glm when SSE is not available
+
+		// result = a * b
+		// [NOTE] result may be the same object as a or b
+		void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& result);
+
+		// result = translate(position) * rotate(orientation) * scale(scale)
+		void compose(
+			const glm::vec3& position,
+			const glm::quat& orientation,
+			const glm::vec3& scale,
+			glm::mat4& result
+		);
+	}
+}
@@ -22,8 +22,19 @@
 	//#include <DbgHelp.h> // [TODO] -- implement stack tracing
 
 	#define STDCALL __stdcall
+	#define NOINLINE __declspec(noinline)
 #else
 	#define STDCALL 
+	#define NOINLINE __attribute__((noinline))
+#endif
+
+// SIMD support; SSE2 is always available on x64, AVX depends on the /arch (or -mavx) setting
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+	#define OVERDRIVE_SSE
+#endif
+
+#ifdef __AVX__
+	#define OVERDRIVE_AVX
 #endif
 
 // with MSVC we can figure out wheter this is a debug build
@@ -53,7 +53,9 @@ namespace overdrive {
 
 		// [NOTE] bind/unbind looks like it could be RAII material as well
 		// [NOTE] maybe include things like cbegin() and cend() in the Data class?
-		// [NOTE] perhaps cache the bind/unbind status and provide an interface to query it?
+		// [NOTE] bindings go through the StateCache
+		// [NOTE] uploads and mapping use the COPY_WRITE target rather than the buffer's own, so that they
+		//        can't disturb the element array binding of whatever vertex array is bound
 		template <typename T>
 		class Buffer {
 		protected:
@@ -96,6 +98,7 @@ namespace overdrive {
 			eBufferUsage getUsage() const;
 			size_t getSize() const;
 
+			void upload(size_t first, const T* items, size_t count); // glBufferSubData, doesn't require the buffer to be mapped
 			Data map(std::initializer_list<eBufferAccess> access); //ex: auto data = map({ eBufferAccess::WRITE, eBufferAccess::INVALIDATE_BUFFER }); // ~ Extra braces, but still seems like a cleaner solution than variadic templates
 			bool isMapped() const;
 
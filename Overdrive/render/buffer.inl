@@ -1,6 +1,7 @@
 #pragma once
 
 #include "buffer.h"
+#include "state_cache.h"
 #include "../util/enum_bitfield.h"
 #include <exception>
 
@@ -15,10 +16,10 @@ namespace overdrive {
 		{
 			assert(buffer);
 
-			GLenum target = static_cast<GLenum>(buffer->getTarget());
+			GLenum target = GL_COPY_WRITE_BUFFER; // see the note at the Buffer class
 			GLsizeiptr numBytes = mNumItems * sizeof(T);
 
-			glBindBuffer(target, buffer->getHandle());
+			StateCache::current().bindBuffer(target, buffer->getHandle());
 
 			mHostMemory = reinterpret_cast<T*>(glMapBufferRange(
 				target,		// Specifies the name of the buffer object
@@ -27,8 +28,6 @@ namespace overdrive {
 				access		// Specifies a combination of access flags indicating the desired access to the mapped range
 			));
 
-			glBindBuffer(target, 0);
-
 			if (!mHostMemory)
 				throw std::runtime_error("Could not map buffer");
 
@@ -37,11 +36,10 @@ namespace overdrive {
 
 		template <typename T>
 		Buffer<T>::Data::~Data() {
-			GLenum target = static_cast<GLenum>(mBuffer->getTarget());
+			GLenum target = GL_COPY_WRITE_BUFFER;
 			
-			glBindBuffer(target, mBuffer->getHandle());
+			StateCache::current().bindBuffer(target, mBuffer->getHandle());
 			glUnmapBuffer(target);
-			glBindBuffer(target, 0);
 
 			mBuffer->mIsMapped = false;
 		}
@@ -104,13 +102,12 @@ namespace overdrive {
 			mNumItems(numItems),
 			mIsMapped(false)
 		{
-			GLenum target = static_cast<GLenum>(target_);
+			GLenum target = GL_COPY_WRITE_BUFFER;
 			size_t numBytes = numItems * sizeof(T);
 
 			glGenBuffers(1, &mHandle);
-			glBindBuffer(target, mHandle);
+			StateCache::current().bindBuffer(target, mHandle);
 			glBufferData(target, numBytes, nullptr, static_cast<GLenum>(usage));
-			glBindBuffer(target, 0);
 		}
 
 		template <typename T>
@@ -124,19 +121,20 @@ namespace overdrive {
 			mNumItems(items.size()),
 			mIsMapped(false)
 		{
-			GLenum target = static_cast<GLenum>(target_);
+			GLenum target = GL_COPY_WRITE_BUFFER;
 			size_t numBytes = items.size() * sizeof(T);
 
 			glGenBuffers(1, &mHandle);
-			glBindBuffer(target, mHandle);
+			StateCache::current().bindBuffer(target, mHandle);
 			glBufferData(target, numBytes, items.begin(), static_cast<GLenum>(usage));
-			glBindBuffer(target, 0);
 		}
 
 		template <typename T>
 		Buffer<T>::~Buffer() {
-			if (mHandle)
+			if (mHandle) {
+				StateCache::current().onDeleteBuffer(mHandle);
 				glDeleteBuffers(1, &mHandle);
+			}
 		}
 
 		template <typename T>
@@ -159,6 +157,17 @@ namespace overdrive {
 			return mNumItems;
 		}
 
+		template <typename T>
+		void Buffer<T>::upload(size_t first, const T* items, size_t count) {
+			if (mIsMapped)
+				throw std::runtime_error("Cannot upload to a mapped buffer");
+
+			assert(first + count <= mNumItems);
+
+			StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, mHandle);
+			glBufferSubData(GL_COPY_WRITE_BUFFER, first * sizeof(T), count * sizeof(T), items);
+		}
+
 		/*
 		template <typename T>
 		template <typename... Pack>
@@ -190,13 +199,13 @@ namespace overdrive {
 				throw std::runtime_error("Cannot bind a mapped buffer");
 
 			GLenum target = static_cast<GLenum>(mTarget);
-			glBindBuffer(target, mHandle);
+			StateCache::current().bindBuffer(target, mHandle);
 		}
 
 		template <typename T>
 		void Buffer<T>::unbind() {
 			GLenum target = static_cast<GLenum>(mTarget);
-			glBindBuffer(target, 0);
+			StateCache::current().bindBuffer(target, 0);
 		}
 
 		// ----- ostream << -----
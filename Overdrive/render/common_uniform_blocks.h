@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../opengl.h"
+#include "uniform_layout.h"
+#include <boost/fusion/adapted.hpp>
+
+namespace overdrive {
+	namespace render {
+		// uniform blocks that are provided by the Renderer; the members must follow std140 rules, which is
+		// checked at compile time below.
+		// Shaders should declare them with a matching binding, e.g.
+		//		layout (std140, binding = 1) uniform Camera {
+		//			mat4 uView;
+		//			mat4 uProjection;
+		//			mat4 uViewProjection;
+		//			vec4 uCameraPosition;
+		//		};
+		namespace blocks {
+			// bound once per flush
+			struct Frame {
+				static const GLuint BINDING = 0;
+
+				glm::vec2 mViewportSize;
+				float mTime;
+				float mDeltaTime;
+			};
+
+			// bound once per flush
+			struct Camera {
+				static const GLuint BINDING = 1;
+
+				glm::mat4 mView;
+				glm::mat4 mProjection;
+				glm::mat4 mViewProjection;
+				glm::vec4 mPosition;	// w = 1
+				glm::vec4 mClip;		// x = near, y = far
+			};
+
+			// streamed per draw, for programs that are not instanced
+			struct Object {
+				static const GLuint BINDING = 2;
+
+				glm::mat4 mModel;
+				glm::vec4 mData;
+			};
+		}
+	}
+}
+
+BOOST_FUSION_ADAPT_STRUCT(
+	overdrive::render::blocks::Frame,
+	(glm::vec2, mViewportSize)
+	(float, mTime)
+	(float, mDeltaTime)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+	overdrive::render::blocks::Camera,
+	(glm::mat4, mView)
+	(glm::mat4, mProjection)
+	(glm::mat4, mViewProjection)
+	(glm::vec4, mPosition)
+	(glm::vec4, mClip)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+	overdrive::render::blocks::Object,
+	(glm::mat4, mModel)
+	(glm::vec4, mData)
+)
+
+static_assert(overdrive::render::layout::IsCompatible<overdrive::render::blocks::Frame>::value, "Frame block does not match std140");
+static_assert(overdrive::render::layout::IsCompatible<overdrive::render::blocks::Camera>::value, "Camera block does not match std140");
+static_assert(overdrive::render::layout::IsCompatible<overdrive::render::blocks::Object>::value, "Object block does not match std140");
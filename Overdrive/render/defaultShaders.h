@@ -12,10 +12,18 @@ namespace overdrive {
 			1 - Normal
 			2 - TexCoord
 			3 - Color
+
+			Instanced vertex shaders (only provided for some formats) take the model matrix from a
+			per-instance attribute instead, see InstanceBuffer:
+			8..11 - Model matrix
+			12 - Instance data
+
+			They read the camera matrices from the Camera uniform block (see common_uniform_blocks.h).
 		*/
 		template <typename TVertexFormat>
 		struct DefaultShader {
 			static const char* getVertexShader();
+			static const char* getInstancedVertexShader();
 			static const char* getFragmentShader();			
 		};
 	}
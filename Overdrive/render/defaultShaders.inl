@@ -245,6 +245,44 @@ namespace overdrive {
 			)";
 		}
 
+		template <>
+		static const char* DefaultShader<attributes::PositionNormalTexCoord>::getInstancedVertexShader() {
+			return R"(
+				#version 420
+
+				layout (std140, binding = 1) uniform Camera {
+					mat4 uView;
+					mat4 uProjection;
+					mat4 uViewProjection;
+					vec4 uCameraPosition;
+					vec4 uCameraClip;
+				};
+
+				uniform vec4 uLightDirection;
+				uniform vec4 uLightAmbient;
+				uniform vec4 uLightDiffuse;
+
+				layout (location = 0) in vec3 aPosition;
+				layout (location = 1) in vec3 aNormal;
+				layout (location = 2) in vec2 aTexCoord;
+
+				layout (location = 8) in mat4 aInstanceModel;
+				layout (location = 12) in vec4 aInstanceData;
+
+				out vec4 vtxColor;
+				smooth out vec2 vtxTexCoord;
+
+				void main() {
+					gl_Position = uViewProjection * aInstanceModel * vec4(aPosition, 1.0);
+					
+					float diffuseFactor = clamp(dot(-aNormal, normalize(uLightDirection.xyz)), 0.0, 1.0);
+
+					vtxColor = uLightAmbient + uLightDiffuse * diffuseFactor;
+					vtxTexCoord = aTexCoord;
+				}
+			)";
+		}
+
 		template <>
 		static const char* DefaultShader<attributes::PositionNormalTexCoord>::getFragmentShader() {
 			return R"(
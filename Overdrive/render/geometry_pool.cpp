@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "geometry_pool.h"
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		GeometryPool::GeometryPool(
+			size_t maxVertices,
+			size_t maxIndices
+		):
+			mVertices(maxVertices),
+			mIndices(maxIndices),
+			mVertexSpace(maxVertices),
+			mIndexSpace(maxIndices)
+		{
+			mVAO.attach(mIndices);
+			mVAO.attach(mVertices);
+		}
+
+		GeometryRange GeometryPool::allocate(size_t numVertices, size_t numIndices) {
+			size_t firstVertex;
+			size_t firstIndex;
+
+			if (!mVertexSpace.allocate(numVertices, firstVertex))
+				throw std::runtime_error("GeometryPool is out of vertex space");
+
+			if (!mIndexSpace.allocate(numIndices, firstIndex)) {
+				mVertexSpace.free(firstVertex);
+				throw std::runtime_error("GeometryPool is out of index space");
+			}
+
+			GeometryRange result;
+
+			result.mFirstIndex = static_cast<GLuint>(firstIndex);
+			result.mNumIndices = static_cast<GLsizei>(numIndices);
+			result.mBaseVertex = static_cast<GLint>(firstVertex);
+
+			return result;
+		}
+
+		GeometryRange GeometryPool::add(
+			const VertexFormat* vertices,
+			size_t numVertices,
+			const IndexFormat* indices,
+			size_t numIndices
+		) {
+			GeometryRange result = allocate(numVertices, numIndices);
+
+			upload(result, vertices, numVertices, indices);
+
+			return result;
+		}
+
+		void GeometryPool::upload(
+			const GeometryRange& range,
+			const VertexFormat* vertices,
+			size_t numVertices,
+			const IndexFormat* indices
+		) {
+			mVertices.upload(range.mBaseVertex, vertices, numVertices);
+			mIndices.upload(range.mFirstIndex, indices, range.mNumIndices);
+		}
+
+		void GeometryPool::release(const GeometryRange& range) {
+			mVertexSpace.free(range.mBaseVertex);
+			mIndexSpace.free(range.mFirstIndex);
+		}
+
+		VertexArray& GeometryPool::getVAO() {
+			return mVAO;
+		}
+
+		size_t GeometryPool::getNumFreeVertices() const {
+			return mVertexSpace.getNumFree();
+		}
+
+		size_t GeometryPool::getNumFreeIndices() const {
+			return mIndexSpace.getNumFree();
+		}
+	}
+}
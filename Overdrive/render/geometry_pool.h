@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vertexbuffer.h"
+#include "indexbuffer.h"
+#include "vertexarray.h"
+#include "range_allocator.h"
+
+namespace overdrive {
+	namespace render {
+		/*
+			One big vertex/index buffer pair (and a vertex array that uses them) that meshes are
+			sub-allocated from. Everything in a pool can be drawn without switching vertex arrays, which
+			makes it possible to draw many different meshes with a single glMultiDrawElementsIndirect.
+
+			Indices are relative to the start of the mesh; the GeometryRange carries the base vertex.
+
+			[NOTE] the capacity is fixed, running out of space throws
+			[NOTE] this creates buffers in the constructor, so it needs a valid, active openGL context
+		*/
+		class GeometryPool {
+		public:
+			using VertexFormat	= attributes::PositionNormalTexCoord;
+			using VertexBuffer	= VertexBuffer<VertexFormat>;
+			using IndexFormat	= GLuint;
+			using IndexBuffer	= IndexBuffer<IndexFormat>;
+
+			static const size_t DEFAULT_NUM_VERTICES = 512 * 1024;
+			static const size_t DEFAULT_NUM_INDICES = 2 * 1024 * 1024;
+
+			GeometryPool(
+				size_t maxVertices = DEFAULT_NUM_VERTICES,
+				size_t maxIndices = DEFAULT_NUM_INDICES
+			);
+
+			GeometryPool(const GeometryPool&) = delete;
+			GeometryPool& operator = (const GeometryPool&) = delete;
+
+			GeometryRange allocate(size_t numVertices, size_t numIndices);
+			GeometryRange add(
+				const VertexFormat* vertices,
+				size_t numVertices,
+				const IndexFormat* indices,
+				size_t numIndices
+			); // allocate + upload
+
+			void upload(const GeometryRange& range, const VertexFormat* vertices, size_t numVertices, const IndexFormat* indices);
+			void release(const GeometryRange& range);
+
+			VertexArray& getVAO();
+
+			size_t getNumFreeVertices() const;
+			size_t getNumFreeIndices() const;
+
+		private:
+			VertexBuffer mVertices;
+			IndexBuffer mIndices;
+			VertexArray mVAO;
+
+			RangeAllocator mVertexSpace;
+			RangeAllocator mIndexSpace;
+		};
+	}
+}
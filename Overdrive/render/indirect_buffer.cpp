@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "indirect_buffer.h"
+#include <algorithm>
+
+namespace overdrive {
+	namespace render {
+		IndirectBuffer::IndirectBuffer(size_t capacity):
+			mStream(capacity * sizeof(DrawElementsIndirectCommand))
+		{
+		}
+
+		GLuint IndirectBuffer::getHandle() const {
+			return mStream.getHandle();
+		}
+
+		size_t IndirectBuffer::getCapacity() const {
+			return mStream.getRegionSize() / sizeof(DrawElementsIndirectCommand);
+		}
+
+		void IndirectBuffer::add(const DrawElementsIndirectCommand& command) {
+			if (!mPending.empty()) {
+				auto& last = mPending.back();
+
+				bool isContinuation =
+					(last.mCount == command.mCount) &&
+					(last.mFirstIndex == command.mFirstIndex) &&
+					(last.mBaseVertex == command.mBaseVertex) &&
+					(last.mBaseInstance + last.mInstanceCount == command.mBaseInstance);
+
+				if (isContinuation) {
+					last.mInstanceCount += command.mInstanceCount;
+					return;
+				}
+			}
+
+			mPending.push_back(command);
+		}
+
+		void IndirectBuffer::add(const VertexArray& vao, const GeometryRange& range, GLuint numInstances, GLuint baseInstance) {
+			GLsizei numIndices = (range.mNumIndices == 0) ? vao.getNumIndices() : range.mNumIndices;
+
+			add(DrawElementsIndirectCommand{
+				static_cast<GLuint>(numIndices),
+				numInstances,
+				range.mFirstIndex,
+				range.mBaseVertex,
+				baseInstance
+			});
+		}
+
+		bool IndirectBuffer::isEmpty() const {
+			return mPending.empty();
+		}
+
+		size_t IndirectBuffer::getNumPending() const {
+			return mPending.size();
+		}
+
+		const std::vector<DrawElementsIndirectCommand>& IndirectBuffer::getPending() const {
+			return mPending;
+		}
+
+		GLsizei IndirectBuffer::submit(VertexArray& vao, ePrimitives mode) {
+			GLsizei numCommands = static_cast<GLsizei>(mPending.size());
+
+			if (numCommands == 0)
+				return 0;
+
+			vao.bind();
+
+			// a single command doesn't need to go through the buffer
+			if (numCommands == 1) {
+				const auto& command = mPending.front();
+
+				GeometryRange range;
+				range.mFirstIndex = command.mFirstIndex;
+				range.mNumIndices = static_cast<GLsizei>(command.mCount);
+				range.mBaseVertex = command.mBaseVertex;
+
+				vao.drawBound(range, command.mInstanceCount, command.mBaseInstance, mode);
+			}
+			else {
+				const size_t stride = sizeof(DrawElementsIndirectCommand);
+
+				// [NOTE] more commands than fit in a region would throw; split up into region-sized draws
+				const DrawElementsIndirectCommand* commands = mPending.data();
+				size_t remaining = mPending.size();
+
+				mStream.bind(eBufferTarget::DRAW_INDIRECT);
+
+				while (remaining > 0) {
+					size_t count = std::min(remaining, getCapacity());
+					StreamAllocation allocation = mStream.allocate(count * stride, stride);
+
+					std::copy(commands, commands + count, allocation.as<DrawElementsIndirectCommand>());
+					vao.multiDrawIndirectBound(static_cast<GLsizei>(count), allocation.mOffset, mode);
+
+					commands += count;
+					remaining -= count;
+				}
+			}
+
+			mPending.clear();
+
+			return numCommands;
+		}
+
+		void IndirectBuffer::reset() {
+			mPending.clear();
+			mStream.advance();
+		}
+	}
+}
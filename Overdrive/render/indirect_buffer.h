@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../opengl.h"
+#include "vertexarray.h"
+#include "stream_buffer.h"
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		// http://docs.gl/gl4/glDrawElementsIndirect (layout is fixed by openGL)
+		struct DrawElementsIndirectCommand {
+			GLuint mCount;
+			GLuint mInstanceCount;
+			GLuint mFirstIndex;
+			GLint mBaseVertex;
+			GLuint mBaseInstance;
+		};
+
+		/*
+			Builds DRAW_INDIRECT commands for an indexed vertex array and submits them with a single
+			glMultiDrawElementsIndirect call. Commands that continue the previous one (same geometry, next
+			base instance) are merged by bumping the instance count.
+
+			The commands are streamed through a StreamBuffer, reset() moves on to the next region.
+
+			[NOTE] the buffer is created lazily on the first submission
+		*/
+		class IndirectBuffer {
+		public:
+			static const size_t DEFAULT_CAPACITY = 4096; // commands per frame
+
+			explicit IndirectBuffer(size_t capacity = DEFAULT_CAPACITY);
+
+			IndirectBuffer(const IndirectBuffer&) = delete;
+			IndirectBuffer& operator = (const IndirectBuffer&) = delete;
+
+			GLuint getHandle() const;
+			size_t getCapacity() const;
+
+			void add(const DrawElementsIndirectCommand& command);
+			void add(const VertexArray& vao, const GeometryRange& range, GLuint numInstances, GLuint baseInstance);
+
+			bool isEmpty() const;
+			size_t getNumPending() const;
+			const std::vector<DrawElementsIndirectCommand>& getPending() const;
+
+			GLsizei submit(VertexArray& vao, ePrimitives mode = ePrimitives::TRIANGLES); // draws and clears the pending commands, returns the number of commands
+			void reset(); // call once per frame, before the first submission
+
+		private:
+			StreamBuffer mStream;
+
+			std::vector<DrawElementsIndirectCommand> mPending;
+		};
+	}
+}
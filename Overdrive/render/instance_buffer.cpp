@@ -0,0 +1,77 @@
+#include "stdafx.h"
+#include "instance_buffer.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace overdrive {
+	namespace render {
+		InstanceBuffer::InstanceBuffer(
+			size_t instancesPerRegion,
+			size_t numRegions
+		):
+			mStream(instancesPerRegion * sizeof(attributes::Instance), numRegions)
+		{
+		}
+
+		GLuint InstanceBuffer::getHandle() const {
+			return mStream.getHandle();
+		}
+
+		size_t InstanceBuffer::getRegionSize() const {
+			return mStream.getRegionSize() / sizeof(attributes::Instance);
+		}
+
+		size_t InstanceBuffer::getNumRegions() const {
+			return mStream.getNumRegions();
+		}
+
+		InstanceRange InstanceBuffer::allocate(size_t maxCount) {
+			assert(maxCount > 0);
+
+			const size_t stride = sizeof(attributes::Instance);
+
+			size_t available = mStream.getNumAvailable(stride) / stride;
+
+			if (available == 0) {
+				mStream.advance();
+				available = mStream.getNumAvailable(stride) / stride;
+			}
+
+			size_t count = std::min(maxCount, available);
+
+			// the region size is a multiple of the stride, so the offset is always a whole number of instances
+			StreamAllocation allocation = mStream.allocate(count * stride, stride);
+
+			return InstanceRange{
+				allocation.as<attributes::Instance>(),
+				static_cast<GLuint>(allocation.mOffset / stride),
+				static_cast<GLsizei>(count)
+			};
+		}
+
+		void InstanceBuffer::advance() {
+			mStream.advance();
+		}
+
+		void InstanceBuffer::bindAttributes() {
+			using attributes::Instance;
+
+			mStream.bind(eBufferTarget::ARRAY);
+
+			const GLsizei stride = sizeof(Instance);
+
+			for (GLuint column = 0; column < 4; ++column) {
+				GLuint location = MODEL_LOCATION + column;
+				size_t offset = offsetof(Instance, mModel) + column * sizeof(glm::vec4);
+
+				glEnableVertexAttribArray(location);
+				glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offset));
+				glVertexAttribDivisor(location, 1);
+			}
+
+			glEnableVertexAttribArray(DATA_LOCATION);
+			glVertexAttribPointer(DATA_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(Instance, mData)));
+			glVertexAttribDivisor(DATA_LOCATION, 1);
+		}
+	}
+}
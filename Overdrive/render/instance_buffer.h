@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../opengl.h"
+#include "stream_buffer.h"
+#include <cstddef>
+
+namespace overdrive {
+	namespace render {
+		namespace attributes {
+			// per-instance vertex attributes (divisor 1)
+			struct Instance {
+				glm::mat4 mModel;	// locations 8..11, one column each
+				glm::vec4 mData;	// location 12, free for whatever the shader wants to do with it
+			};
+		}
+
+		struct InstanceRange {
+			attributes::Instance* mInstances;	// write-only, persistently mapped memory
+			GLuint mFirst;						// pass as baseInstance
+			GLsizei mCount;
+		};
+
+		/*
+			Per-instance data, streamed through a StreamBuffer. Ranges are aligned to whole instances, so
+			the offset of a range in the buffer can be expressed as a base instance.
+
+			A vertex array that has an InstanceBuffer attached reads instance i from element
+			(baseInstance + i), so a single attachment serves every range handed out by allocate().
+
+			[NOTE] the buffer is created lazily, so this can be a member of something that is constructed
+			       before there is an openGL context
+			[NOTE] instanced shaders should declare
+					layout (location = 8) in mat4 aInstanceModel;
+					layout (location = 12) in vec4 aInstanceData;
+		*/
+		class InstanceBuffer {
+		public:
+			static const GLuint MODEL_LOCATION = 8;
+			static const GLuint DATA_LOCATION = 12;
+			static const size_t DEFAULT_REGION_SIZE = 16 * 1024; // instances
+			static const size_t DEFAULT_NUM_REGIONS = 3;
+
+			InstanceBuffer(
+				size_t instancesPerRegion = DEFAULT_REGION_SIZE,
+				size_t numRegions = DEFAULT_NUM_REGIONS
+			);
+
+			InstanceBuffer(const InstanceBuffer&) = delete;
+			InstanceBuffer& operator = (const InstanceBuffer&) = delete;
+
+			GLuint getHandle() const;
+			size_t getRegionSize() const;
+			size_t getNumRegions() const;
+
+			InstanceRange allocate(size_t maxCount); // at least one, at most maxCount instances (limited by the space left in the region)
+			void advance(); // call after the draws using the current region have been issued
+
+			void bindAttributes(); // sets up the instance attributes of the bound vertex array
+
+		private:
+			StreamBuffer mStream;
+		};
+	}
+}
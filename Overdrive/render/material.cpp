@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "material.h"
+#include "shaderprogram.h"
+#include "texture2D.h"
+#include "textureCube.h"
+#include <atomic>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			std::atomic<uint16_t> gNextMaterialID(1);
+			std::atomic<uint16_t> gNextSortID(1); // 0 is left for draws without a material
+
+			uint16_t nextSortID() {
+				uint16_t result = gNextSortID++;
+
+				while (result == 0) // wrapped around
+					result = gNextSortID++;
+
+				return result;
+			}
+		}
+
+		// ----- Material -----
+		Material::Material(ShaderProgram* program):
+			mID(gNextMaterialID++),
+			mProgram(program)
+		{
+			assert(program);
+			assert(program->isLinked());
+		}
+
+		uint16_t Material::getID() const {
+			return mID;
+		}
+
+		ShaderProgram* Material::getProgram() const {
+			return mProgram;
+		}
+
+		RenderState& Material::getRenderState() {
+			return mRenderState;
+		}
+
+		void Material::addTexture(UniformHandle sampler, const TextureBinding& defaultBinding) {
+			validate(sampler);
+
+			for (const auto& name : mTextureNames)
+				if (name == sampler)
+					throw std::runtime_error(std::string("Duplicate material texture: ") + sampler.getName());
+
+			mTextureNames.push_back(sampler);
+			mTextures.push_back(defaultBinding);
+
+			mParameters.set(sampler, static_cast<GLint>(defaultBinding.mUnit));
+		}
+
+		const ParameterBlock& Material::getParameters() const {
+			return mParameters;
+		}
+
+		const std::vector<UniformHandle>& Material::getTextureNames() const {
+			return mTextureNames;
+		}
+
+		const std::vector<TextureBinding>& Material::getTextures() const {
+			return mTextures;
+		}
+
+		void Material::validate(UniformHandle handle) const {
+			if (!mProgram->hasUniform(handle))
+				throw std::runtime_error(std::string("Material program has no uniform ") + handle.getName());
+		}
+
+		// ----- MaterialInstance -----
+		MaterialInstance::MaterialInstance(Material& material):
+			mMaterial(&material),
+			mSortID(nextSortID()),
+			mParameters(material.getParameters()),
+			mTextures(material.getTextures())
+		{
+		}
+
+		Material& MaterialInstance::getMaterial() const {
+			return *mMaterial;
+		}
+
+		uint16_t MaterialInstance::getSortID() const {
+			return mSortID;
+		}
+
+		void MaterialInstance::setTexture(UniformHandle sampler, GLenum target, GLuint texture) {
+			const auto& names = mMaterial->getTextureNames();
+
+			for (size_t i = 0; i < names.size(); ++i) {
+				if (names[i] == sampler) {
+					mTextures[i].mTarget = target;
+					mTextures[i].mHandle = texture;
+					return;
+				}
+			}
+
+			throw std::runtime_error(std::string("Material has no texture ") + sampler.getName());
+		}
+
+		void MaterialInstance::setTexture(UniformHandle sampler, const Texture2D& texture) {
+			setTexture(sampler, GL_TEXTURE_2D, texture.getHandle());
+		}
+
+		void MaterialInstance::setTexture(UniformHandle sampler, const TextureCube& texture) {
+			setTexture(sampler, GL_TEXTURE_CUBE_MAP, texture.getHandle());
+		}
+
+		const ParameterBlock& MaterialInstance::getParameters() const {
+			return mParameters;
+		}
+
+		const TextureBinding* MaterialInstance::getTextures() const {
+			return mTextures.data();
+		}
+
+		uint32_t MaterialInstance::getNumTextures() const {
+			return static_cast<uint32_t>(mTextures.size());
+		}
+
+		void MaterialInstance::apply() const {
+			mParameters.apply(*mMaterial->getProgram());
+		}
+	}
+}
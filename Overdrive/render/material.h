@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../opengl.h"
+#include "parameter_block.h"
+#include "render_queue.h"
+#include "renderstate.h"
+#include <cstdint>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		class ShaderProgram;
+
+		/*
+			Template for MaterialInstances: a shared program and render state, plus the parameters (uniforms
+			and textures) with their default values. Every parameter is checked against the program once,
+			when it is added; instances copy the resulting layout and can only change the values.
+
+			[NOTE] define all parameters before creating instances, instances don't pick up parameters that
+			       are added afterwards
+			[NOTE] IDs are never re-used
+		*/
+		class Material {
+		public:
+			explicit Material(ShaderProgram* program);
+
+			Material(const Material&) = delete;
+			Material& operator = (const Material&) = delete;
+
+			uint16_t getID() const; // stable for the lifetime of the material
+			ShaderProgram* getProgram() const;
+			RenderState& getRenderState();
+
+			template <typename T>
+			void addParameter(UniformHandle handle, const T& defaultValue); // throws if the program doesn't have the uniform
+
+			void addTexture(UniformHandle sampler, const TextureBinding& defaultBinding); // also sets the sampler to the texture unit
+
+			const ParameterBlock& getParameters() const;
+			const std::vector<UniformHandle>& getTextureNames() const;
+			const std::vector<TextureBinding>& getTextures() const;
+
+		private:
+			void validate(UniformHandle handle) const;
+
+			uint16_t mID;
+
+			ShaderProgram* mProgram;
+			RenderState mRenderState;
+
+			ParameterBlock mParameters;
+			std::vector<UniformHandle> mTextureNames;
+			std::vector<TextureBinding> mTextures;
+		};
+
+		/*
+			Per-object values for the parameters of a Material. Switching between instances of the same
+			material only sends the values that differ (see ParameterBlock).
+
+			Draw commands that have a material instance take their program and textures from it; the sort
+			key groups the draws of an instance together (and instances of a material share its program,
+			which sorts first).
+
+			[NOTE] sort IDs are 16 bits and handed out in creation order, so they only repeat after 65535
+			       instances; a collision just merges two groups, the executing side compares the actual state
+		*/
+		class MaterialInstance {
+		public:
+			explicit MaterialInstance(Material& material);
+
+			Material& getMaterial() const;
+			uint16_t getSortID() const; // never 0, that is left for draws without a material
+
+			template <typename T>
+			void set(UniformHandle handle, const T& value); // throws if the material has no such parameter, or if T doesn't match its type
+
+			void setTexture(UniformHandle sampler, GLenum target, GLuint texture); // throws if the material has no such texture
+			void setTexture(UniformHandle sampler, const Texture2D& texture);
+			void setTexture(UniformHandle sampler, const TextureCube& texture);
+
+			const ParameterBlock& getParameters() const;
+			const TextureBinding* getTextures() const;
+			uint32_t getNumTextures() const;
+
+			void apply() const; // sends the changed parameters, the program should be bound
+
+		private:
+			Material* mMaterial;
+			uint16_t mSortID;
+
+			ParameterBlock mParameters;
+			std::vector<TextureBinding> mTextures;
+		};
+	}
+}
+
+#include "material.inl"
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "material.h"
+#include "shaderprogram.h"
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		template <typename T>
+		void Material::addParameter(UniformHandle handle, const T& defaultValue) {
+			validate(handle);
+			mParameters.set(handle, defaultValue);
+		}
+
+		template <typename T>
+		void MaterialInstance::set(UniformHandle handle, const T& value) {
+			const ParameterBlock& declared = mMaterial->getParameters();
+
+			if (!declared.has(handle))
+				throw std::runtime_error(std::string("Material has no parameter ") + handle.getName());
+
+			// the layout was validated when the material added the parameter, don't let an instance change it
+			if (!declared.holds<T>(handle))
+				throw std::runtime_error(std::string("Material parameter ") + handle.getName() + " set with a different type");
+
+			mParameters.set(handle, value);
+		}
+	}
+}
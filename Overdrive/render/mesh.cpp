@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "mesh.h"
+#include "shaderprogram.h"
+#include "state_cache.h"
+
+namespace overdrive {
+	namespace render {
+		Mesh::Mesh(
+			GeometryPool& pool,
+			const VertexFormat* vertices,
+			size_t numVertices,
+			const IndexFormat* indices,
+			size_t numIndices
+		):
+			mMaterial(nullptr),
+			mPool(&pool),
+			mNumVertices(numVertices)
+		{
+			mRange = pool.add(vertices, numVertices, indices, numIndices);
+		}
+
+		Mesh::~Mesh() {
+			mPool->release(mRange);
+		}
+
+		void Mesh::setMaterial(MaterialInstance* material) {
+			mMaterial = material;
+		}
+
+		MaterialInstance* Mesh::getMaterial() const {
+			return mMaterial;
+		}
+
+		const GeometryRange& Mesh::getRange() const {
+			return mRange;
+		}
+
+		VertexArray& Mesh::getVAO() const {
+			return mPool->getVAO();
+		}
+
+		size_t Mesh::getNumVertices() const {
+			return mNumVertices;
+		}
+
+		size_t Mesh::getNumIndices() const {
+			return static_cast<size_t>(mRange.mNumIndices);
+		}
+
+		void Mesh::draw() {
+			if (mMaterial) {
+				mMaterial->getMaterial().getProgram()->bind();
+				mMaterial->getMaterial().getRenderState().apply();
+				mMaterial->apply();
+
+				auto& cache = StateCache::current();
+				const TextureBinding* textures = mMaterial->getTextures();
+
+				for (uint32_t i = 0; i < mMaterial->getNumTextures(); ++i)
+					cache.bindTexture(textures[i].mUnit, textures[i].mTarget, textures[i].mHandle);
+			}
+
+			auto& vao = mPool->getVAO();
+
+			vao.bind();
+			vao.drawBound(mRange, 1, 0);
+		}
+	}
+}
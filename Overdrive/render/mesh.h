@@ -1,33 +1,50 @@
 #pragma once
 
-#include "shaderprogram.h"
-#include "indexbuffer.h"
-#include "vertexbuffer.h"
+#include "material.h"
+#include "geometry_pool.h"
 
 namespace overdrive {
 	namespace render {
+		/*
+			Geometry that lives in a shared GeometryPool; all meshes of a pool share a single vertex array,
+			so they can be batched together into multi-draw indirect calls by the renderer.
+
+			The storage is returned to the pool when the mesh is destroyed.
+		*/
 		class Mesh {
 		public:
-			using VertexFormat	= attributes::PositionNormalTexCoord;
-			using VertexBuffer	= VertexBuffer<VertexFormat>;
-			using IndexFormat	= GLuint;
-			using IndexBuffer	= IndexBuffer<IndexFormat>;
+			using VertexFormat	= GeometryPool::VertexFormat;
+			using IndexFormat	= GeometryPool::IndexFormat;
+
+			Mesh(
+				GeometryPool& pool,
+				const VertexFormat* vertices,
+				size_t numVertices,
+				const IndexFormat* indices,
+				size_t numIndices
+			);
+			~Mesh();
 
-			Mesh();
+			Mesh(const Mesh&) = delete;
+			Mesh& operator = (const Mesh&) = delete;
 			
-			void setVertices(const VertexBuffer& vtx);
-			void setIndices(const IndexBuffer& idx);
-			void setMaterial(ShaderProgram* material);
+			void setMaterial(MaterialInstance* material);
+			MaterialInstance* getMaterial() const;
+
+			const GeometryRange& getRange() const;
+			VertexArray& getVAO() const;
 
-			// [NOTE] need some kind of interface to store and set material parameters for this specific instance
+			size_t getNumVertices() const;
+			size_t getNumIndices() const;
 			
-			void draw();
+			void draw(); // draws just this mesh, prefer submitting a DrawCommand to the Renderer
 
 		private:
-			ShaderProgram* mMaterial; // ~ should this perchance be an actually shared object?
+			MaterialInstance* mMaterial; // not owned, instances are usually shared between meshes
 
-			VertexBuffer mVertices;
-			IndexBuffer mIndices;
+			GeometryPool* mPool;
+			GeometryRange mRange;
+			size_t mNumVertices;
 		};
 	}
 }
@@ -0,0 +1,38 @@
+#include "stdafx.h"
+#include "parameter_block.h"
+
+namespace overdrive {
+	namespace render {
+		bool ParameterBlock::has(UniformHandle handle) const {
+			return (find(handle) != nullptr);
+		}
+
+		void ParameterBlock::apply(ShaderProgram& program) const {
+			const uint8_t* data = mData.data();
+
+			for (const auto& parameter : mParameters)
+				parameter.mApply(program, parameter.mHandle, data + parameter.mOffset);
+		}
+
+		void ParameterBlock::clear() {
+			mParameters.clear();
+			mData.clear();
+		}
+
+		size_t ParameterBlock::getNumParameters() const {
+			return mParameters.size();
+		}
+
+		const std::vector<uint8_t>& ParameterBlock::getData() const {
+			return mData;
+		}
+
+		const ParameterBlock::Parameter* ParameterBlock::find(UniformHandle handle) const {
+			for (const auto& parameter : mParameters)
+				if (parameter.mHandle == handle)
+					return &parameter;
+
+			return nullptr;
+		}
+	}
+}
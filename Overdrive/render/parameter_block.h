@@ -0,0 +1,61 @@
+#pragma once
+
+#include "uniform_handle.h"
+#include <cstdint>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		class ShaderProgram;
+
+		/*
+			A recorded set of uniform values, e.g. the parameters of a material. The values are kept in a
+			single blob; apply() sends them to a program through UniformHandles, which means that the
+			program skips every value that is the same as the one it received last. Re-applying a block
+			that didn't change therefore only costs the comparisons.
+
+			[NOTE] any type that ShaderProgram::setUniform(GLint, const T&) accepts can be stored
+			[NOTE] the program should be bound when applying
+		*/
+		class ParameterBlock {
+		public:
+			template <typename T>
+			void set(UniformHandle handle, const T& value);
+
+			template <typename T>
+			bool get(UniformHandle handle, T& value) const; // false if there is no parameter with this name (and size)
+
+			bool has(UniformHandle handle) const;
+
+			template <typename T>
+			bool holds(UniformHandle handle) const; // true if there is a parameter with this name, of type T
+
+			void apply(ShaderProgram& program) const;
+			void clear();
+
+			size_t getNumParameters() const;
+			const std::vector<uint8_t>& getData() const;
+
+		private:
+			typedef void(*ApplyFunction)(ShaderProgram& program, UniformHandle handle, const uint8_t* data);
+
+			struct Parameter {
+				UniformHandle mHandle;
+				ApplyFunction mApply;
+				uint32_t mOffset; // into mData
+				uint32_t mSize;
+				uint32_t mCapacity; // bytes reserved at mOffset
+			};
+
+			template <typename T>
+			static void applyParameter(ShaderProgram& program, UniformHandle handle, const uint8_t* data);
+
+			const Parameter* find(UniformHandle handle) const;
+
+			std::vector<Parameter> mParameters; // few enough that a linear search is fine
+			std::vector<uint8_t> mData;
+		};
+	}
+}
+
+#include "parameter_block.inl"
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "parameter_block.h"
+#include "shaderprogram.h"
+#include <cstring>
+#include <type_traits>
+
+namespace overdrive {
+	namespace render {
+		template <typename T>
+		void ParameterBlock::set(UniformHandle handle, const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "Parameters are stored as raw bytes");
+
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+
+			for (auto& parameter : mParameters) {
+				if (parameter.mHandle != handle)
+					continue;
+
+				if (sizeof(T) <= parameter.mCapacity) {
+					std::memcpy(mData.data() + parameter.mOffset, bytes, sizeof(T));
+				}
+				else {
+					// a larger type, move it to the end (the old bytes are left unused)
+					parameter.mOffset = static_cast<uint32_t>(mData.size());
+					parameter.mCapacity = static_cast<uint32_t>(sizeof(T));
+					mData.insert(mData.end(), bytes, bytes + sizeof(T));
+				}
+
+				parameter.mSize = static_cast<uint32_t>(sizeof(T));
+
+				parameter.mApply = &applyParameter<T>;
+				return;
+			}
+
+			mParameters.push_back(Parameter{
+				handle,
+				&applyParameter<T>,
+				static_cast<uint32_t>(mData.size()),
+				static_cast<uint32_t>(sizeof(T)),
+				static_cast<uint32_t>(sizeof(T))
+			});
+
+			mData.insert(mData.end(), bytes, bytes + sizeof(T));
+		}
+
+		template <typename T>
+		bool ParameterBlock::get(UniformHandle handle, T& value) const {
+			const Parameter* parameter = find(handle);
+
+			if (!parameter || (parameter->mSize != sizeof(T)))
+				return false;
+
+			std::memcpy(&value, mData.data() + parameter->mOffset, sizeof(T));
+			return true;
+		}
+
+		template <typename T>
+		bool ParameterBlock::holds(UniformHandle handle) const {
+			const Parameter* parameter = find(handle);
+
+			// the apply function is instantiated per type, so it doubles as a type tag
+			return
+				parameter &&
+				(parameter->mSize == sizeof(T)) &&
+				(parameter->mApply == &applyParameter<T>);
+		}
+
+		template <typename T>
+		void ParameterBlock::applyParameter(ShaderProgram& program, UniformHandle handle, const uint8_t* data) {
+			T value; // the blob isn't aligned
+			std::memcpy(&value, data, sizeof(T));
+
+			program.setUniform(handle, value);
+		}
+	}
+}
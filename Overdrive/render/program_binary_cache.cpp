@@ -0,0 +1,393 @@
+#include "stdafx.h"
+#include "program_binary_cache.h"
+#include "shaderprogram.h"
+#include "../core/logger.h"
+#include "../util/exception.h"
+#include "../util/string_hash.h"
+#include <cstring>
+#include <fstream>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			typedef std::chrono::high_resolution_clock Clock;
+
+			const uint32_t CACHE_MAGIC = 0x4250444F; // 'ODPB'
+			const uint32_t CACHE_VERSION = 1;
+
+			// file layout: FileHeader, mNumEntries * FileEntry, binaries
+			struct FileHeader {
+				uint32_t mMagic;
+				uint32_t mVersion;
+				uint64_t mDriverHash;
+				uint32_t mNumEntries;
+				uint32_t mReserved;
+			};
+
+			struct FileEntry {
+				uint64_t mKey;
+				uint64_t mOffset; // from the start of the file
+				uint32_t mFormat;
+				uint32_t mSize;
+			};
+
+			uint64_t hashString(const std::string& str, uint64_t seed) {
+				uint64_t length = str.size();
+
+				seed = util::hashBytes(&length, sizeof(length), seed);
+				return util::hashBytes(str.data(), str.size(), seed);
+			}
+
+			std::string getDriverString(GLenum name) {
+				const GLubyte* str = glGetString(name);
+
+				if (!str)
+					return std::string();
+
+				return reinterpret_cast<const char*>(str);
+			}
+
+			std::chrono::microseconds elapsedSince(Clock::time_point start) {
+				return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start);
+			}
+		}
+
+		ProgramBinaryCache::ProgramBinaryCache(const boost::filesystem::path& p):
+			mPath(p),
+			mDriverHash(0),
+			mIsSupported(isSupported()),
+			mIsDirty(false)
+		{
+			mDriverHash = hashString(getDriverString(GL_VENDOR), mDriverHash);
+			mDriverHash = hashString(getDriverString(GL_RENDERER), mDriverHash);
+			mDriverHash = hashString(getDriverString(GL_VERSION), mDriverHash);
+
+			if (mIsSupported)
+				open();
+			else
+				gLogWarning << "Program binaries are not supported by the driver, shaders will always be compiled";
+		}
+
+		ProgramBinaryCache::~ProgramBinaryCache() {
+			try {
+				save();
+			}
+			catch (const std::exception& ex) {
+				gLogError << "Failed to save program binary cache " << mPath << ": " << ex.what();
+			}
+		}
+
+		bool ProgramBinaryCache::isSupported() {
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+			return (numFormats > 0);
+		}
+
+		void ProgramBinaryCache::build(
+			ShaderProgram& program,
+			const std::vector<ShaderSource>& sources,
+			const std::vector<std::string>& defines
+		) {
+			auto start = Clock::now();
+			uint64_t key = getKey(sources, defines);
+
+			if (load(program, key)) {
+				mStats.mLoadTime += elapsedSince(start);
+				return;
+			}
+
+			if (mIsSupported)
+				program.setBinaryRetrievable(true);
+
+			for (const auto& source : sources)
+				program.attachShader(injectDefines(source.mSource, defines), source.mType);
+
+			program.link();
+
+			if (!program.isLinked())
+				throw ShaderException("Failed to link shader program");
+
+			store(program, key);
+
+			mStats.mCompileTime += elapsedSince(start);
+		}
+
+		uint64_t ProgramBinaryCache::getKey(
+			const std::vector<ShaderSource>& sources,
+			const std::vector<std::string>& defines
+		) const {
+			uint64_t result = mDriverHash;
+
+			for (const auto& source : sources) {
+				uint32_t type = static_cast<uint32_t>(source.mType);
+
+				result = util::hashBytes(&type, sizeof(type), result);
+				result = hashString(source.mSource, result);
+			}
+
+			for (const auto& define : defines)
+				result = hashString(define, result);
+
+			return result;
+		}
+
+		bool ProgramBinaryCache::load(ShaderProgram& program, uint64_t key) {
+			auto it = mEntries.find(key);
+
+			if (it == mEntries.end()) {
+				++mStats.mNumMisses;
+				return false;
+			}
+
+			const Entry& entry = it->second;
+
+			if (!program.loadBinary(entry.mFormat, entry.mData, static_cast<GLsizei>(entry.mSize))) {
+				gLogWarning << "Driver rejected cached program binary, recompiling";
+
+				++mStats.mNumRejected;
+				++mStats.mNumMisses;
+
+				mEntries.erase(it);
+				mIsDirty = true;
+
+				return false;
+			}
+
+			++mStats.mNumHits;
+
+			return true;
+		}
+
+		void ProgramBinaryCache::store(const ShaderProgram& program, uint64_t key) {
+			if (!mIsSupported)
+				return;
+
+			Entry entry;
+			std::vector<uint8_t> data;
+
+			if (!program.getBinary(entry.mFormat, data)) {
+				gLogWarning << "Could not retrieve program binary";
+				return;
+			}
+
+			mStored.push_back(std::move(data));
+
+			entry.mData = mStored.back().data();
+			entry.mSize = static_cast<uint32_t>(mStored.back().size());
+
+			mEntries[key] = entry;
+			mIsDirty = true;
+		}
+
+		void ProgramBinaryCache::save() {
+			if (!mIsDirty)
+				return;
+
+			// write everything to a temporary file first, the current one is still mapped
+			boost::filesystem::path temporary = mPath;
+			temporary += ".tmp";
+
+			{
+				std::ofstream ofs(temporary.c_str(), std::ios::binary | std::ios::trunc);
+
+				if (!ofs.good())
+					throw std::runtime_error("Could not open file for writing");
+
+				FileHeader header;
+
+				header.mMagic = CACHE_MAGIC;
+				header.mVersion = CACHE_VERSION;
+				header.mDriverHash = mDriverHash;
+				header.mNumEntries = static_cast<uint32_t>(mEntries.size());
+				header.mReserved = 0;
+
+				ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+				uint64_t offset = sizeof(FileHeader) + mEntries.size() * sizeof(FileEntry);
+
+				for (const auto& item : mEntries) {
+					FileEntry entry;
+
+					entry.mKey = item.first;
+					entry.mOffset = offset;
+					entry.mFormat = item.second.mFormat;
+					entry.mSize = item.second.mSize;
+
+					ofs.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+					offset += entry.mSize;
+				}
+
+				for (const auto& item : mEntries)
+					ofs.write(reinterpret_cast<const char*>(item.second.mData), item.second.mSize);
+
+				if (!ofs.good())
+					throw std::runtime_error("Failed to write program binary cache");
+			}
+
+			// the mapping has to go before the file can be replaced; if that fails the entries (and the old
+			// file) are still there, and the next save tries again
+			detach();
+
+			boost::system::error_code ec;
+			boost::filesystem::rename(temporary, mPath, ec);
+
+			if (ec) {
+				std::string reason = ec.message();
+
+				boost::filesystem::remove(temporary, ec);
+
+				throw std::runtime_error("Could not replace program binary cache: " + reason);
+			}
+
+			close();
+			open();
+		}
+
+		size_t ProgramBinaryCache::getNumEntries() const {
+			return mEntries.size();
+		}
+
+		const ProgramBinaryCache::Stats& ProgramBinaryCache::getStats() const {
+			return mStats;
+		}
+
+		void ProgramBinaryCache::open() {
+			mIsDirty = false;
+
+			boost::system::error_code ec;
+			auto numBytes = boost::filesystem::file_size(mPath, ec);
+
+			if (ec || (numBytes < sizeof(FileHeader)))
+				return; // no cache yet
+
+			try {
+				mFile.open(mPath);
+			}
+			catch (const FileException&) {
+				gLogWarning << "Could not map program binary cache " << mPath;
+				close();
+				return;
+			}
+
+			numBytes = mFile.getSize(); // may have changed in the meantime
+
+			if (numBytes < sizeof(FileHeader)) {
+				close();
+				return;
+			}
+
+			const uint8_t* base = mFile.getData();
+			const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+
+			if (
+				(header->mMagic != CACHE_MAGIC) ||
+				(header->mVersion != CACHE_VERSION) ||
+				(header->mDriverHash != mDriverHash)
+			) {
+				gLogDebug << "Program binary cache " << mPath << " is out of date, discarding";
+				close();
+				mIsDirty = true; // make sure it gets replaced
+				return;
+			}
+
+			if (sizeof(FileHeader) + header->mNumEntries * sizeof(FileEntry) > numBytes) {
+				gLogWarning << "Program binary cache " << mPath << " is corrupt, discarding";
+				close();
+				mIsDirty = true;
+				return;
+			}
+
+			const FileEntry* entries = reinterpret_cast<const FileEntry*>(base + sizeof(FileHeader));
+
+			mEntries.reserve(header->mNumEntries);
+
+			for (uint32_t i = 0; i < header->mNumEntries; ++i) {
+				const FileEntry& item = entries[i];
+
+				// written so that a huge offset can't wrap around
+				if ((item.mOffset > numBytes) || (item.mSize > numBytes - item.mOffset)) {
+					mIsDirty = true; // skip this one, write a fixed file later on
+					continue;
+				}
+
+				Entry entry;
+
+				entry.mFormat = item.mFormat;
+				entry.mData = base + item.mOffset;
+				entry.mSize = item.mSize;
+
+				mEntries[item.mKey] = entry;
+			}
+		}
+
+		void ProgramBinaryCache::close() {
+			mEntries.clear();
+			mStored.clear();
+
+			mFile.close();
+		}
+
+		void ProgramBinaryCache::detach() {
+			if (!mFile.isOpen())
+				return;
+
+			const uint8_t* begin = mFile.getData();
+			const uint8_t* end = begin + mFile.getSize();
+
+			for (auto& item : mEntries) {
+				Entry& entry = item.second;
+
+				if ((entry.mData < begin) || (entry.mData >= end))
+					continue; // already in mStored
+
+				mStored.emplace_back(entry.mData, entry.mData + entry.mSize);
+				entry.mData = mStored.back().data();
+			}
+
+			mFile.close();
+		}
+
+		std::string injectDefines(const std::string& source, const std::vector<std::string>& defines) {
+			if (defines.empty())
+				return source;
+
+			std::string block;
+
+			for (const auto& define : defines) {
+				block += "#define ";
+				block += define;
+				block += '\n';
+			}
+
+			// #version must be the first statement in a shader, so the defines go right after it
+			size_t position = source.find("#version");
+
+			if (position == std::string::npos)
+				return block + source;
+
+			position = source.find('\n', position);
+
+			if (position == std::string::npos)
+				return source + '\n' + block;
+
+			std::string result = source;
+			result.insert(position + 1, block);
+
+			return result;
+		}
+
+		std::ostream& operator << (std::ostream& os, const ProgramBinaryCache::Stats& stats) {
+			os
+				<< "Program binary cache: "
+				<< stats.mNumHits << " hits ("
+				<< (stats.mLoadTime.count() / 1000.0) << " ms), "
+				<< stats.mNumMisses << " misses ("
+				<< (stats.mCompileTime.count() / 1000.0) << " ms), "
+				<< stats.mNumRejected << " rejected";
+
+			return os;
+		}
+	}
+}
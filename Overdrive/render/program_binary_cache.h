@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../opengl.h"
+#include "shader.h"
+#include "../util/mapped_file.h"
+#include <boost/container/flat_map.hpp>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		class ShaderProgram;
+
+		struct ShaderSource {
+			eShaderType mType;
+			std::string mSource;
+		};
+
+		/*
+			Keeps linked program binaries (glGetProgramBinary) in a single file, so that the next run can
+			skip compiling and linking. Programs are identified by a hash of their sources, the defines
+			that were used and the GL vendor/renderer/version strings.
+
+			The cache file is memory mapped while reading; binaries from this run are kept in memory
+			until save() (or the destructor) writes a new file.
+
+			Usage:
+				ProgramBinaryCache cache("shaders.cache");
+				cache.build(program, { { eShaderType::VERTEX, vs }, { eShaderType::FRAGMENT, fs } });
+
+			[NOTE] the file is replaced as a whole when saving, entries for other drivers are dropped
+			[NOTE] if the driver rejects a binary, the program is compiled from source and the entry is replaced
+			[NOTE] this queries the driver strings in the constructor, so it needs a valid, active openGL context
+		*/
+		class ProgramBinaryCache {
+		public:
+			struct Stats {
+				uint32_t mNumHits = 0;
+				uint32_t mNumMisses = 0;
+				uint32_t mNumRejected = 0;	// found in the cache, but the driver refused it
+
+				std::chrono::microseconds mLoadTime = std::chrono::microseconds(0);		// programs restored from binaries
+				std::chrono::microseconds mCompileTime = std::chrono::microseconds(0);	// programs built from source
+			};
+
+			explicit ProgramBinaryCache(const boost::filesystem::path& p);
+			~ProgramBinaryCache();
+
+			ProgramBinaryCache(const ProgramBinaryCache&) = delete;
+			ProgramBinaryCache& operator = (const ProgramBinaryCache&) = delete;
+
+			static bool isSupported(); // the driver supports at least one binary format
+
+			// restores the program from the cache, or compiles and links it and adds the result to the cache
+			// the defines are inserted after the #version line as '#define <define>'
+			void build(
+				ShaderProgram& program,
+				const std::vector<ShaderSource>& sources,
+				const std::vector<std::string>& defines = std::vector<std::string>()
+			);
+
+			uint64_t getKey(
+				const std::vector<ShaderSource>& sources,
+				const std::vector<std::string>& defines = std::vector<std::string>()
+			) const;
+
+			bool load(ShaderProgram& program, uint64_t key);	// false if missing or rejected
+			void store(const ShaderProgram& program, uint64_t key); // program must be linked with setBinaryRetrievable
+
+			void save(); // no-op if nothing changed
+
+			size_t getNumEntries() const;
+			const Stats& getStats() const;
+
+		private:
+			struct Entry {
+				GLenum mFormat;
+				const uint8_t* mData; // either in the mapped file or in mStored
+				uint32_t mSize;
+			};
+
+			void open();
+			void close();
+			void detach(); // copies the binaries that live in the mapped file into mStored, and unmaps the file
+
+			boost::filesystem::path mPath;
+			uint64_t mDriverHash;
+			bool mIsSupported;
+
+			util::MappedFile mFile;
+
+			boost::container::flat_map<uint64_t, Entry> mEntries;
+			std::deque<std::vector<uint8_t>> mStored; // binaries that were added during this run
+			bool mIsDirty;
+
+			Stats mStats;
+		};
+
+		std::string injectDefines(const std::string& source, const std::vector<std::string>& defines);
+
+		std::ostream& operator << (std::ostream& os, const ProgramBinaryCache::Stats& stats);
+	}
+}
@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "range_allocator.h"
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		RangeAllocator::RangeAllocator(size_t capacity):
+			mNumFree(capacity)
+		{
+			if (capacity > 0)
+				mFree[0] = capacity;
+		}
+
+		bool RangeAllocator::allocate(size_t count, size_t& offset) {
+			assert(count > 0);
+
+			for (auto it = mFree.begin(); it != mFree.end(); ++it) {
+				if (it->second < count)
+					continue;
+
+				offset = it->first;
+				size_t remaining = it->second - count;
+
+				mFree.erase(it);
+
+				if (remaining > 0)
+					mFree[offset + count] = remaining;
+
+				mUsed[offset] = count;
+				mNumFree -= count;
+
+				return true;
+			}
+
+			return false;
+		}
+
+		size_t RangeAllocator::free(size_t offset) {
+			auto used = mUsed.find(offset);
+
+			if (used == mUsed.end())
+				throw std::runtime_error("Tried to free a range that was not allocated");
+
+			size_t numFreed = used->second;
+			size_t count = numFreed;
+
+			mUsed.erase(used);
+			mNumFree += numFreed;
+
+			auto next = mFree.lower_bound(offset);
+
+			// merge with the following block
+			if ((next != mFree.end()) && (next->first == offset + count)) {
+				count += next->second;
+				next = mFree.erase(next);
+			}
+
+			// merge with the preceding block
+			if (next != mFree.begin()) {
+				auto previous = std::prev(next);
+
+				if (previous->first + previous->second == offset) {
+					previous->second += count;
+					return numFreed;
+				}
+			}
+
+			mFree[offset] = count;
+
+			return numFreed;
+		}
+
+		size_t RangeAllocator::getNumFree() const {
+			return mNumFree;
+		}
+
+		size_t RangeAllocator::getNumFreeBlocks() const {
+			return mFree.size();
+		}
+	}
+}
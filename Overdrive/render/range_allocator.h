@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+namespace overdrive {
+	namespace render {
+		/*
+			Hands out ranges of [0, capacity) (elements of a buffer, typically), first fit.
+			Adjacent free blocks are merged again when a range is freed.
+		*/
+		class RangeAllocator {
+		public:
+			explicit RangeAllocator(size_t capacity);
+
+			bool allocate(size_t count, size_t& offset); // false if there's no block large enough
+			size_t free(size_t offset); // yields the size of the freed block, throws if it wasn't allocated
+
+			size_t getNumFree() const;
+			size_t getNumFreeBlocks() const;
+
+		private:
+			std::map<size_t, size_t> mFree; // offset -> size
+			std::map<size_t, size_t> mUsed;
+			size_t mNumFree;
+		};
+	}
+}
@@ -0,0 +1,238 @@
+#include "stdafx.h"
+#include "render_queue.h"
+#include "shaderprogram.h"
+#include "material.h"
+#include "texture2D.h"
+#include "textureCube.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			const uint32_t PASS_SHIFT		= 60;
+			const uint32_t DEPTH_SHIFT		= 48;
+			const uint32_t PROGRAM_SHIFT	= 32;
+			const uint32_t MATERIAL_SHIFT	= 16;
+
+			const uint64_t ID_MASK = 0xFFFF;
+
+			size_t toIndex(eRenderPass pass) {
+				return static_cast<size_t>(pass);
+			}
+		}
+
+		TextureBinding::TextureBinding(GLenum target, GLuint handle, GLuint unit):
+			mTarget(target),
+			mHandle(handle),
+			mUnit(unit)
+		{
+		}
+
+		TextureBinding::TextureBinding(const Texture2D& texture, GLuint unit):
+			mTarget(GL_TEXTURE_2D),
+			mHandle(texture.getHandle()),
+			mUnit(unit)
+		{
+		}
+
+		TextureBinding::TextureBinding(const TextureCube& texture, GLuint unit):
+			mTarget(GL_TEXTURE_CUBE_MAP),
+			mHandle(texture.getHandle()),
+			mUnit(unit)
+		{
+		}
+
+		bool operator == (const TextureBinding& a, const TextureBinding& b) {
+			return
+				(a.mTarget == b.mTarget) &&
+				(a.mHandle == b.mHandle) &&
+				(a.mUnit == b.mUnit);
+		}
+
+		bool operator != (const TextureBinding& a, const TextureBinding& b) {
+			return !(a == b);
+		}
+
+		bool isSameBatch(const DrawCommand& a, const DrawCommand& b) {
+			return
+				(a.mMaterial == b.mMaterial) &&
+				(a.mProgram == b.mProgram) &&
+				(a.mVAO == b.mVAO) &&
+				(a.mPrimitive == b.mPrimitive) &&
+				(a.mNumTextures == b.mNumTextures) &&
+				std::equal(a.mTextures, a.mTextures + a.mNumTextures, b.mTextures);
+		}
+
+		RenderQueue::RenderQueue(size_t arenaSize):
+			mArena(arenaSize)
+		{
+			for (auto& numBuckets : mNumDepthBuckets)
+				numBuckets = MAX_DEPTH_BUCKET + 1;
+
+			mNumDepthBuckets[toIndex(eRenderPass::SOLID)] = DEFAULT_SOLID_BUCKETS;
+		}
+
+		uint64_t RenderQueue::makeKey(
+			eRenderPass pass,
+			uint32_t depthBucket,
+			GLuint program,
+			GLuint material,
+			GLuint vao
+		) {
+			assert(toIndex(pass) < 16);
+			assert(depthBucket <= MAX_DEPTH_BUCKET);
+
+			return
+				(static_cast<uint64_t>(pass) << PASS_SHIFT) |
+				(static_cast<uint64_t>(depthBucket) << DEPTH_SHIFT) |
+				((program & ID_MASK) << PROGRAM_SHIFT) |
+				((material & ID_MASK) << MATERIAL_SHIFT) |
+				(vao & ID_MASK);
+		}
+
+		eRenderPass RenderQueue::getPass(uint64_t key) {
+			return static_cast<eRenderPass>(key >> PASS_SHIFT);
+		}
+
+		uint32_t RenderQueue::getDepthBucket(uint64_t key) {
+			return static_cast<uint32_t>(key >> DEPTH_SHIFT) & MAX_DEPTH_BUCKET;
+		}
+
+		void RenderQueue::setNumDepthBuckets(eRenderPass pass, uint32_t numBuckets) {
+			mNumDepthBuckets[toIndex(pass)] = std::max(1u, std::min(numBuckets, MAX_DEPTH_BUCKET + 1));
+		}
+
+		uint32_t RenderQueue::getNumDepthBuckets(eRenderPass pass) const {
+			return mNumDepthBuckets[toIndex(pass)];
+		}
+
+		void RenderQueue::submit(
+			const DrawCommand& command,
+			eRenderPass pass,
+			float depth
+		) {
+			assert(command.mVAO);
+
+			auto cmd = new (mArena.allocate<DrawCommand>(1)) DrawCommand(command);
+
+			if (command.mMaterial) {
+				cmd->mProgram = command.mMaterial->getMaterial().getProgram();
+				cmd->mTextures = command.mMaterial->getTextures();
+				cmd->mNumTextures = command.mMaterial->getNumTextures();
+			}
+
+			assert(cmd->mProgram);
+
+			if (cmd->mNumTextures > 0) {
+				auto textures = mArena.allocate<TextureBinding>(cmd->mNumTextures);
+				std::uninitialized_copy(cmd->mTextures, cmd->mTextures + cmd->mNumTextures, textures);
+				cmd->mTextures = textures;
+			}
+
+			GLuint material =
+				command.mMaterial ? command.mMaterial->getSortID() :
+				(cmd->mNumTextures > 0) ? cmd->mTextures[0].mHandle : 0;
+
+			mPackets.push_back(Packet{
+				makeKey(
+					pass,
+					quantize(pass, depth),
+					cmd->mProgram->getHandle(),
+					material,
+					command.mVAO->getHandle()
+				),
+				cmd
+			});
+		}
+
+		void RenderQueue::sort() {
+			size_t numPackets = mPackets.size();
+
+			if (numPackets < 2)
+				return;
+
+			mScratch.resize(numPackets);
+
+			Packet* source = mPackets.data();
+			Packet* destination = mScratch.data();
+
+			size_t histogram[8][256];
+			std::memset(histogram, 0, sizeof(histogram));
+
+			// gather all histograms in a single pass over the keys
+			for (size_t i = 0; i < numPackets; ++i) {
+				uint64_t key = source[i].mKey;
+
+				for (int digit = 0; digit < 8; ++digit)
+					++histogram[digit][(key >> (digit * 8)) & 0xFF];
+			}
+
+			for (int digit = 0; digit < 8; ++digit) {
+				size_t* counts = histogram[digit];
+				uint32_t shift = digit * 8;
+
+				// all keys share this byte, nothing would move
+				if (counts[(source[0].mKey >> shift) & 0xFF] == numPackets)
+					continue;
+
+				size_t offset = 0;
+				for (int i = 0; i < 256; ++i) {
+					size_t count = counts[i];
+					counts[i] = offset;
+					offset += count;
+				}
+
+				for (size_t i = 0; i < numPackets; ++i)
+					destination[counts[(source[i].mKey >> shift) & 0xFF]++] = source[i];
+
+				std::swap(source, destination);
+			}
+
+			if (source != mPackets.data())
+				mPackets.swap(mScratch);
+		}
+
+		void RenderQueue::clear() {
+			mPackets.clear();
+			mArena.reset();
+		}
+
+		bool RenderQueue::isEmpty() const {
+			return mPackets.empty();
+		}
+
+		size_t RenderQueue::getNumPackets() const {
+			return mPackets.size();
+		}
+
+		const std::vector<RenderQueue::Packet>& RenderQueue::getPackets() const {
+			return mPackets;
+		}
+
+		const RenderQueue::Packet* RenderQueue::begin() const {
+			return mPackets.data();
+		}
+
+		const RenderQueue::Packet* RenderQueue::end() const {
+			return mPackets.data() + mPackets.size();
+		}
+
+		uint32_t RenderQueue::quantize(eRenderPass pass, float depth) const {
+			uint32_t numBuckets = mNumDepthBuckets[toIndex(pass)];
+
+			depth = std::max(0.0f, std::min(depth, 1.0f));
+
+			uint32_t bucket = std::min(
+				static_cast<uint32_t>(depth * numBuckets),
+				numBuckets - 1
+			);
+
+			if (pass == eRenderPass::TRANSLUCENT)
+				bucket = (numBuckets - 1) - bucket;
+
+			return bucket;
+		}
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../opengl.h"
+#include "../core/linear_allocator.h"
+#include "vertexarray.h"
+#include <cstdint>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		class ShaderProgram;
+		class MaterialInstance;
+		class Texture2D;
+		class TextureCube;
+
+		// passes are executed in this order
+		enum class eRenderPass: uint8_t {
+			SOLID,
+			SKY,
+			TRANSLUCENT,	// sorted back to front
+			OVERLAY,
+
+			COUNT
+		};
+
+		struct TextureBinding {
+			TextureBinding() = default;
+			TextureBinding(GLenum target, GLuint handle, GLuint unit);
+			TextureBinding(const Texture2D& texture, GLuint unit);
+			TextureBinding(const TextureCube& texture, GLuint unit);
+
+			GLenum mTarget = GL_TEXTURE_2D;
+			GLuint mHandle = 0;
+			GLuint mUnit = 0;
+		};
+
+		bool operator == (const TextureBinding& a, const TextureBinding& b);
+		bool operator != (const TextureBinding& a, const TextureBinding& b);
+
+		// everything needed to issue a single draw call
+		struct DrawCommand {
+			const MaterialInstance* mMaterial = nullptr; // if set, provides the program and textures
+			ShaderProgram* mProgram = nullptr;
+			VertexArray* mVAO = nullptr;
+			ePrimitives mPrimitive = ePrimitives::TRIANGLES;
+			GeometryRange mRange; // only used for indexed vertex arrays
+			glm::mat4 mModel;
+			glm::vec4 mInstanceData; // only available to instanced programs (see InstanceBuffer) and programs with an Object block
+
+			const TextureBinding* mTextures = nullptr; // copied into the queue on submission
+			uint32_t mNumTextures = 0;
+		};
+
+		bool isSameBatch(const DrawCommand& a, const DrawCommand& b); // everything but the geometry range and per-instance data matches
+
+		/*
+			Records draw commands for a frame, sorts them by state and hands them out in execution order.
+
+			Each submission becomes a 16 byte packet: a 64-bit sort key and a pointer to a copy of the
+			command in a per-frame arena. Only the packets are moved around while sorting (LSD radix sort,
+			8 bits per pass; passes where all keys share the same byte are skipped).
+
+			Key layout, most significant bits first:
+				[63..60] pass
+				[59..48] depth bucket		(back to front for translucent geometry, front to back otherwise)
+				[47..32] program
+				[31..16] material			(sort ID of the material instance, or the first texture binding)
+				[15.. 0] vertex array
+
+			Solid geometry only uses a few coarse depth buckets, so that state changes dominate the order
+			within a bucket; translucent geometry uses the full resolution.
+
+			[NOTE] GL names are truncated to 16 bits; a collision only makes the ordering slightly worse, as
+			       the executing side compares the actual handles
+			[NOTE] not threadsafe, record from the render thread only
+		*/
+		class RenderQueue {
+		public:
+			struct Packet {
+				uint64_t mKey;
+				const DrawCommand* mCommand;
+			};
+
+			static const size_t DEFAULT_ARENA_SIZE = 256 * 1024;
+			static const uint32_t DEPTH_BITS = 12;
+			static const uint32_t MAX_DEPTH_BUCKET = (1 << DEPTH_BITS) - 1;
+			static const uint32_t DEFAULT_SOLID_BUCKETS = 16;
+
+			explicit RenderQueue(size_t arenaSize = DEFAULT_ARENA_SIZE);
+
+			RenderQueue(const RenderQueue&) = delete;
+			RenderQueue& operator = (const RenderQueue&) = delete;
+
+			static uint64_t makeKey(
+				eRenderPass pass,
+				uint32_t depthBucket,
+				GLuint program,
+				GLuint material,
+				GLuint vao
+			);
+
+			static eRenderPass getPass(uint64_t key);
+			static uint32_t getDepthBucket(uint64_t key);
+
+			void setNumDepthBuckets(eRenderPass pass, uint32_t numBuckets); // clamped to [1, MAX_DEPTH_BUCKET + 1]
+			uint32_t getNumDepthBuckets(eRenderPass pass) const;
+
+			void submit(
+				const DrawCommand& command,
+				eRenderPass pass = eRenderPass::SOLID,
+				float depth = 0.0f // normalized view distance, [0..1]
+			);
+
+			void sort();	// stable, packets with equal keys keep their submission order
+			void clear();	// releases all recorded commands
+
+			bool isEmpty() const;
+			size_t getNumPackets() const;
+			const std::vector<Packet>& getPackets() const;
+
+			const Packet* begin() const;
+			const Packet* end() const;
+
+		private:
+			uint32_t quantize(eRenderPass pass, float depth) const;
+
+			std::vector<Packet> mPackets;
+			std::vector<Packet> mScratch;
+			core::LinearAllocator mArena;
+
+			uint32_t mNumDepthBuckets[static_cast<size_t>(eRenderPass::COUNT)];
+		};
+	}
+}
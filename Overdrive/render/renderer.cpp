@@ -4,20 +4,206 @@
 
 namespace overdrive {
 	namespace render {
+		namespace {
+			const UniformHandle VIEW("uView");
+			const UniformHandle PROJECTION("uProjection");
+			const UniformHandle MODEL("uModel");
+		}
+
 		Renderer::Renderer(video::Window* associatedWindow):
 			mWindow(associatedWindow)
 		{
-	
+			mFrameBlock.mTime = 0.0f;
+			mFrameBlock.mDeltaTime = 0.0f;
 		}
 
-		void Renderer::submit() {
-			
+		void Renderer::setCamera(const scene::Camera& camera) {
+			mView = camera.getView();
+			mProjection = camera.getProjection();
+			mNearClip = camera.getNearClip();
+			mFarClip = camera.getFarClip();
+
+			mCameraBlock.mView = mView;
+			mCameraBlock.mProjection = mProjection;
+			mCameraBlock.mViewProjection = mProjection * mView;
+			mCameraBlock.mPosition = glm::vec4(camera.getPosition(), 1.0f);
+			mCameraBlock.mClip = glm::vec4(mNearClip, mFarClip, 0.0f, 0.0f);
+		}
+
+		void Renderer::setTime(float time, float deltaTime) {
+			mFrameBlock.mTime = time;
+			mFrameBlock.mDeltaTime = deltaTime;
+		}
+
+		void Renderer::submit(const DrawCommand& command, eRenderPass pass) {
+			// view space looks down -z
+			float distance = -(mView * command.mModel[3]).z;
+			float depth = (distance - mNearClip) / (mFarClip - mNearClip);
+
+			mQueue.submit(command, pass, depth);
+		}
+
+		void Renderer::flush() {
+			mStats = RenderStats();
+			mStats.mNumPackets = mQueue.getNumPackets();
+
+			if (mQueue.isEmpty())
+				return;
+
+			mQueue.sort();
+			mIndirect.reset();
+
+			mFrameBlock.mViewportSize = glm::vec2(
+				static_cast<float>(mWindow->getFramebufferWidth()),
+				static_cast<float>(mWindow->getFramebufferHeight())
+			);
+
+			mUniforms.bind(mFrameBlock);
+			mUniforms.bind(mCameraBlock);
+
+			auto& cache = StateCache::current();
+			StateCacheStats before = cache.getStats();
+
+			ShaderProgram* program = nullptr;
+			const MaterialInstance* material = nullptr;
+			bool isInstanced = false;
+			bool hasObjectBlock = false;
+
+			const RenderQueue::Packet* packet = mQueue.begin();
+			const RenderQueue::Packet* end = mQueue.end();
+
+			// consecutive packets mostly share state, the cache filters out the redundant binds
+			while (packet != end) {
+				const DrawCommand& command = *packet->mCommand;
+
+				if (command.mProgram != program) {
+					program = command.mProgram;
+					program->bind();
+					++mStats.mNumProgramChanges;
+
+					isInstanced = program->isInstanced();
+					hasObjectBlock = program->hasObjectBlock();
+
+					// ignored by programs that use the Camera block instead, and not re-sent if they didn't change
+					program->setUniform(VIEW, mView);
+					program->setUniform(PROJECTION, mProjection);
+				}
+
+				if (command.mMaterial != material) {
+					material = command.mMaterial;
+
+					if (material) {
+						material->getMaterial().getRenderState().apply();
+						material->apply();
+						++mStats.mNumMaterialChanges;
+					}
+				}
+
+				for (uint32_t i = 0; i < command.mNumTextures; ++i) {
+					const TextureBinding& binding = command.mTextures[i];
+					cache.bindTexture(binding.mUnit, binding.mTarget, binding.mHandle);
+				}
+
+				if (!isInstanced) {
+					command.mVAO->bind();
+
+					if (hasObjectBlock)
+						mUniforms.bind(blocks::Object{ command.mModel, command.mInstanceData });
+					else
+						program->setUniform(MODEL, command.mModel);
+
+					if ((command.mRange == GeometryRange()) || (command.mVAO->getIndexType() == 0))
+						command.mVAO->drawBound(command.mPrimitive);
+					else
+						command.mVAO->drawBound(command.mRange, 1, 0, command.mPrimitive);
+
+					++mStats.mNumDrawCalls;
+					++packet;
+
+					continue;
+				}
+
+				// the packets are sorted by state, so a batch is a consecutive run
+				const RenderQueue::Packet* last = packet + 1;
+
+				while ((last != end) && isSameBatch(command, *last->mCommand))
+					++last;
+
+				if (command.mVAO->getInstanceBuffer() != &mInstances)
+					command.mVAO->attach(mInstances);
+
+				command.mVAO->bind();
+
+				bool isIndexed = (command.mVAO->getIndexType() != 0);
+
+				// a batch may not fit in the remaining space of the instance buffer region
+				while (packet != last) {
+					InstanceRange range = mInstances.allocate(static_cast<size_t>(last - packet));
+
+					for (GLsizei i = 0; i < range.mCount; ++i, ++packet) {
+						range.mInstances[i].mModel = packet->mCommand->mModel;
+						range.mInstances[i].mData = packet->mCommand->mInstanceData;
+
+						// consecutive packets with the same range end up in a single command
+						if (isIndexed)
+							mIndirect.add(*command.mVAO, packet->mCommand->mRange, 1, range.mFirst + i);
+					}
+
+					if (isIndexed) {
+						GLsizei numCommands = mIndirect.submit(*command.mVAO, command.mPrimitive);
+
+						if (numCommands > 1)
+							mStats.mNumIndirectCommands += numCommands;
+					}
+					else
+						command.mVAO->drawInstancedBound(range.mCount, range.mFirst, command.mPrimitive);
+
+					++mStats.mNumDrawCalls;
+					++mStats.mNumInstancedDrawCalls;
+					mStats.mNumInstances += range.mCount;
+				}
+			}
+
+			mInstances.advance();
+			mUniforms.advance();
+
+			const StateCacheStats& after = cache.getStats();
+
+			for (size_t i = 0; i < static_cast<size_t>(eStateCall::COUNT); ++i) {
+				mStats.mStateCalls.mNumIssued[i] = after.mNumIssued[i] - before.mNumIssued[i];
+				mStats.mStateCalls.mNumElided[i] = after.mNumElided[i] - before.mNumElided[i];
+			}
+
+			mQueue.clear();
 		}
 
 		void Renderer::present() {
+			flush();
+
 			mState.clear(eClearOptions::DEPTH);
 			
 			mWindow->swapBuffers();
 		}
+
+		RenderQueue& Renderer::getQueue() {
+			return mQueue;
+		}
+
+		const RenderStats& Renderer::getStats() const {
+			return mStats;
+		}
+
+		std::ostream& operator << (std::ostream& os, const RenderStats& stats) {
+			os
+				<< stats.mNumPackets << " packets, "
+				<< stats.mNumDrawCalls << " draw calls ("
+				<< stats.mNumInstancedDrawCalls << " instanced, " << stats.mNumInstances << " instances, "
+				<< stats.mNumIndirectCommands << " indirect commands), "
+				<< stats.mNumProgramChanges << " program changes, "
+				<< stats.mNumMaterialChanges << " material changes, "
+				<< "state calls: " << stats.mStateCalls;
+
+			return os;
+		}
 	}
-}
\ No newline at end of file
+}
@@ -4,28 +4,88 @@
 #include "shaderprogram.h"
 #include "framebuffer.h"
 #include "renderstate.h"
+#include "render_queue.h"
+#include "material.h"
+#include "state_cache.h"
+#include "instance_buffer.h"
+#include "indirect_buffer.h"
+#include "uniform_stream.h"
+#include "common_uniform_blocks.h"
 #include "shape_cube.h"
 
 #include "../video/window.h"
 #include "../scene/camera.h"
 
+#include <ostream>
 
 namespace overdrive {
 	namespace render {
+		struct RenderStats {
+			size_t mNumPackets = 0;
+			size_t mNumDrawCalls = 0;
+			size_t mNumInstancedDrawCalls = 0;
+			size_t mNumInstances = 0; // drawn with instanced draw calls
+			size_t mNumIndirectCommands = 0; // sourced by multi-draw indirect calls
+			size_t mNumProgramChanges = 0;
+			size_t mNumMaterialChanges = 0;
+
+			StateCacheStats mStateCalls; // made during the flush
+		};
+
+		/*
+			Draws are not executed on submission; they're collected in a RenderQueue and sorted by state
+			when the renderer is flushed.
+
+			The Frame and Camera uniform blocks (see common_uniform_blocks.h) are streamed and bound once
+			per flush; programs that declare an Object block get their model matrix and instance data
+			through that, streamed per draw. Programs without blocks get uView and uProjection set once
+			when they are bound and uModel per draw (programs that don't use one of these are fine).
+			Other uniforms persist in the program object, so they can be set up front.
+
+			Draws with a MaterialInstance apply its render state and parameters whenever the instance
+			changes; only parameters that differ from what the program last received are sent.
+			[NOTE] the render state of a material stays in effect for following draws without a material
+
+			Programs with an aInstanceModel attribute are drawn instanced: after sorting, consecutive
+			packets that only differ in their model matrix/instance data are merged into a single draw,
+			with the per-instance data streamed through an InstanceBuffer. For indexed vertex arrays the
+			packets in such a run may use different geometry ranges (e.g. meshes in a GeometryPool); the
+			whole run is then drawn with a single glMultiDrawElementsIndirect.
+		*/
 		class Renderer {
 		public:
 			Renderer(video::Window* associatedWindow);
 
-			void submit();
-			void present();
+			void setCamera(const scene::Camera& camera); // view, projection and depth range for the following submissions
+			void setTime(float time, float deltaTime); // in seconds, passed on through the Frame block
+
+			void submit(const DrawCommand& command, eRenderPass pass = eRenderPass::SOLID);
+			void flush();	// sorts and executes everything submitted so far
+			void present();	// flushes and swaps buffers
 			
+			RenderQueue& getQueue();
+			const RenderStats& getStats() const; // as of the last flush
+
 		private:
 			video::Window* mWindow;
 			RenderState mState;
+			RenderQueue mQueue;
+			RenderStats mStats;
+			InstanceBuffer mInstances;
+			IndirectBuffer mIndirect;
+			UniformStream mUniforms;
+
+			blocks::Frame mFrameBlock;
+			blocks::Camera mCameraBlock;
 
 			// default parameters passed to everything rendered:
 			glm::mat4 mView;
 			glm::mat4 mProjection;
+
+			float mNearClip = 0.1f;
+			float mFarClip = 100.0f;
 		};
+
+		std::ostream& operator << (std::ostream& os, const RenderStats& stats);
 	}
 }
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "renderstate.h"
+#include "state_cache.h"
 
 namespace overdrive {
 	namespace render {
@@ -70,49 +71,17 @@ namespace overdrive {
 			}
 		}
 
-		namespace {
-			void setRenderOption(eRenderOptions option, bool enabled, bool& current) {
-				if (enabled != current) {
-					if (enabled)
-						glEnable(static_cast<GLenum>(option));
-					else
-						glDisable(static_cast<GLenum>(option));
-
-					current = enabled;
-				}
-			}
-		}
-
 		void RenderState::apply() {
-			static RenderState currentState;
+			// the cache only forwards what differs from the current context state
+			auto& cache = StateCache::current();
 
-			setRenderOption(eRenderOptions::DEPTH_TEST, mDepthTestEnabled, currentState.mDepthTestEnabled);
-			setRenderOption(eRenderOptions::CULL_FACE, mCullFaceEnabled, currentState.mCullFaceEnabled);
+			cache.setEnabled(static_cast<GLenum>(eRenderOptions::DEPTH_TEST), mDepthTestEnabled);
+			cache.setEnabled(static_cast<GLenum>(eRenderOptions::CULL_FACE), mCullFaceEnabled);
 
-			if (mClearColor != currentState.mClearColor) {
-				glClearColor(
-					mClearColor.r, 
-					mClearColor.g, 
-					mClearColor.b, 
-					mClearColor.a
-				);
-				currentState.mClearColor = mClearColor;
-			}
-
-			if (mClearDepth != currentState.mClearDepth) {
-				glClearDepth(mClearDepth);
-				currentState.mClearDepth = mClearDepth;
-			}
-
-			if (mClearStencil != currentState.mClearStencil) {
-				glClearStencil(mClearStencil);
-				currentState.mClearStencil = mClearStencil;
-			}
-
-			if (mCullMode != currentState.mCullMode) {
-				glCullFace(static_cast<GLenum>(mCullMode));
-				currentState.mCullMode = mCullMode;
-			}
+			cache.setClearColor(mClearColor);
+			cache.setClearDepth(mClearDepth);
+			cache.setClearStencil(mClearStencil);
+			cache.setCullFace(static_cast<GLenum>(mCullMode));
 		}
 
 		RenderState RenderState::getActiveState() {
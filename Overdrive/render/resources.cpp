@@ -0,0 +1,164 @@
+#include "stdafx.h"
+#include "resources.h"
+#include "shader_compiler.h"
+#include "state_cache.h"
+#include "../util/asset_pack.h"
+#include "../util/string_hash.h"
+#include <memory>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			const GLint MAX_LEVELS = 32;
+
+			// sums the size of every level of the bound texture (levelTarget is a single face for cube maps)
+			size_t getBoundTextureSize(GLenum levelTarget, eTextureFormat format) {
+				size_t result = 0;
+
+				for (GLint level = 0; level < MAX_LEVELS; ++level) {
+					GLint width = 0;
+					GLint height = 0;
+					GLint isCompressed = GL_FALSE;
+
+					glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+
+					if (width == 0)
+						break; // past the last level
+
+					glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+					glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &isCompressed);
+
+					if (isCompressed) {
+						GLint numBytes = 0;
+						glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &numBytes);
+
+						result += static_cast<size_t>(numBytes);
+					}
+					else
+						result += static_cast<size_t>(width) * height * gli::block_size(format);
+				}
+
+				return result;
+			}
+
+			uint64_t getProgramKey(const std::vector<ShaderSource>& sources) {
+				uint64_t key = util::hashBytes(nullptr, 0);
+
+				for (const auto& source : sources)
+					key = core::makeResourceKey(source.mSource, source.mType, key);
+
+				return key;
+			}
+		}
+
+		size_t getMemoryUsage(const Texture2D& texture) {
+			if ((texture.getHandle() == 0) || (texture.getFormat() == gli::FORMAT_UNDEFINED))
+				return 0;
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, texture.getHandle());
+
+			size_t result = getBoundTextureSize(GL_TEXTURE_2D, texture.getFormat());
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
+
+			return result;
+		}
+
+		size_t getMemoryUsage(const TextureCube& texture) {
+			if ((texture.getHandle() == 0) || (texture.getFormat() == gli::FORMAT_UNDEFINED))
+				return 0;
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, texture.getHandle());
+
+			// all faces are the same size
+			size_t result = 6 * getBoundTextureSize(GL_TEXTURE_CUBE_MAP_POSITIVE_X, texture.getFormat());
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+			return result;
+		}
+
+		size_t getMemoryUsage(const ShaderProgram& program) {
+			if (!program.isLinked())
+				return 0;
+
+			GLint length = 0;
+			glGetProgramiv(program.getHandle(), GL_PROGRAM_BINARY_LENGTH, &length);
+
+			return static_cast<size_t>(length);
+		}
+
+		size_t getMemoryUsage(const Mesh& mesh) {
+			return
+				mesh.getNumVertices() * sizeof(Mesh::VertexFormat) +
+				mesh.getNumIndices() * sizeof(Mesh::IndexFormat);
+		}
+
+		Texture2DCache::Handle loadTexture2D(Texture2DCache& cache, const std::string& filepath) {
+			return cache.get(core::makeResourceKey(filepath), [&] {
+				return std::make_unique<Texture2D>(loadTexture2D(filepath));
+			});
+		}
+
+		// [NOTE] packed assets share their key with the loose file of the same name; it is the same asset after all
+		Texture2DCache::Handle loadTexture2D(Texture2DCache& cache, const util::AssetPack& pack, const std::string& name) {
+			return cache.get(core::makeResourceKey(util::normalizeAssetName(name)), [&] {
+				return std::make_unique<Texture2D>(loadTexture2D(pack, name));
+			});
+		}
+
+		TextureCubeCache::Handle loadTextureCube(
+			TextureCubeCache& cache,
+			const std::string& positiveX,
+			const std::string& negativeX,
+			const std::string& positiveY,
+			const std::string& negativeY,
+			const std::string& positiveZ,
+			const std::string& negativeZ
+		) {
+			uint64_t key = core::makeResourceKey(positiveX, negativeX, positiveY, negativeY, positiveZ, negativeZ);
+
+			return cache.get(key, [&] {
+				return std::make_unique<TextureCube>(
+					loadTextureCube(positiveX, negativeX, positiveY, negativeY, positiveZ, negativeZ)
+				);
+			});
+		}
+
+		ShaderProgramCache::Handle loadShaderProgram(ShaderProgramCache& cache, const std::vector<ShaderSource>& sources) {
+			return cache.get(getProgramKey(sources), [&] {
+				auto program = std::make_unique<ShaderProgram>();
+
+				for (const auto& source : sources)
+					program->attachShader(source.mSource, source.mType);
+
+				program->link();
+
+				if (!program->isLinked())
+					throw std::runtime_error("Failed to link shader program");
+
+				return program;
+			});
+		}
+
+		ShaderProgramCache::Handle loadShaderProgram(
+			ShaderProgramCache& cache,
+			ShaderCompiler& compiler,
+			const std::vector<ShaderSource>& sources
+		) {
+			uint64_t key = getProgramKey(sources);
+
+			return cache.get(key, [&] {
+				auto program = std::make_unique<ShaderProgram>();
+
+				// the program only has a size once it is linked
+				compiler.submit(*program, sources, std::vector<std::string>(), [&cache, key] {
+					cache.refresh(key);
+				});
+
+				return program;
+			});
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "../core/resource_cache.h"
+#include "mesh.h"
+#include "program_binary_cache.h"
+#include "shaderprogram.h"
+#include "texture2D.h"
+#include "textureCube.h"
+#include <string>
+#include <vector>
+
+namespace overdrive {
+	namespace util {
+		class AssetPack;
+	}
+
+	namespace render {
+		class ShaderCompiler;
+
+		typedef core::ResourceCache<Texture2D>		Texture2DCache;
+		typedef core::ResourceCache<TextureCube>	TextureCubeCache;
+		typedef core::ResourceCache<ShaderProgram>	ShaderProgramCache;
+		typedef core::ResourceCache<Mesh>			MeshCache; // there are no mesh files yet, use ResourceCache::get with a loader
+
+		// memory used by a resource, for the ResourceCache budget
+		// [NOTE] textures query the driver for the size of every level, so this needs the openGL context
+		// [NOTE] shader programs report the size of their binary, which is the closest thing the driver exposes
+		size_t getMemoryUsage(const Texture2D& texture);
+		size_t getMemoryUsage(const TextureCube& texture);
+		size_t getMemoryUsage(const ShaderProgram& program);
+		size_t getMemoryUsage(const Mesh& mesh);
+
+		// cached versions of the regular loaders, keyed on the file name(s)
+		Texture2DCache::Handle loadTexture2D(Texture2DCache& cache, const std::string& filepath);
+		Texture2DCache::Handle loadTexture2D(Texture2DCache& cache, const util::AssetPack& pack, const std::string& name);
+		TextureCubeCache::Handle loadTextureCube(
+			TextureCubeCache& cache,
+			const std::string& positiveX,
+			const std::string& negativeX,
+			const std::string& positiveY,
+			const std::string& negativeY,
+			const std::string& positiveZ,
+			const std::string& negativeZ
+		);
+
+		// keyed on the shader types and sources; compiles and links on a miss (throws on errors)
+		ShaderProgramCache::Handle loadShaderProgram(ShaderProgramCache& cache, const std::vector<ShaderSource>& sources);
+
+		// same, but a miss is submitted to the compiler; the program is usable once its build has finished
+		// [NOTE] keep the handle until the build has finished, the compiler doesn't own the program
+		// [NOTE] a build that fails stays in the cache (unlinked) until it is released and evicted
+		// [NOTE] the cache is told the size of the program when the build finishes, so it must outlive the build
+		ShaderProgramCache::Handle loadShaderProgram(
+			ShaderProgramCache& cache,
+			ShaderCompiler& compiler,
+			const std::vector<ShaderSource>& sources
+		);
+	}
+}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "shader.h"
 #include "../core/logger.h"
+#include <cstring>
 #include <memory>
 
 namespace overdrive {
@@ -10,9 +11,32 @@ namespace overdrive {
 		{
 		}
 
+		bool isParallelShaderCompileSupported() {
+			static const bool result = [] {
+				if (GLEW_ARB_parallel_shader_compile)
+					return true;
+
+				// glew doesn't know the KHR version, go through the extension list
+				GLint numExtensions = 0;
+				glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+
+				for (GLint i = 0; i < numExtensions; ++i) {
+					const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+					if (name && (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0))
+						return true;
+				}
+
+				return false;
+			}();
+
+			return result;
+		}
+
 		Shader::Shader(eShaderType type):
 			mType(type),
-			mHandle(0)
+			mHandle(0),
+			mIsChecked(false)
 		{
 			mHandle = glCreateShader(static_cast<GLenum>(type));
 			if (!mHandle)
@@ -26,7 +50,8 @@ namespace overdrive {
 
 		Shader::Shader(Shader&& s) :
 			mType(s.mType),
-			mHandle(s.mHandle)
+			mHandle(s.mHandle),
+			mIsChecked(s.mIsChecked)
 		{
 			s.mHandle = 0;
 		}
@@ -37,6 +62,7 @@ namespace overdrive {
 
 			mType = s.mType;
 			mHandle = s.mHandle;
+			mIsChecked = s.mIsChecked;
 
 			s.mHandle = 0;
 			
@@ -48,11 +74,37 @@ namespace overdrive {
 		}
 
 		void Shader::compile(const std::string& source) {
-			const char* raw = source.c_str();
+			compileAsync(source);
+			checkCompileStatus();
+		}
+
+		void Shader::compileAsync(const std::string& source) {
+			compileAsync(source.data(), source.size());
+		}
+
+		void Shader::compileAsync(const char* source, size_t length) {
+			GLint rawLength = static_cast<GLint>(length);
 
-			glShaderSource(mHandle, 1, &raw, nullptr);
+			glShaderSource(mHandle, 1, &source, &rawLength);
 			glCompileShader(mHandle);
 
+			mIsChecked = false;
+		}
+
+		bool Shader::isCompileComplete() const {
+			if (mIsChecked || !isParallelShaderCompileSupported())
+				return true;
+
+			GLint result = GL_FALSE;
+			glGetShaderiv(mHandle, GL_COMPLETION_STATUS_KHR, &result);
+
+			return (result == GL_TRUE);
+		}
+
+		void Shader::checkCompileStatus() {
+			if (mIsChecked)
+				return;
+
 			GLint result;
 			glGetShaderiv(mHandle, GL_COMPILE_STATUS, &result);
 
@@ -78,6 +130,8 @@ namespace overdrive {
 					throw ShaderException(message.get());
 				}
 			}
+
+			mIsChecked = true;
 		}
 
 		std::string Shader::getSource() const {
@@ -19,6 +19,13 @@ namespace overdrive {
 			COMPUTE				= GL_COMPUTE_SHADER
 		};
 
+#ifndef GL_COMPLETION_STATUS_KHR
+	#define GL_COMPLETION_STATUS_KHR 0x91B1 // same value as GL_COMPLETION_STATUS_ARB
+#endif
+
+		// ARB_ or KHR_parallel_shader_compile; without it, querying the status of a compile or link blocks
+		bool isParallelShaderCompileSupported();
+
 		class Shader {
 		public:
 			Shader(eShaderType type);
@@ -31,13 +38,19 @@ namespace overdrive {
 
 			GLuint getHandle() const;
 
-			void compile(const std::string& source);
+			void compile(const std::string& source);		// blocks until compiled, throws on error
+			void compileAsync(const std::string& source);	// the result is checked in checkCompileStatus
+			void compileAsync(const char* source, size_t length); // source doesn't need to be null-terminated
+
+			bool isCompileComplete() const; // never blocks; always true without parallel shader compile support
+			void checkCompileStatus();		// blocks until compiled, throws on error
 
 			std::string getSource() const;
 
 		private:
 			eShaderType mType;
 			GLuint mHandle;
+			bool mIsChecked; // compile status has been verified
 		};
 
 		std::ostream& operator << (std::ostream& os, const eShaderType& type);
@@ -0,0 +1,175 @@
+#include "stdafx.h"
+#include "shader_compiler.h"
+#include "shaderprogram.h"
+#include "../core/logger.h"
+#include <algorithm>
+
+namespace overdrive {
+	namespace render {
+		// ----- ProgramBuild -----
+		ProgramBuild::ProgramBuild(std::shared_ptr<State> state):
+			mState(std::move(state))
+		{
+		}
+
+		bool ProgramBuild::isValid() const {
+			return (mState != nullptr);
+		}
+
+		eBuildStatus ProgramBuild::getStatus() const {
+			assert(mState);
+			return mState->mStatus;
+		}
+
+		bool ProgramBuild::isPending() const {
+			return (getStatus() == eBuildStatus::PENDING);
+		}
+
+		bool ProgramBuild::isReady() const {
+			return (getStatus() == eBuildStatus::READY);
+		}
+
+		bool ProgramBuild::isFailed() const {
+			return (getStatus() == eBuildStatus::FAILED);
+		}
+
+		const std::string& ProgramBuild::getError() const {
+			assert(mState);
+			return mState->mError;
+		}
+
+		ShaderProgram* ProgramBuild::getProgram() const {
+			assert(mState);
+			return mState->mProgram;
+		}
+
+		// ----- ShaderCompiler -----
+		ShaderCompiler::ShaderCompiler(ProgramBinaryCache* cache, GLuint maxThreads):
+			mCache(cache)
+		{
+			if (isParallelShaderCompileSupported()) {
+				// [NOTE] only the ARB version can be configured through glew, the KHR version uses the driver default
+				if (GLEW_ARB_parallel_shader_compile)
+					glMaxShaderCompilerThreadsARB(maxThreads);
+			}
+			else
+				gLogDebug << "Parallel shader compilation is not supported, shaders will be compiled synchronously";
+		}
+
+		ShaderCompiler::~ShaderCompiler() {
+			finishAll();
+		}
+
+		ProgramBuild ShaderCompiler::submit(
+			ShaderProgram& program,
+			const std::vector<ShaderSource>& sources,
+			const std::vector<std::string>& defines,
+			std::function<void()> onFinished
+		) {
+			auto state = std::make_shared<ProgramBuild::State>();
+			state->mProgram = &program;
+
+			Pending pending;
+			pending.mState = state;
+			pending.mKey = 0;
+			pending.mOnFinished = std::move(onFinished);
+
+			if (mCache) {
+				pending.mKey = mCache->getKey(sources, defines);
+
+				if (mCache->load(program, pending.mKey)) {
+					state->mStatus = eBuildStatus::READY;
+
+					if (pending.mOnFinished)
+						pending.mOnFinished();
+
+					return ProgramBuild(state);
+				}
+
+				if (ProgramBinaryCache::isSupported())
+					program.setBinaryRetrievable(true);
+			}
+
+			try {
+				for (const auto& source : sources)
+					program.attachShaderAsync(injectDefines(source.mSource, defines), source.mType);
+
+				program.linkAsync();
+			}
+			catch (const ShaderException& ex) {
+				state->mStatus = eBuildStatus::FAILED;
+				state->mError = ex.what();
+
+				if (pending.mOnFinished)
+					pending.mOnFinished();
+
+				return ProgramBuild(state);
+			}
+
+			if (isParallelShaderCompileSupported())
+				mPending.push_back(pending);
+			else
+				finish(pending);
+
+			return ProgramBuild(state);
+		}
+
+		void ShaderCompiler::update() {
+			auto it = std::remove_if(
+				mPending.begin(),
+				mPending.end(),
+				[this](Pending& pending) {
+					if (!pending.mState->mProgram->isLinkComplete())
+						return false;
+
+					finish(pending);
+					return true;
+				}
+			);
+
+			mPending.erase(it, mPending.end());
+		}
+
+		void ShaderCompiler::finishAll() {
+			for (auto& pending : mPending)
+				finish(pending);
+
+			mPending.clear();
+		}
+
+		size_t ShaderCompiler::getNumPending() const {
+			return mPending.size();
+		}
+
+		bool ShaderCompiler::isIdle() const {
+			return mPending.empty();
+		}
+
+		void ShaderCompiler::finish(Pending& pending) {
+			auto& state = *pending.mState;
+			bool isLinked = false;
+
+			try {
+				isLinked = state.mProgram->finishLink();
+
+				if (!isLinked)
+					state.mError = "Failed to link shader program";
+			}
+			catch (const ShaderException& ex) {
+				state.mError = ex.what();
+			}
+
+			if (isLinked) {
+				if (mCache)
+					mCache->store(*state.mProgram, pending.mKey);
+
+				state.mStatus = eBuildStatus::READY;
+			}
+			else
+				state.mStatus = eBuildStatus::FAILED;
+
+			if (pending.mOnFinished)
+				pending.mOnFinished();
+		}
+	}
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../opengl.h"
+#include "program_binary_cache.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		class ShaderProgram;
+
+		enum class eBuildStatus {
+			PENDING,
+			READY,
+			FAILED
+		};
+
+		// future-like handle to a program that is being built by a ShaderCompiler
+		// [NOTE] the status only changes during ShaderCompiler::update/finishAll, so polling this is cheap
+		class ProgramBuild {
+		public:
+			ProgramBuild() = default; // not associated with any build
+
+			bool isValid() const;
+
+			eBuildStatus getStatus() const;
+			bool isPending() const;
+			bool isReady() const;
+			bool isFailed() const;
+
+			const std::string& getError() const; // empty unless the build failed
+			ShaderProgram* getProgram() const;
+
+		private:
+			friend class ShaderCompiler;
+
+			struct State {
+				ShaderProgram* mProgram = nullptr;
+				eBuildStatus mStatus = eBuildStatus::PENDING;
+				std::string mError;
+			};
+
+			explicit ProgramBuild(std::shared_ptr<State> state);
+
+			std::shared_ptr<State> mState;
+		};
+
+		/*
+			Starts compiling and linking programs without waiting for the driver. With ARB_ or
+			KHR_parallel_shader_compile the driver compiles on its own threads, and update() only finishes
+			programs whose GL_COMPLETION_STATUS says they're done -- so it never blocks.
+
+			Without the extension, submit() compiles and links right away (the old synchronous path) and
+			the returned build is already finished.
+
+			Usage:
+				ShaderCompiler compiler(&cache);
+				auto build = compiler.submit(program, { { eShaderType::VERTEX, vs }, { eShaderType::FRAGMENT, fs } });
+				...
+				compiler.update(); // once per frame
+				if (build.isReady())
+					...
+
+			[NOTE] submitted programs must stay alive until their build is finished; the destructor finishes everything
+			[NOTE] with a ProgramBinaryCache, cached programs are restored immediately and new ones are added when finished
+		*/
+		class ShaderCompiler {
+		public:
+			static const GLuint ALL_THREADS = 0xFFFFFFFF; // let the driver decide
+
+			explicit ShaderCompiler(ProgramBinaryCache* cache = nullptr, GLuint maxThreads = ALL_THREADS);
+			~ShaderCompiler();
+
+			ShaderCompiler(const ShaderCompiler&) = delete;
+			ShaderCompiler& operator = (const ShaderCompiler&) = delete;
+
+			// the defines are inserted after the #version line, see injectDefines
+			// onFinished is called once the build is ready or has failed (from within submit if that happens right away)
+			ProgramBuild submit(
+				ShaderProgram& program,
+				const std::vector<ShaderSource>& sources,
+				const std::vector<std::string>& defines = std::vector<std::string>(),
+				std::function<void()> onFinished = std::function<void()>()
+			);
+
+			void update();		// finishes the builds the driver is done with
+			void finishAll();	// blocks until everything is finished
+
+			size_t getNumPending() const;
+			bool isIdle() const;
+
+		private:
+			struct Pending {
+				std::shared_ptr<ProgramBuild::State> mState;
+				uint64_t mKey;
+				std::function<void()> mOnFinished;
+			};
+
+			void finish(Pending& pending);
+
+			ProgramBinaryCache* mCache;
+			std::vector<Pending> mPending;
+		};
+	}
+}
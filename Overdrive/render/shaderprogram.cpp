@@ -2,8 +2,11 @@
 #include "shaderprogram.h"
 #include "shaderAttribute.h"
 #include "shaderUniform.h"
+#include "state_cache.h"
 #include "../core/logger.h"
-#include <fstream>
+#include "../util/asset_pack.h"
+#include "../util/mapped_file.h"
+#include <cstring>
 
 namespace overdrive {
 	namespace render {
@@ -24,7 +27,10 @@ namespace overdrive {
 
 		ShaderProgram::ShaderProgram():
 			mHandle(0),
-			mIsLinked(false)
+			mIsLinking(false),
+			mIsLinked(false),
+			mIsInstanced(false),
+			mHasObjectBlock(false)
 		{
 		}
 
@@ -34,6 +40,7 @@ namespace overdrive {
 					if (shader)
 						glDetachShader(mHandle, shader->getHandle());
 
+				StateCache::current().onDeleteProgram(mHandle);
 				glDeleteProgram(mHandle);
 			}
 		}
@@ -43,14 +50,20 @@ namespace overdrive {
 		}
 
 		void ShaderProgram::attachShader(const std::string& source, eShaderType type) {
-			if (mHandle == 0) {
-				mHandle = glCreateProgram();
+			attachShader(source.data(), source.size(), type);
+		}
 
-				if (mHandle == 0) {
-					gLogError << "Failed to create shader program";
-					throw ShaderException("Failed to create shader program");
-				}
-			}
+		void ShaderProgram::attachShaderAsync(const std::string& source, eShaderType type) {
+			attachShaderAsync(source.data(), source.size(), type);
+		}
+
+		void ShaderProgram::attachShader(const char* source, size_t length, eShaderType type) {
+			attachShaderAsync(source, length, type);
+			getShader(type)->checkCompileStatus();
+		}
+
+		void ShaderProgram::attachShaderAsync(const char* source, size_t length, eShaderType type) {
+			createHandle();
 
 			int idx = getShaderIndex(type);
 
@@ -60,7 +73,7 @@ namespace overdrive {
 			}
 
 			mShaders[idx] = std::make_unique<Shader>(type);
-			mShaders[idx]->compile(source);
+			mShaders[idx]->compileAsync(source, length);
 			glAttachShader(mHandle, mShaders[idx]->getHandle());
 		}
 
@@ -77,22 +90,36 @@ namespace overdrive {
 				throw ShaderException("Not a regular file");
 			}
 
-			std::ifstream ifs(p.c_str());
-			if (!ifs.good()) {
-				gLogError << "Could not open file: " << p;
-				throw ShaderException("Could not open file");
+			util::MappedFile file(p);
+
+			if (file.getSize() == 0) {
+				gLogError << "Empty shader file: " << p;
+				throw ShaderException("Empty shader file");
 			}
 
-			std::string content(
-				(std::istreambuf_iterator<char>(ifs)),  // <~ Most Vexing Parse... hence the extra ()
-				std::istreambuf_iterator<char>()
-			);
+			// the driver copies the source during glShaderSource, so the mapping can go right after
+			attachShader(file.getChars(), file.getSize(), type);
+		}
 
-			attachShader(content, type);
+		void ShaderProgram::loadShader(const util::AssetPack& pack, const std::string& name, eShaderType type) {
+			std::vector<uint8_t> buffer; // only used for compressed entries
+			auto data = pack.read(name, buffer);
+
+			if (!data.isValid()) {
+				gLogError << "Shader not found in asset pack: " << name;
+				throw ShaderException("File not found");
+			}
+
+			attachShader(data.getChars(), data.mSize, type);
 		}
 
 		void ShaderProgram::link() {
-			if (mIsLinked) {
+			linkAsync();
+			finishLink();
+		}
+
+		void ShaderProgram::linkAsync() {
+			if (mIsLinked || mIsLinking) {
 				gLogWarning << "Shader program already linked";
 				return;
 			}
@@ -104,6 +131,30 @@ namespace overdrive {
 
 			glLinkProgram(mHandle);
 
+			mIsLinking = true;
+		}
+
+		bool ShaderProgram::isLinkComplete() const {
+			if (!mIsLinking || !isParallelShaderCompileSupported())
+				return true;
+
+			GLint result = GL_FALSE;
+			glGetProgramiv(mHandle, GL_COMPLETION_STATUS_KHR, &result);
+
+			return (result == GL_TRUE);
+		}
+
+		bool ShaderProgram::finishLink() {
+			if (!mIsLinking)
+				return mIsLinked;
+
+			mIsLinking = false;
+
+			// report compile errors first, the link log would only say that a shader is broken
+			for (const auto& shader : mShaders)
+				if (shader)
+					shader->checkCompileStatus();
+
 			GLint result;
 			glGetProgramiv(mHandle, GL_LINK_STATUS, &result);
 
@@ -125,10 +176,79 @@ namespace overdrive {
 					);
 
 					gLogError << message.get();
-					return;
 				}
+
+				return false;
+			}
+
+			onLinked();
+
+			return true;
+		}
+
+		bool ShaderProgram::isLinked() const {
+			return mIsLinked;
+		}
+
+		void ShaderProgram::setBinaryRetrievable(bool enabled) {
+			createHandle();
+			glProgramParameteri(mHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, enabled ? GL_TRUE : GL_FALSE);
+		}
+
+		bool ShaderProgram::getBinary(GLenum& format, std::vector<uint8_t>& data) const {
+			if (!mIsLinked)
+				return false;
+
+			GLint numBytes = 0;
+			glGetProgramiv(mHandle, GL_PROGRAM_BINARY_LENGTH, &numBytes);
+
+			if (numBytes <= 0)
+				return false;
+
+			data.resize(numBytes);
+
+			GLsizei bytesWritten = 0;
+			glGetProgramBinary(mHandle, numBytes, &bytesWritten, &format, data.data());
+			data.resize(bytesWritten);
+
+			return (bytesWritten > 0);
+		}
+
+		bool ShaderProgram::loadBinary(GLenum format, const void* data, GLsizei numBytes) {
+			if (mIsLinked) {
+				gLogWarning << "Shader program already linked";
+				return false;
+			}
+
+			createHandle();
+			glProgramBinary(mHandle, format, data, numBytes);
+
+			// [NOTE] a binary from another driver (version) is rejected by leaving the program unlinked;
+			//		  the handle can still be used to compile and link the program from source
+			GLint result;
+			glGetProgramiv(mHandle, GL_LINK_STATUS, &result);
+
+			if (result == GL_FALSE)
+				return false;
+
+			onLinked();
+
+			return true;
+		}
+
+		void ShaderProgram::createHandle() {
+			if (mHandle)
+				return;
+
+			mHandle = glCreateProgram();
+
+			if (mHandle == 0) {
+				gLogError << "Failed to create shader program";
+				throw ShaderException("Failed to create shader program");
 			}
+		}
 
+		void ShaderProgram::onLinked() {
 			mIsLinked = true;
 
 #ifdef OVERDRIVE_DEBUG
@@ -137,10 +257,10 @@ namespace overdrive {
 
 			gatherUniforms();
 			gatherAttributes();
-		}
+			gatherUniformBlocks();
 
-		bool ShaderProgram::isLinked() const {
-			return mIsLinked;
+			mIsInstanced = hasAttribute("aInstanceModel");
+			mHasObjectBlock = hasUniformBlock("Object");
 		}
 
 		void ShaderProgram::validate() {
@@ -182,11 +302,11 @@ namespace overdrive {
 
 		void ShaderProgram::bind() {
 			assert(mHandle);
-			glUseProgram(mHandle);
+			StateCache::current().useProgram(mHandle);
 		}
 
 		void ShaderProgram::unbind() {
-			glUseProgram(0);
+			StateCache::current().useProgram(0);
 		}
 
 		void ShaderProgram::listUniforms() const {
@@ -229,6 +349,23 @@ namespace overdrive {
 		}
 		*/
 
+		bool ShaderProgram::hasUniform(const std::string& name) const {
+			return (mUniforms.find(name) != mUniforms.end());
+		}
+
+		bool ShaderProgram::hasUniform(UniformHandle handle) const {
+			return (mUniformSlots.find(handle.getHash()) != mUniformSlots.end());
+		}
+
+		GLint ShaderProgram::getUniformLocation(UniformHandle handle) const {
+			auto it = mUniformSlots.find(handle.getHash());
+
+			if (it == mUniformSlots.end())
+				return -1;
+
+			return it->second.mLocation;
+		}
+
 		GLint ShaderProgram::getUniformLocation(const std::string& name) const {
 			auto it = mUniforms.find(name);
 
@@ -247,6 +384,10 @@ namespace overdrive {
 			return it->second;
 		}
 
+		bool ShaderProgram::hasAttribute(const std::string& name) const {
+			return (mAttributes.find(name) != mAttributes.end());
+		}
+
 		GLint ShaderProgram::getAttributeLocation(const std::string& name) const {
 			auto it = mAttributes.find(name);
 			
@@ -265,6 +406,98 @@ namespace overdrive {
 			return it->second;
 		}
 
+		bool ShaderProgram::hasUniformBlock(const std::string& name) const {
+			return (mUniformBlocks.find(name) != mUniformBlocks.end());
+		}
+
+		bool ShaderProgram::isInstanced() const {
+			return mIsInstanced;
+		}
+
+		bool ShaderProgram::hasObjectBlock() const {
+			return mHasObjectBlock;
+		}
+
+		const ShaderUniformBlock& ShaderProgram::getUniformBlockData(const std::string& name) const {
+			auto it = mUniformBlocks.find(name);
+
+			if (it == mUniformBlocks.end())
+				throw ShaderException(std::string("Cannot locate uniform block: ") + name);
+
+			return it->second;
+		}
+
+		void ShaderProgram::forgetUniformValues() {
+			for (auto& item : mUniformSlots) {
+				item.second.mSize = 0;
+				item.second.mCapacity = 0;
+			}
+
+			mUniformValues.clear();
+		}
+
+		ShaderProgram::UniformSlot* ShaderProgram::findSlot(UniformHandle handle) {
+			auto it = mUniformSlots.find(handle.getHash());
+
+			if (it == mUniformSlots.end())
+				return nullptr;
+
+			return &it->second;
+		}
+
+		ShaderProgram::UniformSlot* ShaderProgram::findSlot(const std::string& name) {
+			if (UniformSlot* slot = findSlot(UniformHandle(name.c_str())))
+				return slot;
+
+			if (!hasUniform(name))
+				throw ShaderException(std::string("Cannot locate uniform: ") + name);
+
+			return nullptr; // part of a uniform block
+		}
+
+		bool ShaderProgram::updateValue(UniformSlot& slot, const void* value, size_t size) {
+			auto& cache = StateCache::current();
+
+			if (slot.mSize == size) {
+				uint8_t* previous = mUniformValues.data() + slot.mOffset;
+
+				if (std::memcmp(previous, value, size) == 0) {
+					cache.recordUniform(false);
+					return false;
+				}
+
+				std::memcpy(previous, value, size);
+			}
+			else if (size <= slot.mCapacity) {
+				// a differently sized value that fits in the storage of the slot
+				std::memcpy(mUniformValues.data() + slot.mOffset, value, size);
+				slot.mSize = static_cast<uint32_t>(size);
+			}
+			else {
+				// first time (or a larger value), append storage for it; the largest uniform type bounds how often that happens
+				slot.mOffset = static_cast<uint32_t>(mUniformValues.size());
+				slot.mSize = static_cast<uint32_t>(size);
+				slot.mCapacity = slot.mSize;
+
+				const uint8_t* bytes = static_cast<const uint8_t*>(value);
+				mUniformValues.insert(mUniformValues.end(), bytes, bytes + size);
+			}
+
+			cache.recordUniform(true);
+			return true;
+		}
+
+		// http://docs.gl/gl4/glUniformBlockBinding
+		void ShaderProgram::bindUniformBlock(const std::string& name, GLuint binding) {
+			auto it = mUniformBlocks.find(name);
+
+			if (it == mUniformBlocks.end())
+				throw ShaderException(std::string("Cannot locate uniform block: ") + name);
+
+			glUniformBlockBinding(mHandle, it->second.mIndex, binding);
+			it->second.mBinding = static_cast<GLint>(binding);
+		}
+
 		// http://docs.gl/gl4/glGetProgramInterface
 		// http://docs.gl/gl4/glGetProgramResource
 		void ShaderProgram::gatherUniforms() {
@@ -334,6 +567,15 @@ namespace overdrive {
 					uniformName.get(),
 					ShaderUniform(uniformName.get(), results)
 				));
+
+				GLint location = results[2];
+
+				if (location >= 0) {
+					UniformHandle handle(uniformName.get());
+
+					if (!mUniformSlots.insert(std::make_pair(handle.getHash(), UniformSlot{ location, 0, 0, 0 })).second)
+						throw ShaderException(std::string("Uniform name hash collision: ") + uniformName.get());
+				}
 			}
 		}
 
@@ -399,6 +641,54 @@ namespace overdrive {
 			}
 		}
 
+		// http://docs.gl/gl4/glGetProgramInterface
+		// http://docs.gl/gl4/glGetProgramResource
+		void ShaderProgram::gatherUniformBlocks() {
+			typedef std::pair<std::string, ShaderUniformBlock> BlockPair;
+
+			GLint numBlocks = 0;
+			glGetProgramInterfaceiv(mHandle, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &numBlocks);
+
+			GLenum properties[] = {
+				GL_NAME_LENGTH,
+				GL_BUFFER_BINDING,
+				GL_BUFFER_DATA_SIZE
+			};
+
+			const size_t numProperties = sizeof(properties) / sizeof(properties[0]);
+
+			for (GLint i = 0; i < numBlocks; ++i) {
+				GLint results[numProperties];
+				glGetProgramResourceiv(
+					mHandle,
+					GL_UNIFORM_BLOCK,
+					i,
+					numProperties,
+					properties,
+					numProperties,
+					nullptr,
+					results
+				);
+
+				GLint nameSize = results[0];
+				std::unique_ptr<GLchar[]> blockName(new GLchar[nameSize]);
+
+				glGetProgramResourceName(
+					mHandle,
+					GL_UNIFORM_BLOCK,
+					i,
+					nameSize,
+					nullptr,
+					blockName.get()
+				);
+
+				mUniformBlocks.insert(BlockPair(
+					blockName.get(),
+					ShaderUniformBlock{ static_cast<GLuint>(i), results[1], results[2] }
+				));
+			}
+		}
+
 		void ShaderProgram::setUniform(GLint location, GLfloat x) {
 			glUniform1f(location, x);
 		}
@@ -5,10 +5,16 @@
 #include <boost/container/flat_map.hpp>
 #include <ostream>
 #include <memory>
+#include <vector>
 #include "../opengl.h"
 #include "shader.h"
+#include "uniform_handle.h"
 
 namespace overdrive {
+	namespace util {
+		class AssetPack;
+	}
+
 	namespace render {
 		class ShaderAttribute;
 		class ShaderUniform;
@@ -20,11 +26,21 @@ namespace overdrive {
 		//		  The program will be compiled, linked, verified etc upon the first time a shader is attached
 		// [NOTE] The amount of uniforms and/or attributes is too low to justify using a mapping structure
 		// [NOTE] glm also supports a simd optimized vec4 (just the float version), still need to figure out how to properly use it
+		// [NOTE] Setting a uniform through a UniformHandle (or by name) remembers the value, and doesn't send it again if it
+		//		  didn't change. Setting by location bypasses this; call forgetUniformValues() after doing that
+		// [NOTE] A program can be restored from a driver specific binary instead of compiling and linking it, see
+		//		  ProgramBinaryCache. Such a program has no Shader objects attached
 
 		// [TODO] the shader program exposes many types of interfaces, perhaps support the remaining types as well?
-		// [TODO] to/from binary formats should be possible
 		// [TODO] perhaps move the gather active attribute/uniform from this class
 
+		// ~ GL_UNIFORM_BLOCK resource interface
+		struct ShaderUniformBlock {
+			GLuint mIndex;
+			GLint mBinding;
+			GLint mDataSize; // in bytes
+		};
+
 		// http://docs.gl/gl4/glCreateProgram
 		class ShaderProgram {
 		public:
@@ -38,13 +54,28 @@ namespace overdrive {
 
 			GLuint getHandle() const;
 
-			void attachShader(const std::string& source, eShaderType type);
-			void loadShader(const boost::filesystem::path& p, eShaderType type);
+			void attachShader(const std::string& source, eShaderType type);			// compiles immediately, throws on errors
+			void attachShaderAsync(const std::string& source, eShaderType type);	// compile errors are thrown by finishLink
+			void attachShader(const char* source, size_t length, eShaderType type);			// source doesn't need to be null-terminated
+			void attachShaderAsync(const char* source, size_t length, eShaderType type);
+			void loadShader(const boost::filesystem::path& p, eShaderType type);	// compiles straight from the memory-mapped file
+			void loadShader(const util::AssetPack& pack, const std::string& name, eShaderType type);
 
 			void link();
+
+			// link without waiting for the driver; poll isLinkComplete and call finishLink once it yields true
+			// (finishLink blocks if the driver is not done yet, this is all that happens without parallel compile support)
+			void linkAsync();
+			bool isLinkComplete() const;
+			bool finishLink(); // throws on compile errors, logs link errors; yields isLinked()
+
 			bool isLinked() const;
 			void validate();
 
+			void setBinaryRetrievable(bool enabled); // hint that getBinary will be used; must be set before linking
+			bool getBinary(GLenum& format, std::vector<uint8_t>& data) const; // false if the program is not linked
+			bool loadBinary(GLenum format, const void* data, GLsizei numBytes); // false if the driver rejects the binary
+
 			void bind();	// ~> use
 			void unbind();
 
@@ -56,12 +87,24 @@ namespace overdrive {
 			void bindAttributeLocation(GLuint id, const std::string& name);
 			void bindFragDataLocation(GLuint id, const std::string& name);
 
+			bool hasUniform(const std::string& name) const;
+			bool hasUniform(UniformHandle handle) const; // only uniforms with a location (so not members of uniform blocks)
 			GLint getUniformLocation(const std::string& name) const;
+			GLint getUniformLocation(UniformHandle handle) const; // -1 if there is no such uniform
 			const ShaderUniform& getUniformData(const std::string& name) const;
 			
+			bool hasAttribute(const std::string& name) const;
 			GLint getAttributeLocation(const std::string& name) const;
 			const ShaderAttribute& getAttributeData(const std::string& name) const;
 
+			bool hasUniformBlock(const std::string& name) const;
+			const ShaderUniformBlock& getUniformBlockData(const std::string& name) const;
+			void bindUniformBlock(const std::string& name, GLuint binding); // not needed for blocks that specify layout(binding = x)
+
+			// looked up once when the program is linked, so the Renderer doesn't have to search by name per draw
+			bool isInstanced() const;		// has the per-instance aInstanceModel attribute (see InstanceBuffer)
+			bool hasObjectBlock() const;	// uses the per-draw Object uniform block (see blocks::Object)
+
 			// ------ Set Uniform -----
 
 			template <typename T> void setUniform(const std::string& name, const T& value);
@@ -69,6 +112,14 @@ namespace overdrive {
 			template <typename T> void setUniform(const std::string& name, const T& x, const T& y, const T& z);
 			template <typename T> void setUniform(const std::string& name, const T& x, const T& y, const T& z, const T& w);
 
+			// uniforms that are not active in this program are ignored, like glUniform* does with location -1
+			template <typename T> void setUniform(UniformHandle handle, const T& value);
+			template <typename T> void setUniform(UniformHandle handle, const T& x, const T& y);
+			template <typename T> void setUniform(UniformHandle handle, const T& x, const T& y, const T& z);
+			template <typename T> void setUniform(UniformHandle handle, const T& x, const T& y, const T& z, const T& w);
+
+			void forgetUniformValues(); // the next set of every uniform will be sent
+
 			// float
 			void setUniform(GLint location, GLfloat x);
 			void setUniform(GLint location, GLfloat x, GLfloat y);
@@ -145,16 +196,44 @@ namespace overdrive {
 			// atomic counter
 
 		private:
+			// last value sent to a uniform, kept in mUniformValues
+			struct UniformSlot {
+				GLint mLocation;
+				uint32_t mOffset;
+				uint32_t mSize; // 0 until the first value is sent
+				uint32_t mCapacity; // bytes reserved at mOffset, a smaller value re-uses them
+			};
+
+			UniformSlot* findSlot(UniformHandle handle);
+			UniformSlot* findSlot(const std::string& name); // throws if there is no such uniform, nullptr if it has no location
+			bool updateValue(UniformSlot& slot, const void* value, size_t size); // true if the value changed
+
+			template <typename T> void setUniform(UniformSlot& slot, const T& value);
+			template <typename T> void setUniform(UniformSlot& slot, const T& x, const T& y);
+			template <typename T> void setUniform(UniformSlot& slot, const T& x, const T& y, const T& z);
+			template <typename T> void setUniform(UniformSlot& slot, const T& x, const T& y, const T& z, const T& w);
+
+			void createHandle();
+			void onLinked();
+
 			void gatherUniforms();		// query all active uniforms and store results in mUniforms
 			void gatherAttributes();	// query all active attributes and store results in mAttributes
+			void gatherUniformBlocks();	// query all active uniform blocks and store results in mUniformBlocks
 
 			GLuint mHandle;
 			std::unique_ptr<Shader> mShaders[6]; // fixed positions for all shader types
 			
 			boost::container::flat_map<std::string, ShaderUniform> mUniforms;
 			boost::container::flat_map<std::string, ShaderAttribute> mAttributes;
+			boost::container::flat_map<std::string, ShaderUniformBlock> mUniformBlocks;
+
+			boost::container::flat_map<uint32_t, UniformSlot> mUniformSlots; // by name hash
+			std::vector<uint8_t> mUniformValues;
 
+			bool mIsLinking; // between linkAsync and finishLink
 			bool mIsLinked;
+			bool mIsInstanced;
+			bool mHasObjectBlock;
 		};
 		
 		std::ostream& operator << (std::ostream& os, const ShaderProgram& program);
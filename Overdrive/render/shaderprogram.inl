@@ -9,8 +9,8 @@ namespace overdrive {
 			const std::string& name, 
 			const T& value
 		) {
-			GLint location = getUniformLocation(name);
-			setUniform(location, value);
+			if (UniformSlot* slot = findSlot(name))
+				setUniform(*slot, value);
 		}
 
 		template <typename T> 
@@ -19,8 +19,8 @@ namespace overdrive {
 			const T& x, 
 			const T& y
 		) {
-			GLint location = getUniformLocation(name);
-			setUniform(location, x, y);
+			if (UniformSlot* slot = findSlot(name))
+				setUniform(*slot, x, y);
 		}
 
 		template <typename T> 
@@ -30,8 +30,8 @@ namespace overdrive {
 			const T& y, 
 			const T& z
 		) {
-			GLint location = getUniformLocation(name);
-			setUniform(location, x, y, z);
+			if (UniformSlot* slot = findSlot(name))
+				setUniform(*slot, x, y, z);
 		}
 
 		template <typename T> 
@@ -42,8 +42,98 @@ namespace overdrive {
 			const T& z, 
 			const T& w
 		) {
-			GLint location = getUniformLocation(name);
-			setUniform(location, x, y, z, w);
+			if (UniformSlot* slot = findSlot(name))
+				setUniform(*slot, x, y, z, w);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformHandle handle,
+			const T& value
+		) {
+			if (UniformSlot* slot = findSlot(handle))
+				setUniform(*slot, value);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformHandle handle,
+			const T& x,
+			const T& y
+		) {
+			if (UniformSlot* slot = findSlot(handle))
+				setUniform(*slot, x, y);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformHandle handle,
+			const T& x,
+			const T& y,
+			const T& z
+		) {
+			if (UniformSlot* slot = findSlot(handle))
+				setUniform(*slot, x, y, z);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformHandle handle,
+			const T& x,
+			const T& y,
+			const T& z,
+			const T& w
+		) {
+			if (UniformSlot* slot = findSlot(handle))
+				setUniform(*slot, x, y, z, w);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformSlot& slot,
+			const T& value
+		) {
+			if (updateValue(slot, &value, sizeof(T)))
+				setUniform(slot.mLocation, value);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformSlot& slot,
+			const T& x,
+			const T& y
+		) {
+			const T values[] = { x, y };
+
+			if (updateValue(slot, values, sizeof(values)))
+				setUniform(slot.mLocation, x, y);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformSlot& slot,
+			const T& x,
+			const T& y,
+			const T& z
+		) {
+			const T values[] = { x, y, z };
+
+			if (updateValue(slot, values, sizeof(values)))
+				setUniform(slot.mLocation, x, y, z);
+		}
+
+		template <typename T>
+		void ShaderProgram::setUniform(
+			UniformSlot& slot,
+			const T& x,
+			const T& y,
+			const T& z,
+			const T& w
+		) {
+			const T values[] = { x, y, z, w };
+
+			if (updateValue(slot, values, sizeof(values)))
+				setUniform(slot.mLocation, x, y, z, w);
 		}
 	}
 }
@@ -62,6 +62,17 @@ namespace overdrive {
 			void Cube::draw() {
 				mVAO.draw();
 			}
+
+			void Cube::drawInstanced(InstanceBuffer& instances, const InstanceRange& range) {
+				if (mVAO.getInstanceBuffer() != &instances)
+					mVAO.attach(instances);
+
+				mVAO.drawInstanced(range);
+			}
+
+			VertexArray& Cube::getVAO() {
+				return mVAO;
+			}
 		}
 	}
 }
@@ -18,6 +18,9 @@ namespace overdrive {
 				Cube(float size = 1.0f);
 
 				void draw();
+				void drawInstanced(InstanceBuffer& instances, const InstanceRange& range);
+
+				VertexArray& getVAO();
 
 			private:
 				VertexBuffer mVertexBuffer;
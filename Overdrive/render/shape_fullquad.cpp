@@ -21,6 +21,17 @@ namespace overdrive {
 			void FullQuad::draw() {
 				mVAO.draw();
 			}
+
+			void FullQuad::drawInstanced(InstanceBuffer& instances, const InstanceRange& range) {
+				if (mVAO.getInstanceBuffer() != &instances)
+					mVAO.attach(instances);
+
+				mVAO.drawInstanced(range);
+			}
+
+			VertexArray& FullQuad::getVAO() {
+				return mVAO;
+			}
 		}
 	}
 }
\ No newline at end of file
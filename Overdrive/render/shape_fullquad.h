@@ -15,6 +15,9 @@ namespace overdrive {
 				FullQuad();
 
 				void draw();
+				void drawInstanced(InstanceBuffer& instances, const InstanceRange& range);
+
+				VertexArray& getVAO();
 
 			private:
 				VertexBuffer<attributes::PositionTexCoord> mVBO;
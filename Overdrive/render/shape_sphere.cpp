@@ -97,6 +97,17 @@ namespace overdrive {
 			void Sphere::draw() {
 				mVAO.draw();
 			}
+
+			void Sphere::drawInstanced(InstanceBuffer& instances, const InstanceRange& range) {
+				if (mVAO.getInstanceBuffer() != &instances)
+					mVAO.attach(instances);
+
+				mVAO.drawInstanced(range);
+			}
+
+			VertexArray& Sphere::getVAO() {
+				return mVAO;
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -19,6 +19,9 @@ namespace overdrive {
 				Sphere(float radius = 1.0f, unsigned int slices = 16, unsigned int stacks = 16);
 
 				void draw();
+				void drawInstanced(InstanceBuffer& instances, const InstanceRange& range);
+
+				VertexArray& getVAO();
 
 			private:
 				VertexBuffer mVertexBuffer;
@@ -0,0 +1,347 @@
+#include "stdafx.h"
+#include "state_cache.h"
+#include <algorithm>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			const GLenum gBufferTargets[StateCache::NUM_BUFFER_TARGETS] = {
+				GL_ARRAY_BUFFER,
+				GL_ATOMIC_COUNTER_BUFFER,
+				GL_COPY_READ_BUFFER,
+				GL_COPY_WRITE_BUFFER,
+				GL_DISPATCH_INDIRECT_BUFFER,
+				GL_DRAW_INDIRECT_BUFFER,
+				GL_ELEMENT_ARRAY_BUFFER,
+				GL_PIXEL_PACK_BUFFER,
+				GL_PIXEL_UNPACK_BUFFER,
+				GL_QUERY_BUFFER,
+				GL_SHADER_STORAGE_BUFFER,
+				GL_TEXTURE_BUFFER,
+				GL_TRANSFORM_FEEDBACK_BUFFER,
+				GL_UNIFORM_BUFFER
+			};
+
+			const GLenum gTextureTargets[StateCache::NUM_TEXTURE_TARGETS] = {
+				GL_TEXTURE_1D,
+				GL_TEXTURE_2D,
+				GL_TEXTURE_3D,
+				GL_TEXTURE_1D_ARRAY,
+				GL_TEXTURE_2D_ARRAY,
+				GL_TEXTURE_RECTANGLE,
+				GL_TEXTURE_CUBE_MAP,
+				GL_TEXTURE_CUBE_MAP_ARRAY,
+				GL_TEXTURE_BUFFER,
+				GL_TEXTURE_2D_MULTISAMPLE,
+				GL_TEXTURE_2D_MULTISAMPLE_ARRAY
+			};
+
+			// capabilities that get a bit in the cache, anything else is always forwarded
+			const GLenum gCapabilities[] = {
+				GL_DEPTH_TEST,
+				GL_CULL_FACE,
+				GL_BLEND,
+				GL_STENCIL_TEST,
+				GL_SCISSOR_TEST,
+				GL_POLYGON_OFFSET_FILL,
+				GL_MULTISAMPLE,
+				GL_SAMPLE_ALPHA_TO_COVERAGE,
+				GL_FRAMEBUFFER_SRGB,
+				GL_PRIMITIVE_RESTART,
+				GL_PROGRAM_POINT_SIZE,
+				GL_TEXTURE_CUBE_MAP_SEAMLESS,
+				GL_DEPTH_CLAMP,
+				GL_RASTERIZER_DISCARD,
+				GL_DITHER
+			};
+
+			const size_t NUM_CAPABILITIES = sizeof(gCapabilities) / sizeof(gCapabilities[0]);
+
+			enum eFixedFunction: uint32_t {
+				CLEAR_COLOR		= 1 << 0,
+				CLEAR_DEPTH		= 1 << 1,
+				CLEAR_STENCIL	= 1 << 2,
+				CULL_FACE		= 1 << 3
+			};
+
+			template <size_t N>
+			size_t findIndex(const GLenum (&table)[N], GLenum value) {
+				return std::find(std::begin(table), std::end(table), value) - std::begin(table);
+			}
+
+			size_t toIndex(eStateCall call) {
+				return static_cast<size_t>(call);
+			}
+		}
+
+		// ----- StateCacheStats -----
+		size_t StateCacheStats::getNumIssued() const {
+			size_t result = 0;
+
+			for (auto count : mNumIssued)
+				result += count;
+
+			return result;
+		}
+
+		size_t StateCacheStats::getNumElided() const {
+			size_t result = 0;
+
+			for (auto count : mNumElided)
+				result += count;
+
+			return result;
+		}
+
+		// ----- StateCache -----
+		StateCache::StateCache() {
+			invalidate();
+		}
+
+		StateCache& StateCache::current() {
+			static thread_local StateCache cache;
+			return cache;
+		}
+
+		void StateCache::invalidate() {
+			mProgram = UNKNOWN;
+			mVertexArray = UNKNOWN;
+			mActiveTexture = UNKNOWN;
+
+			std::fill(std::begin(mBuffers), std::end(mBuffers), UNKNOWN);
+
+			for (auto& unit : mTextures)
+				std::fill(std::begin(unit), std::end(unit), UNKNOWN);
+
+			mKnownCapabilities = 0;
+			mEnabledCapabilities = 0;
+			mKnownFixedFunction = 0;
+		}
+
+		void StateCache::useProgram(GLuint program) {
+			if (update(eStateCall::PROGRAM, mProgram, program))
+				glUseProgram(program);
+		}
+
+		void StateCache::bindVertexArray(GLuint vao) {
+			if (update(eStateCall::VERTEX_ARRAY, mVertexArray, vao)) {
+				glBindVertexArray(vao);
+
+				mBuffers[findIndex(gBufferTargets, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+			}
+		}
+
+		void StateCache::bindBuffer(GLenum target, GLuint buffer) {
+			size_t index = findIndex(gBufferTargets, target);
+			assert(index < NUM_BUFFER_TARGETS);
+
+			if (update(eStateCall::BUFFER, mBuffers[index], buffer))
+				glBindBuffer(target, buffer);
+		}
+
+		void StateCache::activeTexture(GLuint unit) {
+			assert(unit < MAX_TEXTURE_UNITS);
+
+			if (update(eStateCall::ACTIVE_TEXTURE, mActiveTexture, unit))
+				glActiveTexture(GL_TEXTURE0 + unit);
+		}
+
+		void StateCache::bindTexture(GLenum target, GLuint texture) {
+			if (mActiveTexture == UNKNOWN)
+				activeTexture(0);
+
+			bindTexture(mActiveTexture, target, texture);
+		}
+
+		void StateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+			assert(unit < MAX_TEXTURE_UNITS);
+
+			size_t index = findIndex(gTextureTargets, target);
+			assert(index < NUM_TEXTURE_TARGETS);
+
+			if (update(eStateCall::TEXTURE, mTextures[unit][index], texture)) {
+				activeTexture(unit);
+				glBindTexture(target, texture);
+			}
+		}
+
+		void StateCache::setEnabled(GLenum capability, bool enabled) {
+			size_t index = findIndex(gCapabilities, capability);
+			uint32_t bit = (index < NUM_CAPABILITIES) ? (1u << index) : 0;
+
+			bool isKnown = (mKnownCapabilities & bit) != 0;
+			bool isEnabled = (mEnabledCapabilities & bit) != 0;
+
+			if (isKnown && (isEnabled == enabled)) {
+				++mStats.mNumElided[toIndex(eStateCall::CAPABILITY)];
+				return;
+			}
+
+			if (enabled) {
+				glEnable(capability);
+				mEnabledCapabilities |= bit;
+			}
+			else {
+				glDisable(capability);
+				mEnabledCapabilities &= ~bit;
+			}
+
+			mKnownCapabilities |= bit;
+			++mStats.mNumIssued[toIndex(eStateCall::CAPABILITY)];
+		}
+
+		void StateCache::setClearColor(const glm::vec4& color) {
+			if ((mKnownFixedFunction & CLEAR_COLOR) && (mClearColor == color)) {
+				++mStats.mNumElided[toIndex(eStateCall::FIXED_FUNCTION)];
+				return;
+			}
+
+			glClearColor(color.r, color.g, color.b, color.a);
+
+			mClearColor = color;
+			mKnownFixedFunction |= CLEAR_COLOR;
+			++mStats.mNumIssued[toIndex(eStateCall::FIXED_FUNCTION)];
+		}
+
+		void StateCache::setClearDepth(double depth) {
+			if ((mKnownFixedFunction & CLEAR_DEPTH) && (mClearDepth == depth)) {
+				++mStats.mNumElided[toIndex(eStateCall::FIXED_FUNCTION)];
+				return;
+			}
+
+			glClearDepth(depth);
+
+			mClearDepth = depth;
+			mKnownFixedFunction |= CLEAR_DEPTH;
+			++mStats.mNumIssued[toIndex(eStateCall::FIXED_FUNCTION)];
+		}
+
+		void StateCache::setClearStencil(GLint index) {
+			if ((mKnownFixedFunction & CLEAR_STENCIL) && (mClearStencil == index)) {
+				++mStats.mNumElided[toIndex(eStateCall::FIXED_FUNCTION)];
+				return;
+			}
+
+			glClearStencil(index);
+
+			mClearStencil = index;
+			mKnownFixedFunction |= CLEAR_STENCIL;
+			++mStats.mNumIssued[toIndex(eStateCall::FIXED_FUNCTION)];
+		}
+
+		void StateCache::setCullFace(GLenum mode) {
+			if ((mKnownFixedFunction & CULL_FACE) && (mCullFace == mode)) {
+				++mStats.mNumElided[toIndex(eStateCall::FIXED_FUNCTION)];
+				return;
+			}
+
+			glCullFace(mode);
+
+			mCullFace = mode;
+			mKnownFixedFunction |= CULL_FACE;
+			++mStats.mNumIssued[toIndex(eStateCall::FIXED_FUNCTION)];
+		}
+
+		void StateCache::onDeleteProgram(GLuint program) {
+			if (mProgram == program)
+				mProgram = 0;
+		}
+
+		void StateCache::onDeleteVertexArray(GLuint vao) {
+			if (mVertexArray == vao) {
+				mVertexArray = 0;
+				mBuffers[findIndex(gBufferTargets, GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+			}
+		}
+
+		void StateCache::onDeleteBuffer(GLuint buffer) {
+			for (auto& binding : mBuffers)
+				if (binding == buffer)
+					binding = 0;
+		}
+
+		void StateCache::onDeleteTexture(GLuint texture) {
+			for (auto& unit : mTextures)
+				for (auto& binding : unit)
+					if (binding == texture)
+						binding = 0;
+		}
+
+		GLuint StateCache::getProgram() const {
+			return mProgram;
+		}
+
+		GLuint StateCache::getVertexArray() const {
+			return mVertexArray;
+		}
+
+		GLuint StateCache::getBuffer(GLenum target) const {
+			size_t index = findIndex(gBufferTargets, target);
+			assert(index < NUM_BUFFER_TARGETS);
+
+			return mBuffers[index];
+		}
+
+		GLuint StateCache::getTexture(GLuint unit, GLenum target) const {
+			assert(unit < MAX_TEXTURE_UNITS);
+
+			size_t index = findIndex(gTextureTargets, target);
+			assert(index < NUM_TEXTURE_TARGETS);
+
+			return mTextures[unit][index];
+		}
+
+		void StateCache::recordUniform(bool isIssued) {
+			if (isIssued)
+				++mStats.mNumIssued[toIndex(eStateCall::UNIFORM)];
+			else
+				++mStats.mNumElided[toIndex(eStateCall::UNIFORM)];
+		}
+
+		const StateCacheStats& StateCache::getStats() const {
+			return mStats;
+		}
+
+		void StateCache::resetStats() {
+			mStats = StateCacheStats();
+		}
+
+		bool StateCache::update(eStateCall call, GLuint& cached, GLuint value) {
+			if (cached == value) {
+				++mStats.mNumElided[toIndex(call)];
+				return false;
+			}
+
+			cached = value;
+			++mStats.mNumIssued[toIndex(call)];
+
+			return true;
+		}
+
+		std::ostream& operator << (std::ostream& os, const eStateCall& call) {
+			switch (call) {
+			case eStateCall::PROGRAM:			os << "program"; break;
+			case eStateCall::VERTEX_ARRAY:		os << "vertex array"; break;
+			case eStateCall::BUFFER:			os << "buffer"; break;
+			case eStateCall::ACTIVE_TEXTURE:	os << "active texture"; break;
+			case eStateCall::TEXTURE:			os << "texture"; break;
+			case eStateCall::CAPABILITY:		os << "capability"; break;
+			case eStateCall::FIXED_FUNCTION:	os << "fixed function"; break;
+			case eStateCall::UNIFORM:			os << "uniform"; break;
+			default:
+				os << "Unknown state call: " << static_cast<int>(call);
+			}
+
+			return os;
+		}
+
+		std::ostream& operator << (std::ostream& os, const StateCacheStats& stats) {
+			os << stats.getNumIssued() << " issued, " << stats.getNumElided() << " elided";
+
+			for (size_t i = 0; i < toIndex(eStateCall::COUNT); ++i)
+				os << "\n\t" << static_cast<eStateCall>(i) << ": " << stats.mNumIssued[i] << " / " << stats.mNumElided[i];
+
+			return os;
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../opengl.h"
+#include <cstdint>
+#include <ostream>
+
+namespace overdrive {
+	namespace render {
+		enum class eStateCall {
+			PROGRAM,
+			VERTEX_ARRAY,
+			BUFFER,
+			ACTIVE_TEXTURE,
+			TEXTURE,
+			CAPABILITY,		// glEnable/glDisable
+			FIXED_FUNCTION,	// clear values, cull face
+			UNIFORM,		// glUniform* through a UniformHandle (only counted, see recordUniform)
+
+			COUNT
+		};
+
+		struct StateCacheStats {
+			size_t mNumIssued[static_cast<size_t>(eStateCall::COUNT)] = {};
+			size_t mNumElided[static_cast<size_t>(eStateCall::COUNT)] = {};
+
+			size_t getNumIssued() const;
+			size_t getNumElided() const;
+		};
+
+		/*
+			Shadows the binding state of the current openGL context and only forwards calls that actually
+			change something. Unknown state (after construction or invalidate()) is never elided.
+
+			[NOTE] there is one cache per thread; Window::makeCurrent invalidates it when the context changes.
+			       Code that talks to openGL directly should call invalidate() afterwards
+			[NOTE] the element array binding is part of the vertex array state, so it is forgotten whenever
+			       the vertex array binding changes
+			[NOTE] openGL unbinds deleted objects, and may hand out the same name again; the onDelete*
+			       functions keep the cache in line with that
+		*/
+		class StateCache {
+		public:
+			static const GLuint MAX_TEXTURE_UNITS = 32;
+			static const size_t NUM_BUFFER_TARGETS = 14;
+			static const size_t NUM_TEXTURE_TARGETS = 11;
+			static const GLuint UNKNOWN = ~0u;
+
+			StateCache();
+
+			StateCache(const StateCache&) = delete;
+			StateCache& operator = (const StateCache&) = delete;
+
+			static StateCache& current();
+
+			void invalidate();
+
+			void useProgram(GLuint program);
+			void bindVertexArray(GLuint vao);
+			void bindBuffer(GLenum target, GLuint buffer);
+			void activeTexture(GLuint unit);
+			void bindTexture(GLenum target, GLuint texture); // binds to the active unit
+			void bindTexture(GLuint unit, GLenum target, GLuint texture);
+			void setEnabled(GLenum capability, bool enabled);
+
+			void setClearColor(const glm::vec4& color);
+			void setClearDepth(double depth);
+			void setClearStencil(GLint index);
+			void setCullFace(GLenum mode);
+
+			void onDeleteProgram(GLuint program);
+			void onDeleteVertexArray(GLuint vao);
+			void onDeleteBuffer(GLuint buffer);
+			void onDeleteTexture(GLuint texture);
+
+			// uniform values are part of the program objects, ShaderProgram keeps track of those itself
+			void recordUniform(bool isIssued);
+
+			GLuint getProgram() const;
+			GLuint getVertexArray() const;
+			GLuint getBuffer(GLenum target) const;
+			GLuint getTexture(GLuint unit, GLenum target) const;
+
+			const StateCacheStats& getStats() const;
+			void resetStats();
+
+		private:
+			bool update(eStateCall call, GLuint& cached, GLuint value); // true if the call should be issued
+
+			GLuint mProgram;
+			GLuint mVertexArray;
+			GLuint mBuffers[NUM_BUFFER_TARGETS];
+			GLuint mActiveTexture;
+			GLuint mTextures[MAX_TEXTURE_UNITS][NUM_TEXTURE_TARGETS];
+
+			uint32_t mKnownCapabilities;
+			uint32_t mEnabledCapabilities;
+
+			glm::vec4 mClearColor;
+			double mClearDepth;
+			GLint mClearStencil;
+			GLenum mCullFace;
+			uint32_t mKnownFixedFunction; // one bit per value above
+
+			StateCacheStats mStats;
+		};
+
+		std::ostream& operator << (std::ostream& os, const eStateCall& call);
+		std::ostream& operator << (std::ostream& os, const StateCacheStats& stats);
+	}
+}
@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "stream_buffer.h"
+#include "state_cache.h"
+#include "../util/enum_bitfield.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace render {
+		StreamBuffer::StreamBuffer(
+			size_t bytesPerRegion,
+			size_t numRegions
+		):
+			mHandle(0),
+			mMemory(nullptr),
+			mRegionSize(bytesPerRegion),
+			mNumRegions(numRegions),
+			mRegion(0),
+			mOffset(0),
+			mNeedsWait(false),
+			mFences(new GLsync[numRegions])
+		{
+			assert(bytesPerRegion > 0);
+			assert(numRegions > 0);
+
+			std::fill(mFences.get(), mFences.get() + numRegions, nullptr);
+		}
+
+		StreamBuffer::~StreamBuffer() {
+			for (size_t i = 0; i < mNumRegions; ++i)
+				if (mFences[i])
+					glDeleteSync(mFences[i]);
+
+			if (mHandle) {
+				StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, mHandle);
+				glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+
+				StateCache::current().onDeleteBuffer(mHandle);
+				glDeleteBuffers(1, &mHandle);
+			}
+		}
+
+		GLuint StreamBuffer::getHandle() const {
+			return mHandle;
+		}
+
+		size_t StreamBuffer::getRegionSize() const {
+			return mRegionSize;
+		}
+
+		size_t StreamBuffer::getNumRegions() const {
+			return mNumRegions;
+		}
+
+		StreamAllocation StreamBuffer::allocate(size_t numBytes, size_t alignment) {
+			assert(numBytes > 0);
+			assert(alignment > 0);
+
+			if (!mHandle)
+				create();
+
+			if (getNumAvailable(alignment) < numBytes) {
+				advance();
+
+				if (getNumAvailable(alignment) < numBytes)
+					throw std::runtime_error("StreamBuffer allocation does not fit in a single region");
+			}
+
+			wait();
+
+			size_t offset = alignedOffset(alignment);
+
+			mOffset = offset + numBytes - mRegion * mRegionSize;
+
+			return StreamAllocation{
+				mMemory + offset,
+				static_cast<GLintptr>(offset),
+				static_cast<GLsizeiptr>(numBytes)
+			};
+		}
+
+		size_t StreamBuffer::getNumAvailable(size_t alignment) const {
+			size_t regionEnd = (mRegion + 1) * mRegionSize;
+			size_t offset = alignedOffset(alignment);
+
+			if (offset >= regionEnd)
+				return 0;
+
+			return regionEnd - offset;
+		}
+
+		void StreamBuffer::advance() {
+			if (mOffset == 0)
+				return; // nothing was written, the region can be re-used as is
+
+			mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			mRegion = (mRegion + 1) % mNumRegions;
+			mOffset = 0;
+			mNeedsWait = true;
+		}
+
+		void StreamBuffer::bind(eBufferTarget target) {
+			if (!mHandle)
+				create();
+
+			StateCache::current().bindBuffer(static_cast<GLenum>(target), mHandle);
+		}
+
+		void StreamBuffer::bindRange(eBufferTarget target, GLuint index, const StreamAllocation& allocation) {
+			// glBindBufferRange also changes the generic binding point of the target, so go through the cache for that first
+			bind(target);
+
+			glBindBufferRange(static_cast<GLenum>(target), index, mHandle, allocation.mOffset, allocation.mSize);
+		}
+
+		size_t StreamBuffer::getUniformAlignment() {
+			GLint result = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &result);
+			return static_cast<size_t>(result);
+		}
+
+		void StreamBuffer::create() {
+			GLsizeiptr numBytes = mRegionSize * mNumRegions;
+
+			util::Bitfield<eBufferAccess> flags({
+				eBufferAccess::WRITE,
+				eBufferAccess::PERSISTENT,
+				eBufferAccess::COHERENT
+			});
+
+			glGenBuffers(1, &mHandle);
+
+			StateCache::current().bindBuffer(GL_COPY_WRITE_BUFFER, mHandle);
+			glBufferStorage(GL_COPY_WRITE_BUFFER, numBytes, nullptr, flags.value());
+
+			mMemory = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, numBytes, flags.value()));
+
+			if (!mMemory)
+				throw std::runtime_error("Could not map stream buffer");
+		}
+
+		void StreamBuffer::wait() {
+			if (!mNeedsWait)
+				return;
+
+			GLsync& fence = mFences[mRegion];
+
+			if (fence) {
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+
+			mNeedsWait = false;
+		}
+
+		size_t StreamBuffer::alignedOffset(size_t alignment) const {
+			size_t offset = mRegion * mRegionSize + mOffset;
+
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	}
+}
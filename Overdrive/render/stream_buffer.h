@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../opengl.h"
+#include "buffer.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace overdrive {
+	namespace render {
+		struct StreamAllocation {
+			void* mMemory;			// write-only, persistently mapped memory
+			GLintptr mOffset;		// in bytes, from the start of the buffer
+			GLsizeiptr mSize;		// in bytes
+
+			template <typename T>
+			T* as() const; // reinterpret the memory
+		};
+
+		/*
+			Persistently mapped, N-buffered ring for data that is rewritten every frame (uniform blocks,
+			instance data, dynamic vertices). The buffer is created once with glBufferStorage and stays
+			mapped for its entire lifetime, so streaming data never maps or unmaps anything.
+
+			The storage is split into a number of regions. allocate() bumps a pointer through the current
+			region; advance() fences the region that was written to and moves on to the next one. The GPU
+			is only waited for when a region is re-entered while it's still being read from, which with
+			enough regions practically never happens.
+
+			A region that can't fit an allocation is advanced past automatically.
+
+			[NOTE] the buffer is created lazily, so this can be a member of something that is constructed
+			       before there is an openGL context
+			[NOTE] the memory is coherent, but writes should still be done before the draw that uses them
+			       is issued
+		*/
+		class StreamBuffer {
+		public:
+			static const size_t DEFAULT_REGION_SIZE = 4 * 1024 * 1024; // bytes
+			static const size_t DEFAULT_NUM_REGIONS = 3;
+
+			StreamBuffer(
+				size_t bytesPerRegion = DEFAULT_REGION_SIZE,
+				size_t numRegions = DEFAULT_NUM_REGIONS
+			);
+			~StreamBuffer();
+
+			StreamBuffer(const StreamBuffer&) = delete;
+			StreamBuffer& operator = (const StreamBuffer&) = delete;
+
+			GLuint getHandle() const;
+			size_t getRegionSize() const;
+			size_t getNumRegions() const;
+
+			StreamAllocation allocate(size_t numBytes, size_t alignment = 16); // alignment doesn't need to be a power of 2
+			size_t getNumAvailable(size_t alignment = 1) const; // bytes left in the current region
+			void advance(); // call after the draws using the current region have been issued (typically once per frame)
+
+			void bind(eBufferTarget target);
+			void bindRange(eBufferTarget target, GLuint index, const StreamAllocation& allocation); // for indexed targets (uniform blocks, shader storage etc)
+
+			static size_t getUniformAlignment(); // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+
+		private:
+			void create();
+			void wait(); // until the GPU is done with the current region
+			size_t alignedOffset(size_t alignment) const; // absolute
+
+			GLuint mHandle;
+			uint8_t* mMemory;
+
+			size_t mRegionSize;
+			size_t mNumRegions;
+
+			size_t mRegion;
+			size_t mOffset; // within the current region
+			bool mNeedsWait;
+
+			std::unique_ptr<GLsync[]> mFences;
+		};
+	}
+}
+
+#include "stream_buffer.inl"
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "stream_buffer.h"
+
+namespace overdrive {
+	namespace render {
+		template <typename T>
+		T* StreamAllocation::as() const {
+			return static_cast<T*>(mMemory);
+		}
+	}
+}
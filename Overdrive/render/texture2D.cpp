@@ -1,13 +1,27 @@
 #include "stdafx.h"
 #include "texture2D.h"
 #include "gltypes.h"
+#include "state_cache.h"
 #include "../core/logger.h"
 #include "../util/deleters.h"
+#include "../util/asset_pack.h"
+#include "../util/mapped_file.h"
 
-#include <cstdio>
+#include <algorithm>
 
 namespace overdrive {
 	namespace render {
+		namespace {
+			GLsizei getNumMipLevels(int width, int height) {
+				GLsizei result = 1;
+
+				for (int size = std::max(width, height); size > 1; size /= 2)
+					++result;
+
+				return result;
+			}
+		}
+
 		Texture2D::Texture2D():
 			mHandle(0),
 			mFormat(gli::FORMAT_UNDEFINED),
@@ -30,7 +44,7 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unable to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_2D, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
 
 			auto format = detail::gFormatConverter.translate(fmt);
 			
@@ -55,7 +69,7 @@ namespace overdrive {
 
 			// ~ Swizzle parameters?
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
 		}
 
 		Texture2D::Texture2D(
@@ -73,7 +87,7 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unable to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_2D, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
 
 			auto format = detail::gFormatConverter.translate(fmt);
 
@@ -101,7 +115,7 @@ namespace overdrive {
 
 			// ~ Swizzle parameters?
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
 		}
 
 		Texture2D::Texture2D(const gli::texture& tex):
@@ -117,61 +131,180 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unabled to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_2D, mHandle);
+			setImage(tex, tex.data());
+		}
 
-			auto format = detail::gFormatConverter.translate(tex.format());
-			int baseWidth = tex.dimensions().x;
-			int baseHeight = tex.dimensions().y;
+		Texture2D::Texture2D(const TextureFileView& view):
+			mHandle(0),
+			mFormat(view.mFormat),
+			mWidth(view.getWidth()),
+			mHeight(view.getHeight())
+		{
+			glGenTextures(1, &mHandle);
+			if (mHandle == 0)
+				throw std::runtime_error("Unable to allocate a new texture handle");
+
+			setImage(view, view.begin());
+		}
+
+		Texture2D::~Texture2D() {
+			if (mHandle) {
+				StateCache::current().onDeleteTexture(mHandle);
+				glDeleteTextures(1, &mHandle);
+			}
+		}
+
+		void Texture2D::setImage(eTextureFormat fmt, int width, int height, const void* pixels) {
+			assert(mHandle);
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
 
-			glTexStorage2D(
+			auto format = detail::gFormatConverter.translate(fmt);
+
+			glTexImage2D(
 				GL_TEXTURE_2D,
-				static_cast<GLint>(tex.levels()),
+				0,		// base mip level
 				format.Internal,
-				baseWidth,
-				baseHeight
+				width,
+				height,
+				0,		// border (must be 0)
+				format.External,
+				format.Type,
+				pixels
 			);
 
+			glGenerateMipmap(GL_TEXTURE_2D);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, getNumMipLevels(width, height) - 1);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
+
+			mFormat = fmt;
+			mWidth = width;
+			mHeight = height;
+		}
+
+		void Texture2D::setImage(const gli::texture& tex, const void* pixels) {
+			assert(mHandle);
+
+			if (tex.target() != gli::TARGET_2D)
+				throw std::runtime_error("GLI texture does not have a 2D target");
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
+
+			auto format = detail::gFormatConverter.translate(tex.format());
+			int baseWidth = tex.dimensions().x;
+			int baseHeight = tex.dimensions().y;
+
+			// the levels are at the same offsets in pixels as they are in the gli texture
+			const char* base = static_cast<const char*>(pixels);
+			const char* origin = static_cast<const char*>(tex.data());
+
 			for (size_t level = 0; level < tex.levels(); ++level) {
 				auto levelDimensions = tex.dimensions(level);
+				const char* levelData = base + (static_cast<const char*>(tex.data(0, 0, level)) - origin); // (layer, face, level)
 
 				if (gli::is_compressed(tex.format()))
-					glCompressedTexSubImage2D(
+					glCompressedTexImage2D(
 						GL_TEXTURE_2D,
 						static_cast<GLint>(level),
-						0, // x offset
-						0, // y offset
+						format.Internal,
 						levelDimensions.x,
 						levelDimensions.y,
-						format.Internal,
+						0, // border (must be 0)
 						static_cast<GLsizei>(tex.size(level)),
-						tex.data(0, 0, level) // (layer, face, level)
+						levelData
 					);
 				else
-					glTexSubImage2D(
+					glTexImage2D(
 						GL_TEXTURE_2D,
 						static_cast<GLint>(level),
-						0, // x offset
-						0, // y offset
+						format.Internal,
 						levelDimensions.x,
 						levelDimensions.y,
-						format.Internal,
+						0, // border (must be 0)
+						format.External,
 						format.Type,
-						tex.data(0, 0, level) // (layer, face, level)
+						levelData
 					);
 			}
 
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(tex.levels()) - 1);
+
 			// set various flags
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-			glBindTexture(GL_TEXTURE_2D, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
+
+			mFormat = tex.format();
+			mWidth = baseWidth;
+			mHeight = baseHeight;
 		}
 
-		Texture2D::~Texture2D() {
-			if (mHandle)
-				glDeleteTextures(1, &mHandle);
+		void Texture2D::setImage(const TextureFileView& view, const void* pixels) {
+			assert(mHandle);
+			assert(!view.mLevels.empty());
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
+
+			auto format = detail::gFormatConverter.translate(view.mFormat);
+
+			// [NOTE] uncompressed KTX rows are padded to 4 bytes, which matches the default GL_UNPACK_ALIGNMENT
+			const char* base = static_cast<const char*>(pixels);
+
+			for (size_t level = 0; level < view.mLevels.size(); ++level) {
+				const auto& item = view.mLevels[level];
+				const char* levelData = base + (item.mData - view.begin());
+
+				if (gli::is_compressed(view.mFormat))
+					glCompressedTexImage2D(
+						GL_TEXTURE_2D,
+						static_cast<GLint>(level),
+						format.Internal,
+						item.mWidth,
+						item.mHeight,
+						0, // border (must be 0)
+						static_cast<GLsizei>(item.mNumBytes),
+						levelData
+					);
+				else
+					glTexImage2D(
+						GL_TEXTURE_2D,
+						static_cast<GLint>(level),
+						format.Internal,
+						item.mWidth,
+						item.mHeight,
+						0, // border (must be 0)
+						format.External,
+						format.Type,
+						levelData
+					);
+			}
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(view.mLevels.size()) - 1);
+
+			if (view.mLevels.size() > 1)
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			else
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
+
+			mFormat = view.mFormat;
+			mWidth = view.getWidth();
+			mHeight = view.getHeight();
 		}
 
 		Texture2D::Texture2D(Texture2D&& t):
@@ -184,8 +317,10 @@ namespace overdrive {
 		}
 
 		Texture2D& Texture2D::operator = (Texture2D&& t) {
-			if (mHandle)
+			if (mHandle) {
+				StateCache::current().onDeleteTexture(mHandle);
 				glDeleteTextures(1, &mHandle);
+			}
 
 			mHandle = t.mHandle;
 			mFormat = t.mFormat;
@@ -499,40 +634,50 @@ namespace overdrive {
 		}
 
 		void Texture2D::bind() {
-			glBindTexture(GL_TEXTURE_2D, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, mHandle);
 		}
 
 		void Texture2D::unbind() {
-			glBindTexture(GL_TEXTURE_2D, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_2D, 0);
 		}
 
 		void Texture2D::bind(int textureUnit) {
-			glActiveTexture(asTextureUnit(textureUnit));
-			glBindTextureUnit(textureUnit, mHandle);
+			StateCache::current().bindTexture(textureUnit, GL_TEXTURE_2D, mHandle);
 		}
 
 		void Texture2D::unbind(int textureUnit) {
-			glBindTextureUnit(textureUnit, 0);
+			StateCache::current().bindTexture(textureUnit, GL_TEXTURE_2D, 0);
 		}
 
 		Texture2D loadTexture2D(const std::string& filename) {
-			std::unique_ptr<FILE, util::FCloseHelper> file(
-				std::fopen(filename.c_str(), "rb")
-			);
+			// [NOTE] the file is mapped instead of read, decoders work on the page cache directly
+			util::MappedFile file(filename);
+
+			return loadTexture2D(file.getData(), file.getSize());
+		}
 
-			// figure out how big the file is
-			auto begin_of_file = std::ftell(file.get());
-			std::fseek(file.get(), 0, SEEK_END);			
-			auto end_of_file = std::ftell(file.get());
-			std::fseek(file.get(), 0, SEEK_SET);
+		Texture2D loadTexture2D(const util::AssetPack& pack, const std::string& name) {
+			std::vector<uint8_t> buffer; // only used for compressed entries
+			auto data = pack.read(name, buffer);
 
-			std::vector<char> rawData(static_cast<size_t>(end_of_file - begin_of_file));
+			if (!data.isValid())
+				throw std::runtime_error("Asset not found: " + name);
 
-			std::fread(&rawData[0], 1, rawData.size(), file.get());
+			return loadTexture2D(data.mData, data.mSize);
+		}
+
+		Texture2D loadTexture2D(const void* data, size_t numBytes) {
+			// plain 2D dds/ktx files are uploaded straight from the source data
+			{
+				TextureFileView view;
+
+				if (parseTextureFile(data, numBytes, view))
+					return Texture2D(view);
+			}
 
 			// try to load it as a gli texture
 			{
-				auto tex = gli::load(&rawData[0], rawData.size());
+				auto tex = gli::load(static_cast<const char*>(data), numBytes);
 
 				if (!tex.empty())
 					return Texture2D(tex);
@@ -546,8 +691,8 @@ namespace overdrive {
 				
 				std::unique_ptr<stbi_uc[], util::FreeHelper> rawTexture(
 					stbi_load_from_memory(
-						reinterpret_cast<const stbi_uc*>(&rawData[0]), 
-						static_cast<int>(rawData.size()), 
+						static_cast<const stbi_uc*>(data),
+						static_cast<int>(numBytes),
 						&width, 
 						&height, 
 						&numChannels, 
@@ -1,8 +1,13 @@
 #pragma once
 
 #include "texture.h"
+#include "texture_file.h"
 
 namespace overdrive {
+	namespace util {
+		class AssetPack;
+	}
+
 	namespace render {
 		/*
 			Remaining texture parameters:
@@ -31,6 +36,7 @@ namespace overdrive {
 			Texture2D(eTextureFormat fmt, int width, int height, const unsigned char* rawData); // [NOTE] this assumes that the raw data is actually what you say it is! Doesn't support compressed formats in particular!
 			//Texture2D(eTextureFormat fmt, int width, int height, unsigned char* rawData, size_t numBytes); // [NOTE] this does support compressed formats, but still does only minimal checking
 			Texture2D(const gli::texture& tex);
+			explicit Texture2D(const TextureFileView& view); // uploads straight from the (mapped) file data
 			~Texture2D();
 
 			Texture2D(const Texture2D&) = delete;
@@ -44,6 +50,12 @@ namespace overdrive {
 			int getWidth() const;
 			int getHeight() const;
 
+			// (re)specify the image; the storage stays mutable, so a texture can be streamed in again (same handle)
+			// [NOTE] pixels may be an offset into the bound PIXEL_UNPACK buffer
+			void setImage(eTextureFormat fmt, int width, int height, const void* pixels); // mipmaps are generated from level 0
+			void setImage(const gli::texture& tex, const void* pixels); // pixels contains all levels, laid out like tex.data()
+			void setImage(const TextureFileView& view, const void* pixels); // pixels contains all levels, laid out like view.begin()
+
 			void bind();
 			void unbind();
 
@@ -58,5 +70,7 @@ namespace overdrive {
 		};
 
 		Texture2D loadTexture2D(const std::string& filepath); // should probably become a full path
+		Texture2D loadTexture2D(const util::AssetPack& pack, const std::string& name);
+		Texture2D loadTexture2D(const void* data, size_t numBytes); // contents of a dds, ktx or stbi-supported file
 	}
 }
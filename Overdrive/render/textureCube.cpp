@@ -1,7 +1,9 @@
 #include "stdafx.h"
 #include "textureCube.h"
 #include "texture2D.h"
+#include "state_cache.h"
 #include "../util/deleters.h"
+#include "../util/mapped_file.h"
 
 namespace overdrive {
 	namespace render {
@@ -19,7 +21,7 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unable to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
 
 			auto format = detail::gFormatConverter.translate(fmt);
 
@@ -38,7 +40,7 @@ namespace overdrive {
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 		}
 
 		TextureCube::TextureCube(
@@ -59,7 +61,7 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unable to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
 
 			auto format = detail::gFormatConverter.translate(fmt);
 
@@ -78,7 +80,7 @@ namespace overdrive {
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 		}
 
 		TextureCube::TextureCube(const gli::texture& tex) {
@@ -86,7 +88,7 @@ namespace overdrive {
 			if (mHandle == 0)
 				throw std::runtime_error("Unable to allocate a new texture handle");
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
 
 			auto format = detail::gFormatConverter.translate(tex.format());
 			auto dims = tex.dimensions();
@@ -199,12 +201,107 @@ namespace overdrive {
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 		}
 
 		TextureCube::~TextureCube() {
-			if (mHandle)
+			if (mHandle) {
+				StateCache::current().onDeleteTexture(mHandle);
 				glDeleteTextures(1, &mHandle);
+			}
+		}
+
+		void TextureCube::setImage(eTextureFormat fmt, int width, int height, const void* const faces[6]) {
+			assert(mHandle);
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+
+			auto format = detail::gFormatConverter.translate(fmt);
+
+			for (GLenum i = 0; i < 6; ++i)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format.Internal, width, height, 0, format.External, format.Type, faces[i]);
+
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0);
+
+			// set various flags
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+			mFormat = fmt;
+		}
+
+		void TextureCube::setImage(const TextureFileView* const faces[6], const void* const pixels[6]) {
+			assert(mHandle);
+
+			const TextureFileView& first = *faces[0];
+
+			for (int i = 1; i < 6; ++i)
+				if (
+					(faces[i]->mFormat != first.mFormat) ||
+					(faces[i]->getWidth() != first.getWidth()) ||
+					(faces[i]->getHeight() != first.getHeight()) ||
+					(faces[i]->mLevels.size() != first.mLevels.size())
+				)
+					throw std::runtime_error("Cube map faces differ in size or format");
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+
+			auto format = detail::gFormatConverter.translate(first.mFormat);
+			bool isCompressed = gli::is_compressed(first.mFormat);
+
+			for (GLenum i = 0; i < 6; ++i) {
+				const char* base = static_cast<const char*>(pixels[i]);
+
+				for (size_t level = 0; level < faces[i]->mLevels.size(); ++level) {
+					const auto& item = faces[i]->mLevels[level];
+					const char* levelData = base + (item.mData - faces[i]->begin());
+
+					if (isCompressed)
+						glCompressedTexImage2D(
+							GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+							static_cast<GLint>(level),
+							format.Internal,
+							item.mWidth,
+							item.mHeight,
+							0,
+							static_cast<GLsizei>(item.mNumBytes),
+							levelData
+						);
+					else
+						glTexImage2D(
+							GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+							static_cast<GLint>(level),
+							format.Internal,
+							item.mWidth,
+							item.mHeight,
+							0,
+							format.External,
+							format.Type,
+							levelData
+						);
+				}
+			}
+
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(first.mLevels.size()) - 1);
+
+			if (first.mLevels.size() > 1)
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			else
+				glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+			mFormat = first.mFormat;
 		}
 
 		TextureCube::TextureCube(TextureCube&& t):
@@ -215,8 +312,10 @@ namespace overdrive {
 		}
 
 		TextureCube& TextureCube::operator = (TextureCube&& t) {
-			if (mHandle)
+			if (mHandle) {
+				StateCache::current().onDeleteTexture(mHandle);
 				glDeleteTextures(1, &mHandle);
+			}
 
 			mHandle = t.mHandle;
 			mFormat = t.mFormat;
@@ -235,41 +334,23 @@ namespace overdrive {
 		}
 				
 		void TextureCube::bind() {
-			glBindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, mHandle);
 		}
 
 		void TextureCube::unbind() {
-			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+			StateCache::current().bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 		}
 
 
 		void TextureCube::bind(int textureUnit) {
-			glBindTextureUnit(textureUnit, mHandle);
+			StateCache::current().bindTexture(textureUnit, GL_TEXTURE_CUBE_MAP, mHandle);
 		}
 
 		void TextureCube::unbind(int textureUnit) {
-			glBindTextureUnit(textureUnit, 0);
+			StateCache::current().bindTexture(textureUnit, GL_TEXTURE_CUBE_MAP, 0);
 		}
 
 		namespace {
-			std::vector<char> readFile(const std::string& filepath) {
-				std::unique_ptr<FILE, util::FCloseHelper> file(
-					std::fopen(filepath.c_str(), "rb")
-				);
-
-				// figure out how big the file is
-				auto begin_of_file = std::ftell(file.get());
-				std::fseek(file.get(), 0, SEEK_END);
-				auto end_of_file = std::ftell(file.get());
-				std::fseek(file.get(), 0, SEEK_SET);
-
-				std::vector<char> rawData(static_cast<size_t>(end_of_file - begin_of_file));
-
-				std::fread(&rawData[0], 1, rawData.size(), file.get());
-
-				return rawData;
-			}
-
 			struct ImageInfo {
 				int mImageWidth;
 				int mImageHeight;
@@ -277,15 +358,15 @@ namespace overdrive {
 				std::unique_ptr<stbi_uc[], util::FreeHelper> mUncompressedData;
 			};
 
-			ImageInfo loadRaw(const std::vector<char>& rawData) {
+			ImageInfo loadRaw(const util::MappedFile& file) {
 				ImageInfo result;
 
 				int numChannels = 0;
 
 				result.mUncompressedData.reset(
 					stbi_load_from_memory(
-						reinterpret_cast<const stbi_uc*>(rawData.data()),
-						static_cast<int>(rawData.size()),
+						file.getData(),
+						static_cast<int>(file.getSize()),
 						&result.mImageWidth,
 						&result.mImageHeight,
 						&numChannels, 
@@ -308,18 +389,18 @@ namespace overdrive {
 		}
 
 		TextureCube loadTextureCube(const std::string& filepath) {
-			auto rawData = readFile(filepath);
+			util::MappedFile file(filepath);
 
 			// try for gli first
 			{
-				auto tex = gli::load(&rawData[0], rawData.size());
+				auto tex = gli::load(file.getChars(), file.getSize());
 
 				if (!tex.empty())
 					return TextureCube(tex);
 			}
 
 			// load using stbi
-			auto img = loadRaw(rawData);
+			auto img = loadRaw(file);
 
 			if (img.mUncompressedData) {
 				return TextureCube(
@@ -347,13 +428,13 @@ namespace overdrive {
 			const std::string& negativeZ
 		) {
 			// assume stbi... [TODO] add gli basis
-			std::vector<char> file_data[] = {
-				readFile(positiveX),
-				readFile(negativeX),
-				readFile(positiveY),
-				readFile(negativeY),
-				readFile(positiveZ),
-				readFile(negativeZ)
+			util::MappedFile file_data[] = {
+				util::MappedFile(positiveX),
+				util::MappedFile(negativeX),
+				util::MappedFile(positiveY),
+				util::MappedFile(negativeY),
+				util::MappedFile(positiveZ),
+				util::MappedFile(negativeZ)
 			};
 
 			ImageInfo uncompressed[] = {	
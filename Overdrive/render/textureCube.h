@@ -1,6 +1,7 @@
 #pragma once
 
 #include "texture.h"
+#include "texture_file.h"
 
 namespace overdrive {
 	namespace render {
@@ -52,6 +53,11 @@ namespace overdrive {
 			GLuint getHandle() const;
 			eTextureFormat getFormat() const;
 
+			// (re)specify all faces (in eCubeFace order: +X, -X, +Y, -Y, +Z, -Z); the storage stays mutable, like Texture2D
+			// [NOTE] the faces may be offsets into the bound PIXEL_UNPACK buffer
+			void setImage(eTextureFormat fmt, int width, int height, const void* const faces[6]);
+			void setImage(const TextureFileView* const faces[6], const void* const pixels[6]); // all levels; pixels[i] is laid out like faces[i]->begin()
+
 			// [NOTE] these are not particularily safe!
 			//void setFace(eCubeFace face, const gli::texture2D& t);
 			//void setFace(eCubeFace face, const unsigned char* rawData);
@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include "texture_file.h"
+#include <algorithm>
+#include <cstring>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			size_t alignUp(size_t value, size_t alignment) {
+				return (value + alignment - 1) / alignment * alignment;
+			}
+
+			size_t getLevelSize(eTextureFormat format, int width, int height) {
+				auto blockExtent = gli::block_dimensions(format);
+
+				size_t numBlocksX = (width + blockExtent.x - 1) / blockExtent.x;
+				size_t numBlocksY = (height + blockExtent.y - 1) / blockExtent.y;
+
+				return numBlocksX * numBlocksY * gli::block_size(format);
+			}
+
+			// a full mip chain, down to 1x1; files that claim more levels are corrupt
+			size_t getMaxLevels(uint32_t width, uint32_t height) {
+				uint32_t extent = std::max(width, height);
+				size_t result = 1;
+
+				while (extent >>= 1)
+					++result;
+
+				return result;
+			}
+
+			bool parseDDS(const uint8_t* data, size_t numBytes, TextureFileView& result) {
+				using gli::detail::ddsHeader;
+				using gli::detail::ddsHeader10;
+
+				size_t offset = sizeof(gli::detail::FOURCC_DDS);
+
+				if (numBytes < offset + sizeof(ddsHeader))
+					return false;
+
+				ddsHeader header;
+				std::memcpy(&header, data + offset, sizeof(header));
+				offset += sizeof(header);
+
+				if (!(header.Format.flags & gli::dx::DDPF_FOURCC))
+					return false; // described by channel masks
+
+				if (header.CubemapFlags & (gli::detail::DDSCAPS2_CUBEMAP | gli::detail::DDSCAPS2_VOLUME))
+					return false;
+
+				gli::dx dx;
+				eTextureFormat format;
+
+				if (
+					(header.Format.fourCC == gli::dx::D3DFMT_DX10) ||
+					(header.Format.fourCC == gli::dx::D3DFMT_GLI1)
+				) {
+					if (numBytes < offset + sizeof(ddsHeader10))
+						return false;
+
+					ddsHeader10 header10;
+					std::memcpy(&header10, data + offset, sizeof(header10));
+					offset += sizeof(header10);
+
+					if (
+						(header10.ArraySize > 1) ||
+						(header10.ResourceDimension != gli::detail::D3D10_RESOURCE_DIMENSION_TEXTURE2D) ||
+						(header10.MiscFlag & gli::detail::D3D10_RESOURCE_MISC_TEXTURECUBE)
+					)
+						return false;
+
+					format = dx.find(header.Format.fourCC, header10.Format, header.Format.flags);
+				}
+				else
+					format = dx.find(header.Format.fourCC, header.Format.flags);
+
+				if (format == static_cast<eTextureFormat>(gli::FORMAT_INVALID))
+					return false;
+
+				size_t numLevels = (header.Flags & gli::detail::DDSD_MIPMAPCOUNT) ? std::max<uint32_t>(header.MipMapLevels, 1) : 1;
+
+				if (numLevels > getMaxLevels(header.Width, header.Height))
+					return false;
+
+				result.mFormat = format;
+				result.mLevels.clear();
+
+				// levels are stored back to back
+				for (size_t level = 0; level < numLevels; ++level) {
+					TextureFileView::Level item;
+
+					item.mWidth = std::max(static_cast<int>(header.Width >> level), 1);
+					item.mHeight = std::max(static_cast<int>(header.Height >> level), 1);
+					item.mNumBytes = getLevelSize(format, item.mWidth, item.mHeight);
+					item.mData = data + offset;
+
+					offset += item.mNumBytes;
+
+					if (offset > numBytes)
+						return false; // truncated
+
+					result.mLevels.push_back(item);
+				}
+
+				return true;
+			}
+
+			bool parseKTX(const uint8_t* data, size_t numBytes, TextureFileView& result) {
+				using gli::detail::ktxHeader10;
+
+				size_t offset = sizeof(gli::detail::FOURCC_KTX10);
+
+				if (numBytes < offset + sizeof(ktxHeader10))
+					return false;
+
+				ktxHeader10 header;
+				std::memcpy(&header, data + offset, sizeof(header));
+				offset += sizeof(header);
+
+				if (header.Endianness != 0x04030201)
+					return false; // written on a machine with different endianness
+
+				if (
+					(header.NumberOfFaces > 1) ||
+					(header.NumberOfArrayElements > 0) ||
+					(header.PixelHeight == 0) ||
+					(header.PixelDepth > 0)
+				)
+					return false; // not a plain 2D texture
+
+				gli::gl gl;
+				eTextureFormat format = gl.find(
+					static_cast<gli::gl::internalFormat>(header.GLInternalFormat),
+					static_cast<gli::gl::externalFormat>(header.GLFormat),
+					static_cast<gli::gl::typeFormat>(header.GLType)
+				);
+
+				if (format == static_cast<eTextureFormat>(gli::FORMAT_INVALID))
+					return false;
+
+				offset += header.BytesOfKeyValueData;
+
+				size_t numLevels = std::max<uint32_t>(header.NumberOfMipmapLevels, 1);
+
+				if (numLevels > getMaxLevels(header.PixelWidth, header.PixelHeight))
+					return false;
+
+				result.mFormat = format;
+				result.mLevels.clear();
+
+				// every level is prefixed with its size, and padded to 4 bytes
+				for (size_t level = 0; level < numLevels; ++level) {
+					uint32_t imageSize = 0;
+
+					if (offset + sizeof(imageSize) > numBytes)
+						return false;
+
+					std::memcpy(&imageSize, data + offset, sizeof(imageSize));
+					offset += sizeof(imageSize);
+
+					TextureFileView::Level item;
+
+					item.mWidth = std::max(static_cast<int>(header.PixelWidth >> level), 1);
+					item.mHeight = std::max(static_cast<int>(header.PixelHeight >> level), 1);
+					item.mNumBytes = imageSize;
+					item.mData = data + offset;
+
+					if (offset + imageSize > numBytes)
+						return false;
+
+					offset += alignUp(imageSize, 4);
+
+					result.mLevels.push_back(item);
+				}
+
+				return true;
+			}
+		}
+
+		int TextureFileView::getWidth() const {
+			return mLevels.empty() ? 0 : mLevels.front().mWidth;
+		}
+
+		int TextureFileView::getHeight() const {
+			return mLevels.empty() ? 0 : mLevels.front().mHeight;
+		}
+
+		const uint8_t* TextureFileView::begin() const {
+			return mLevels.empty() ? nullptr : mLevels.front().mData;
+		}
+
+		const uint8_t* TextureFileView::end() const {
+			return mLevels.empty() ? nullptr : (mLevels.back().mData + mLevels.back().mNumBytes);
+		}
+
+		bool parseTextureFile(const void* data, size_t numBytes, TextureFileView& result) {
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+			if (
+				(numBytes >= sizeof(gli::detail::FOURCC_DDS)) &&
+				(std::memcmp(bytes, gli::detail::FOURCC_DDS, sizeof(gli::detail::FOURCC_DDS)) == 0)
+			)
+				return parseDDS(bytes, numBytes, result);
+
+			if (
+				(numBytes >= sizeof(gli::detail::FOURCC_KTX10)) &&
+				(std::memcmp(bytes, gli::detail::FOURCC_KTX10, sizeof(gli::detail::FOURCC_KTX10)) == 0)
+			)
+				return parseKTX(bytes, numBytes, result);
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "texture.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		/*
+			Describes a 2D texture stored in a DDS or KTX file, without copying anything: the levels point
+			straight into the file data (typically a util::MappedFile). This allows mip chains to go from the
+			page cache to glCompressedTexSubImage2D directly.
+
+			Handles plain 2D textures (1 face, 1 layer) in
+				KTX: any format gli knows about
+				DDS: FourCC (DXT, ATI) and DX10 header formats
+
+			Anything else (cube maps, arrays, uncompressed DDS described by channel masks) is left to gli::load.
+		*/
+		struct TextureFileView {
+			struct Level {
+				const uint8_t* mData;
+				size_t mNumBytes;
+				int mWidth;
+				int mHeight;
+			};
+
+			eTextureFormat mFormat;
+			std::vector<Level> mLevels;
+
+			int getWidth() const;
+			int getHeight() const;
+
+			const uint8_t* begin() const;	// start of the first level
+			const uint8_t* end() const;		// end of the last level
+		};
+
+		// false if the data is not a DDS/KTX file that can be viewed directly
+		bool parseTextureFile(const void* data, size_t numBytes, TextureFileView& result);
+	}
+}
@@ -0,0 +1,518 @@
+#include "stdafx.h"
+#include "texture_streamer.h"
+#include "state_cache.h"
+#include "../core/logger.h"
+#include "../core/resource_cache.h"
+#include "../util/string_hash.h"
+#include <cstring>
+
+namespace overdrive {
+	namespace render {
+		namespace {
+			const size_t STAGING_ALIGNMENT = 16;
+			const uint8_t PLACEHOLDER_TEXEL[] = { 128, 128, 128, 255 };
+
+			// every file starts at an aligned offset in the staging buffer, so ktx rows stay 4-byte aligned
+			size_t getStagingSize(const TextureFileView& view) {
+				size_t numBytes = static_cast<size_t>(view.end() - view.begin());
+
+				return (numBytes + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+			}
+
+			eTextureFormat getFormat(int numChannels) {
+				switch (numChannels) {
+				case 1: return gli::FORMAT_R8_UNORM_PACK8;
+				case 2: return gli::FORMAT_RG8_UNORM_PACK8;
+				case 3: return gli::FORMAT_RGB8_UNORM_PACK8;
+				case 4: return gli::FORMAT_RGBA8_UNORM_PACK8;
+
+				default:
+					throw std::runtime_error("Unsupported number of channels encountered");
+				}
+			}
+
+			const void* toOffset(GLintptr offset) {
+				return reinterpret_cast<const void*>(offset);
+			}
+		}
+
+		// ----- StreamedTexture -----
+		StreamedTexture::StreamedTexture(std::shared_ptr<State> state):
+			mState(std::move(state))
+		{
+		}
+
+		bool StreamedTexture::isValid() const {
+			return (mState != nullptr);
+		}
+
+		eStreamStatus StreamedTexture::getStatus() const {
+			assert(mState);
+			return mState->mStatus;
+		}
+
+		bool StreamedTexture::isReady() const {
+			return (getStatus() == eStreamStatus::READY);
+		}
+
+		bool StreamedTexture::isFailed() const {
+			return (getStatus() == eStreamStatus::FAILED);
+		}
+
+		const std::string& StreamedTexture::getName() const {
+			assert(mState);
+			return mState->mName;
+		}
+
+		GLenum StreamedTexture::getTarget() const {
+			assert(mState);
+			return mState->mTextureCube ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+		}
+
+		GLuint StreamedTexture::getHandle() const {
+			assert(mState);
+
+			if (mState->mTextureCube)
+				return mState->mTextureCube->getHandle();
+			else
+				return mState->mTexture2D->getHandle();
+		}
+
+		Texture2D* StreamedTexture::getTexture2D() const {
+			assert(mState);
+			return mState->mTexture2D.get();
+		}
+
+		TextureCube* StreamedTexture::getTextureCube() const {
+			assert(mState);
+			return mState->mTextureCube.get();
+		}
+
+		// ----- TextureStreamer -----
+		size_t TextureStreamer::Request::getNumBytes() const {
+			size_t result = 0;
+
+			if (!mViews.empty()) {
+				for (const auto& view : mViews)
+					result += getStagingSize(view);
+
+				return result;
+			}
+
+			if (mTexture)
+				return mTexture->size();
+
+			for (const auto& image : mImages)
+				result += image.mNumBytes;
+
+			return result;
+		}
+
+		TextureStreamer::TextureStreamer(
+			core::JobSystem& jobSystem,
+			size_t bytesPerFrame
+		):
+			mJobSystem(jobSystem),
+			mAssetPack(nullptr),
+			mStaging(bytesPerFrame),
+			mNumPending(0)
+		{
+		}
+
+		TextureStreamer::~TextureStreamer() {
+			mJobSystem.wait(mJobs);
+		}
+
+		StreamedTexture TextureStreamer::load2D(const std::string& filepath) {
+			std::vector<std::string> files = { filepath };
+			uint64_t key = getKey(files);
+
+			if (auto existing = findShared(key))
+				return StreamedTexture(existing);
+
+			auto request = std::make_shared<Request>();
+
+			request->mFiles = std::move(files);
+			request->mState = std::make_shared<StreamedTexture::State>();
+			request->mState->mTexture2D = std::make_unique<Texture2D>(
+				gli::FORMAT_RGBA8_UNORM_PACK8,
+				1,
+				1,
+				PLACEHOLDER_TEXEL
+			);
+
+			return submit(key, std::move(request));
+		}
+
+		StreamedTexture TextureStreamer::loadCube(
+			const std::string& positiveX,
+			const std::string& negativeX,
+			const std::string& positiveY,
+			const std::string& negativeY,
+			const std::string& positiveZ,
+			const std::string& negativeZ
+		) {
+			std::vector<std::string> files = { positiveX, negativeX, positiveY, negativeY, positiveZ, negativeZ };
+			uint64_t key = getKey(files);
+
+			if (auto existing = findShared(key))
+				return StreamedTexture(existing);
+
+			auto request = std::make_shared<Request>();
+
+			request->mFiles = std::move(files);
+			request->mState = std::make_shared<StreamedTexture::State>();
+			request->mState->mTextureCube = std::make_unique<TextureCube>(
+				gli::FORMAT_RGBA8_UNORM_PACK8,
+				1,
+				1,
+				PLACEHOLDER_TEXEL,
+				PLACEHOLDER_TEXEL,
+				PLACEHOLDER_TEXEL,
+				PLACEHOLDER_TEXEL,
+				PLACEHOLDER_TEXEL,
+				PLACEHOLDER_TEXEL
+			);
+
+			return submit(key, std::move(request));
+		}
+
+		// [NOTE] packed assets share their key with the loose file of the same name, like in the resource caches
+		uint64_t TextureStreamer::getKey(const std::vector<std::string>& files) {
+			uint64_t key = util::hashBytes(nullptr, 0);
+
+			for (const auto& file : files)
+				key = core::makeResourceKey(util::normalizeAssetName(file), key);
+
+			return key;
+		}
+
+		std::shared_ptr<StreamedTexture::State> TextureStreamer::findShared(uint64_t key) {
+			auto it = mShared.find(key);
+
+			if (it == mShared.end())
+				return nullptr;
+
+			auto state = it->second.lock();
+
+			if (!state || (state->mStatus == eStreamStatus::FAILED)) {
+				mShared.erase(it);
+				return nullptr;
+			}
+
+			++mStats.mNumShared;
+
+			return state;
+		}
+
+		StreamedTexture TextureStreamer::submit(uint64_t key, std::shared_ptr<Request> request) {
+			request->mState->mName = request->mFiles.front();
+			request->mPack = mAssetPack;
+
+			mShared[key] = request->mState;
+
+			++mNumPending;
+			++mStats.mNumRequested;
+
+			mJobSystem.schedule(
+				[this, request] {
+					decode(*request);
+
+					std::lock_guard<std::mutex> lock(mDecodedMutex);
+					mDecoded.push_back(request);
+				},
+				mJobs
+			);
+
+			return StreamedTexture(request->mState);
+		}
+
+		void TextureStreamer::update() {
+			collectDecoded();
+
+			size_t numBytesUploaded = 0;
+
+			while (!mUploads.empty()) {
+				auto& request = *mUploads.front();
+
+				if (!request.mError.empty()) {
+					gLogError << "Failed to load texture " << request.mState->mName << ": " << request.mError;
+
+					request.mState->mStatus = eStreamStatus::FAILED;
+					++mStats.mNumFailed;
+				}
+				else {
+					size_t numBytes = request.getNumBytes();
+					bool fitsStaging = (numBytes <= mStaging.getNumAvailable(STAGING_ALIGNMENT));
+
+					// the staging region for this frame is the budget
+					if (!fitsStaging && (numBytesUploaded > 0))
+						break;
+
+					try {
+						upload(request, fitsStaging);
+
+						request.mState->mStatus = eStreamStatus::READY;
+						++mStats.mNumCompleted;
+					}
+					catch (const std::exception& ex) {
+						gLogError << "Failed to upload texture " << request.mState->mName << ": " << ex.what();
+
+						request.mState->mStatus = eStreamStatus::FAILED;
+						++mStats.mNumFailed;
+					}
+
+					numBytesUploaded += numBytes;
+
+					// an oversized texture takes up the entire frame
+					if (!fitsStaging) {
+						mUploads.pop_front();
+						--mNumPending;
+						break;
+					}
+				}
+
+				mUploads.pop_front();
+				--mNumPending;
+			}
+
+			if (numBytesUploaded > 0) {
+				StateCache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				mStaging.advance();
+			}
+
+			mStats.mNumBytesUploaded += numBytesUploaded;
+			mStats.mNumBytesLastUpdate = numBytesUploaded;
+		}
+
+		void TextureStreamer::setAssetPack(const util::AssetPack* pack) {
+			mAssetPack = pack;
+		}
+
+		void TextureStreamer::finishAll() {
+			mJobSystem.wait(mJobs);
+
+			while (mNumPending > 0)
+				update();
+		}
+
+		size_t TextureStreamer::getNumPending() const {
+			return mNumPending;
+		}
+
+		const TextureStreamer::Stats& TextureStreamer::getStats() const {
+			return mStats;
+		}
+
+		void TextureStreamer::decode(Request& request) {
+			// [NOTE] jobs must not throw, errors are reported by update()
+			try {
+				for (size_t i = 0; i < request.mFiles.size(); ++i) {
+					util::AssetView data = read(request, request.mFiles[i]);
+
+					// dds/ktx files don't need any decoding, the source data is kept until the upload
+					TextureFileView view;
+
+					if (parseTextureFile(data.mData, data.mSize, view)) {
+						if (!request.mImages.empty())
+							throw std::runtime_error("Cube map faces are stored in different file types");
+
+						request.mViews.push_back(std::move(view));
+						continue;
+					}
+
+					if (!request.mViews.empty())
+						throw std::runtime_error("Cube map faces are stored in different file types");
+
+					if (request.mFiles.size() == 1) {
+						// try to load it as a gli texture first
+						auto tex = gli::load(data.getChars(), data.mSize);
+
+						if (!tex.empty()) {
+							if (tex.target() != gli::TARGET_2D)
+								throw std::runtime_error("GLI texture does not have a 2D target");
+
+							request.mTexture = std::make_unique<gli::texture>(tex);
+							break;
+						}
+					}
+
+					Image image;
+					int numChannels = 0;
+
+					image.mPixels.reset(
+						stbi_load_from_memory(
+							data.mData,
+							static_cast<int>(data.mSize),
+							&image.mWidth,
+							&image.mHeight,
+							&numChannels,
+							0
+						)
+					);
+
+					if (!image.mPixels)
+						throw std::runtime_error(stbi_failure_reason());
+
+					image.mFormat = getFormat(numChannels);
+					image.mNumBytes = static_cast<size_t>(image.mWidth) * image.mHeight * numChannels;
+
+					if (!request.mImages.empty()) {
+						const auto& first = request.mImages.front();
+
+						if (
+							(image.mWidth != first.mWidth) ||
+							(image.mHeight != first.mHeight) ||
+							(image.mFormat != first.mFormat)
+						)
+							throw std::runtime_error("Cube map faces differ in size or format");
+					}
+
+					request.mImages.push_back(std::move(image));
+				}
+
+				// decoded copies were made, so the source data can go
+				if (request.mViews.empty()) {
+					request.mMappings.clear();
+					request.mBuffers.clear();
+				}
+			}
+			catch (const std::exception& ex) {
+				request.mError = ex.what();
+			}
+		}
+
+		util::AssetView TextureStreamer::read(Request& request, const std::string& name) {
+			util::AssetView result;
+
+			if (request.mPack && request.mPack->contains(name)) {
+				// uncompressed entries point straight into the pack, compressed ones into a buffer owned by the request
+				std::vector<uint8_t> buffer;
+				result = request.mPack->read(name, buffer);
+
+				if (!buffer.empty())
+					request.mBuffers.push_back(std::move(buffer)); // moving the vector keeps the data where it is
+			}
+			else {
+				request.mMappings.emplace_back(name);
+
+				result.mData = request.mMappings.back().getData();
+				result.mSize = request.mMappings.back().getSize();
+			}
+
+			if (result.mSize == 0)
+				throw std::runtime_error("Empty file: " + name);
+
+			return result;
+		}
+
+		void TextureStreamer::upload(Request& request, bool useStaging) {
+			size_t numBytes = request.getNumBytes();
+			std::vector<const void*> sources;
+
+			// either offsets into the staging buffer or plain pointers
+			if (useStaging) {
+				StreamAllocation allocation = mStaging.allocate(numBytes, STAGING_ALIGNMENT);
+				uint8_t* destination = allocation.as<uint8_t>();
+				GLintptr offset = allocation.mOffset;
+
+				if (!request.mViews.empty()) {
+					for (const auto& view : request.mViews) {
+						std::memcpy(destination, view.begin(), static_cast<size_t>(view.end() - view.begin()));
+						sources.push_back(toOffset(offset));
+
+						destination += getStagingSize(view);
+						offset += getStagingSize(view);
+					}
+				}
+				else if (request.mTexture) {
+					std::memcpy(destination, request.mTexture->data(), numBytes);
+					sources.push_back(toOffset(offset));
+				}
+				else {
+					for (const auto& image : request.mImages) {
+						std::memcpy(destination, image.mPixels.get(), image.mNumBytes);
+						sources.push_back(toOffset(offset));
+
+						destination += image.mNumBytes;
+						offset += image.mNumBytes;
+					}
+				}
+
+				mStaging.bind(eBufferTarget::PIXEL_UNPACK);
+			}
+			else {
+				StateCache::current().bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+				if (!request.mViews.empty())
+					for (const auto& view : request.mViews)
+						sources.push_back(view.begin());
+				else if (request.mTexture)
+					sources.push_back(request.mTexture->data());
+				else
+					for (const auto& image : request.mImages)
+						sources.push_back(image.mPixels.get());
+			}
+
+			// decoded rows are tightly packed (3-channel images usually aren't a multiple of 4 bytes wide)
+			// [NOTE] ktx rows are padded to 4 bytes, so files uploaded through a view keep the default alignment
+			if (request.mViews.empty())
+				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+			auto& state = *request.mState;
+
+			if (!request.mViews.empty()) {
+				if (state.mTexture2D)
+					state.mTexture2D->setImage(request.mViews.front(), sources.front());
+				else {
+					const TextureFileView* faces[6];
+
+					for (size_t i = 0; i < 6; ++i)
+						faces[i] = &request.mViews[i];
+
+					state.mTextureCube->setImage(faces, sources.data());
+				}
+			}
+			else if (request.mTexture)
+				state.mTexture2D->setImage(*request.mTexture, sources.front());
+			else if (state.mTexture2D) {
+				const auto& image = request.mImages.front();
+				state.mTexture2D->setImage(image.mFormat, image.mWidth, image.mHeight, sources.front());
+			}
+			else {
+				const auto& image = request.mImages.front();
+				state.mTextureCube->setImage(image.mFormat, image.mWidth, image.mHeight, sources.data());
+			}
+
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+			// the decoded data isn't needed anymore
+			request.mImages.clear();
+			request.mTexture.reset();
+			request.mViews.clear();
+			request.mMappings.clear();
+			request.mBuffers.clear();
+		}
+
+		void TextureStreamer::collectDecoded() {
+			std::lock_guard<std::mutex> lock(mDecodedMutex);
+
+			for (auto& request : mDecoded)
+				mUploads.push_back(std::move(request));
+
+			mDecoded.clear();
+		}
+
+		std::ostream& operator << (std::ostream& os, const TextureStreamer::Stats& stats) {
+			os
+				<< "Texture streamer: "
+				<< stats.mNumCompleted << "/" << stats.mNumRequested << " textures ("
+				<< stats.mNumFailed << " failed, "
+				<< stats.mNumShared << " shared), "
+				<< (stats.mNumBytesUploaded / 1024) << " KB uploaded ("
+				<< (stats.mNumBytesLastUpdate / 1024) << " KB last update)";
+
+			return os;
+		}
+	}
+}
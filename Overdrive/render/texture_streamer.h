@@ -0,0 +1,181 @@
+#pragma once
+
+#include "../opengl.h"
+#include "../core/job_system.h"
+#include "../util/deleters.h"
+#include "../util/asset_pack.h"
+#include "../util/mapped_file.h"
+#include "stream_buffer.h"
+#include "texture2D.h"
+#include "textureCube.h"
+#include "texture_file.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace overdrive {
+	namespace render {
+		enum class eStreamStatus {
+			LOADING,
+			READY,
+			FAILED	// the placeholder stays in place
+		};
+
+		// handle to a texture that is being loaded by a TextureStreamer
+		// [NOTE] the openGL texture exists right away and contains a placeholder; the actual image replaces
+		//		  its contents later on, so the handle can be given to materials and draw commands immediately
+		class StreamedTexture {
+		public:
+			StreamedTexture() = default; // not associated with any texture
+
+			bool isValid() const;
+
+			eStreamStatus getStatus() const;
+			bool isReady() const;
+			bool isFailed() const;
+
+			const std::string& getName() const; // (first) file name
+			GLenum getTarget() const;	// GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+			GLuint getHandle() const;	// stays the same when the placeholder is replaced
+
+			Texture2D* getTexture2D() const;		// nullptr for cube maps
+			TextureCube* getTextureCube() const;	// nullptr for 2D textures
+
+		private:
+			friend class TextureStreamer;
+
+			struct State {
+				std::string mName;
+				eStreamStatus mStatus = eStreamStatus::LOADING;
+
+				std::unique_ptr<Texture2D> mTexture2D;
+				std::unique_ptr<TextureCube> mTextureCube;
+			};
+
+			explicit StreamedTexture(std::shared_ptr<State> state);
+
+			std::shared_ptr<State> mState;
+		};
+
+		/*
+			Loads textures without stalling the calling thread:
+				1) reading and decoding the files happens in jobs on the JobSystem
+				2) decoded pixels are copied into a persistently mapped PIXEL_UNPACK buffer (see StreamBuffer)
+				   (dds/ktx files aren't decoded at all, they go from the memory-mapped file into the buffer)
+				3) update() issues the uploads from that buffer, up to a number of bytes per frame
+
+			Usage:
+				TextureStreamer streamer(engine.getJobSystem());
+				auto tex = streamer.load2D("assets/image/test_pattern_001.png");
+				TextureBinding binding(tex.getTarget(), tex.getHandle(), 0); // valid right away
+				...
+				streamer.update(); // once per frame, on the thread that owns the openGL context
+
+			[NOTE] load2D/loadCube create the placeholder texture, so they must be called on the openGL thread as well
+			[NOTE] a texture is uploaded in one go; one that is larger than the per-frame budget is uploaded
+				   directly from client memory, in a frame of its own
+			[NOTE] the destructor waits for decode jobs that are still running
+			[NOTE] with an asset pack set, files found in the pack are read from it instead of from disk
+			[NOTE] requesting files that are already streamed (or still loading) yields the same texture, as long as
+				   a handle to it is around; failed textures are requested again
+		*/
+		class TextureStreamer {
+		public:
+			struct Stats {
+				size_t mNumRequested = 0;
+				size_t mNumShared = 0;		// requests that got an existing texture, not included in mNumRequested
+				size_t mNumCompleted = 0;
+				size_t mNumFailed = 0;
+
+				size_t mNumBytesUploaded = 0;	// total
+				size_t mNumBytesLastUpdate = 0;
+			};
+
+			static const size_t DEFAULT_BYTES_PER_FRAME = 8 * 1024 * 1024;
+
+			explicit TextureStreamer(
+				core::JobSystem& jobSystem,
+				size_t bytesPerFrame = DEFAULT_BYTES_PER_FRAME
+			);
+			~TextureStreamer();
+
+			TextureStreamer(const TextureStreamer&) = delete;
+			TextureStreamer& operator = (const TextureStreamer&) = delete;
+
+			StreamedTexture load2D(const std::string& filepath);	// gli (ktx/dds) or stbi formats
+			StreamedTexture loadCube(								// ktx/dds or stbi formats, all faces must be the same size
+				const std::string& positiveX,
+				const std::string& negativeX,
+				const std::string& positiveY,
+				const std::string& negativeY,
+				const std::string& positiveZ,
+				const std::string& negativeZ
+			);
+
+			void setAssetPack(const util::AssetPack* pack); // nullptr to read loose files only; the pack must outlive the pending requests
+
+			void update();		// uploads decoded textures, within the per-frame budget
+			void finishAll();	// blocks until every requested texture is uploaded (loading screens)
+
+			size_t getNumPending() const; // requested, but not uploaded yet
+			const Stats& getStats() const;
+
+		private:
+			struct Image {
+				eTextureFormat mFormat;
+				int mWidth;
+				int mHeight;
+				std::unique_ptr<uint8_t[], util::FreeHelper> mPixels; // stbi
+				size_t mNumBytes;
+			};
+
+			struct Request {
+				std::shared_ptr<StreamedTexture::State> mState;
+				std::vector<std::string> mFiles;
+				const util::AssetPack* mPack = nullptr;
+
+				// filled in by the decode job
+				std::vector<Image> mImages;
+				std::unique_ptr<gli::texture> mTexture;		// if the file could be loaded with gli (it can't be assigned to)
+				std::vector<TextureFileView> mViews;		// dds/ktx files that are uploaded as-is, one per file
+				std::vector<util::MappedFile> mMappings;	// loose files the views point into
+				std::vector<std::vector<uint8_t>> mBuffers;	// decompressed asset pack entries the views point into
+				std::string mError;
+
+				size_t getNumBytes() const;
+			};
+
+			static uint64_t getKey(const std::vector<std::string>& files);
+			std::shared_ptr<StreamedTexture::State> findShared(uint64_t key);
+			StreamedTexture submit(uint64_t key, std::shared_ptr<Request> request);
+
+			static void decode(Request& request); // on a worker thread
+			static util::AssetView read(Request& request, const std::string& name); // the data lives as long as the request
+			void upload(Request& request, bool useStaging);
+			void collectDecoded();
+
+			core::JobSystem& mJobSystem;
+			core::JobHandle mJobs;
+
+			const util::AssetPack* mAssetPack;
+
+			std::unordered_map<uint64_t, std::weak_ptr<StreamedTexture::State>> mShared; // by file names
+
+			StreamBuffer mStaging;
+
+			std::mutex mDecodedMutex;
+			std::vector<std::shared_ptr<Request>> mDecoded; // filled by the decode jobs
+
+			std::deque<std::shared_ptr<Request>> mUploads; // only touched on the openGL thread
+			size_t mNumPending;
+
+			Stats mStats;
+		};
+
+		std::ostream& operator << (std::ostream& os, const TextureStreamer::Stats& stats);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../util/string_hash.h"
+#include <cstdint>
+#include <ostream>
+
+namespace overdrive {
+	namespace render {
+		/*
+			Names a uniform by the hash of its name, so that looking it up in a ShaderProgram is an integer
+			search rather than a string compare. Constructing one from a literal is constexpr:
+
+				static const UniformHandle MODEL("uModel"); // or constexpr
+
+			[NOTE] the name is not copied; it should outlive the handle (which is the case for literals)
+		*/
+		class UniformHandle {
+		public:
+			constexpr explicit UniformHandle(const char* name):
+				mHash(util::hashString(name)),
+				mName(name)
+			{
+			}
+
+			constexpr uint32_t getHash() const { return mHash; }
+			constexpr const char* getName() const { return mName; }
+
+		private:
+			uint32_t mHash;
+			const char* mName; // for diagnostics
+		};
+
+		inline bool operator == (const UniformHandle& a, const UniformHandle& b) { return a.getHash() == b.getHash(); }
+		inline bool operator != (const UniformHandle& a, const UniformHandle& b) { return a.getHash() != b.getHash(); }
+
+		inline std::ostream& operator << (std::ostream& os, const UniformHandle& handle) {
+			os << handle.getName();
+			return os;
+		}
+	}
+}
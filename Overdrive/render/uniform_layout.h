@@ -0,0 +1,187 @@
+#pragma once
+
+#include "../opengl.h"
+#include <boost/fusion/include/at_c.hpp>
+#include <boost/fusion/include/is_sequence.hpp>
+#include <boost/fusion/include/size.hpp>
+#include <boost/fusion/include/value_at.hpp>
+#include <cstddef>
+#include <type_traits>
+
+namespace overdrive {
+	namespace render {
+		/*
+			Compile-time description of the std140 and std430 block layouts, for structs adapted with
+			BOOST_FUSION_ADAPT_STRUCT (see common_uniform_blocks.h).
+
+			For a block struct S:
+				layout::Block<S, layout::Std140>::size				size of the block according to the rules
+				layout::Block<S, layout::Std140>::Offset<i>::value	offset of the i-th member
+				layout::IsCompatible<S, layout::Std140>::value		sizes of all members and the struct itself match
+
+			The C++ compiler knows nothing about the offsets of adapted members, so the offsets themselves
+			can only be verified at runtime (see layout::matchesOffsets), in the same way VertexBuffer
+			figures out its attribute offsets.
+
+			Supported member types: GLfloat, GLint, GLuint, GLdouble, glm vectors and matrices of those,
+			fixed size arrays and nested adapted structs.
+
+			[NOTE] GLSL bools take 4 bytes in a block, use GLuint for them
+			[NOTE] BOOST_FUSION_ADAPT_STRUCT can't parse array types, adapt array members through a typedef
+			[NOTE] glm::mat3 (and other matrices with 3-component columns) can never match; in std140 every
+			       column is padded to a vec4 -- use glm::mat4 or glm::mat3x4 instead
+
+			https://www.khronos.org/registry/OpenGL/specs/gl/glspec45.core.pdf (7.6.2.2 Standard Uniform Block Layout)
+		*/
+		namespace layout {
+			struct Std140 {};	// uniform blocks
+			struct Std430 {};	// shader storage blocks
+
+			namespace detail {
+				template <size_t value, size_t alignment>
+				struct AlignUp {
+					static const size_t result = (value + alignment - 1) / alignment * alignment;
+				};
+
+				template <size_t a, size_t b>
+				struct Max {
+					static const size_t result = (a > b) ? a : b;
+				};
+
+				// std140 rounds the alignment of arrays and structs up to that of a vec4
+				template <typename tRules, size_t alignment>
+				struct AggregateAlignment;
+
+				template <size_t alignment>
+				struct AggregateAlignment<Std140, alignment> {
+					static const size_t result = Max<alignment, 16>::result;
+				};
+
+				template <size_t alignment>
+				struct AggregateAlignment<Std430, alignment> {
+					static const size_t result = alignment;
+				};
+
+				template <size_t numBytes>
+				struct Scalar {
+					static const size_t alignment = numBytes;
+					static const size_t size = numBytes;
+				};
+
+				template <typename T, size_t N>
+				struct Vector {
+					static const size_t alignment = ((N == 3) ? 4 : N) * sizeof(T); // a vec3 is aligned as a vec4
+					static const size_t size = N * sizeof(T);
+				};
+			}
+
+			// alignment and size of a single member; types that can't be in a block don't have a definition
+			template <typename T, typename tRules, typename Enable = void>
+			struct Member;
+
+			template <typename tRules> struct Member<GLfloat, tRules>:	detail::Scalar<4> {};
+			template <typename tRules> struct Member<GLint, tRules>:	detail::Scalar<4> {};
+			template <typename tRules> struct Member<GLuint, tRules>:	detail::Scalar<4> {};
+			template <typename tRules> struct Member<GLdouble, tRules>:	detail::Scalar<8> {};
+
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tvec2<T, P>, tRules>: detail::Vector<T, 2> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tvec3<T, P>, tRules>: detail::Vector<T, 3> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tvec4<T, P>, tRules>: detail::Vector<T, 4> {};
+
+			template <typename T, size_t N, typename tRules>
+			struct Member<T[N], tRules> {
+				typedef Member<T, tRules> Element;
+
+				static const size_t alignment = detail::AggregateAlignment<tRules, Element::alignment>::result;
+				static const size_t stride = detail::AlignUp<Element::size, alignment>::result;
+				static const size_t size = stride * N;
+			};
+
+			// (column major) matrices are laid out as an array of column vectors
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat2x2<T, P>, tRules>: Member<glm::tvec2<T, P>[2], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat2x3<T, P>, tRules>: Member<glm::tvec3<T, P>[2], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat2x4<T, P>, tRules>: Member<glm::tvec4<T, P>[2], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat3x2<T, P>, tRules>: Member<glm::tvec2<T, P>[3], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat3x3<T, P>, tRules>: Member<glm::tvec3<T, P>[3], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat3x4<T, P>, tRules>: Member<glm::tvec4<T, P>[3], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat4x2<T, P>, tRules>: Member<glm::tvec2<T, P>[4], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat4x3<T, P>, tRules>: Member<glm::tvec3<T, P>[4], tRules> {};
+			template <typename T, glm::precision P, typename tRules> struct Member<glm::tmat4x4<T, P>, tRules>: Member<glm::tvec4<T, P>[4], tRules> {};
+
+			template <typename tSequence, typename tRules>
+			struct Block;
+
+			// nested structs
+			template <typename T, typename tRules>
+			struct Member<
+				T,
+				tRules,
+				typename std::enable_if<
+					boost::fusion::traits::is_sequence<T>::value &&
+					!std::is_array<T>::value
+				>::type
+			>:
+				Block<T, tRules>
+			{
+			};
+
+			namespace detail {
+				template <typename tSequence, size_t index>
+				struct MemberType {
+					typedef typename boost::fusion::result_of::value_at_c<tSequence, index>::type type;
+				};
+
+				// offset of a member is the end of the previous one, aligned up to what this member needs
+				template <typename tSequence, typename tRules, size_t index>
+				struct MemberLayout {
+					typedef MemberLayout<tSequence, tRules, index - 1> Previous;
+					typedef typename MemberType<tSequence, index>::type Type;
+					typedef Member<Type, tRules> Layout;
+
+					static const size_t offset = AlignUp<Previous::offset + Previous::Layout::size, Layout::alignment>::result;
+					static const size_t alignment = Max<Previous::alignment, Layout::alignment>::result; // largest so far
+					static const bool isCompatible = Previous::isCompatible && (sizeof(Type) == Layout::size);
+				};
+
+				template <typename tSequence, typename tRules>
+				struct MemberLayout<tSequence, tRules, 0> {
+					typedef typename MemberType<tSequence, 0>::type Type;
+					typedef Member<Type, tRules> Layout;
+
+					static const size_t offset = 0;
+					static const size_t alignment = Layout::alignment;
+					static const bool isCompatible = (sizeof(Type) == Layout::size);
+				};
+			}
+
+			template <typename tSequence, typename tRules>
+			struct Block {
+				static const size_t numMembers = boost::fusion::result_of::size<tSequence>::value;
+
+				typedef detail::MemberLayout<tSequence, tRules, numMembers - 1> Last;
+
+				static const size_t alignment = detail::AggregateAlignment<tRules, Last::alignment>::result;
+				static const size_t size = detail::AlignUp<Last::offset + Last::Layout::size, alignment>::result;
+
+				template <size_t index>
+				struct Offset {
+					static const size_t value = detail::MemberLayout<tSequence, tRules, index>::offset;
+				};
+			};
+
+			// all members have the expected size, and so does the struct as a whole
+			template <typename tSequence, typename tRules = Std140>
+			struct IsCompatible {
+				static const bool value =
+					detail::MemberLayout<tSequence, tRules, Block<tSequence, tRules>::numMembers - 1>::isCompatible &&
+					(sizeof(tSequence) == Block<tSequence, tRules>::size);
+			};
+
+			// compares the actual member offsets with the ones the rules prescribe (top level members only)
+			template <typename tSequence, typename tRules = Std140>
+			bool matchesOffsets();
+		}
+	}
+}
+
+#include "uniform_layout.inl"
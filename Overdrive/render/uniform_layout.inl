@@ -0,0 +1,41 @@
+#pragma once
+
+#include "uniform_layout.h"
+
+namespace overdrive {
+	namespace render {
+		namespace layout {
+			namespace detail {
+				template <typename tSequence, typename tRules, size_t index>
+				struct CheckOffsets {
+					static bool apply(const tSequence& sample) {
+						const char* start = reinterpret_cast<const char*>(&sample);
+						const char* member = reinterpret_cast<const char*>(&boost::fusion::at_c<index>(sample));
+
+						if (static_cast<size_t>(member - start) != MemberLayout<tSequence, tRules, index>::offset)
+							return false;
+
+						return CheckOffsets<tSequence, tRules, index - 1>::apply(sample);
+					}
+				};
+
+				template <typename tSequence, typename tRules>
+				struct CheckOffsets<tSequence, tRules, 0> {
+					static bool apply(const tSequence& sample) {
+						const char* start = reinterpret_cast<const char*>(&sample);
+						const char* member = reinterpret_cast<const char*>(&boost::fusion::at_c<0>(sample));
+
+						return (member == start);
+					}
+				};
+			}
+
+			template <typename tSequence, typename tRules>
+			bool matchesOffsets() {
+				tSequence sample;
+
+				return detail::CheckOffsets<tSequence, tRules, Block<tSequence, tRules>::numMembers - 1>::apply(sample);
+			}
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#include "stdafx.h"
+#include "uniform_stream.h"
+
+namespace overdrive {
+	namespace render {
+		UniformStream::UniformStream(
+			size_t bytesPerRegion,
+			size_t numRegions
+		):
+			mStream(bytesPerRegion, numRegions),
+			mAlignment(0)
+		{
+		}
+
+		void UniformStream::advance() {
+			mStream.advance();
+		}
+	}
+}
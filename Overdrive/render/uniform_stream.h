@@ -0,0 +1,38 @@
+#pragma once
+
+#include "stream_buffer.h"
+#include "uniform_layout.h"
+
+namespace overdrive {
+	namespace render {
+		/*
+			Uniform blocks streamed through a StreamBuffer: setting a block is a single memcpy into
+			persistently mapped memory and a glBindBufferRange, regardless of the number of members.
+
+			Block types are structs adapted with BOOST_FUSION_ADAPT_STRUCT that follow the std140 rules
+			(see uniform_layout.h and common_uniform_blocks.h).
+
+			[NOTE] like the StreamBuffer, nothing is created until the first block is bound
+		*/
+		class UniformStream {
+		public:
+			static const size_t DEFAULT_REGION_SIZE = 1024 * 1024; // bytes
+
+			UniformStream(
+				size_t bytesPerRegion = DEFAULT_REGION_SIZE,
+				size_t numRegions = StreamBuffer::DEFAULT_NUM_REGIONS
+			);
+
+			template <typename T>
+			StreamAllocation bind(const T& block, GLuint binding = T::BINDING);
+
+			void advance(); // call once per frame, after the draws using the blocks have been issued
+
+		private:
+			StreamBuffer mStream;
+			size_t mAlignment; // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried lazily
+		};
+	}
+}
+
+#include "uniform_stream.inl"
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "uniform_stream.h"
+#include <cstring>
+
+namespace overdrive {
+	namespace render {
+		template <typename T>
+		StreamAllocation UniformStream::bind(const T& block, GLuint binding) {
+			static_assert(layout::IsCompatible<T, layout::Std140>::value, "Block type does not follow the std140 layout rules");
+
+#ifdef OVERDRIVE_DEBUG
+			static const bool isValid = layout::matchesOffsets<T, layout::Std140>();
+			assert(isValid);
+#endif
+
+			if (mAlignment == 0)
+				mAlignment = StreamBuffer::getUniformAlignment();
+
+			StreamAllocation allocation = mStream.allocate(sizeof(T), mAlignment);
+
+			std::memcpy(allocation.mMemory, &block, sizeof(T));
+			mStream.bindRange(eBufferTarget::UNIFORM, binding, allocation);
+
+			return allocation;
+		}
+	}
+}
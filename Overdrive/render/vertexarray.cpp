@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "vertexarray.h"
 #include "gltypes.h"
+#include "state_cache.h"
 
 namespace overdrive {
 	namespace render {
@@ -9,33 +10,70 @@ namespace overdrive {
 		}
 
 		VertexArray::~VertexArray() {
-			if (mHandle)
+			if (mHandle) {
+				StateCache::current().onDeleteVertexArray(mHandle);
 				glDeleteVertexArrays(1, &mHandle);
+			}
+		}
+
+		bool operator == (const GeometryRange& a, const GeometryRange& b) {
+			return
+				(a.mFirstIndex == b.mFirstIndex) &&
+				(a.mNumIndices == b.mNumIndices) &&
+				(a.mBaseVertex == b.mBaseVertex);
+		}
+
+		bool operator != (const GeometryRange& a, const GeometryRange& b) {
+			return !(a == b);
 		}
 
 		GLuint VertexArray::getHandle() const {
 			return mHandle;
 		}
 
+		GLsizei VertexArray::getNumVertices() const {
+			return mVertexBufferSize;
+		}
+
+		GLsizei VertexArray::getNumIndices() const {
+			return mIndexBufferSize;
+		}
+
+		GLenum VertexArray::getIndexType() const {
+			return mIndexBufferType;
+		}
+
+		void VertexArray::attach(InstanceBuffer& instances) {
+			bind();
+			instances.bindAttributes();
+
+			mInstanceBuffer = &instances;
+		}
+
+		InstanceBuffer* VertexArray::getInstanceBuffer() const {
+			return mInstanceBuffer;
+		}
+
 		void VertexArray::bind() {
-			glBindVertexArray(mHandle);
+			StateCache::current().bindVertexArray(mHandle);
 		}
 
 		void VertexArray::unbind() {
-			glBindVertexArray(0);
+			StateCache::current().bindVertexArray(0);
 		}
 
-		void VertexArray::draw(ePrimitives mode_) {
+		void VertexArray::draw(ePrimitives mode) {
 			bind();
+			drawBound(mode);
+		}
 
+		void VertexArray::drawBound(ePrimitives mode_) {
 			GLenum mode = static_cast<GLenum>(mode_);
 
 			if (mIndexBufferType == 0)
 				glDrawArrays(mode, 0, mVertexBufferSize);
 			else
 				glDrawElements(mode, mIndexBufferSize, mIndexBufferType, nullptr);
-
-			unbind();
 		}
 
 		void VertexArray::drawInstanced(GLsizei primitiveCount, ePrimitives mode_) {
@@ -58,8 +96,64 @@ namespace overdrive {
 					nullptr, 
 					primitiveCount
 				);
+		}
+
+		void VertexArray::drawInstanced(const InstanceRange& range, ePrimitives mode) {
+			assert(mInstanceBuffer);
 
-			unbind();
+			bind();
+			drawInstancedBound(range.mCount, range.mFirst, mode);
+		}
+
+		void VertexArray::drawInstancedBound(GLsizei numInstances, GLuint baseInstance, ePrimitives mode_) {
+			GLenum mode = static_cast<GLenum>(mode_);
+
+			if (mIndexBufferType == 0)
+				glDrawArraysInstancedBaseInstance(
+					mode,
+					0,
+					mVertexBufferSize,
+					numInstances,
+					baseInstance
+				);
+			else
+				glDrawElementsInstancedBaseInstance(
+					mode,
+					mIndexBufferSize,
+					mIndexBufferType,
+					nullptr,
+					numInstances,
+					baseInstance
+				);
+		}
+
+		void VertexArray::drawBound(const GeometryRange& range, GLsizei numInstances, GLuint baseInstance, ePrimitives mode) {
+			assert(mIndexBufferType != 0);
+
+			GLsizei numIndices = (range.mNumIndices == 0) ? mIndexBufferSize : range.mNumIndices;
+			GLvoid* offset = (GLvoid*)(getTypeSize(mIndexBufferType) * range.mFirstIndex);
+
+			glDrawElementsInstancedBaseVertexBaseInstance(
+				static_cast<GLenum>(mode),
+				numIndices,
+				mIndexBufferType,
+				offset,
+				numInstances,
+				range.mBaseVertex,
+				baseInstance
+			);
+		}
+
+		void VertexArray::multiDrawIndirectBound(GLsizei numCommands, GLintptr offset, ePrimitives mode) {
+			assert(mIndexBufferType != 0);
+
+			glMultiDrawElementsIndirect(
+				static_cast<GLenum>(mode),
+				mIndexBufferType,
+				reinterpret_cast<const GLvoid*>(offset),
+				numCommands,
+				0 // tightly packed
+			);
 		}
 
 		void VertexArray::drawRange(GLuint begin, GLuint end, ePrimitives mode_) {
@@ -86,8 +180,6 @@ namespace overdrive {
 					mIndexBufferType,
 					offset
 				);
-
-			unbind();
 		}
 
 		std::ostream& operator << (std::ostream& os, const ePrimitives& value) {
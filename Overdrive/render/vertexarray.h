@@ -2,6 +2,7 @@
 
 #include "vertexbuffer.h"
 #include "indexbuffer.h"
+#include "instance_buffer.h"
 #include <ostream>
 
 namespace overdrive {
@@ -23,16 +24,28 @@ namespace overdrive {
 
 			PATCHES = GL_PATCHES
 		};
+
+		// part of an indexed vertex array; indices are relative to mBaseVertex
+		struct GeometryRange {
+			GLuint mFirstIndex = 0;
+			GLsizei mNumIndices = 0; // 0 means the entire vertex array
+			GLint mBaseVertex = 0;
+		};
+
+		bool operator == (const GeometryRange& a, const GeometryRange& b);
+		bool operator != (const GeometryRange& a, const GeometryRange& b);
+
 		/*
-			[TODO] Figure out how the draw indirect is supposed to work
-			[TODO] Figure out how the multidrawarray is supposed to work
 			[TODO] Perhaps get rid of the branch in :draw*() and make both variations explicit
+			[NOTE] binding goes through the StateCache, draw*() leaves the vertex array bound
 		*/
 		// http://docs.gl/gl4/glDrawArrays
 		// http://docs.gl/gl4/glDrawArraysInstanced
 		// http://docs.gl/gl4/glDrawElements
 		// http://docs.gl/gl4/glDrawElementsInstanced
 		// http://docs.gl/gl4/glDrawRangeElements
+		// http://docs.gl/gl4/glDrawElementsInstancedBaseVertexBaseInstance
+		// http://docs.gl/gl4/glMultiDrawElementsIndirect
 		class VertexArray {
 		public:
 			VertexArray();
@@ -44,6 +57,9 @@ namespace overdrive {
 			VertexArray& operator = (VertexArray&&) = delete;
 
 			GLuint getHandle() const;
+			GLsizei getNumVertices() const;
+			GLsizei getNumIndices() const;
+			GLenum getIndexType() const; // 0 if there is no index buffer attached
 
 			void bind();
 			void unbind();
@@ -54,10 +70,20 @@ namespace overdrive {
 			template <typename T>
 			void attach(IndexBuffer<T>& indexbuffer);
 
+			void attach(InstanceBuffer& instances); // per-instance attributes, see InstanceBuffer
+			InstanceBuffer* getInstanceBuffer() const;
+
 			void draw(ePrimitives mode = ePrimitives::TRIANGLES);
+			void drawBound(ePrimitives mode = ePrimitives::TRIANGLES); // assumes this VAO is already bound, leaves it bound
 			void drawInstanced(GLsizei primitiveCount, ePrimitives mode = ePrimitives::TRIANGLES);
+			void drawInstanced(const InstanceRange& range, ePrimitives mode = ePrimitives::TRIANGLES);
+			void drawInstancedBound(GLsizei numInstances, GLuint baseInstance, ePrimitives mode = ePrimitives::TRIANGLES); // assumes this VAO is already bound
 			void drawRange(GLuint begin, GLuint end, ePrimitives mode = ePrimitives::TRIANGLES); // [NOTE] not entirely sure I got this one right, needs to be tested
 
+			// these assume this VAO is already bound and has an index buffer
+			void drawBound(const GeometryRange& range, GLsizei numInstances, GLuint baseInstance, ePrimitives mode = ePrimitives::TRIANGLES);
+			void multiDrawIndirectBound(GLsizei numCommands, GLintptr offset, ePrimitives mode = ePrimitives::TRIANGLES); // reads DrawElementsIndirectCommands from the bound DRAW_INDIRECT buffer
+
 			template <typename T>
 			void draw(size_t numElements, T* indexbuffer, ePrimitives mode); // draw with raw index buffer
 
@@ -67,6 +93,8 @@ namespace overdrive {
 			GLsizei mVertexBufferSize = 0;
 			GLsizei mIndexBufferSize = 0;
 			GLenum mIndexBufferType = 0;
+
+			InstanceBuffer* mInstanceBuffer = nullptr;
 		};
 
 		std::ostream& operator << (std::ostream& os, const ePrimitives& value);
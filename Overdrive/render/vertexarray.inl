@@ -26,10 +26,10 @@ namespace overdrive {
 		}
 
 		template <typename T>
-		void VertexArray::draw(size_t numElements, T* indexbuffer, ePrimitives mode) {
+		void VertexArray::draw(size_t numElements, T* indexbuffer, ePrimitives mode_) {
 			bind();
 
-			GLenum mode = static_cast<GLenum>(mode);
+			GLenum mode = static_cast<GLenum>(mode_);
 			GLenum indexBufferType = ToValue<T>::value;
 
 			assert(
@@ -44,8 +44,6 @@ namespace overdrive {
 				indexBufferType, 
 				indexbuffer
 			);
-
-			unbind();
 		}
 	}
 }
\ No newline at end of file
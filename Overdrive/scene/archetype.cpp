@@ -0,0 +1,178 @@
+#include "stdafx.h"
+#include "archetype.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+namespace overdrive {
+	namespace scene {
+		namespace {
+			size_t alignUp(size_t value, size_t alignment) {
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+
+			// total bytes needed for a chunk with the given capacity, fills in the column offsets
+			size_t layoutColumns(
+				const std::vector<ComponentTypeID>& types,
+				size_t capacity,
+				std::vector<size_t>& offsets
+			) {
+				size_t offset = alignUp(sizeof(EntityHandle) * capacity, Archetype::COLUMN_ALIGNMENT);
+
+				offsets.clear();
+
+				for (auto type : types) {
+					const auto& info = getComponentInfo(type);
+
+					offsets.push_back(offset);
+					offset = alignUp(offset + info.mSize * capacity, Archetype::COLUMN_ALIGNMENT);
+				}
+
+				return offset;
+			}
+		}
+
+		Archetype::Archetype(const ComponentMask& mask):
+			mMask(mask)
+		{
+			for (auto& column : mColumnLookup)
+				column = NONE;
+
+			size_t rowSize = sizeof(EntityHandle);
+
+			for (ComponentTypeID i = 0; i < MAX_COMPONENT_TYPES; ++i) {
+				if (mask.test(i)) {
+					mColumnLookup[i] = mTypes.size();
+					mTypes.push_back(i);
+
+					assert(getComponentInfo(i).mAlignment <= COLUMN_ALIGNMENT);
+					rowSize += getComponentInfo(i).mSize;
+				}
+			}
+
+			// start from the optimistic estimate and back off until the padding fits as well
+			mChunkCapacity = std::max<size_t>(CHUNK_SIZE / rowSize, 1);
+
+			while (
+				(mChunkCapacity > 1) &&
+				(layoutColumns(mTypes, mChunkCapacity, mColumnOffsets) > CHUNK_SIZE)
+			)
+				--mChunkCapacity;
+
+			mChunkBytes = layoutColumns(mTypes, mChunkCapacity, mColumnOffsets);
+		}
+
+		Archetype::~Archetype() {
+			for (size_t chunk = 0; chunk < mChunks.size(); ++chunk)
+				for (size_t i = 0; i < mChunks[chunk].mSize; ++i)
+					destroyComponents(Row{ chunk, i });
+		}
+
+		const ComponentMask& Archetype::getMask() const {
+			return mMask;
+		}
+
+		const std::vector<ComponentTypeID>& Archetype::getTypes() const {
+			return mTypes;
+		}
+
+		size_t Archetype::getColumn(ComponentTypeID type) const {
+			return mColumnLookup[type];
+		}
+
+		size_t Archetype::getChunkCapacity() const {
+			return mChunkCapacity;
+		}
+
+		size_t Archetype::getNumChunks() const {
+			return mChunks.size();
+		}
+
+		size_t Archetype::getChunkSize(size_t chunk) const {
+			return mChunks[chunk].mSize;
+		}
+
+		size_t Archetype::getNumEntities() const {
+			if (mChunks.empty())
+				return 0;
+
+			return (mChunks.size() - 1) * mChunkCapacity + mChunks.back().mSize;
+		}
+
+		EntityHandle* Archetype::getEntities(size_t chunk) {
+			return reinterpret_cast<EntityHandle*>(mChunks[chunk].mData);
+		}
+
+		void* Archetype::getColumnData(size_t column, size_t chunk) {
+			return mChunks[chunk].mData + mColumnOffsets[column];
+		}
+
+		void* Archetype::getComponent(size_t column, const Row& row) {
+			const auto& info = getComponentInfo(mTypes[column]);
+			return static_cast<char*>(getColumnData(column, row.mChunk)) + info.mSize * row.mIndex;
+		}
+
+		Archetype::Row Archetype::allocateRow(EntityHandle entity) {
+			if (mChunks.empty() || (mChunks.back().mSize == mChunkCapacity)) {
+				Chunk chunk;
+
+				chunk.mMemory.reset(new char[mChunkBytes + COLUMN_ALIGNMENT]);
+				auto address = reinterpret_cast<uintptr_t>(chunk.mMemory.get());
+				chunk.mData = chunk.mMemory.get() + (alignUp(address, COLUMN_ALIGNMENT) - address);
+				chunk.mSize = 0;
+
+				mChunks.push_back(std::move(chunk));
+			}
+
+			Row result{ mChunks.size() - 1, mChunks.back().mSize++ };
+			new (getEntities(result.mChunk) + result.mIndex) EntityHandle(entity);
+
+			return result;
+		}
+
+		EntityHandle Archetype::removeRow(const Row& row) {
+			Row last{ mChunks.size() - 1, mChunks.back().mSize - 1 };
+			EntityHandle moved;
+
+			if ((last.mChunk != row.mChunk) || (last.mIndex != row.mIndex)) {
+				moved = getEntities(last.mChunk)[last.mIndex];
+				getEntities(row.mChunk)[row.mIndex] = moved;
+
+				for (size_t column = 0; column < mTypes.size(); ++column)
+					getComponentInfo(mTypes[column]).mMoveConstruct(
+						getComponent(column, row),
+						getComponent(column, last)
+					);
+			}
+
+			if (--mChunks.back().mSize == 0)
+				mChunks.pop_back();
+
+			return moved;
+		}
+
+		void Archetype::destroyComponents(const Row& row) {
+			for (size_t column = 0; column < mTypes.size(); ++column)
+				getComponentInfo(mTypes[column]).mDestroy(getComponent(column, row));
+		}
+
+		Archetype* Archetype::getAddEdge(ComponentTypeID type) const {
+			auto it = mAddEdges.find(type);
+			return (it == mAddEdges.end()) ? nullptr : it->second;
+		}
+
+		Archetype* Archetype::getRemoveEdge(ComponentTypeID type) const {
+			auto it = mRemoveEdges.find(type);
+			return (it == mRemoveEdges.end()) ? nullptr : it->second;
+		}
+
+		void Archetype::setAddEdge(ComponentTypeID type, Archetype* target) {
+			mAddEdges[type] = target;
+		}
+
+		void Archetype::setRemoveEdge(ComponentTypeID type, Archetype* target) {
+			mRemoveEdges[type] = target;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "component_type.h"
+#include "entity.h"
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace overdrive {
+	namespace scene {
+		/*
+			Stores all entities that have exactly the same set of components. Entities are packed into
+			fixed-size chunks; within a chunk every component type (and the entity handle) has its own
+			contiguous column (SoA). Rows are kept dense: removing an entity moves the very last row into the hole,
+			so every chunk but the last one is full.
+
+			[NOTE] rows handed out by allocateRow() are uninitialized, and removeRow() expects the components
+			       of the removed row to be destroyed (or moved out) already
+		*/
+		class Archetype {
+		public:
+			static const size_t CHUNK_SIZE = 16 * 1024; // bytes
+			static const size_t COLUMN_ALIGNMENT = 64;	// every column starts on a cache line
+			static const size_t NONE = static_cast<size_t>(-1);
+
+			struct Row {
+				size_t mChunk;
+				size_t mIndex;
+			};
+
+			explicit Archetype(const ComponentMask& mask);
+			~Archetype();
+
+			Archetype(const Archetype&) = delete;
+			Archetype& operator = (const Archetype&) = delete;
+
+			const ComponentMask& getMask() const;
+			const std::vector<ComponentTypeID>& getTypes() const;
+
+			size_t getColumn(ComponentTypeID type) const; // NONE if this archetype doesn't have the component
+
+			size_t getChunkCapacity() const; // rows per chunk
+			size_t getNumChunks() const;
+			size_t getChunkSize(size_t chunk) const; // rows in use
+			size_t getNumEntities() const;
+
+			EntityHandle* getEntities(size_t chunk);
+			void* getColumnData(size_t column, size_t chunk);
+			void* getComponent(size_t column, const Row& row);
+
+			Row allocateRow(EntityHandle entity);
+			EntityHandle removeRow(const Row& row); // returns the entity that was moved into the row, if any
+
+			void destroyComponents(const Row& row);
+
+			// cached transitions to other archetypes
+			Archetype* getAddEdge(ComponentTypeID type) const;
+			Archetype* getRemoveEdge(ComponentTypeID type) const;
+			void setAddEdge(ComponentTypeID type, Archetype* target);
+			void setRemoveEdge(ComponentTypeID type, Archetype* target);
+
+		private:
+			struct Chunk {
+				std::unique_ptr<char[]> mMemory;
+				char* mData; // aligned
+				size_t mSize;
+			};
+
+			ComponentMask mMask;
+			std::vector<ComponentTypeID> mTypes;
+			size_t mColumnLookup[MAX_COMPONENT_TYPES];
+
+			std::vector<size_t> mColumnOffsets; // per component column; the entity column is at offset 0
+			size_t mChunkCapacity;
+			size_t mChunkBytes;
+
+			std::vector<Chunk> mChunks;
+
+			std::unordered_map<ComponentTypeID, Archetype*> mAddEdges;
+			std::unordered_map<ComponentTypeID, Archetype*> mRemoveEdges;
+		};
+	}
+}
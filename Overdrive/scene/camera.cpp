@@ -156,6 +156,14 @@ namespace overdrive {
 			mFarClip = farClip;
 		}
 
+		float Camera::getNearClip() const {
+			return mNearClip;
+		}
+
+		float Camera::getFarClip() const {
+			return mFarClip;
+		}
+
 		void Camera::setViewport(int x, int y, int width, int height) {
 			mViewportX = x;
 			mViewportY = y;
@@ -198,6 +206,10 @@ namespace overdrive {
 			return mProjection;
 		}
 
+		const math::Frustum& Camera::getFrustum() const {
+			return mFrustum;
+		}
+
 		void Camera::update() {
 			// set viewport
 			glViewport(
@@ -223,6 +235,8 @@ namespace overdrive {
 			default:
 				assert(false);
 			}
+
+			mFrustum.extract(mProjection * mView);
 		}
 
 		void Camera::operator()(const video::Window::OnFramebufferResized& resized) {
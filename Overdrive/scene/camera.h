@@ -59,6 +59,8 @@ namespace overdrive {
 			void setFOV(float radians);
 			void setAspect(float ratio);
 			void setClip(float nearClip, float farClip);
+			float getNearClip() const;
+			float getFarClip() const;
 			
 			void setViewport(int x, int y, int width, int height);
 			void setViewportWindow(video::Window* window); // uses the entire window, derives aspect ratio from the window
@@ -66,6 +68,7 @@ namespace overdrive {
 			eMode getMode() const;
 			const glm::mat4& getView() const;
 			const glm::mat4& getProjection() const;
+			const math::Frustum& getFrustum() const; // world space, as of the last update()
 
 			void update(); // sets the viewport and recalculates matrices
 
@@ -0,0 +1,85 @@
+#include "stdafx.h"
+#include "command_buffer.h"
+
+namespace overdrive {
+	namespace scene {
+		// ----- Commands -----
+		CommandBuffer::Command::Command(EntityHandle entity):
+			mEntity(entity)
+		{
+		}
+
+		struct CommandBuffer::PlaceCommand:
+			public Command
+		{
+			explicit PlaceCommand(EntityHandle entity):
+				Command(entity)
+			{
+			}
+
+			virtual void apply(Registry& registry) override {
+				registry.place(mEntity);
+			}
+		};
+
+		struct CommandBuffer::DestroyCommand:
+			public Command
+		{
+			explicit DestroyCommand(EntityHandle entity):
+				Command(entity)
+			{
+			}
+
+			virtual void apply(Registry& registry) override {
+				registry.destroy(mEntity);
+			}
+		};
+
+		// ----- CommandBuffer -----
+		CommandBuffer::CommandBuffer(Registry* registry, size_t capacity):
+			mRegistry(registry),
+			mStorage(capacity)
+		{
+		}
+
+		CommandBuffer::~CommandBuffer() {
+			clear();
+		}
+
+		EntityHandle CommandBuffer::create() {
+			EntityHandle result = mRegistry->reserve();
+			record<PlaceCommand>(result);
+
+			return result;
+		}
+
+		void CommandBuffer::destroy(EntityHandle entity) {
+			record<DestroyCommand>(entity);
+		}
+
+		void CommandBuffer::playback() {
+			for (auto command : mCommands)
+				if (mRegistry->isValid(command->mEntity))
+					command->apply(*mRegistry);
+
+			clear();
+		}
+
+		void CommandBuffer::clear() {
+			for (auto command : mCommands)
+				command->~Command();
+
+			mCommands.clear();
+			mStorage.reset();
+		}
+
+		size_t CommandBuffer::getNumCommands() const {
+			std::lock_guard<util::Spinlock> lock(mMutex);
+			return mCommands.size();
+		}
+
+		bool CommandBuffer::isEmpty() const {
+			return getNumCommands() == 0;
+		}
+	}
+}
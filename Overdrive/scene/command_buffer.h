@@ -0,0 +1,79 @@
+#pragma once
+
+#include "entity.h"
+#include "../core/linear_allocator.h"
+#include "../util/spinlock.h"
+#include <cstddef>
+#include <vector>
+
+namespace overdrive {
+	namespace scene {
+		class Registry;
+
+		/*
+			Records structural changes (creating/destroying entities, adding/removing components) so they can be
+			applied later at a safe point. Recording is threadsafe; entities created through the buffer get their
+			handle right away, but only show up in the registry after playback.
+
+			Commands are stored in a linear allocator that is recycled on every playback. Commands that refer to an
+			entity that was destroyed in the meantime are skipped.
+
+			[NOTE] playback() should not overlap with recording
+		*/
+		class CommandBuffer {
+		public:
+			static const size_t DEFAULT_CAPACITY = 64 * 1024; // bytes, grows when exceeded
+
+			explicit CommandBuffer(Registry* registry, size_t capacity = DEFAULT_CAPACITY);
+			~CommandBuffer();
+
+			CommandBuffer(const CommandBuffer&) = delete;
+			CommandBuffer& operator = (const CommandBuffer&) = delete;
+
+			EntityHandle create();
+			void destroy(EntityHandle entity);
+
+			template <typename T, typename... tArgs>
+			void add(EntityHandle entity, tArgs&&... args);
+
+			template <typename T>
+			void remove(EntityHandle entity);
+
+			void playback(); // applies all commands in the order they were recorded
+			void clear();	 // discards all commands
+
+			size_t getNumCommands() const;
+			bool isEmpty() const;
+
+		private:
+			struct Command {
+				explicit Command(EntityHandle entity);
+				virtual ~Command() = default;
+
+				virtual void apply(Registry& registry) = 0;
+
+				EntityHandle mEntity;
+			};
+
+			struct PlaceCommand;
+			struct DestroyCommand;
+
+			template <typename T>
+			struct AddCommand;
+
+			template <typename T>
+			struct RemoveCommand;
+
+			template <typename tCommand, typename... tArgs>
+			void record(tArgs&&... args);
+
+			Registry* mRegistry;
+
+			mutable util::Spinlock mMutex;
+			core::LinearAllocator mStorage;
+			std::vector<Command*> mCommands;
+		};
+	}
+}
+
+#include "command_buffer.inl"
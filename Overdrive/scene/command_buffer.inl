@@ -0,0 +1,61 @@
+#pragma once
+
+#include "command_buffer.h"
+#include "registry.h"
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace overdrive {
+	namespace scene {
+		template <typename T>
+		struct CommandBuffer::AddCommand:
+			public Command
+		{
+			template <typename... tArgs>
+			AddCommand(EntityHandle entity, tArgs&&... args):
+				Command(entity),
+				mComponent(std::forward<tArgs>(args)...)
+			{
+			}
+
+			virtual void apply(Registry& registry) override {
+				registry.add<T>(mEntity, std::move(mComponent));
+			}
+
+			T mComponent;
+		};
+
+		template <typename T>
+		struct CommandBuffer::RemoveCommand:
+			public Command
+		{
+			explicit RemoveCommand(EntityHandle entity):
+				Command(entity)
+			{
+			}
+
+			virtual void apply(Registry& registry) override {
+				registry.remove<T>(mEntity);
+			}
+		};
+
+		template <typename T, typename... tArgs>
+		void CommandBuffer::add(EntityHandle entity, tArgs&&... args) {
+			record<AddCommand<T>>(entity, std::forward<tArgs>(args)...);
+		}
+
+		template <typename T>
+		void CommandBuffer::remove(EntityHandle entity) {
+			record<RemoveCommand<T>>(entity);
+		}
+
+		template <typename tCommand, typename... tArgs>
+		void CommandBuffer::record(tArgs&&... args) {
+			std::lock_guard<util::Spinlock> lock(mMutex);
+
+			void* storage = mStorage.allocate(sizeof(tCommand), alignof(tCommand));
+			mCommands.push_back(new (storage) tCommand(std::forward<tArgs>(args)...));
+		}
+	}
+}
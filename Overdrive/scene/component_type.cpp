@@ -0,0 +1,32 @@
+#include "stdafx.h"
+#include "component_type.h"
+#include <mutex>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace scene {
+		namespace {
+			std::mutex gComponentTypeMutex; // util::Type is not threadsafe
+			ComponentInfo gComponentInfo[MAX_COMPONENT_TYPES];
+		}
+
+		const ComponentInfo& getComponentInfo(ComponentTypeID id) {
+			return gComponentInfo[id];
+		}
+
+		namespace detail {
+			ComponentTypeID registerComponentType(size_t (*getIndex)(), const ComponentInfo& info) {
+				std::lock_guard<std::mutex> lock(gComponentTypeMutex);
+
+				size_t index = getIndex();
+
+				if (index >= MAX_COMPONENT_TYPES)
+					throw std::runtime_error("Too many component types");
+
+				gComponentInfo[index] = info;
+
+				return static_cast<ComponentTypeID>(index);
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace overdrive {
+	namespace scene {
+		typedef uint32_t ComponentTypeID;
+
+		static const size_t MAX_COMPONENT_TYPES = 128;
+		typedef std::bitset<MAX_COMPONENT_TYPES> ComponentMask;
+
+		// type-erased operations, used to move components between archetypes
+		struct ComponentInfo {
+			size_t mSize = 0;
+			size_t mAlignment = 0;
+			const char* mName = nullptr;
+
+			void (*mMoveConstruct)(void* destination, void* source) = nullptr; // also destroys the source
+			void (*mDestroy)(void* object) = nullptr;
+		};
+
+		template <typename T>
+		ComponentTypeID getComponentTypeID(); // const qualification is ignored
+
+		const ComponentInfo& getComponentInfo(ComponentTypeID id);
+
+		template <typename... tComponents>
+		ComponentMask makeComponentMask();
+
+		namespace detail {
+			ComponentTypeID registerComponentType(size_t (*getIndex)(), const ComponentInfo& info);
+		}
+	}
+}
+
+#include "component_type.inl"
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "component_type.h"
+#include "../util/typemap.h"
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace overdrive {
+	namespace scene {
+		namespace detail {
+			template <typename T>
+			size_t getComponentIndex() {
+				return util::Type<ComponentInfo>::getIndex<T>();
+			}
+
+			template <typename T>
+			void moveConstructComponent(void* destination, void* source) {
+				T* object = static_cast<T*>(source);
+
+				new (destination) T(std::move(*object));
+				object->~T();
+			}
+
+			template <typename T>
+			void destroyComponent(void* object) {
+				static_cast<T*>(object)->~T();
+			}
+
+			template <typename T>
+			ComponentInfo makeComponentInfo() {
+				ComponentInfo result;
+
+				result.mSize = sizeof(T);
+				result.mAlignment = alignof(T);
+				result.mName = typeid(T).name();
+				result.mMoveConstruct = &moveConstructComponent<T>;
+				result.mDestroy = &destroyComponent<T>;
+
+				return result;
+			}
+		}
+
+		template <typename T>
+		ComponentTypeID getComponentTypeID() {
+			typedef typename std::remove_const<T>::type Component;
+
+			static_assert(std::is_move_constructible<Component>::value, "Components should be move constructible");
+
+			static const ComponentTypeID id = detail::registerComponentType(
+				&detail::getComponentIndex<Component>,
+				detail::makeComponentInfo<Component>()
+			);
+
+			return id;
+		}
+
+		template <typename... tComponents>
+		ComponentMask makeComponentMask() {
+			ComponentMask result;
+
+			int expand[] = { 0, (result.set(getComponentTypeID<tComponents>()), 0)... };
+			(void)expand;
+
+			return result;
+		}
+	}
+}
@@ -1,14 +1,15 @@
 #include "stdafx.h"
 #include "entity.h"
+#include <atomic>
 
 namespace overdrive {
 	namespace scene {
 		namespace {
-			static EntityID gNextEntityID = 0;
+			std::atomic<EntityID> gNextEntityID(0);
 		}
 
 		Entity::Entity():
-			mID(gNextEntityID++)
+			mID(gNextEntityID.fetch_add(1, std::memory_order_relaxed))
 		{
 		}
 
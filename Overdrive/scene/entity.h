@@ -1,9 +1,14 @@
 #pragma once
 
+#include "../core/handle.h"
+
 namespace overdrive {
 	namespace scene {
 		typedef unsigned long long EntityID;
 
+		class Entity;
+		typedef core::Handle<Entity> EntityHandle;
+
 		class Entity {
 		public:
 			Entity();
@@ -0,0 +1,279 @@
+#include "stdafx.h"
+#include "registry.h"
+#include "command_buffer.h"
+#include <cassert>
+#include <mutex>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace scene {
+		Registry::Registry():
+			mCommandBuffer(std::make_unique<CommandBuffer>(this))
+		{
+			mEmptyArchetype = getArchetype(ComponentMask());
+		}
+
+		Registry::~Registry() {
+			// components are destroyed along with the archetypes
+		}
+
+		EntityHandle Registry::create() {
+			EntityHandle result = reserve();
+			place(result);
+
+			return result;
+		}
+
+		void Registry::destroy(EntityHandle entity) {
+			if (!isValid(entity))
+				throw std::runtime_error("Tried to destroy a stale entity");
+
+			Location* location = getLocation(entity); // nullptr if the entity was reserved but not placed yet
+
+			if (Archetype* archetype = location ? location->mArchetype : nullptr) {
+				archetype->destroyComponents(location->mRow);
+
+				EntityHandle moved = archetype->removeRow(location->mRow);
+
+				if (moved)
+					mLocations[moved.mIndex].mRow = location->mRow;
+
+				location->mArchetype = nullptr;
+			}
+
+			mEntities.destroy(entity);
+		}
+
+		bool Registry::isValid(EntityHandle entity) const {
+			return mEntities.isValid(entity);
+		}
+
+		Entity* Registry::getEntity(EntityHandle entity) const {
+			return mEntities.get(entity);
+		}
+
+		void Registry::getMatchingArchetypes(const ComponentMask& mask, std::vector<Archetype*>& result) const {
+			for (const auto& archetype : mArchetypes)
+				if ((archetype->getMask() & mask) == mask)
+					result.push_back(archetype.get());
+		}
+
+		CommandBuffer& Registry::getCommandBuffer() {
+			return *mCommandBuffer;
+		}
+
+		size_t Registry::getNumEntities() const {
+			return mEntities.getSize();
+		}
+
+		size_t Registry::getNumArchetypes() const {
+			return mArchetypes.size();
+		}
+
+		EntityHandle Registry::reserve() {
+			return mEntities.create();
+		}
+
+		void Registry::place(EntityHandle entity) {
+			if (!isValid(entity))
+				return; // destroyed before it was placed
+
+			if (mLocations.size() <= entity.mIndex)
+				mLocations.resize(entity.mIndex + 1);
+
+			Location& location = mLocations[entity.mIndex];
+
+			location.mArchetype = mEmptyArchetype;
+			location.mRow = mEmptyArchetype->allocateRow(entity);
+		}
+
+		// [NOTE] lookups must not grow mLocations, they can happen concurrently from parallelForEach jobs;
+		//        place() makes room for every entity that is created
+		Registry::Location* Registry::getLocation(EntityHandle entity) {
+			if (
+				(!isValid(entity)) ||
+				(mLocations.size() <= entity.mIndex)
+			)
+				return nullptr;
+
+			return &mLocations[entity.mIndex];
+		}
+
+		const Registry::Location* Registry::getLocation(EntityHandle entity) const {
+			if (
+				(!isValid(entity)) ||
+				(mLocations.size() <= entity.mIndex)
+			)
+				return nullptr;
+
+			return &mLocations[entity.mIndex];
+		}
+
+		void Registry::runQuery(
+			core::JobSystem& jobSystem,
+			const ComponentMask& reads,
+			const ComponentMask& writes,
+			const core::JobHandle& jobs,
+			const std::function<void()>& schedule
+		) {
+			std::vector<core::JobHandle> conflicts;
+
+			while (true) {
+				{
+					std::lock_guard<util::Spinlock> lock(mQueryLock);
+
+					mActiveQueries.erase(
+						std::remove_if(
+							mActiveQueries.begin(),
+							mActiveQueries.end(),
+							[](const ActiveQuery& query) { return query.mJobs.isDone(); }
+						),
+						mActiveQueries.end()
+					);
+
+					conflicts.clear();
+
+					for (const auto& query : mActiveQueries) {
+						if (
+							(query.mWrites & (reads | writes)).any() ||
+							(query.mReads & writes).any()
+						)
+							conflicts.push_back(query.mJobs);
+					}
+
+					if (conflicts.empty()) {
+						// [NOTE] the jobs never take the query lock, so they can start right away
+						schedule();
+
+						if (!jobs.isDone())
+							mActiveQueries.push_back(ActiveQuery{ reads, writes, jobs });
+
+						return;
+					}
+				}
+
+				// parks the calling job (or runs other jobs) instead of spinning
+				for (const auto& handle : conflicts)
+					jobSystem.wait(handle);
+			}
+		}
+
+		Archetype* Registry::getArchetype(const ComponentMask& mask) {
+			auto it = mArchetypeLookup.find(mask);
+
+			if (it != mArchetypeLookup.end())
+				return it->second;
+
+			mArchetypes.push_back(std::make_unique<Archetype>(mask));
+			Archetype* result = mArchetypes.back().get();
+
+			mArchetypeLookup[mask] = result;
+
+			return result;
+		}
+
+		void Registry::moveEntity(
+			EntityHandle entity,
+			Location& location,
+			Archetype* target,
+			ComponentTypeID unconstructed
+		) {
+			Archetype* source = location.mArchetype;
+			Archetype::Row row = target->allocateRow(entity);
+
+			// move the components that the target has as well, the others are dropped
+			const auto& types = source->getTypes();
+
+			for (size_t column = 0; column < types.size(); ++column) {
+				const auto& info = getComponentInfo(types[column]);
+				size_t targetColumn = target->getColumn(types[column]);
+
+				if (targetColumn == Archetype::NONE) {
+					if (types[column] != unconstructed)
+						info.mDestroy(source->getComponent(column, location.mRow));
+				}
+				else
+					info.mMoveConstruct(
+						target->getComponent(targetColumn, row),
+						source->getComponent(column, location.mRow)
+					);
+			}
+
+			EntityHandle moved = source->removeRow(location.mRow);
+
+			if (moved)
+				mLocations[moved.mIndex].mRow = location.mRow;
+
+			location.mArchetype = target;
+			location.mRow = row;
+		}
+
+		void* Registry::addComponent(EntityHandle entity, ComponentTypeID type) {
+			Location* location = getLocation(entity);
+
+			if (!location || !location->mArchetype)
+				throw std::runtime_error("Tried to add a component to a stale entity");
+
+			Archetype* source = location->mArchetype;
+			Archetype* target = source->getAddEdge(type);
+
+			if (!target) {
+				target = getArchetype(ComponentMask(source->getMask()).set(type));
+
+				source->setAddEdge(type, target);
+				target->setRemoveEdge(type, source);
+			}
+
+			moveEntity(entity, *location, target);
+
+			return target->getComponent(target->getColumn(type), location->mRow);
+		}
+
+		void Registry::cancelAdd(EntityHandle entity, ComponentTypeID type) {
+			Location& location = *getLocation(entity);
+
+			// addComponent created the edges in both directions
+			Archetype* source = location.mArchetype->getRemoveEdge(type);
+			assert(source);
+
+			moveEntity(entity, location, source, type);
+		}
+
+		void Registry::removeComponent(EntityHandle entity, ComponentTypeID type) {
+			Location* location = getLocation(entity);
+
+			if (!location || !location->mArchetype)
+				throw std::runtime_error("Tried to remove a component from a stale entity");
+
+			Archetype* source = location->mArchetype;
+
+			if (!source->getMask().test(type))
+				return;
+
+			Archetype* target = source->getRemoveEdge(type);
+
+			if (!target) {
+				target = getArchetype(ComponentMask(source->getMask()).reset(type));
+
+				source->setRemoveEdge(type, target);
+				target->setAddEdge(type, source);
+			}
+
+			moveEntity(entity, *location, target);
+		}
+
+		void* Registry::getComponent(EntityHandle entity, ComponentTypeID type) {
+			Location* location = getLocation(entity);
+
+			if (!location || !location->mArchetype)
+				return nullptr;
+
+			size_t column = location->mArchetype->getColumn(type);
+
+			if (column == Archetype::NONE)
+				return nullptr;
+
+			return location->mArchetype->getComponent(column, location->mRow);
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "archetype.h"
+#include "component_type.h"
+#include "entity.h"
+#include "../core/job_system.h"
+#include "../core/pool.h"
+#include "../util/spinlock.h"
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace overdrive {
+	namespace scene {
+		class CommandBuffer;
+
+		template <typename... tComponents>
+		class View;
+
+		/*
+			Archetype based entity/component storage. Entities are generational handles; their components
+			live in the archetype table that matches their exact set of components. Components can be any
+			move-constructible and move-assignable type, there is no need to derive from anything.
+
+			Adding or removing a component moves the entity to another archetype (a structural change). Structural
+			changes are not threadsafe and invalidate views and component pointers, so while systems/jobs are running
+			they should be recorded in a CommandBuffer instead (reserving an entity handle is threadsafe though).
+
+			parallelForEach splits the chunks matched by a query into jobs. While the jobs are in flight the query's
+			component access is tracked; a parallelForEach that would write to a component that a running query reads
+			or writes (or read a component that one writes) first waits for that query to complete.
+
+			[NOTE] starting a conflicting parallelForEach from within the jobs of another one deadlocks
+		*/
+		class Registry {
+		public:
+			static const size_t DEFAULT_MIN_BATCH_SIZE = 256; // rows per job
+
+			Registry();
+			~Registry();
+
+			Registry(const Registry&) = delete;
+			Registry& operator = (const Registry&) = delete;
+
+			EntityHandle create();
+			void destroy(EntityHandle entity);
+
+			bool isValid(EntityHandle entity) const;
+			Entity* getEntity(EntityHandle entity) const; // nullptr if the handle is stale
+
+			template <typename T, typename... tArgs>
+			T& add(EntityHandle entity, tArgs&&... args); // replaces the component if it is already present
+
+			template <typename T>
+			void remove(EntityHandle entity);
+
+			template <typename T>
+			T* get(EntityHandle entity); // nullptr if the entity doesn't have the component
+
+			template <typename T>
+			bool has(EntityHandle entity) const;
+
+			template <typename... tComponents>
+			View<tComponents...> view(); // components that are only read should be const-qualified
+
+			template <typename tFunction, typename... tComponents>
+			core::JobHandle parallelForEach(
+				core::JobSystem& jobSystem,
+				const View<tComponents...>& query,
+				tFunction fn, // fn(tComponents&...), should be safe to call concurrently
+				size_t minBatchSize = DEFAULT_MIN_BATCH_SIZE
+			);
+
+			void getMatchingArchetypes(const ComponentMask& mask, std::vector<Archetype*>& result) const;
+
+			CommandBuffer& getCommandBuffer(); // shared buffer, played back by Scene::update
+
+			size_t getNumEntities() const;
+			size_t getNumArchetypes() const;
+
+		private:
+			friend class CommandBuffer;
+
+			struct Location {
+				Archetype* mArchetype = nullptr; // nullptr while the entity is only reserved
+				Archetype::Row mRow;
+			};
+
+			EntityHandle reserve(); // threadsafe
+			void place(EntityHandle entity);
+
+			Location* getLocation(EntityHandle entity);
+			const Location* getLocation(EntityHandle entity) const;
+
+			Archetype* getArchetype(const ComponentMask& mask);
+			void moveEntity(
+				EntityHandle entity,
+				Location& location,
+				Archetype* target,
+				ComponentTypeID unconstructed = MAX_COMPONENT_TYPES // dropped without being destroyed
+			);
+
+			void* addComponent(EntityHandle entity, ComponentTypeID type); // uninitialized storage
+			void cancelAdd(EntityHandle entity, ComponentTypeID type); // the component constructor threw, undo addComponent
+			void removeComponent(EntityHandle entity, ComponentTypeID type);
+			void* getComponent(EntityHandle entity, ComponentTypeID type);
+
+			struct ActiveQuery {
+				ComponentMask mReads;
+				ComponentMask mWrites;
+				core::JobHandle mJobs;
+			};
+
+			// waits (through the JobSystem) until no running query conflicts, then schedules the jobs and registers
+			// the access; both happen under the query lock, so a registered query is never without its jobs
+			void runQuery(
+				core::JobSystem& jobSystem,
+				const ComponentMask& reads,
+				const ComponentMask& writes,
+				const core::JobHandle& jobs,
+				const std::function<void()>& schedule // adds the jobs to the handle
+			);
+
+			core::Pool<Entity> mEntities;
+			std::vector<Location> mLocations; // indexed by handle
+
+			std::vector<std::unique_ptr<Archetype>> mArchetypes;
+			std::unordered_map<ComponentMask, Archetype*> mArchetypeLookup;
+			Archetype* mEmptyArchetype;
+
+			util::Spinlock mQueryLock;
+			std::vector<ActiveQuery> mActiveQueries;
+
+			std::unique_ptr<CommandBuffer> mCommandBuffer;
+		};
+	}
+}
+
+#include "registry.inl"
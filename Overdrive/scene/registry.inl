@@ -0,0 +1,107 @@
+#pragma once
+
+#include "registry.h"
+#include "view.h"
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace overdrive {
+	namespace scene {
+		template <typename T, typename... tArgs>
+		T& Registry::add(EntityHandle entity, tArgs&&... args) {
+			static_assert(std::is_move_assignable<T>::value, "Components should be move assignable, add() replaces existing ones by assignment");
+
+			if (T* existing = get<T>(entity)) {
+				*existing = T(std::forward<tArgs>(args)...);
+				return *existing;
+			}
+
+			void* storage = addComponent(entity, getComponentTypeID<T>());
+
+			try {
+				return *new (storage) T(std::forward<tArgs>(args)...);
+			}
+			catch (...) {
+				cancelAdd(entity, getComponentTypeID<T>());
+				throw;
+			}
+		}
+
+		template <typename T>
+		void Registry::remove(EntityHandle entity) {
+			removeComponent(entity, getComponentTypeID<T>());
+		}
+
+		template <typename T>
+		T* Registry::get(EntityHandle entity) {
+			return static_cast<T*>(getComponent(entity, getComponentTypeID<T>()));
+		}
+
+		template <typename T>
+		bool Registry::has(EntityHandle entity) const {
+			const Location* location = getLocation(entity);
+
+			return
+				(location) &&
+				(location->mArchetype) &&
+				(location->mArchetype->getMask().test(getComponentTypeID<T>()));
+		}
+
+		template <typename... tComponents>
+		View<tComponents...> Registry::view() {
+			return View<tComponents...>(this);
+		}
+
+		template <typename tFunction, typename... tComponents>
+		core::JobHandle Registry::parallelForEach(
+			core::JobSystem& jobSystem,
+			const View<tComponents...>& query,
+			tFunction fn,
+			size_t minBatchSize
+		) {
+			typedef View<tComponents...> Query;
+
+			core::JobHandle result;
+
+			// aim for a couple of jobs per worker so stealing can even things out, but never go below the minimum
+			size_t numEntities = query.getNumEntities();
+			size_t numWorkers = jobSystem.getNumWorkers();
+			size_t batchSize = std::max<size_t>(
+				std::max<size_t>(minBatchSize, 1),
+				(numEntities + numWorkers * 4 - 1) / (numWorkers * 4)
+			);
+
+			auto ranges = std::make_shared<std::vector<ChunkRange>>();
+			query.getRanges(batchSize, *ranges);
+
+			auto function = std::make_shared<tFunction>(std::move(fn));
+
+			runQuery(jobSystem, Query::getReadMask(), Query::getWriteMask(), result, [&] {
+				// chunks can be smaller than a batch, so a job may cover several ranges
+				size_t first = 0;
+
+				while (first < ranges->size()) {
+					size_t last = first;
+					size_t numRows = 0;
+
+					while ((last < ranges->size()) && (numRows < batchSize)) {
+						numRows += (*ranges)[last].mEnd - (*ranges)[last].mBegin;
+						++last;
+					}
+
+					jobSystem.schedule([ranges, function, first, last] {
+						for (size_t i = first; i < last; ++i)
+							Query::forEachInRange(*function, (*ranges)[i]);
+					}, result);
+
+					first = last;
+				}
+			});
+
+			return result;
+		}
+	}
+}
@@ -12,9 +12,35 @@ namespace overdrive {
 	}
 
 	void Scene::update() {
+		mRegistry.getCommandBuffer().playback();
+		mTransforms.update();
 	}
 
 	void Scene::shutdown() {
 		System::shutdown();
 	}
+
+	scene::EntityHandle Scene::createEntity() {
+		return mRegistry.create();
+	}
+
+	void Scene::destroyEntity(scene::EntityHandle handle) {
+		mRegistry.destroy(handle);
+	}
+
+	scene::Entity* Scene::getEntity(scene::EntityHandle handle) const {
+		return mRegistry.getEntity(handle);
+	}
+
+	scene::Registry& Scene::getRegistry() {
+		return mRegistry;
+	}
+
+	scene::CommandBuffer& Scene::getCommandBuffer() {
+		return mRegistry.getCommandBuffer();
+	}
+
+	scene::TransformHierarchy& Scene::getTransforms() {
+		return mTransforms;
+	}
 }
@@ -1,8 +1,16 @@
 #pragma once
 
 #include "../core/system.h"
+#include "registry.h"
+#include "command_buffer.h"
+#include "transform_hierarchy.h"
 
 namespace overdrive {
+	/*
+		Owns the entity/component registry and the transform hierarchy. Structural changes that were
+		recorded in the registry's command buffer are applied at the start of every update, after which
+		the world transforms of modified nodes are brought up to date.
+	*/
 	class Scene:
 		public core::System
 	{
@@ -13,7 +21,29 @@ namespace overdrive {
 		virtual void update() override;
 		virtual void shutdown() override;
 
-	private:
+		scene::EntityHandle createEntity();
+		void destroyEntity(scene::EntityHandle handle);
+		scene::Entity* getEntity(scene::EntityHandle handle) const; // nullptr if the handle is stale
+
+		template <typename... tComponents>
+		scene::View<tComponents...> view();
+
+		// spreads the query over the engine's job system and waits for it to complete
+		template <typename tFunction, typename... tComponents>
+		void parallelForEach(
+			const scene::View<tComponents...>& query,
+			tFunction fn,
+			size_t minBatchSize = scene::Registry::DEFAULT_MIN_BATCH_SIZE
+		);
 
+		scene::Registry& getRegistry();
+		scene::CommandBuffer& getCommandBuffer();
+		scene::TransformHierarchy& getTransforms();
+
+	private:
+		scene::Registry mRegistry;
+		scene::TransformHierarchy mTransforms;
 	};
 }
+
+#include "scene.inl"
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "scene.h"
+#include "../core/engine.h"
+
+namespace overdrive {
+	template <typename... tComponents>
+	scene::View<tComponents...> Scene::view() {
+		return mRegistry.view<tComponents...>();
+	}
+
+	template <typename tFunction, typename... tComponents>
+	void Scene::parallelForEach(
+		const scene::View<tComponents...>& query,
+		tFunction fn,
+		size_t minBatchSize
+	) {
+		auto& jobSystem = mEngine->getJobSystem();
+		jobSystem.wait(mRegistry.parallelForEach(jobSystem, query, std::move(fn), minBatchSize));
+	}
+}
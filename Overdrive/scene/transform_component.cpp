@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "transform_component.h"
+#include "../math/simd.h"
 
 namespace overdrive {
 	namespace scene {
@@ -43,11 +44,8 @@ namespace overdrive {
 
 		const glm::mat4& TransformComponent::getTransform() {
 			if (mDirty) {
-				auto rotationMatrix = glm::mat4_cast(mOrientation);
-				auto translationMatrix = glm::translate(mPosition);
-				auto scaleMatrix = glm::scale(mScale);
-
-				mTransform = scaleMatrix * rotationMatrix * translationMatrix;
+				math::compose(mPosition, mOrientation, mScale, mTransform); // translation * rotation * scale
+				mDirty = false;
 			}
 			
 			return mTransform;
@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "transform_hierarchy.h"
+#include "../math/simd.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace overdrive {
+	namespace scene {
+		namespace {
+			template <typename T>
+			void permute(std::vector<T>& values, const std::vector<uint32_t>& order) {
+				std::vector<T> result;
+				result.reserve(order.size());
+
+				for (auto index : order)
+					result.push_back(values[index]);
+
+				values.swap(result);
+			}
+		}
+
+		const TransformHierarchy::NodeID TransformHierarchy::NONE;
+
+		TransformHierarchy::TransformHierarchy():
+			mIsOrdered(true),
+			mIsDirty(false),
+			mNumUpdated(0)
+		{
+		}
+
+		TransformHierarchy::NodeID TransformHierarchy::create(NodeID parent) {
+			NodeID result;
+
+			if (mFreeNodes.empty()) {
+				result = static_cast<NodeID>(mIndexOf.size());
+				mIndexOf.push_back(NONE);
+			}
+			else {
+				result = mFreeNodes.back();
+				mFreeNodes.pop_back();
+			}
+
+			uint32_t parentIndex = (parent == NONE) ? NONE : getIndex(parent);
+			uint32_t index = static_cast<uint32_t>(mNode.size());
+
+			mIndexOf[result] = index;
+
+			mNode.push_back(result);
+			mParentNode.push_back(parent);
+			mParent.push_back(parentIndex);
+			mPosition.push_back(glm::vec3(0.0f));
+			mOrientation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+			mScale.push_back(glm::vec3(1.0f));
+			mLocal.push_back(glm::mat4());
+			mWorld.push_back(glm::mat4());
+			mDirty.push_back(0);
+
+			markDirty(index);
+
+			// appending after the parent keeps parents in front, but not the breadth-first order
+			if (parent != NONE)
+				mIsOrdered = false;
+
+			return result;
+		}
+
+		void TransformHierarchy::destroy(NodeID node) {
+			restoreOrder();
+
+			uint32_t first = getIndex(node);
+
+			// descendants are stored after their ancestors, so a single forward scan finds the whole subtree
+			std::vector<bool> isRemoved(mNode.size(), false);
+			isRemoved[first] = true;
+
+			for (size_t i = first + 1; i < mNode.size(); ++i)
+				if ((mParent[i] != NONE) && isRemoved[mParent[i]])
+					isRemoved[i] = true;
+
+			std::vector<uint32_t> order;
+			order.reserve(mNode.size());
+
+			for (uint32_t i = 0; i < mNode.size(); ++i) {
+				if (isRemoved[i]) {
+					mIndexOf[mNode[i]] = NONE;
+					mFreeNodes.push_back(mNode[i]);
+				}
+				else
+					order.push_back(i);
+			}
+
+			permute(mNode, order);
+			permute(mParentNode, order);
+			permute(mPosition, order);
+			permute(mOrientation, order);
+			permute(mScale, order);
+			permute(mLocal, order);
+			permute(mWorld, order);
+			permute(mDirty, order);
+
+			mParent.resize(mNode.size());
+
+			for (uint32_t i = 0; i < mNode.size(); ++i) {
+				mIndexOf[mNode[i]] = i;
+				mParent[i] = (mParentNode[i] == NONE) ? NONE : mIndexOf[mParentNode[i]];
+			}
+		}
+
+		void TransformHierarchy::setParent(NodeID node, NodeID parent) {
+			uint32_t index = getIndex(node);
+
+			// make sure we're not creating a cycle
+			for (NodeID ancestor = parent; ancestor != NONE; ancestor = mParentNode[getIndex(ancestor)])
+				if (ancestor == node)
+					throw std::runtime_error("Cannot parent a transform to one of its descendants");
+
+			mParentNode[index] = parent;
+			mParent[index] = (parent == NONE) ? NONE : getIndex(parent);
+
+			markDirty(index);
+			mIsOrdered = false;
+		}
+
+		TransformHierarchy::NodeID TransformHierarchy::getParent(NodeID node) const {
+			return mParentNode[getIndex(node)];
+		}
+
+		void TransformHierarchy::setPosition(NodeID node, const glm::vec3& position) {
+			uint32_t index = getIndex(node);
+
+			mPosition[index] = position;
+			markDirty(index);
+		}
+
+		void TransformHierarchy::setOrientation(NodeID node, const glm::quat& orientation) {
+			uint32_t index = getIndex(node);
+
+			mOrientation[index] = orientation;
+			markDirty(index);
+		}
+
+		void TransformHierarchy::setScale(NodeID node, const glm::vec3& scale) {
+			uint32_t index = getIndex(node);
+
+			mScale[index] = scale;
+			markDirty(index);
+		}
+
+		const glm::vec3& TransformHierarchy::getPosition(NodeID node) const {
+			return mPosition[getIndex(node)];
+		}
+
+		const glm::quat& TransformHierarchy::getOrientation(NodeID node) const {
+			return mOrientation[getIndex(node)];
+		}
+
+		const glm::vec3& TransformHierarchy::getScale(NodeID node) const {
+			return mScale[getIndex(node)];
+		}
+
+		const glm::mat4& TransformHierarchy::getLocalTransform(NodeID node) const {
+			return mLocal[getIndex(node)];
+		}
+
+		const glm::mat4& TransformHierarchy::getWorldTransform(NodeID node) const {
+			return mWorld[getIndex(node)];
+		}
+
+		void TransformHierarchy::update() {
+			restoreOrder();
+
+			mNumUpdated = 0;
+
+			if (!mIsDirty)
+				return;
+
+			size_t numNodes = mNode.size();
+
+			for (size_t i = 0; i < numNodes; ++i) {
+				uint32_t parent = mParent[i];
+				uint8_t flags = mDirty[i];
+
+				// pick up changes from the parent (which has already been processed)
+				if ((parent != NONE) && (mDirty[parent] & WORLD_DIRTY))
+					flags |= WORLD_DIRTY;
+
+				if (!flags)
+					continue;
+
+				if (flags & LOCAL_DIRTY)
+					math::compose(mPosition[i], mOrientation[i], mScale[i], mLocal[i]);
+
+				if (parent == NONE)
+					mWorld[i] = mLocal[i];
+				else
+					math::multiply(mWorld[parent], mLocal[i], mWorld[i]);
+
+				mDirty[i] = flags;
+				++mNumUpdated;
+			}
+
+			std::memset(mDirty.data(), 0, mDirty.size());
+			mIsDirty = false;
+		}
+
+		bool TransformHierarchy::isValid(NodeID node) const {
+			return
+				(node < mIndexOf.size()) &&
+				(mIndexOf[node] != NONE);
+		}
+
+		size_t TransformHierarchy::getNumNodes() const {
+			return mNode.size();
+		}
+
+		size_t TransformHierarchy::getNumUpdated() const {
+			return mNumUpdated;
+		}
+
+		uint32_t TransformHierarchy::getIndex(NodeID node) const {
+			if (!isValid(node))
+				throw std::runtime_error("Invalid transform node");
+
+			return mIndexOf[node];
+		}
+
+		void TransformHierarchy::markDirty(uint32_t index) {
+			mDirty[index] = LOCAL_DIRTY | WORLD_DIRTY;
+			mIsDirty = true;
+		}
+
+		void TransformHierarchy::restoreOrder() {
+			if (mIsOrdered)
+				return;
+
+			size_t numNodes = mNode.size();
+
+			// depth per storage index; parents may currently come after their children
+			std::vector<uint32_t> depth(numNodes, NONE);
+
+			for (uint32_t i = 0; i < numNodes; ++i) {
+				uint32_t current = i;
+				uint32_t d = 0;
+
+				while ((depth[current] == NONE) && (mParent[current] != NONE)) {
+					current = mParent[current];
+					++d;
+				}
+
+				uint32_t base = (depth[current] == NONE) ? 0 : depth[current];
+
+				// write back along the chain so every node is only walked once
+				for (uint32_t j = i; depth[j] == NONE; j = mParent[j]) {
+					depth[j] = base + d--;
+
+					if (mParent[j] == NONE)
+						break;
+				}
+			}
+
+			std::vector<uint32_t> order(numNodes);
+			std::iota(order.begin(), order.end(), 0);
+
+			std::stable_sort(order.begin(), order.end(), [&depth](uint32_t a, uint32_t b) {
+				return depth[a] < depth[b];
+			});
+
+			permute(mNode, order);
+			permute(mParentNode, order);
+			permute(mPosition, order);
+			permute(mOrientation, order);
+			permute(mScale, order);
+			permute(mLocal, order);
+			permute(mWorld, order);
+			permute(mDirty, order);
+
+			for (uint32_t i = 0; i < numNodes; ++i)
+				mIndexOf[mNode[i]] = i;
+
+			for (uint32_t i = 0; i < numNodes; ++i)
+				mParent[i] = (mParentNode[i] == NONE) ? NONE : mIndexOf[mParentNode[i]];
+
+			mIsOrdered = true;
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "../opengl.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace overdrive {
+	namespace scene {
+		/*
+			Parent/child transforms, stored breadth-first in flat arrays (one per attribute). Because every
+			parent comes before its children, update() is a single linear pass: a node is recomputed when it
+			was modified itself or when its parent's world transform changed during the same pass. Clean
+			subtrees are skipped entirely.
+
+			Nodes are referred to by a stable NodeID; the storage order is restored lazily (on the next update)
+			when nodes are added, removed or reparented.
+
+			[NOTE] world transforms reflect the state as of the last update()
+		*/
+		class TransformHierarchy {
+		public:
+			typedef uint32_t NodeID;
+			static const NodeID NONE = 0xFFFFFFFF;
+
+			TransformHierarchy();
+
+			NodeID create(NodeID parent = NONE);
+			void destroy(NodeID node); // also destroys all descendants
+
+			void setParent(NodeID node, NodeID parent);
+			NodeID getParent(NodeID node) const;
+
+			void setPosition(NodeID node, const glm::vec3& position);
+			void setOrientation(NodeID node, const glm::quat& orientation);
+			void setScale(NodeID node, const glm::vec3& scale);
+
+			const glm::vec3& getPosition(NodeID node) const;
+			const glm::quat& getOrientation(NodeID node) const;
+			const glm::vec3& getScale(NodeID node) const;
+
+			const glm::mat4& getLocalTransform(NodeID node) const;
+			const glm::mat4& getWorldTransform(NodeID node) const;
+
+			void update();
+
+			bool isValid(NodeID node) const;
+			size_t getNumNodes() const;
+			size_t getNumUpdated() const; // during the last update
+
+		private:
+			enum eDirtyFlags: uint8_t {
+				LOCAL_DIRTY = 1, // the node's own position/orientation/scale changed
+				WORLD_DIRTY = 2	 // the world transform needs to be recomputed
+			};
+
+			uint32_t getIndex(NodeID node) const; // throws on an invalid node
+			void markDirty(uint32_t index);
+			void restoreOrder();
+
+			// node-indexed
+			std::vector<uint32_t> mIndexOf; // NONE for unused ids
+			std::vector<NodeID> mFreeNodes;
+
+			// storage, in breadth-first order
+			std::vector<NodeID> mNode;
+			std::vector<NodeID> mParentNode;
+			std::vector<uint32_t> mParent; // storage index of the parent, NONE for roots
+			std::vector<glm::vec3> mPosition;
+			std::vector<glm::quat> mOrientation;
+			std::vector<glm::vec3> mScale;
+			std::vector<glm::mat4> mLocal;
+			std::vector<glm::mat4> mWorld;
+			std::vector<uint8_t> mDirty;
+
+			bool mIsOrdered;
+			bool mIsDirty;
+			size_t mNumUpdated;
+		};
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "archetype.h"
+#include "component_type.h"
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace overdrive {
+	namespace core {
+		class System;
+	}
+
+	namespace scene {
+		class Registry;
+
+		// a range of rows within a single chunk, the unit of work for parallel iteration
+		struct ChunkRange {
+			Archetype* mArchetype;
+			size_t mChunk;
+			size_t mBegin;
+			size_t mEnd;
+		};
+
+		/*
+			All entities that have (at least) the requested components. Iteration walks the matching archetypes
+			chunk by chunk, handing out pointers into the component columns, so the inner loops are linear
+			over contiguous memory.
+
+			Components that are only read should be requested as const, this is used to figure out which
+			queries can run concurrently.
+
+			[NOTE] a view is a snapshot of the matching archetypes; don't make structural changes while iterating
+		*/
+		template <typename... tComponents>
+		class View {
+		public:
+			static_assert(sizeof...(tComponents) > 0, "A view needs at least one component type");
+
+			explicit View(Registry* registry);
+
+			template <typename tFunction>
+			void forEach(tFunction&& fn); // fn(tComponents&...)
+
+			template <typename tFunction>
+			void forEachWithEntity(tFunction&& fn); // fn(EntityHandle, tComponents&...)
+
+			template <typename tFunction>
+			void forEachChunk(tFunction&& fn); // fn(size_t count, const EntityHandle* entities, tComponents*... columns)
+
+			template <typename tFunction>
+			static void forEachInRange(tFunction& fn, const ChunkRange& range); // fn(tComponents&...)
+
+			void getRanges(size_t maxRows, std::vector<ChunkRange>& result) const; // splits every chunk into ranges of at most maxRows
+
+			size_t getNumEntities() const;
+			const std::vector<Archetype*>& getArchetypes() const;
+
+			static ComponentMask getMask();		 // every component in the query
+			static ComponentMask getReadMask();	 // the const components
+			static ComponentMask getWriteMask(); // the non-const components
+
+			static void declareAccess(core::System& system); // registers the components with the frame graph (by type name)
+
+		private:
+			typedef std::array<size_t, sizeof...(tComponents)> Columns;
+			typedef std::index_sequence_for<tComponents...> Indices;
+
+			template <typename tFunction, size_t... tIndices>
+			static void invokeChunk(
+				tFunction& fn,
+				Archetype* archetype,
+				size_t chunk,
+				const Columns& columns,
+				std::index_sequence<tIndices...>
+			);
+
+			template <typename tFunction, size_t... tIndices>
+			static void invokeRange(
+				tFunction& fn,
+				const ChunkRange& range,
+				const Columns& columns,
+				std::index_sequence<tIndices...>
+			);
+
+			template <bool tWithEntity, typename tFunction, size_t... tIndices>
+			static void invokeRows(
+				tFunction& fn,
+				Archetype* archetype,
+				size_t chunk,
+				const Columns& columns,
+				std::index_sequence<tIndices...>
+			);
+
+			static Columns getColumns(const Archetype* archetype);
+
+			std::vector<Archetype*> mArchetypes;
+		};
+	}
+}
+
+#include "view.inl"
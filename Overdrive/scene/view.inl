@@ -0,0 +1,199 @@
+#pragma once
+
+#include "view.h"
+#include "registry.h"
+#include "../core/system.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace overdrive {
+	namespace scene {
+		namespace detail {
+			// calls fn with or without the entity handle up front, so forEach and forEachWithEntity can share the loop
+			template <bool tWithEntity>
+			struct RowInvoker;
+
+			template <>
+			struct RowInvoker<true> {
+				template <typename tFunction, typename... tComponents>
+				static void invoke(tFunction& fn, size_t count, const EntityHandle* entities, tComponents*... columns) {
+					for (size_t i = 0; i < count; ++i)
+						fn(entities[i], columns[i]...);
+				}
+			};
+
+			template <>
+			struct RowInvoker<false> {
+				template <typename tFunction, typename... tComponents>
+				static void invoke(tFunction& fn, size_t count, const EntityHandle*, tComponents*... columns) {
+					for (size_t i = 0; i < count; ++i)
+						fn(columns[i]...);
+				}
+			};
+		}
+
+		template <typename... tComponents>
+		View<tComponents...>::View(Registry* registry) {
+			registry->getMatchingArchetypes(getMask(), mArchetypes);
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction>
+		void View<tComponents...>::forEach(tFunction&& fn) {
+			for (auto archetype : mArchetypes) {
+				Columns columns = getColumns(archetype);
+
+				for (size_t chunk = 0; chunk < archetype->getNumChunks(); ++chunk)
+					invokeRows<false>(fn, archetype, chunk, columns, Indices());
+			}
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction>
+		void View<tComponents...>::forEachWithEntity(tFunction&& fn) {
+			for (auto archetype : mArchetypes) {
+				Columns columns = getColumns(archetype);
+
+				for (size_t chunk = 0; chunk < archetype->getNumChunks(); ++chunk)
+					invokeRows<true>(fn, archetype, chunk, columns, Indices());
+			}
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction>
+		void View<tComponents...>::forEachChunk(tFunction&& fn) {
+			for (auto archetype : mArchetypes) {
+				Columns columns = getColumns(archetype);
+
+				for (size_t chunk = 0; chunk < archetype->getNumChunks(); ++chunk)
+					invokeChunk(fn, archetype, chunk, columns, Indices());
+			}
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction>
+		void View<tComponents...>::forEachInRange(tFunction& fn, const ChunkRange& range) {
+			invokeRange(fn, range, getColumns(range.mArchetype), Indices());
+		}
+
+		template <typename... tComponents>
+		void View<tComponents...>::getRanges(size_t maxRows, std::vector<ChunkRange>& result) const {
+			for (auto archetype : mArchetypes) {
+				for (size_t chunk = 0; chunk < archetype->getNumChunks(); ++chunk) {
+					size_t count = archetype->getChunkSize(chunk);
+
+					for (size_t begin = 0; begin < count; begin += maxRows)
+						result.push_back(ChunkRange{ archetype, chunk, begin, std::min(begin + maxRows, count) });
+				}
+			}
+		}
+
+		template <typename... tComponents>
+		size_t View<tComponents...>::getNumEntities() const {
+			size_t result = 0;
+
+			for (auto archetype : mArchetypes)
+				result += archetype->getNumEntities();
+
+			return result;
+		}
+
+		template <typename... tComponents>
+		const std::vector<Archetype*>& View<tComponents...>::getArchetypes() const {
+			return mArchetypes;
+		}
+
+		template <typename... tComponents>
+		ComponentMask View<tComponents...>::getMask() {
+			return makeComponentMask<tComponents...>();
+		}
+
+		template <typename... tComponents>
+		ComponentMask View<tComponents...>::getReadMask() {
+			ComponentMask result;
+
+			int expand[] = { 0, (std::is_const<tComponents>::value ? (result.set(getComponentTypeID<tComponents>()), 0) : 0)... };
+			(void)expand;
+
+			return result;
+		}
+
+		template <typename... tComponents>
+		ComponentMask View<tComponents...>::getWriteMask() {
+			ComponentMask result;
+
+			int expand[] = { 0, (std::is_const<tComponents>::value ? 0 : (result.set(getComponentTypeID<tComponents>()), 0))... };
+			(void)expand;
+
+			return result;
+		}
+
+		template <typename... tComponents>
+		void View<tComponents...>::declareAccess(core::System& system) {
+			ComponentMask writes = getWriteMask();
+			ComponentMask all = getMask();
+
+			for (ComponentTypeID i = 0; i < MAX_COMPONENT_TYPES; ++i) {
+				if (writes.test(i))
+					system.addWrite(getComponentInfo(i).mName);
+				else if (all.test(i))
+					system.addRead(getComponentInfo(i).mName);
+			}
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction, size_t... tIndices>
+		void View<tComponents...>::invokeChunk(
+			tFunction& fn,
+			Archetype* archetype,
+			size_t chunk,
+			const Columns& columns,
+			std::index_sequence<tIndices...>
+		) {
+			fn(
+				archetype->getChunkSize(chunk),
+				static_cast<const EntityHandle*>(archetype->getEntities(chunk)),
+				static_cast<tComponents*>(archetype->getColumnData(columns[tIndices], chunk))...
+			);
+		}
+
+		template <typename... tComponents>
+		template <typename tFunction, size_t... tIndices>
+		void View<tComponents...>::invokeRange(
+			tFunction& fn,
+			const ChunkRange& range,
+			const Columns& columns,
+			std::index_sequence<tIndices...>
+		) {
+			detail::RowInvoker<false>::invoke(
+				fn,
+				range.mEnd - range.mBegin,
+				range.mArchetype->getEntities(range.mChunk) + range.mBegin,
+				static_cast<tComponents*>(range.mArchetype->getColumnData(columns[tIndices], range.mChunk)) + range.mBegin...
+			);
+		}
+
+		template <typename... tComponents>
+		template <bool tWithEntity, typename tFunction, size_t... tIndices>
+		void View<tComponents...>::invokeRows(
+			tFunction& fn,
+			Archetype* archetype,
+			size_t chunk,
+			const Columns& columns,
+			std::index_sequence<tIndices...>
+		) {
+			detail::RowInvoker<tWithEntity>::invoke(
+				fn,
+				archetype->getChunkSize(chunk),
+				archetype->getEntities(chunk),
+				static_cast<tComponents*>(archetype->getColumnData(columns[tIndices], chunk))...
+			);
+		}
+
+		template <typename... tComponents>
+		typename View<tComponents...>::Columns View<tComponents...>::getColumns(const Archetype* archetype) {
+			Columns result = {{ archetype->getColumn(getComponentTypeID<tComponents>())... }};
+			return result;
+		}
+	}
+}
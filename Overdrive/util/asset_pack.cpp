@@ -0,0 +1,480 @@
+#include "stdafx.h"
+#include "asset_pack.h"
+#include "exception.h"
+#include "lz4.h"
+#include "../core/logger.h"
+#include <cstring>
+#include <fstream>
+
+namespace overdrive {
+	namespace util {
+		namespace {
+			const uint32_t PACK_MAGIC = 0x5041444F; // 'ODAP'
+			const uint32_t PACK_VERSION = 1;
+			const uint32_t EMPTY_SLOT = 0xFFFFFFFF;
+
+			const uint32_t FLAG_COMPRESSED = 0x1; // LZ4 block
+
+			struct FileHeader {
+				uint32_t mMagic;
+				uint32_t mVersion;
+				uint32_t mNumEntries;
+				uint32_t mNumSlots;		// power of two, at least twice the number of entries
+				uint64_t mEntriesOffset;
+				uint64_t mSlotsOffset;
+				uint64_t mNamesOffset;
+				uint64_t mNamesSize;
+			};
+
+			struct FileEntry {
+				uint64_t mHash;
+				uint64_t mOffset;		// from the start of the file
+				uint64_t mSize;			// as stored
+				uint64_t mOriginalSize;	// after decompression
+				uint32_t mNameOffset;	// in the names block
+				uint32_t mNameLength;
+				uint32_t mFlags;
+				uint32_t mReserved;
+			};
+
+			char normalize(char c) {
+				return (c == '\\') ? '/' : c;
+			}
+
+			// FNV-1a (same as hashBytes), with normalized separators
+			uint64_t hashName(const char* name, size_t length) {
+				uint64_t hash = 14695981039346656037ull;
+
+				for (size_t i = 0; i < length; ++i)
+					hash = (hash ^ static_cast<uint8_t>(normalize(name[i]))) * 1099511628211ull;
+
+				return hash;
+			}
+
+			bool equalNames(const char* a, const char* b, size_t length) {
+				for (size_t i = 0; i < length; ++i)
+					if (normalize(a[i]) != normalize(b[i]))
+						return false;
+
+				return true;
+			}
+
+			uint32_t getNumSlots(size_t numEntries) {
+				uint32_t result = 1;
+
+				while (result < numEntries * 2)
+					result *= 2;
+
+				return result;
+			}
+
+			uint64_t alignUp(uint64_t value, uint64_t alignment) {
+				return (value + alignment - 1) & ~(alignment - 1);
+			}
+
+			const FileEntry* toEntry(const void* entry) {
+				return static_cast<const FileEntry*>(entry);
+			}
+		}
+
+		// ----- AssetView -----
+		bool AssetView::isValid() const {
+			return (mData != nullptr);
+		}
+
+		const char* AssetView::getChars() const {
+			return reinterpret_cast<const char*>(mData);
+		}
+
+		// ----- AssetPack -----
+		AssetPack::AssetPack():
+			mNumEntries(0),
+			mNumSlots(0),
+			mEntries(nullptr),
+			mSlots(nullptr),
+			mNames(nullptr)
+		{
+		}
+
+		AssetPack::AssetPack(const boost::filesystem::path& p):
+			AssetPack()
+		{
+			open(p);
+		}
+
+		AssetPack::AssetPack(AssetPack&& pack):
+			mFile(std::move(pack.mFile)),
+			mNumEntries(pack.mNumEntries),
+			mNumSlots(pack.mNumSlots),
+			mEntries(pack.mEntries),
+			mSlots(pack.mSlots),
+			mNames(pack.mNames)
+		{
+			pack.close();
+		}
+
+		AssetPack& AssetPack::operator = (AssetPack&& pack) {
+			mFile = std::move(pack.mFile);
+			mNumEntries = pack.mNumEntries;
+			mNumSlots = pack.mNumSlots;
+			mEntries = pack.mEntries;
+			mSlots = pack.mSlots;
+			mNames = pack.mNames;
+
+			pack.close();
+
+			return *this;
+		}
+
+		void AssetPack::open(const boost::filesystem::path& p) {
+			close();
+
+			mFile.open(p);
+
+			const uint8_t* base = mFile.getData();
+			size_t numBytes = mFile.getSize();
+
+			if (numBytes < sizeof(FileHeader)) {
+				gLogError << "Not an asset pack: " << p;
+				close();
+				throw UnsupportedFormatException();
+			}
+
+			const FileHeader* header = reinterpret_cast<const FileHeader*>(base);
+
+			if (header->mMagic != PACK_MAGIC) {
+				gLogError << "Not an asset pack: " << p;
+				close();
+				throw UnsupportedFormatException();
+			}
+
+			if (header->mVersion != PACK_VERSION) {
+				gLogError << "Asset pack " << p << " has version " << header->mVersion << ", expected " << PACK_VERSION;
+				close();
+				throw VersionException();
+			}
+
+			// the tables are trusted after this, so make sure they're inside the file
+			if (
+				(header->mNumSlots == 0) ||
+				((header->mNumSlots & (header->mNumSlots - 1)) != 0) ||
+				(header->mEntriesOffset + header->mNumEntries * sizeof(FileEntry) > numBytes) ||
+				(header->mSlotsOffset + header->mNumSlots * sizeof(uint32_t) > numBytes) ||
+				(header->mNamesOffset + header->mNamesSize > numBytes)
+			) {
+				gLogError << "Asset pack " << p << " is corrupt";
+				close();
+				throw UnsupportedFormatException();
+			}
+
+			mNumEntries = header->mNumEntries;
+			mNumSlots = header->mNumSlots;
+			mEntries = base + header->mEntriesOffset;
+			mSlots = reinterpret_cast<const uint32_t*>(base + header->mSlotsOffset);
+			mNames = reinterpret_cast<const char*>(base + header->mNamesOffset);
+
+			const FileEntry* entries = toEntry(mEntries);
+
+			for (uint32_t i = 0; i < mNumEntries; ++i) {
+				const FileEntry& entry = entries[i];
+
+				if (
+					(entry.mOffset + entry.mSize > numBytes) ||
+					(entry.mNameOffset + entry.mNameLength > header->mNamesSize)
+				) {
+					gLogError << "Asset pack " << p << " is corrupt";
+					close();
+					throw UnsupportedFormatException();
+				}
+			}
+		}
+
+		void AssetPack::close() {
+			mFile.close();
+
+			mNumEntries = 0;
+			mNumSlots = 0;
+			mEntries = nullptr;
+			mSlots = nullptr;
+			mNames = nullptr;
+		}
+
+		bool AssetPack::isOpen() const {
+			return mFile.isOpen();
+		}
+
+		size_t AssetPack::getNumAssets() const {
+			return mNumEntries;
+		}
+
+		std::vector<std::string> AssetPack::getNames() const {
+			std::vector<std::string> result;
+			result.reserve(mNumEntries);
+
+			const FileEntry* entries = toEntry(mEntries);
+
+			for (uint32_t i = 0; i < mNumEntries; ++i)
+				result.emplace_back(mNames + entries[i].mNameOffset, entries[i].mNameLength);
+
+			return result;
+		}
+
+		bool AssetPack::contains(const std::string& name) const {
+			return (find(name.data(), name.size()) != nullptr);
+		}
+
+		bool AssetPack::isCompressed(const std::string& name) const {
+			const FileEntry* entry = toEntry(find(name.data(), name.size()));
+
+			return entry && (entry->mFlags & FLAG_COMPRESSED);
+		}
+
+		size_t AssetPack::getSize(const std::string& name) const {
+			const FileEntry* entry = toEntry(find(name.data(), name.size()));
+
+			return entry ? static_cast<size_t>(entry->mOriginalSize) : 0;
+		}
+
+		AssetView AssetPack::view(const std::string& name) const {
+			AssetView result;
+
+			const FileEntry* entry = toEntry(find(name.data(), name.size()));
+
+			if (entry && !(entry->mFlags & FLAG_COMPRESSED)) {
+				result.mData = mFile.getData() + entry->mOffset;
+				result.mSize = static_cast<size_t>(entry->mSize);
+			}
+
+			return result;
+		}
+
+		AssetView AssetPack::read(const std::string& name, std::vector<uint8_t>& buffer) const {
+			const FileEntry* entry = toEntry(find(name.data(), name.size()));
+
+			if (!entry)
+				return AssetView();
+
+			AssetView result;
+
+			if (!(entry->mFlags & FLAG_COMPRESSED)) {
+				result.mData = mFile.getData() + entry->mOffset;
+				result.mSize = static_cast<size_t>(entry->mSize);
+
+				return result;
+			}
+
+			buffer.resize(static_cast<size_t>(entry->mOriginalSize));
+
+			if (!lz4Decompress(
+				mFile.getData() + entry->mOffset,
+				static_cast<size_t>(entry->mSize),
+				buffer.data(),
+				buffer.size()
+			)) {
+				gLogError << "Corrupt asset in pack: " << name;
+				throw UnsupportedFormatException();
+			}
+
+			result.mData = buffer.data();
+			result.mSize = buffer.size();
+
+			return result;
+		}
+
+		const void* AssetPack::find(const char* name, size_t length) const {
+			if (mNumSlots == 0)
+				return nullptr;
+
+			const FileEntry* entries = toEntry(mEntries);
+
+			uint64_t hash = hashName(name, length);
+			uint32_t mask = mNumSlots - 1;
+
+			// linear probing; the table is at most half full, so this ends quickly
+			for (uint32_t i = 0; i < mNumSlots; ++i) {
+				uint32_t index = mSlots[(static_cast<uint32_t>(hash) + i) & mask];
+
+				if ((index == EMPTY_SLOT) || (index >= mNumEntries))
+					return nullptr;
+
+				const FileEntry& entry = entries[index];
+
+				if (
+					(entry.mHash == hash) &&
+					(entry.mNameLength == length) &&
+					equalNames(mNames + entry.mNameOffset, name, length)
+				)
+					return &entry;
+			}
+
+			return nullptr;
+		}
+
+		// ----- AssetPackWriter -----
+		AssetPackWriter::AssetPackWriter(size_t alignment):
+			mAlignment(alignment)
+		{
+			assert((alignment > 0) && ((alignment & (alignment - 1)) == 0));
+		}
+
+		void AssetPackWriter::add(const std::string& name, const void* data, size_t numBytes, bool compress) {
+			Item item;
+
+			item.mName = normalizeAssetName(name);
+			item.mHash = hashName(item.mName.data(), item.mName.size());
+			item.mOriginalSize = numBytes;
+			item.mIsCompressed = false;
+
+			if (compress && (numBytes > 0)) {
+				item.mData.resize(lz4CompressBound(numBytes));
+
+				size_t compressedSize = lz4Compress(data, numBytes, item.mData.data(), item.mData.size());
+
+				if ((compressedSize > 0) && (compressedSize <= numBytes - numBytes / 8)) {
+					item.mData.resize(compressedSize);
+					item.mData.shrink_to_fit();
+					item.mIsCompressed = true;
+				}
+			}
+
+			if (!item.mIsCompressed) {
+				const uint8_t* bytes = static_cast<const uint8_t*>(data);
+				item.mData.assign(bytes, bytes + numBytes);
+			}
+
+			auto it = std::find_if(mItems.begin(), mItems.end(), [&](const Item& x) {
+				return x.mName == item.mName;
+			});
+
+			if (it != mItems.end())
+				*it = std::move(item);
+			else
+				mItems.push_back(std::move(item));
+		}
+
+		void AssetPackWriter::addFile(const std::string& name, const boost::filesystem::path& p, bool compress) {
+			MappedFile file(p);
+
+			add(name, file.getData(), file.getSize(), compress);
+		}
+
+		size_t AssetPackWriter::getNumAssets() const {
+			return mItems.size();
+		}
+
+		size_t AssetPackWriter::getNumBytes() const {
+			size_t result = 0;
+
+			for (const auto& item : mItems)
+				result += item.mData.size();
+
+			return result;
+		}
+
+		size_t AssetPackWriter::getNumOriginalBytes() const {
+			size_t result = 0;
+
+			for (const auto& item : mItems)
+				result += item.mOriginalSize;
+
+			return result;
+		}
+
+		void AssetPackWriter::save(const boost::filesystem::path& p) const {
+			uint32_t numEntries = static_cast<uint32_t>(mItems.size());
+			uint32_t numSlots = getNumSlots(mItems.size());
+
+			// names block
+			std::string names;
+			std::vector<FileEntry> entries(numEntries);
+
+			for (uint32_t i = 0; i < numEntries; ++i) {
+				entries[i].mHash = mItems[i].mHash;
+				entries[i].mSize = mItems[i].mData.size();
+				entries[i].mOriginalSize = mItems[i].mOriginalSize;
+				entries[i].mNameOffset = static_cast<uint32_t>(names.size());
+				entries[i].mNameLength = static_cast<uint32_t>(mItems[i].mName.size());
+				entries[i].mFlags = mItems[i].mIsCompressed ? FLAG_COMPRESSED : 0;
+				entries[i].mReserved = 0;
+
+				names += mItems[i].mName;
+			}
+
+			// slot table
+			std::vector<uint32_t> slots(numSlots, EMPTY_SLOT);
+			uint32_t mask = numSlots - 1;
+
+			for (uint32_t i = 0; i < numEntries; ++i) {
+				uint32_t slot = static_cast<uint32_t>(entries[i].mHash) & mask;
+
+				while (slots[slot] != EMPTY_SLOT)
+					slot = (slot + 1) & mask;
+
+				slots[slot] = i;
+			}
+
+			// offsets
+			FileHeader header;
+
+			header.mMagic = PACK_MAGIC;
+			header.mVersion = PACK_VERSION;
+			header.mNumEntries = numEntries;
+			header.mNumSlots = numSlots;
+			header.mEntriesOffset = sizeof(FileHeader);
+			header.mSlotsOffset = header.mEntriesOffset + numEntries * sizeof(FileEntry);
+			header.mNamesOffset = header.mSlotsOffset + numSlots * sizeof(uint32_t);
+			header.mNamesSize = names.size();
+
+			uint64_t offset = header.mNamesOffset + header.mNamesSize;
+
+			for (auto& entry : entries) {
+				offset = alignUp(offset, mAlignment);
+				entry.mOffset = offset;
+				offset += entry.mSize;
+			}
+
+			boost::filesystem::path temporary = p;
+			temporary += ".tmp";
+
+			{
+				std::ofstream ofs(temporary.c_str(), std::ios::binary | std::ios::trunc);
+
+				if (!ofs.good())
+					throw std::runtime_error("Could not open file for writing");
+
+				ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				ofs.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(FileEntry));
+				ofs.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint32_t));
+				ofs.write(names.data(), names.size());
+
+				uint64_t position = header.mNamesOffset + header.mNamesSize;
+				const char padding[256] = {};
+
+				for (uint32_t i = 0; i < numEntries; ++i) {
+					while (position < entries[i].mOffset) {
+						uint64_t numPadding = std::min<uint64_t>(entries[i].mOffset - position, sizeof(padding));
+
+						ofs.write(padding, numPadding);
+						position += numPadding;
+					}
+
+					ofs.write(reinterpret_cast<const char*>(mItems[i].mData.data()), mItems[i].mData.size());
+					position += mItems[i].mData.size();
+				}
+
+				if (!ofs.good())
+					throw std::runtime_error("Failed to write asset pack");
+			}
+
+			boost::filesystem::rename(temporary, p);
+		}
+
+		std::string normalizeAssetName(const std::string& name) {
+			std::string result(name);
+
+			std::replace(result.begin(), result.end(), '\\', '/');
+
+			return result;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "mapped_file.h"
+#include <boost/filesystem.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace overdrive {
+	namespace util {
+		// a range of bytes inside an AssetPack (or inside a decompression buffer)
+		struct AssetView {
+			const uint8_t* mData = nullptr;
+			size_t mSize = 0;
+
+			bool isValid() const;
+			const char* getChars() const;
+		};
+
+		/*
+			Read-only archive of assets, produced offline by an AssetPackWriter (see the Cooker project).
+			The whole pack is memory mapped when opened; after that, looking up and reading an asset does
+			not involve any system calls.
+
+			File layout:
+				header
+				entry table			(path hash, offset, sizes, flags)
+				slot table			(open addressing on the path hash, power of two size)
+				names				(normalized paths, to resolve hash collisions and for listing)
+				data				(every entry aligned, optionally LZ4 compressed)
+
+			Usage:
+				AssetPack pack("assets.pack");
+
+				if (pack.contains("assets/image/test_pattern_001.png"))
+					auto view = pack.view("assets/image/test_pattern_001.png"); // points into the mapping
+
+			[NOTE] paths are matched as-is, except that '\' and '/' are considered equal
+			[NOTE] views into the pack stay valid for as long as the pack is open
+		*/
+		class AssetPack {
+		public:
+			AssetPack();
+			explicit AssetPack(const boost::filesystem::path& p); // throws if the file can't be mapped or isn't a (current) pack
+
+			AssetPack(const AssetPack&) = delete;
+			AssetPack(AssetPack&& pack);
+			AssetPack& operator = (const AssetPack&) = delete;
+			AssetPack& operator = (AssetPack&& pack);
+
+			void open(const boost::filesystem::path& p);
+			void close();
+
+			bool isOpen() const;
+			size_t getNumAssets() const;
+			std::vector<std::string> getNames() const;
+
+			bool contains(const std::string& name) const;
+			bool isCompressed(const std::string& name) const;
+			size_t getSize(const std::string& name) const; // uncompressed, 0 if the asset is missing
+
+			AssetView view(const std::string& name) const; // zero-copy; invalid if the asset is missing or compressed
+			AssetView read(const std::string& name, std::vector<uint8_t>& buffer) const; // decompresses into buffer if needed, throws on corrupt data
+
+		private:
+			const void* find(const char* name, size_t length) const; // FileEntry, nullptr if missing
+
+			MappedFile mFile;
+
+			uint32_t mNumEntries;
+			uint32_t mNumSlots;
+			const void* mEntries;
+			const uint32_t* mSlots;
+			const char* mNames;
+		};
+
+		/*
+			Collects assets in memory and writes them as a single pack file.
+
+			[NOTE] compressed entries are only kept if that saves at least 1/8th, otherwise they're stored as-is
+			[NOTE] adding the same path twice replaces the first one
+		*/
+		class AssetPackWriter {
+		public:
+			static const size_t DEFAULT_ALIGNMENT = 16;
+
+			explicit AssetPackWriter(size_t alignment = DEFAULT_ALIGNMENT); // must be a power of two
+
+			void add(const std::string& name, const void* data, size_t numBytes, bool compress = false);
+			void addFile(const std::string& name, const boost::filesystem::path& p, bool compress = false);
+
+			size_t getNumAssets() const;
+			size_t getNumBytes() const;			// sum of the (possibly compressed) entries
+			size_t getNumOriginalBytes() const;	// sum of the uncompressed entries
+
+			void save(const boost::filesystem::path& p) const; // throws on failure; writes a temporary file first
+
+		private:
+			struct Item {
+				std::string mName;	// normalized
+				uint64_t mHash;
+				std::vector<uint8_t> mData;
+				size_t mOriginalSize;
+				bool mIsCompressed;
+			};
+
+			size_t mAlignment;
+			std::vector<Item> mItems;
+		};
+
+		std::string normalizeAssetName(const std::string& name); // backslashes become forward slashes
+	}
+}
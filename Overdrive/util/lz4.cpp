@@ -0,0 +1,207 @@
+#include "stdafx.h"
+#include "lz4.h"
+#include <cstring>
+
+namespace overdrive {
+	namespace util {
+		namespace {
+			const size_t MIN_MATCH = 4;
+			const size_t LAST_LITERALS = 5;	// the last 5 bytes are always literals
+			const size_t MF_LIMIT = 12;		// the last match starts at least 12 bytes before the end
+			const size_t MAX_OFFSET = 65535;
+			const int HASH_BITS = 12;
+
+			uint32_t read32(const uint8_t* ptr) {
+				uint32_t result;
+				std::memcpy(&result, ptr, sizeof(result));
+				return result;
+			}
+
+			uint32_t hashSequence(uint32_t sequence) {
+				return (sequence * 2654435761u) >> (32 - HASH_BITS);
+			}
+
+			// lengths that don't fit in the token continue as a series of bytes, 255 means 'more follows'
+			uint8_t* writeLength(uint8_t* ptr, size_t length) {
+				while (length >= 255) {
+					*ptr++ = 255;
+					length -= 255;
+				}
+
+				*ptr++ = static_cast<uint8_t>(length);
+
+				return ptr;
+			}
+
+			bool readLength(const uint8_t*& ptr, const uint8_t* end, size_t& length) {
+				uint8_t value;
+
+				do {
+					if (ptr >= end)
+						return false;
+
+					value = *ptr++;
+					length += value;
+				} while (value == 255);
+
+				return true;
+			}
+
+			uint8_t* writeSequence(
+				uint8_t* ptr,
+				const uint8_t* literals,
+				size_t numLiterals,
+				size_t offset,		// 0 for the last sequence
+				size_t matchLength	// excluding MIN_MATCH
+			) {
+				uint8_t* token = ptr++;
+
+				*token = static_cast<uint8_t>(std::min<size_t>(numLiterals, 15) << 4);
+
+				if (numLiterals >= 15)
+					ptr = writeLength(ptr, numLiterals - 15);
+
+				std::memcpy(ptr, literals, numLiterals);
+				ptr += numLiterals;
+
+				if (offset == 0)
+					return ptr;
+
+				*ptr++ = static_cast<uint8_t>(offset & 0xFF);
+				*ptr++ = static_cast<uint8_t>(offset >> 8);
+
+				*token |= static_cast<uint8_t>(std::min<size_t>(matchLength, 15));
+
+				if (matchLength >= 15)
+					ptr = writeLength(ptr, matchLength - 15);
+
+				return ptr;
+			}
+		}
+
+		size_t lz4CompressBound(size_t numBytes) {
+			return numBytes + (numBytes / 255) + 16;
+		}
+
+		size_t lz4Compress(const void* source, size_t sourceSize, void* destination, size_t destinationCapacity) {
+			if (destinationCapacity < lz4CompressBound(sourceSize))
+				return 0;
+
+			const uint8_t* begin = static_cast<const uint8_t*>(source);
+			const uint8_t* end = begin + sourceSize;
+			const uint8_t* anchor = begin; // start of the pending literals
+
+			uint8_t* output = static_cast<uint8_t*>(destination);
+
+			if (sourceSize > MF_LIMIT) {
+				const uint8_t* matchLimit = end - LAST_LITERALS;
+				const uint8_t* searchLimit = end - MF_LIMIT;
+
+				// last position (relative to begin) where a sequence with a given hash was seen
+				std::vector<uint32_t> table(1 << HASH_BITS, 0);
+
+				const uint8_t* current = begin;
+
+				while (current < searchLimit) {
+					uint32_t sequence = read32(current);
+					uint32_t& slot = table[hashSequence(sequence)];
+					const uint8_t* candidate = begin + slot;
+
+					slot = static_cast<uint32_t>(current - begin);
+
+					if (
+						(candidate >= current) ||
+						(static_cast<size_t>(current - candidate) > MAX_OFFSET) ||
+						(read32(candidate) != sequence)
+					) {
+						++current;
+						continue;
+					}
+
+					const uint8_t* matchEnd = current + MIN_MATCH;
+					const uint8_t* reference = candidate + MIN_MATCH;
+
+					while ((matchEnd < matchLimit) && (*matchEnd == *reference)) {
+						++matchEnd;
+						++reference;
+					}
+
+					output = writeSequence(
+						output,
+						anchor,
+						static_cast<size_t>(current - anchor),
+						static_cast<size_t>(current - candidate),
+						static_cast<size_t>(matchEnd - current) - MIN_MATCH
+					);
+
+					current = matchEnd;
+					anchor = current;
+				}
+			}
+
+			output = writeSequence(output, anchor, static_cast<size_t>(end - anchor), 0, 0);
+
+			return static_cast<size_t>(output - static_cast<uint8_t*>(destination));
+		}
+
+		bool lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize) {
+			const uint8_t* input = static_cast<const uint8_t*>(source);
+			const uint8_t* inputEnd = input + sourceSize;
+
+			uint8_t* begin = static_cast<uint8_t*>(destination);
+			uint8_t* output = begin;
+			uint8_t* outputEnd = begin + destinationSize;
+
+			while (input < inputEnd) {
+				uint8_t token = *input++;
+
+				size_t numLiterals = token >> 4;
+
+				if ((numLiterals == 15) && !readLength(input, inputEnd, numLiterals))
+					return false;
+
+				if (
+					(numLiterals > static_cast<size_t>(inputEnd - input)) ||
+					(numLiterals > static_cast<size_t>(outputEnd - output))
+				)
+					return false;
+
+				std::memcpy(output, input, numLiterals);
+				input += numLiterals;
+				output += numLiterals;
+
+				if (input == inputEnd)
+					break; // the last sequence only has literals
+
+				if (inputEnd - input < 2)
+					return false;
+
+				size_t offset = input[0] | (static_cast<size_t>(input[1]) << 8);
+				input += 2;
+
+				if ((offset == 0) || (offset > static_cast<size_t>(output - begin)))
+					return false;
+
+				size_t matchLength = token & 0x0F;
+
+				if ((matchLength == 15) && !readLength(input, inputEnd, matchLength))
+					return false;
+
+				matchLength += MIN_MATCH;
+
+				if (matchLength > static_cast<size_t>(outputEnd - output))
+					return false;
+
+				// [NOTE] the match may overlap with the output (offset < length repeats a pattern), so copy bytewise
+				const uint8_t* match = output - offset;
+
+				for (size_t i = 0; i < matchLength; ++i)
+					output[i] = match[i];
+
+				output += matchLength;
+			}
+
+			return (output == outputEnd);
+		}
+	}
+}
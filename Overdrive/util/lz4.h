@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace overdrive {
+	namespace util {
+		/*
+			Minimal implementation of the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md),
+			used to compress entries in asset packs. Blocks are compatible with LZ4_compress_default/LZ4_decompress_safe,
+			but there is no frame format and no streaming; the uncompressed size must be stored elsewhere.
+
+			The compressor is a straightforward greedy matcher meant for offline use, the decompressor is
+			the part that runs while loading and validates all offsets and lengths against the buffers.
+		*/
+		size_t lz4CompressBound(size_t numBytes); // worst case size of a compressed block
+
+		// returns the size of the compressed block, or 0 if the destination is smaller than lz4CompressBound
+		size_t lz4Compress(const void* source, size_t sourceSize, void* destination, size_t destinationCapacity);
+
+		// false if the block is malformed or doesn't decompress to exactly destinationSize bytes
+		bool lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize);
+	}
+}
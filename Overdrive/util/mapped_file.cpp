@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "mapped_file.h"
+
+namespace overdrive {
+	namespace util {
+		MappedFile::MappedFile():
+			mData(nullptr),
+			mSize(0),
+			mIsOpen(false)
+		{
+		}
+
+		MappedFile::MappedFile(const boost::filesystem::path& p):
+			MappedFile()
+		{
+			open(p);
+		}
+
+		MappedFile::~MappedFile() {
+			close();
+		}
+
+		MappedFile::MappedFile(MappedFile&& file):
+			mData(file.mData),
+			mSize(file.mSize),
+			mIsOpen(file.mIsOpen)
+		{
+			file.mData = nullptr;
+			file.mSize = 0;
+			file.mIsOpen = false;
+		}
+
+		MappedFile& MappedFile::operator = (MappedFile&& file) {
+			if (this == &file)
+				return *this;
+
+			close();
+
+			mData = file.mData;
+			mSize = file.mSize;
+			mIsOpen = file.mIsOpen;
+
+			file.mData = nullptr;
+			file.mSize = 0;
+			file.mIsOpen = false;
+
+			return *this;
+		}
+
+		void MappedFile::close() {
+			if (mData)
+				unmap();
+
+			mData = nullptr;
+			mSize = 0;
+			mIsOpen = false;
+		}
+
+		bool MappedFile::isOpen() const {
+			return mIsOpen;
+		}
+
+		const uint8_t* MappedFile::getData() const {
+			return mData;
+		}
+
+		const char* MappedFile::getChars() const {
+			return reinterpret_cast<const char*>(mData);
+		}
+
+		size_t MappedFile::getSize() const {
+			return mSize;
+		}
+	}
+}
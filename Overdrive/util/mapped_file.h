@@ -0,0 +1,45 @@
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <cstddef>
+#include <cstdint>
+
+namespace overdrive {
+	namespace util {
+		/*
+			Read-only view of an entire file, mapped into memory (mmap on linux, a file mapping on windows).
+			Reading from it goes straight to the page cache; nothing is copied onto the heap.
+
+			[NOTE] the data stays valid for as long as the MappedFile is open
+			[NOTE] an empty file is open, but has no data
+			[NOTE] the file handles are closed right after mapping, the mapping itself keeps the file alive
+		*/
+		class MappedFile {
+		public:
+			MappedFile();
+			explicit MappedFile(const boost::filesystem::path& p); // throws FileException if the file can't be mapped
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile(MappedFile&& file);
+			MappedFile& operator = (const MappedFile&) = delete;
+			MappedFile& operator = (MappedFile&& file);
+
+			void open(const boost::filesystem::path& p); // closes the current file first
+			void close();
+
+			bool isOpen() const;
+
+			const uint8_t* getData() const;
+			const char* getChars() const; // same as getData
+			size_t getSize() const; // in bytes
+
+		private:
+			void unmap(); // platform-specific
+
+			const uint8_t* mData;
+			size_t mSize;
+			bool mIsOpen;
+		};
+	}
+}
@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "mapped_file.h"
+#include "exception.h"
+#include "../preprocessor.h"
+#include "../core/logger.h"
+
+#if OVERDRIVE_PLATFORM == OVERDRIVE_PLATFORM_LINUX
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace overdrive {
+	namespace util {
+		void MappedFile::open(const boost::filesystem::path& p) {
+			close();
+
+			int fd = ::open(p.c_str(), O_RDONLY);
+
+			if (fd < 0) {
+				gLogError << "Could not open file " << p << ": " << std::strerror(errno);
+				throw FileException();
+			}
+
+			struct stat info;
+
+			if (::fstat(fd, &info) != 0) {
+				gLogError << "Could not query file " << p << ": " << std::strerror(errno);
+				::close(fd);
+				throw FileException();
+			}
+
+			size_t numBytes = static_cast<size_t>(info.st_size);
+
+			if (numBytes > 0) {
+				void* mapping = ::mmap(nullptr, numBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if (mapping == MAP_FAILED) {
+					gLogError << "Could not map file " << p << ": " << std::strerror(errno);
+					::close(fd);
+					throw FileException();
+				}
+
+				// loaders typically read front to back
+				::posix_madvise(mapping, numBytes, POSIX_MADV_SEQUENTIAL);
+
+				mData = static_cast<const uint8_t*>(mapping);
+				mSize = numBytes;
+			}
+
+			::close(fd); // the mapping keeps its own reference
+			mIsOpen = true;
+		}
+
+		void MappedFile::unmap() {
+			::munmap(const_cast<uint8_t*>(mData), mSize);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "mapped_file.h"
+#include "exception.h"
+#include "../preprocessor.h"
+#include "../core/logger.h"
+
+#if OVERDRIVE_PLATFORM == OVERDRIVE_PLATFORM_WINDOWS
+
+#include "exception_windows.h"
+
+namespace overdrive {
+	namespace util {
+		void MappedFile::open(const boost::filesystem::path& p) {
+			close();
+
+			HANDLE file = ::CreateFileW(
+				p.c_str(),
+				GENERIC_READ,
+				FILE_SHARE_READ,
+				nullptr,
+				OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+				nullptr
+			);
+
+			if (file == INVALID_HANDLE_VALUE) {
+				gLogError << "Could not open file " << p << ": " << WinException().what();
+				throw FileException();
+			}
+
+			LARGE_INTEGER numBytes;
+
+			if (!::GetFileSizeEx(file, &numBytes)) {
+				gLogError << "Could not query file " << p << ": " << WinException().what();
+				::CloseHandle(file);
+				throw FileException();
+			}
+
+			if (numBytes.QuadPart > 0) {
+				HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+				if (!mapping) {
+					gLogError << "Could not map file " << p << ": " << WinException().what();
+					::CloseHandle(file);
+					throw FileException();
+				}
+
+				LPVOID view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+				if (!view) {
+					gLogError << "Could not map file " << p << ": " << WinException().what();
+					::CloseHandle(mapping);
+					::CloseHandle(file);
+					throw FileException();
+				}
+
+				// the view keeps its own reference to the mapping (and the file)
+				::CloseHandle(mapping);
+
+				mData = static_cast<const uint8_t*>(view);
+				mSize = static_cast<size_t>(numBytes.QuadPart);
+			}
+
+			::CloseHandle(file);
+			mIsOpen = true;
+		}
+
+		void MappedFile::unmap() {
+			::UnmapViewOfFile(mData);
+		}
+	}
+}
+
+#endif
@@ -6,6 +6,7 @@ namespace overdrive {
 	namespace util {
 		class Spinlock {
 		public:
+			Spinlock() = default;
 			Spinlock(const Spinlock&) = delete;
 			Spinlock& operator = (const Spinlock&) = delete;
 
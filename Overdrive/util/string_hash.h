@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace overdrive {
+	namespace util {
+		// 32-bit FNV-1a; constexpr, so hashes of string literals can be computed at compile time:
+		//		constexpr uint32_t hash = hashString("uModel");
+		// [NOTE] recursive because of the C++11 constexpr rules, this is not meant for long strings
+		constexpr uint32_t hashString(const char* str, uint32_t hash = 2166136261u) {
+			return (*str == '\0') ?
+				hash :
+				hashString(str + 1, (hash ^ static_cast<uint32_t>(static_cast<uint8_t>(*str))) * 16777619u);
+		}
+
+		// 64-bit FNV-1a over arbitrary data, for runtime use; pass the previous result as seed to hash several pieces
+		inline uint64_t hashBytes(const void* data, size_t numBytes, uint64_t hash = 14695981039346656037ull) {
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+			for (size_t i = 0; i < numBytes; ++i)
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+			return hash;
+		}
+	}
+}
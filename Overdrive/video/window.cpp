@@ -4,6 +4,7 @@
 #include "../core/channel.h"
 #include "../input/keyboard.h"
 #include "../input/mouse.h"
+#include "../render/state_cache.h"
 
 // ----- Window Callbacks -----
 namespace {
@@ -281,6 +282,9 @@ namespace overdrive {
 			if (gLastActiveContext != mHandle) {
 				glfwMakeContextCurrent(mHandle);
 				gLastActiveContext = mHandle;
+
+				// whatever the cache knows belongs to the previous context
+				render::StateCache::current().invalidate();
 			}
 		}
 
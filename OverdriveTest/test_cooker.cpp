@@ -0,0 +1,486 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "../Cooker/block_compression.h"
+#include "../Cooker/texture_cooker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace OverdriveTest {
+	namespace {
+		// ----- reference decoders, straight from the BC1/BC4/BC7 specifications -----
+		void decode565(uint16_t value, int color[3]) {
+			int r = (value >> 11) & 31;
+			int g = (value >> 5) & 63;
+			int b = value & 31;
+
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		uint16_t getColor0(const uint8_t* block) {
+			return static_cast<uint16_t>(block[0] | (block[1] << 8));
+		}
+
+		uint16_t getColor1(const uint8_t* block) {
+			return static_cast<uint16_t>(block[2] | (block[3] << 8));
+		}
+
+		int getColorIndex(const uint8_t* block, int texel) {
+			return (block[4 + texel / 4] >> (2 * (texel % 4))) & 3;
+		}
+
+		// writes RGB, leaves alpha alone
+		void decodeBC1(const uint8_t* block, uint8_t texels[64]) {
+			uint16_t color0 = getColor0(block);
+			uint16_t color1 = getColor1(block);
+			int palette[4][3];
+
+			decode565(color0, palette[0]);
+			decode565(color1, palette[1]);
+
+			for (int channel = 0; channel < 3; ++channel) {
+				if (color0 > color1) {
+					palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+					palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+				}
+				else {
+					palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+					palette[3][channel] = 0;
+				}
+			}
+
+			for (int i = 0; i < 16; ++i)
+				for (int channel = 0; channel < 3; ++channel)
+					texels[i * 4 + channel] = static_cast<uint8_t>(palette[getColorIndex(block, i)][channel]);
+		}
+
+		int getAlphaIndex(const uint8_t* block, int texel) {
+			uint64_t bits = 0;
+
+			for (int i = 0; i < 6; ++i)
+				bits |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+
+			return static_cast<int>((bits >> (3 * texel)) & 7);
+		}
+
+		// writes alpha only
+		void decodeBC4(const uint8_t* block, uint8_t texels[64]) {
+			int alpha0 = block[0];
+			int alpha1 = block[1];
+			int palette[8] = { alpha0, alpha1 };
+
+			if (alpha0 > alpha1) {
+				for (int i = 1; i < 7; ++i)
+					palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+			else {
+				for (int i = 1; i < 5; ++i)
+					palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + 3] = static_cast<uint8_t>(palette[getAlphaIndex(block, i)]);
+		}
+
+		class BitReader {
+		public:
+			explicit BitReader(const uint8_t* data):
+				mData(data),
+				mPosition(0)
+			{
+			}
+
+			int read(int numBits) {
+				int result = 0;
+
+				for (int i = 0; i < numBits; ++i, ++mPosition)
+					result |= ((mData[mPosition / 8] >> (mPosition % 8)) & 1) << i;
+
+				return result;
+			}
+
+			int getPosition() const {
+				return mPosition;
+			}
+
+		private:
+			const uint8_t* mData;
+			int mPosition;
+		};
+
+		struct BC7Mode6 {
+			int mMode;				// the 7 mode bits, should be 1 << 6
+			int mEndpoints[2][4];	// including the p-bits
+			int mIndices[16];
+			int mNumBits;			// should be 128
+		};
+
+		BC7Mode6 parseBC7Mode6(const uint8_t* block) {
+			BC7Mode6 result;
+			BitReader reader(block);
+
+			result.mMode = reader.read(7);
+
+			for (int channel = 0; channel < 4; ++channel) {
+				result.mEndpoints[0][channel] = reader.read(7) << 1;
+				result.mEndpoints[1][channel] = reader.read(7) << 1;
+			}
+
+			for (int i = 0; i < 2; ++i) {
+				int pbit = reader.read(1);
+
+				for (int channel = 0; channel < 4; ++channel)
+					result.mEndpoints[i][channel] |= pbit;
+			}
+
+			// the anchor index has an implicit 0 as its most significant bit
+			for (int i = 0; i < 16; ++i)
+				result.mIndices[i] = reader.read((i == 0) ? 3 : 4);
+
+			result.mNumBits = reader.getPosition();
+
+			return result;
+		}
+
+		void decodeBC7Mode6(const uint8_t* block, uint8_t texels[64]) {
+			static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			BC7Mode6 parsed = parseBC7Mode6(block);
+
+			for (int i = 0; i < 16; ++i) {
+				int weight = weights[parsed.mIndices[i]];
+
+				for (int channel = 0; channel < 4; ++channel)
+					texels[i * 4 + channel] = static_cast<uint8_t>(
+						((64 - weight) * parsed.mEndpoints[0][channel] + weight * parsed.mEndpoints[1][channel] + 32) >> 6
+					);
+			}
+		}
+
+		// ----- test data -----
+		int getMaxError(const uint8_t a[64], const uint8_t b[64], int firstChannel, int numChannels) {
+			int result = 0;
+
+			for (int i = 0; i < 16; ++i)
+				for (int channel = firstChannel; channel < firstChannel + numChannels; ++channel)
+					result = std::max(result, std::abs(a[i * 4 + channel] - b[i * 4 + channel]));
+
+			return result;
+		}
+
+		// the largest difference between two texels in any one channel
+		int getMaxRange(const uint8_t texels[64], int firstChannel, int numChannels) {
+			int result = 0;
+
+			for (int channel = firstChannel; channel < firstChannel + numChannels; ++channel) {
+				int minimum = 255;
+				int maximum = 0;
+
+				for (int i = 0; i < 16; ++i) {
+					minimum = std::min<int>(minimum, texels[i * 4 + channel]);
+					maximum = std::max<int>(maximum, texels[i * 4 + channel]);
+				}
+
+				result = std::max(result, maximum - minimum);
+			}
+
+			return result;
+		}
+
+		// a smooth ramp between two random colors (7 steps along the diagonal), plus a little noise
+		void makeGradientBlock(std::mt19937& rng, uint8_t texels[64]) {
+			std::uniform_int_distribution<int> color(0, 255);
+			std::uniform_int_distribution<int> noise(-2, 2);
+
+			int from[4];
+			int to[4];
+
+			for (int channel = 0; channel < 4; ++channel) {
+				from[channel] = color(rng);
+				to[channel] = color(rng);
+			}
+
+			for (int i = 0; i < 16; ++i) {
+				int step = (i % 4) + (i / 4);
+
+				for (int channel = 0; channel < 4; ++channel) {
+					int value = from[channel] + (to[channel] - from[channel]) * step / 6 + noise(rng);
+					texels[i * 4 + channel] = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+				}
+			}
+		}
+
+		float srgbToLinear(int value) {
+			float c = value / 255.0f;
+			return (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+
+		int linearToSrgb(float value) {
+			float c = (value <= 0.0031308f) ? (value * 12.92f) : (1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f);
+			return static_cast<int>(c * 255.0f + 0.5f);
+		}
+	}
+
+	TEST_CLASS(TestCooker) {
+	public:
+		TEST_METHOD(TestBC1) {
+			using overdrive::cooker::compressBlockBC1;
+
+			uint8_t texels[64];
+			uint8_t block[8];
+			uint8_t decoded[64] = {};
+
+			// a red to blue ramp that hits the 4 palette entries exactly, one per column
+			const uint8_t ramp[4][3] = { { 255, 0, 0 }, { 170, 0, 85 }, { 85, 0, 170 }, { 0, 0, 255 } };
+
+			for (int i = 0; i < 16; ++i)
+				for (int channel = 0; channel < 3; ++channel)
+					texels[i * 4 + channel] = ramp[i % 4][channel];
+
+			compressBlockBC1(texels, block);
+			decodeBC1(block, decoded);
+
+			// 4-color mode, with the palette ordered color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+			Assert::IsTrue(getColor0(block) > getColor1(block));
+			Assert::AreEqual(0xF800, static_cast<int>(getColor0(block)));
+			Assert::AreEqual(0x001F, static_cast<int>(getColor1(block)));
+
+			for (int row = 0; row < 4; ++row) {
+				Assert::AreEqual(0, getColorIndex(block, row * 4 + 0));
+				Assert::AreEqual(2, getColorIndex(block, row * 4 + 1));
+				Assert::AreEqual(3, getColorIndex(block, row * 4 + 2));
+				Assert::AreEqual(1, getColorIndex(block, row * 4 + 3));
+			}
+
+			Assert::IsTrue(getMaxError(texels, decoded, 0, 3) <= 1);
+
+			// a solid block is only off by the 5:6:5 quantization
+			for (int i = 0; i < 16; ++i) {
+				texels[i * 4 + 0] = 100;
+				texels[i * 4 + 1] = 150;
+				texels[i * 4 + 2] = 200;
+			}
+
+			compressBlockBC1(texels, block);
+			decodeBC1(block, decoded);
+
+			Assert::IsTrue(getColor0(block) >= getColor1(block));
+			Assert::IsTrue(getMaxError(texels, decoded, 0, 3) <= 4);
+
+			// gradients; with 4 palette entries for 7 steps the error is bounded by 1/6th of the range (plus quantization)
+			std::mt19937 rng(1234);
+			double sumSq = 0.0;
+
+			for (int n = 0; n < 1000; ++n) {
+				makeGradientBlock(rng, texels);
+				compressBlockBC1(texels, block);
+				decodeBC1(block, decoded);
+
+				Assert::IsTrue(getColor0(block) >= getColor1(block));
+				Assert::IsTrue(getMaxError(texels, decoded, 0, 3) <= getMaxRange(texels, 0, 3) / 6 + 8);
+
+				for (int i = 0; i < 64; ++i)
+					if ((i % 4) != 3)
+						sumSq += (texels[i] - decoded[i]) * (texels[i] - decoded[i]);
+			}
+
+			Assert::IsTrue(std::sqrt(sumSq / (1000 * 48)) < 10.0);
+		}
+
+		TEST_METHOD(TestBC3) {
+			using overdrive::cooker::compressBlockBC3;
+
+			uint8_t texels[64] = {};
+			uint8_t block[16];
+			uint8_t decoded[64] = {};
+
+			// alpha values that are exactly the 8 interpolated values between 0 and 224
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + 3] = static_cast<uint8_t>((i % 8) * 32);
+
+			compressBlockBC3(texels, block);
+			decodeBC4(block, decoded);
+
+			// 8-value mode: alpha0 is the maximum (index 0), alpha1 the minimum (index 1), step s in between is index 8 - s
+			Assert::AreEqual(224, static_cast<int>(block[0]));
+			Assert::AreEqual(0, static_cast<int>(block[1]));
+
+			for (int i = 0; i < 16; ++i) {
+				int step = i % 8;
+				int expected = (step == 0) ? 1 : ((step == 7) ? 0 : (8 - step));
+
+				Assert::AreEqual(expected, getAlphaIndex(block, i));
+			}
+
+			Assert::AreEqual(0, getMaxError(texels, decoded, 3, 1));
+
+			// constant alpha
+			for (int i = 0; i < 16; ++i)
+				texels[i * 4 + 3] = 77;
+
+			compressBlockBC3(texels, block);
+			decodeBC4(block, decoded);
+
+			Assert::AreEqual(0, getMaxError(texels, decoded, 3, 1));
+
+			// gradients; the color half is a regular BC1 block
+			std::mt19937 rng(5678);
+
+			for (int n = 0; n < 1000; ++n) {
+				makeGradientBlock(rng, texels);
+				compressBlockBC3(texels, block);
+				decodeBC4(block, decoded);
+				decodeBC1(block + 8, decoded);
+
+				Assert::IsTrue(block[0] >= block[1]);
+				Assert::IsTrue(getMaxError(texels, decoded, 3, 1) <= getMaxRange(texels, 3, 1) / 14 + 2);
+				Assert::IsTrue(getMaxError(texels, decoded, 0, 3) <= getMaxRange(texels, 0, 3) / 6 + 8);
+			}
+		}
+
+		TEST_METHOD(TestBC7) {
+			using overdrive::cooker::compressBlockBC7;
+
+			uint8_t texels[64];
+			uint8_t block[16];
+			uint8_t decoded[64];
+
+			// mode 6 layout: 7 mode bits, 8 x 7 endpoint bits, 2 p-bits, a 3-bit anchor index and 15 4-bit indices
+			std::mt19937 rng(4321);
+			double sumSq = 0.0;
+
+			for (int n = 0; n < 1000; ++n) {
+				makeGradientBlock(rng, texels);
+				compressBlockBC7(texels, block);
+
+				BC7Mode6 parsed = parseBC7Mode6(block);
+
+				Assert::AreEqual(0x40, parsed.mMode);
+				Assert::AreEqual(0x40, static_cast<int>(block[0] & 0x7F));
+				Assert::AreEqual(128, parsed.mNumBits);
+
+				decodeBC7Mode6(block, decoded);
+
+				Assert::IsTrue(getMaxError(texels, decoded, 0, 4) <= getMaxRange(texels, 0, 4) / 30 + 6);
+
+				for (int i = 0; i < 64; ++i)
+					sumSq += (texels[i] - decoded[i]) * (texels[i] - decoded[i]);
+			}
+
+			Assert::IsTrue(std::sqrt(sumSq / (1000 * 64)) < 3.0);
+
+			// the first texel sits at the far end of the ramp, so the endpoints have to be swapped to make room
+			// for the implicit 0 in the anchor index
+			for (int i = 0; i < 16; ++i)
+				for (int channel = 0; channel < 4; ++channel)
+					texels[i * 4 + channel] = static_cast<uint8_t>(240 - i * 15);
+
+			compressBlockBC7(texels, block);
+			decodeBC7Mode6(block, decoded);
+
+			BC7Mode6 parsed = parseBC7Mode6(block);
+
+			Assert::IsTrue(parsed.mEndpoints[0][0] > parsed.mEndpoints[1][0]);
+			Assert::IsTrue(parsed.mIndices[0] < 8);
+			Assert::IsTrue(parsed.mIndices[15] >= 8);
+			Assert::IsTrue(getMaxError(texels, decoded, 0, 4) <= 4);
+
+			// solid blocks only lose the lowest bit at most
+			for (int i = 0; i < 16; ++i) {
+				texels[i * 4 + 0] = 17;
+				texels[i * 4 + 1] = 128;
+				texels[i * 4 + 2] = 201;
+				texels[i * 4 + 3] = 255;
+			}
+
+			compressBlockBC7(texels, block);
+			decodeBC7Mode6(block, decoded);
+
+			Assert::IsTrue(getMaxError(texels, decoded, 0, 4) <= 1);
+		}
+
+		TEST_METHOD(TestMipGeneration) {
+			using overdrive::cooker::generateMipLevel;
+
+			overdrive::core::JobSystem jobSystem(2);
+
+			// 8x2 -> 4x1; red ramps up, green down, blue is black/white per row, alpha ramps up
+			const int width = 8;
+			const int height = 2;
+
+			std::vector<uint8_t> texels(width * height * 4);
+
+			for (int y = 0; y < height; ++y)
+				for (int x = 0; x < width; ++x) {
+					uint8_t* texel = &texels[(y * width + x) * 4];
+
+					texel[0] = static_cast<uint8_t>(x * 36);
+					texel[1] = static_cast<uint8_t>(255 - x * 36);
+					texel[2] = static_cast<uint8_t>(y * 255);
+					texel[3] = static_cast<uint8_t>(x * 36);
+				}
+
+			auto color = generateMipLevel(jobSystem, texels.data(), width, height, true);
+			auto data = generateMipLevel(jobSystem, texels.data(), width, height, false);
+
+			Assert::AreEqual(size_t(4 * 1 * 4), color.size());
+			Assert::AreEqual(size_t(4 * 1 * 4), data.size());
+
+			for (int x = 0; x < 4; ++x) {
+				const uint8_t* a = &texels[(2 * x) * 4];
+				const uint8_t* b = &texels[(2 * x + 1) * 4];
+				const uint8_t* c = &texels[(width + 2 * x) * 4];
+				const uint8_t* d = &texels[(width + 2 * x + 1) * 4];
+
+				for (int channel = 0; channel < 4; ++channel) {
+					float average = (a[channel] + b[channel] + c[channel] + d[channel]) / 4.0f;
+					float linear = 0.25f * (
+						srgbToLinear(a[channel]) +
+						srgbToLinear(b[channel]) +
+						srgbToLinear(c[channel]) +
+						srgbToLinear(d[channel])
+					);
+
+					// color channels are averaged in linear space, alpha and non-color data as is
+					int expected = (channel == 3) ?
+						static_cast<int>(average + 0.5f) :
+						linearToSrgb(linear);
+
+					Assert::IsTrue(std::abs(expected - color[x * 4 + channel]) <= 1);
+					Assert::IsTrue(std::abs(static_cast<int>(average + 0.5f) - data[x * 4 + channel]) <= 1);
+				}
+
+				// black and white average to 188 in sRGB, rather than 128
+				Assert::IsTrue(std::abs(188 - color[x * 4 + 2]) <= 1);
+				Assert::IsTrue(std::abs(128 - data[x * 4 + 2]) <= 1);
+			}
+
+			// odd sizes repeat the last row/column; 1x1 is the end of the chain
+			const uint8_t single[4] = { 10, 20, 30, 40 };
+			auto last = generateMipLevel(jobSystem, single, 1, 1, true);
+
+			Assert::AreEqual(size_t(4), last.size());
+
+			for (int channel = 0; channel < 4; ++channel)
+				Assert::IsTrue(std::abs(single[channel] - last[channel]) <= 1);
+
+			std::vector<uint8_t> odd(3 * 3 * 4, 200);
+			auto oddLevel = generateMipLevel(jobSystem, odd.data(), 3, 3, true);
+
+			Assert::AreEqual(size_t(1 * 1 * 4), oddLevel.size());
+			Assert::IsTrue(std::abs(200 - oddLevel[0]) <= 1);
+		}
+	};
+}
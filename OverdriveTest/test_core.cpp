@@ -1,13 +1,842 @@
 #include "stdafx.h"
 #include "CppUnitTest.h"
 
+#include "../Overdrive/core/channel.h"
+#include "../Overdrive/core/frame_allocator.h"
+#include "../Overdrive/core/job_system.h"
+#include "../Overdrive/core/pool.h"
+#include "../Overdrive/core/resource_cache.h"
+#include "../Overdrive/util/asset_pack.h"
+#include "../Overdrive/util/lz4.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
-namespace OverdriveTest {		
+namespace OverdriveTest {
+	namespace {
+		struct BenchMessage {
+			int mValue;
+		};
+
+		struct BenchHandler {
+			long long mSum = 0;
+
+			void operator()(const BenchMessage& msg) {
+				mSum += msg.mValue;
+			}
+		};
+
+		struct ChangeMessage {
+			int mValue;
+		};
+
+		struct PostMessage {
+			int mSender;
+			int mIndex;
+		};
+
+		struct PostHandler {
+			std::vector<PostMessage> mReceived;
+
+			void operator()(const PostMessage& message) {
+				mReceived.push_back(message);
+			}
+
+			void operator()(const overdrive::core::MessageBatch<PostMessage>& batch) {
+				mReceived.insert(mReceived.end(), batch.begin(), batch.end());
+			}
+		};
+
+		struct IdleHandler {
+			void operator()(const ChangeMessage&) {
+			}
+		};
+
+		// adds and removes another handler from within the broadcast, after giving the main thread time to start a change
+		struct ChangingHandler {
+			std::atomic<bool> mIsBroadcasting{ false };
+			IdleHandler mOther;
+
+			void operator()(const ChangeMessage&) {
+				mIsBroadcasting = true;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+				overdrive::core::Channel::add<ChangeMessage>(&mOther);
+				overdrive::core::Channel::remove<ChangeMessage>(&mOther);
+			}
+		};
+
+		// counts live instances, to check the pool runs every destructor exactly once
+		struct Counted {
+			static std::atomic<int> sNumAlive;
+
+			int mValue;
+
+			explicit Counted(int value):
+				mValue(value)
+			{
+				++sNumAlive;
+			}
+
+			~Counted() {
+				--sNumAlive;
+			}
+		};
+
+		std::atomic<int> Counted::sNumAlive(0);
+
+		struct TestResource {
+			int mValue;
+			size_t mNumBytes;
+		};
+
+		size_t getMemoryUsage(const TestResource& resource) {
+			return resource.mNumBytes;
+		}
+	}
+
 	TEST_CLASS(TestCore) {
 	public:
 		TEST_METHOD(TestLogger) {
 
 		}
+
+		TEST_METHOD(TestAssetPack) {
+			using namespace overdrive::util;
+
+			std::string text;
+			for (int i = 0; i < 200; ++i)
+				text += "uniform mat4 uModel;\n";
+
+			std::vector<uint8_t> binary(1000);
+			for (size_t i = 0; i < binary.size(); ++i)
+				binary[i] = static_cast<uint8_t>((i * 7919) >> 3);
+
+			// lz4 blocks round trip
+			{
+				std::vector<uint8_t> compressed(lz4CompressBound(text.size()));
+				size_t numBytes = lz4Compress(text.data(), text.size(), compressed.data(), compressed.size());
+
+				Assert::IsTrue(numBytes > 0);
+				Assert::IsTrue(numBytes < text.size());
+
+				std::string decompressed(text.size(), '\0');
+				Assert::IsTrue(lz4Decompress(compressed.data(), numBytes, &decompressed[0], decompressed.size()));
+				Assert::IsTrue(decompressed == text);
+
+				// truncated blocks are rejected instead of read past
+				Assert::IsFalse(lz4Decompress(compressed.data(), numBytes / 2, &decompressed[0], decompressed.size()));
+			}
+
+			{
+				AssetPackWriter writer;
+
+				writer.add("shaders/test.frag", text.data(), text.size(), true);
+				writer.add("assets\\image\\test.bin", binary.data(), binary.size());
+
+				for (int i = 0; i < 100; ++i)
+					writer.add("assets/generated/" + std::to_string(i), &i, sizeof(i));
+
+				writer.save("test_asset_pack.pack");
+			}
+
+			{
+				AssetPack pack("test_asset_pack.pack");
+				std::vector<uint8_t> buffer;
+
+				Assert::AreEqual(static_cast<size_t>(102), pack.getNumAssets());
+				Assert::IsFalse(pack.contains("shaders/missing.frag"));
+
+				// compressed entries can't be viewed directly
+				Assert::IsTrue(pack.isCompressed("shaders/test.frag"));
+				Assert::IsFalse(pack.view("shaders/test.frag").isValid());
+
+				auto shader = pack.read("shaders/test.frag", buffer);
+				Assert::IsTrue(std::string(shader.getChars(), shader.mSize) == text);
+
+				// either separator matches
+				auto image = pack.view("assets/image/test.bin");
+				Assert::IsTrue(image.isValid());
+				Assert::AreEqual(binary.size(), image.mSize);
+				Assert::IsTrue(std::equal(binary.begin(), binary.end(), image.mData));
+				Assert::AreEqual(static_cast<size_t>(0), reinterpret_cast<uintptr_t>(image.mData) % AssetPackWriter::DEFAULT_ALIGNMENT);
+
+				for (int i = 0; i < 100; ++i) {
+					auto view = pack.view("assets/generated/" + std::to_string(i));
+
+					Assert::AreEqual(sizeof(int), view.mSize);
+					Assert::AreEqual(i, *reinterpret_cast<const int*>(view.mData));
+				}
+			}
+
+			boost::filesystem::remove("test_asset_pack.pack");
+		}
+
+		TEST_METHOD(TestLinearAllocator) {
+			using overdrive::core::LinearAllocator;
+
+			LinearAllocator allocator(64);
+
+			auto values = allocator.allocate<uint32_t>(4);
+			auto aligned = allocator.allocate(1, 32);
+
+			Assert::AreEqual(static_cast<size_t>(0), reinterpret_cast<uintptr_t>(values) % alignof(uint32_t));
+			Assert::AreEqual(static_cast<size_t>(0), reinterpret_cast<uintptr_t>(aligned) % 32);
+			Assert::IsTrue(allocator.getNumBytesUsed() > 16);
+			Assert::AreEqual(static_cast<size_t>(2), allocator.getStats().mNumAllocations);
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getStats().mNumOverflows);
+
+			// doesn't fit, goes to the heap
+			auto large = static_cast<char*>(allocator.allocate(100));
+			std::fill(large, large + 100, 'x');
+
+			Assert::AreEqual(static_cast<size_t>(1), allocator.getStats().mNumOverflows);
+			Assert::AreEqual(static_cast<size_t>(64), allocator.getCapacity());
+
+			size_t peak = allocator.getStats().mNumBytesAllocated;
+
+			// reset grows the block to fit the peak
+			allocator.reset();
+
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getNumBytesUsed());
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getStats().mNumAllocations);
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getStats().mNumOverflows);
+			Assert::AreEqual(static_cast<size_t>(3), allocator.getStats().mTotalAllocations);
+			Assert::AreEqual(static_cast<size_t>(1), allocator.getStats().mNumResets);
+			Assert::AreEqual(peak, allocator.getStats().mPeakBytes);
+			Assert::IsTrue(allocator.getCapacity() >= peak);
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getCapacity() % 64); // doubled
+
+			allocator.allocate(100);
+
+			Assert::AreEqual(static_cast<size_t>(0), allocator.getStats().mNumOverflows);
+
+			// an empty block grows as well
+			LinearAllocator empty(0);
+
+			empty.allocate(10);
+			empty.reset();
+
+			Assert::IsTrue(empty.getCapacity() >= 10);
+
+			empty.allocate(10);
+
+			Assert::AreEqual(static_cast<size_t>(0), empty.getStats().mNumOverflows);
+		}
+
+		TEST_METHOD(TestFrameAllocator) {
+			using overdrive::core::AllocatorStats;
+			using overdrive::core::FrameAllocator;
+			using overdrive::core::FrameVector;
+
+			// buffered frames
+			{
+				FrameAllocator allocator(64, 2);
+
+				auto first = allocator.allocate<int>(1);
+				*first = 1;
+
+				allocator.nextFrame();
+
+				auto second = allocator.allocate<int>(1);
+				*second = 2;
+
+				Assert::AreEqual(1, *first); // still valid during the next frame
+				Assert::AreEqual(static_cast<size_t>(1), allocator.getStats().mNumAllocations);
+
+				allocator.nextFrame(); // recycles the first frame
+
+				Assert::AreEqual(static_cast<size_t>(0), allocator.getStats().mNumAllocations);
+				Assert::AreEqual(2, *second);
+			}
+
+			// containers
+			{
+				FrameAllocator allocator(1024);
+				FrameVector<int> values(allocator.getResource());
+
+				for (int i = 0; i < 100; ++i)
+					values.push_back(i);
+
+				Assert::AreEqual(99, values.back());
+				Assert::IsTrue(allocator.getStats().mNumAllocations > 0);
+			}
+
+			// per-thread allocators are only advanced by their own thread
+			{
+				std::atomic<int> phase(0);
+				size_t numBefore = 0;
+				size_t numAfterFrame = 0;
+				size_t numAfterFence = 0;
+				int value = 0;
+
+				std::thread owner([&] {
+					auto& allocator = FrameAllocator::local();
+
+					int* shared = allocator.allocate<int>(1);
+					*shared = 42;
+					numBefore = allocator.getStats().mNumAllocations;
+
+					phase = 1;
+
+					while (phase != 2)
+						std::this_thread::yield();
+
+					numAfterFrame = allocator.getStats().mNumAllocations;
+					value = *shared;
+
+					FrameAllocator::fence();
+
+					numAfterFence = allocator.getStats().mNumAllocations;
+				});
+
+				while (phase != 1)
+					std::this_thread::yield();
+
+				FrameAllocator::nextFrameAll();
+				phase = 2;
+
+				owner.join();
+
+				Assert::AreEqual(static_cast<size_t>(1), numBefore);
+				Assert::AreEqual(static_cast<size_t>(1), numAfterFrame);
+				Assert::AreEqual(42, value);
+				Assert::AreEqual(static_cast<size_t>(0), numAfterFence);
+
+				// the owner reported its stats when it was advanced
+				FrameAllocator::nextFrameAll();
+
+				AllocatorStats stats = FrameAllocator::getLastFrameStats();
+				Assert::IsTrue(stats.mTotalAllocations >= 1);
+			}
+		}
+
+		// a job that waits on another job keeps the frame memory of the workers it ran on alive
+		TEST_METHOD(TestFrameAllocatorJobs) {
+			using overdrive::core::FrameAllocator;
+			using overdrive::core::JobHandle;
+			using overdrive::core::JobSystem;
+
+			JobSystem jobs(3);
+
+			std::atomic<bool> isReleased(false);
+			std::atomic<bool> isWaiting(false);
+			std::atomic<bool> isIntact(false);
+
+			JobHandle gate = jobs.schedule([&] {
+				while (!isReleased)
+					std::this_thread::yield();
+			});
+
+			JobHandle job = jobs.schedule([&] {
+				auto& allocator = FrameAllocator::local();
+
+				int* value = allocator.allocate<int>(1);
+				*value = 42;
+
+				isWaiting = true;
+				jobs.wait(gate);
+
+				isIntact = (*value == 42) && (allocator.getStats().mNumAllocations == 1);
+			});
+
+			while (!isWaiting)
+				std::this_thread::yield();
+
+			// let the workers go through their scheduling loop a couple of times
+			for (int i = 0; i < 3; ++i) {
+				FrameAllocator::nextFrameAll();
+
+				JobHandle idle;
+				for (int j = 0; j < 4; ++j)
+					jobs.schedule([] {
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					}, idle);
+
+				while (!idle.isDone())
+					std::this_thread::yield();
+			}
+
+			isReleased = true;
+			jobs.wait(job);
+
+			Assert::IsTrue(isIntact);
+		}
+
+		TEST_METHOD(TestPool) {
+			using overdrive::core::Handle;
+			using overdrive::core::Pool;
+
+			// create, get, destroy
+			{
+				Pool<Counted, 4> pool;
+
+				auto a = pool.create(1);
+				auto b = pool.create(2);
+
+				Assert::IsTrue(a != b);
+				Assert::AreEqual(1, pool.get(a)->mValue);
+				Assert::AreEqual(2, pool.get(b)->mValue);
+				Assert::AreEqual(static_cast<size_t>(2), pool.getSize());
+				Assert::AreEqual(static_cast<size_t>(4), pool.getCapacity());
+				Assert::AreEqual(2, Counted::sNumAlive.load());
+
+				pool.destroy(a);
+
+				Assert::IsFalse(pool.isValid(a));
+				Assert::IsTrue(pool.get(a) == nullptr);
+				Assert::AreEqual(static_cast<size_t>(1), pool.getSize());
+				Assert::AreEqual(1, Counted::sNumAlive.load());
+
+				// the slot is reused, the old handle stays stale
+				auto c = pool.create(3);
+
+				Assert::AreEqual(a.mIndex, c.mIndex);
+				Assert::IsTrue(a != c);
+				Assert::IsFalse(pool.isValid(a));
+				Assert::AreEqual(3, pool.get(c)->mValue);
+
+				bool isThrown = false;
+
+				try {
+					pool.destroy(a);
+				}
+				catch (const std::runtime_error&) {
+					isThrown = true;
+				}
+
+				Assert::IsTrue(isThrown);
+				Assert::AreEqual(3, pool.get(c)->mValue);
+
+				// null handles never refer to anything
+				Assert::IsFalse(pool.isValid(Handle<Counted>()));
+
+				// grows by whole chunks
+				std::vector<Handle<Counted>> handles;
+
+				for (int i = 0; i < 10; ++i)
+					handles.push_back(pool.create(100 + i));
+
+				Assert::AreEqual(static_cast<size_t>(12), pool.getSize());
+				Assert::AreEqual(static_cast<size_t>(12), pool.getCapacity());
+
+				for (int i = 0; i < 10; ++i)
+					Assert::AreEqual(100 + i, pool.get(handles[i])->mValue);
+			}
+
+			// the pool destroys whatever is left
+			Assert::AreEqual(0, Counted::sNumAlive.load());
+
+			// forEach visits the live objects in slot order
+			{
+				Pool<Counted, 4> pool;
+				std::vector<Handle<Counted>> handles;
+
+				for (int i = 0; i < 6; ++i)
+					handles.push_back(pool.create(i));
+
+				pool.destroy(handles[1]);
+				pool.destroy(handles[4]);
+
+				std::vector<int> visited;
+
+				pool.forEach([&](Handle<Counted> handle, Counted& object) {
+					Assert::IsTrue(pool.get(handle) == &object);
+					visited.push_back(object.mValue);
+				});
+
+				Assert::AreEqual(static_cast<size_t>(4), visited.size());
+				Assert::AreEqual(0, visited[0]);
+				Assert::AreEqual(2, visited[1]);
+				Assert::AreEqual(3, visited[2]);
+				Assert::AreEqual(5, visited[3]);
+			}
+
+			// concurrent destroys of the same handle, only one of them wins
+			for (int round = 0; round < 100; ++round) {
+				Pool<Counted, 4> pool;
+
+				auto handle = pool.create(1);
+				std::atomic<int> numDestroyed(0);
+				std::atomic<int> numThrown(0);
+				std::atomic<bool> isStarted(false);
+				std::vector<std::thread> threads;
+
+				for (int i = 0; i < 4; ++i)
+					threads.emplace_back([&] {
+						while (!isStarted)
+							std::this_thread::yield();
+
+						try {
+							pool.destroy(handle);
+							++numDestroyed;
+						}
+						catch (const std::runtime_error&) {
+							++numThrown;
+						}
+					});
+
+				isStarted = true;
+
+				for (auto& thread : threads)
+					thread.join();
+
+				Assert::AreEqual(1, numDestroyed.load());
+				Assert::AreEqual(3, numThrown.load());
+				Assert::AreEqual(0, Counted::sNumAlive.load());
+
+				// the slot went onto the free list once
+				auto first = pool.create(2);
+				auto second = pool.create(3);
+
+				Assert::IsTrue(first.mIndex != second.mIndex);
+			}
+		}
+
+		TEST_METHOD(TestResourceCache) {
+			using overdrive::core::ResourceCache;
+			using overdrive::core::makeResourceKey;
+
+			typedef ResourceCache<TestResource> Cache;
+
+			auto makeLoader = [](int value, size_t numBytes) -> Cache::Loader {
+				return [=] {
+					return std::unique_ptr<TestResource>(new TestResource{ value, numBytes });
+				};
+			};
+
+			Assert::IsTrue(makeResourceKey("a.png") != makeResourceKey("b.png"));
+			Assert::IsTrue(makeResourceKey("a.png", 1) != makeResourceKey("a.png", 2));
+			Assert::IsTrue(makeResourceKey("a", std::string("bc")) != makeResourceKey("ab", std::string("c")));
+			Assert::IsTrue(makeResourceKey("a.png", 1) == makeResourceKey("a.png", 1));
+
+			// sharing
+			{
+				Cache cache;
+
+				auto first = cache.get(1, makeLoader(10, 0));
+				auto second = cache.get(1, makeLoader(20, 0));
+
+				Assert::IsTrue(first == second);
+				Assert::AreEqual(10, second->mValue);
+				Assert::AreEqual(static_cast<size_t>(1), cache.getStats().mNumHits);
+				Assert::AreEqual(static_cast<size_t>(1), cache.getStats().mNumMisses);
+				Assert::IsTrue(cache.find(2) == nullptr);
+			}
+
+			// least recently used, unreferenced resources are evicted first
+			{
+				Cache cache(100);
+
+				cache.get(1, makeLoader(1, 40));
+				cache.get(2, makeLoader(2, 40));
+				cache.find(1); // 2 is now the least recently used
+
+				auto third = cache.get(3, makeLoader(3, 40));
+
+				Assert::IsTrue(cache.contains(1));
+				Assert::IsFalse(cache.contains(2));
+				Assert::IsTrue(cache.contains(3));
+				Assert::AreEqual(static_cast<size_t>(80), cache.getStats().mNumBytes);
+				Assert::AreEqual(static_cast<size_t>(40), cache.getStats().mNumBytesInUse);
+
+				// referenced resources stay, even over budget
+				auto fourth = cache.get(4, makeLoader(4, 90));
+
+				Assert::IsFalse(cache.contains(1));
+				Assert::IsTrue(cache.contains(3));
+				Assert::IsTrue(cache.contains(4));
+				Assert::AreEqual(static_cast<size_t>(130), cache.getStats().mNumBytes);
+
+				third.reset();
+				cache.trim();
+
+				Assert::IsFalse(cache.contains(3));
+				Assert::AreEqual(static_cast<size_t>(3), cache.getStats().mNumEvicted);
+
+				fourth.reset();
+
+				Assert::AreEqual(static_cast<size_t>(1), cache.purge());
+				Assert::AreEqual(static_cast<size_t>(0), cache.getStats().mNumBytes);
+			}
+
+			// failed loads are not cached
+			{
+				Cache cache;
+				bool isThrown = false;
+
+				try {
+					cache.get(1, []() -> std::unique_ptr<TestResource> { throw std::runtime_error("missing"); });
+				}
+				catch (const std::runtime_error&) {
+					isThrown = true;
+				}
+
+				Assert::IsTrue(isThrown);
+				Assert::IsFalse(cache.contains(1));
+				Assert::AreEqual(static_cast<size_t>(1), cache.getStats().mNumFailed);
+				Assert::AreEqual(5, cache.get(1, makeLoader(5, 0))->mValue);
+			}
+
+			// concurrent requests for the same key share a single load
+			{
+				Cache cache;
+				std::atomic<int> numLoads(0);
+				std::vector<std::thread> threads;
+				std::vector<Cache::Handle> handles(8);
+
+				for (size_t i = 0; i < handles.size(); ++i)
+					threads.emplace_back([&, i] {
+						handles[i] = cache.get(1, [&] {
+							++numLoads;
+							std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+							return std::unique_ptr<TestResource>(new TestResource{ 7, 0 });
+						});
+					});
+
+				for (auto& thread : threads)
+					thread.join();
+
+				Assert::AreEqual(1, numLoads.load());
+
+				for (const auto& handle : handles)
+					Assert::IsTrue(handle == handles.front());
+			}
+
+			// a loader that requests its own key fails instead of waiting for itself
+			{
+				Cache cache;
+				bool isNestedThrown = false;
+				bool isThrown = false;
+
+				try {
+					cache.get(1, [&]() -> std::unique_ptr<TestResource> {
+						try {
+							cache.get(1, makeLoader(1, 0));
+						}
+						catch (const std::runtime_error&) {
+							isNestedThrown = true;
+							throw;
+						}
+
+						return nullptr;
+					});
+				}
+				catch (const std::runtime_error&) {
+					isThrown = true;
+				}
+
+				Assert::IsTrue(isNestedThrown);
+				Assert::IsTrue(isThrown);
+				Assert::IsFalse(cache.contains(1));
+				Assert::AreEqual(7, cache.get(1, makeLoader(7, 0))->mValue);
+			}
+
+			// resources that grow after loading are accounted for by refresh
+			{
+				Cache cache(100);
+
+				auto first = cache.get(1, makeLoader(1, 0));
+				cache.get(2, makeLoader(2, 40));
+
+				first->mNumBytes = 80;
+				cache.refresh(1);
+
+				Assert::AreEqual(static_cast<size_t>(80), cache.getStats().mNumBytes);
+				Assert::IsFalse(cache.contains(2));
+			}
+
+			// two jobs on the same thread requesting the same key: the second one is parked until the first is done
+			{
+				overdrive::core::JobSystem jobSystem(1); // only this thread
+				Cache cache(Cache::UNLIMITED, &jobSystem);
+
+				overdrive::core::JobHandle gate;
+				overdrive::core::JobHandle jobs;
+				std::atomic<int> numLoads(0);
+				std::atomic<int> numThrown(0);
+				Cache::Handle handles[2];
+
+				jobSystem.hold(gate);
+
+				for (auto& handle : handles)
+					jobSystem.schedule([&] {
+						try {
+							handle = cache.get(1, [&] {
+								++numLoads;
+								jobSystem.wait(gate); // parks the loading job
+
+								return std::unique_ptr<TestResource>(new TestResource{ 3, 0 });
+							});
+						}
+						catch (const std::runtime_error&) {
+							++numThrown;
+						}
+					}, jobs);
+
+				while (jobSystem.tryRunJob());
+
+				Assert::IsFalse(jobs.isDone());
+				Assert::AreEqual(static_cast<size_t>(1), cache.getStats().mNumWaits);
+
+				jobSystem.release(gate);
+				jobSystem.wait(jobs);
+
+				Assert::AreEqual(1, numLoads.load());
+				Assert::AreEqual(0, numThrown.load());
+				Assert::IsTrue(handles[0] && (handles[0] == handles[1]));
+			}
+		}
+
+		TEST_METHOD(TestChannelPost) {
+			using overdrive::core::Channel;
+
+			// a sync point of its own, so nothing else dispatches these
+			Channel::setSyncPoint<PostMessage>("TestChannelPost");
+
+			PostHandler handler;
+			Channel::add<PostMessage>(&handler);
+
+			// more than fit in a ring, the overflow is delivered after the ring in posting order
+			const int numMessages = 600;
+
+			for (int i = 0; i < numMessages; ++i)
+				Channel::post(PostMessage{ 0, i });
+
+			Assert::IsTrue(handler.mReceived.empty());
+
+			Channel::dispatchPosted("TestChannelPost");
+
+			Assert::AreEqual(static_cast<size_t>(numMessages), handler.mReceived.size());
+
+			for (int i = 0; i < numMessages; ++i)
+				Assert::AreEqual(i, handler.mReceived[i].mIndex);
+
+			// the ring is empty again, and keeps working after an overflow
+			handler.mReceived.clear();
+			Channel::dispatchPosted("TestChannelPost");
+			Assert::IsTrue(handler.mReceived.empty());
+
+			Channel::post(PostMessage{ 0, numMessages });
+			Channel::dispatchPosted("TestChannelPost");
+			Assert::AreEqual(static_cast<size_t>(1), handler.mReceived.size());
+
+			// messages from threads that exited before the dispatch are still delivered, in order per thread
+			handler.mReceived.clear();
+
+			std::vector<std::thread> senders;
+
+			for (int sender = 1; sender <= 4; ++sender)
+				senders.emplace_back([sender, numMessages] {
+					for (int i = 0; i < numMessages; ++i)
+						Channel::post(PostMessage{ sender, i });
+				});
+
+			for (auto& thread : senders)
+				thread.join();
+
+			Channel::dispatchPosted("TestChannelPost");
+
+			Assert::AreEqual(static_cast<size_t>(4 * numMessages), handler.mReceived.size());
+
+			int next[5] = {};
+
+			for (const auto& message : handler.mReceived)
+				Assert::AreEqual(next[message.mSender]++, message.mIndex);
+
+			// their rings are released by that dispatch, nothing is delivered twice
+			handler.mReceived.clear();
+			Channel::dispatchPosted("TestChannelPost");
+			Assert::IsTrue(handler.mReceived.empty());
+
+			Channel::remove<PostMessage>(&handler);
+			Channel::setSyncPoint<PostMessage>("");
+		}
+
+		// a handler that modifies the channel while another thread is waiting for its broadcast to finish
+		TEST_METHOD(TestChannelChangeFromHandler) {
+			using overdrive::core::Channel;
+
+			ChangingHandler handler;
+			IdleHandler extra;
+
+			Channel::add<ChangeMessage>(&handler);
+
+			std::thread broadcaster([] {
+				Channel::broadcast(ChangeMessage{ 1 });
+			});
+
+			while (!handler.mIsBroadcasting)
+				std::this_thread::yield();
+
+			Channel::add<ChangeMessage>(&extra); // waits for the broadcast, which must be able to make its own changes
+
+			broadcaster.join();
+
+			Assert::AreEqual(size_t(2), Channel::getNumHandlers<ChangeMessage>());
+
+			Channel::removeAll<ChangeMessage>();
+		}
+
+		// broadcast latency with 1, 10 and 100 handlers while another thread keeps adding/removing a handler
+		TEST_METHOD(BenchmarkChannelBroadcast) {
+			using overdrive::core::Channel;
+			using Clock = std::chrono::high_resolution_clock;
+
+			const int numBroadcasts = 1000000;
+
+			for (int numHandlers : { 1, 10, 100 }) {
+				std::vector<BenchHandler> handlers(numHandlers);
+
+				for (auto& handler : handlers)
+					Channel::add<BenchMessage>(&handler);
+
+				std::atomic<bool> done(false);
+				std::atomic<int> numChanges(0);
+
+				std::thread churn([&] {
+					BenchHandler extra;
+
+					while (!done) {
+						Channel::add<BenchMessage>(&extra);
+						Channel::remove<BenchMessage>(&extra);
+						++numChanges;
+					}
+				});
+
+				auto start = Clock::now();
+
+				for (int i = 0; i < numBroadcasts; ++i)
+					Channel::broadcast(BenchMessage{ 1 });
+
+				auto elapsed = Clock::now() - start;
+
+				done = true;
+				churn.join();
+
+				Channel::removeAll<BenchMessage>();
+
+				for (const auto& handler : handlers)
+					Assert::AreEqual(static_cast<long long>(numBroadcasts), handler.mSum);
+
+				std::stringstream sstr;
+				sstr
+					<< numHandlers << " handlers: "
+					<< std::chrono::duration<double, std::nano>(elapsed).count() / numBroadcasts << " ns per broadcast ("
+					<< numChanges << " concurrent add/remove pairs)\n";
+
+				Logger::WriteMessage(sstr.str().c_str());
+			}
+		}
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,1283 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "../Overdrive/render/common_uniform_blocks.h"
+#include "../Overdrive/render/instance_buffer.h"
+#include "../Overdrive/render/material.h"
+#include "../Overdrive/render/parameter_block.h"
+#include "../Overdrive/render/program_binary_cache.h"
+#include "../Overdrive/render/range_allocator.h"
+#include "../Overdrive/render/render_queue.h"
+#include "../Overdrive/render/shader_compiler.h"
+#include "../Overdrive/render/shaderprogram.h"
+#include "../Overdrive/render/state_cache.h"
+#include "../Overdrive/render/stream_buffer.h"
+#include "../Overdrive/render/texture2D.h"
+#include "../Overdrive/render/texture_file.h"
+#include "../Overdrive/render/texture_streamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace {
+	typedef float Float3[3];
+
+	struct Light {
+		glm::vec3 mDirection;
+		float mIntensity;
+	};
+
+	struct Lighting {
+		float mExposure;
+		Light mSun;
+		Float3 mWeights;
+		glm::mat3 mBasis;
+	};
+
+	struct Particle {
+		float mAge;
+		Float3 mWeights;
+		glm::vec2 mVelocity;
+	};
+
+	// hidden window for the tests that need an OpenGL context; they are skipped if none can be created
+	class TestContext {
+	public:
+		TestContext():
+			mWindow(nullptr)
+		{
+			if (!glfwInit())
+				return;
+
+			glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+			glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+			glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+			mWindow = glfwCreateWindow(64, 64, "OverdriveTest", nullptr, nullptr);
+
+			if (!mWindow)
+				return;
+
+			glfwMakeContextCurrent(mWindow);
+
+			glewExperimental = GL_TRUE;
+			if (glewInit() != GLEW_OK) {
+				glfwDestroyWindow(mWindow);
+				mWindow = nullptr;
+				return;
+			}
+
+			while (glGetError() != GL_NO_ERROR); // glewInit may leave an error behind
+		}
+
+		~TestContext() {
+			if (mWindow)
+				glfwDestroyWindow(mWindow);
+
+			glfwTerminate();
+		}
+
+		bool isValid() const {
+			if (!mWindow)
+				Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage("No OpenGL context, skipped");
+
+			return (mWindow != nullptr);
+		}
+
+	private:
+		GLFWwindow* mWindow;
+	};
+
+	const char* gVertexSource =
+		"#version 450 core\n"
+		"void main() { gl_Position = vec4(0.0, 0.0, 0.0, 1.0); }\n";
+
+	const char* gFragmentSource =
+		"#version 450 core\n"
+		"uniform float uScale;\n"
+		"uniform vec4 uTint;\n"
+		"out vec4 oColor;\n"
+		"void main() { oColor = uTint * uScale; }\n";
+
+	template <typename T>
+	void append(std::vector<uint8_t>& file, const T& value) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		file.insert(file.end(), bytes, bytes + sizeof(T));
+	}
+
+	void writeFile(const char* path, const std::vector<uint8_t>& data) {
+		std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+		ofs.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	// mirrors the layout in program_binary_cache.cpp
+	std::vector<uint8_t> makeCacheHeader(uint32_t magic, uint64_t driverHash, uint32_t numEntries) {
+		std::vector<uint8_t> file;
+
+		append(file, magic);
+		append(file, uint32_t(1)); // version
+		append(file, driverHash);
+		append(file, numEntries);
+		append(file, uint32_t(0)); // reserved
+
+		return file;
+	}
+
+	void appendCacheEntry(std::vector<uint8_t>& file, uint64_t key, uint64_t offset, uint32_t size) {
+		append(file, key);
+		append(file, offset);
+		append(file, uint32_t(0)); // format
+		append(file, size);
+	}
+
+	// 16x16 DXT1 with a full mip chain (128 + 32 + 8 + 8 + 8 bytes)
+	std::vector<uint8_t> makeDDS(uint32_t numLevels) {
+		gli::detail::ddsHeader header;
+		std::memset(&header, 0, sizeof(header));
+
+		header.Size = sizeof(header);
+		header.Flags = gli::detail::DDSD_MIPMAPCOUNT;
+		header.Width = 16;
+		header.Height = 16;
+		header.MipMapLevels = numLevels;
+		header.Format.size = sizeof(header.Format);
+		header.Format.flags = gli::dx::DDPF_FOURCC;
+		header.Format.fourCC = gli::dx::D3DFMT_DXT1;
+
+		std::vector<uint8_t> file(std::begin(gli::detail::FOURCC_DDS), std::end(gli::detail::FOURCC_DDS));
+		append(file, header);
+
+		for (size_t level = 0; level < 5; ++level) {
+			size_t numBlocks = std::max<size_t>((16 >> level) / 4, 1);
+			file.resize(file.size() + numBlocks * numBlocks * 8, static_cast<uint8_t>(level));
+		}
+
+		return file;
+	}
+
+	// 4x2 RGBA8 with a full mip chain, every level prefixed with its size
+	std::vector<uint8_t> makeKTX(uint32_t numLevels) {
+		auto& format = gli::gl().translate(gli::FORMAT_RGBA8_UNORM_PACK8);
+
+		gli::detail::ktxHeader10 header;
+		std::memset(&header, 0, sizeof(header));
+
+		header.Endianness = 0x04030201;
+		header.GLType = format.Type;
+		header.GLTypeSize = 1;
+		header.GLFormat = format.External;
+		header.GLInternalFormat = format.Internal;
+		header.GLBaseInternalFormat = format.External;
+		header.PixelWidth = 4;
+		header.PixelHeight = 2;
+		header.NumberOfFaces = 1;
+		header.NumberOfMipmapLevels = numLevels;
+
+		std::vector<uint8_t> file(std::begin(gli::detail::FOURCC_KTX10), std::end(gli::detail::FOURCC_KTX10));
+		append(file, header);
+
+		for (uint32_t level = 0; level < 3; ++level) {
+			uint32_t imageSize = std::max(4u >> level, 1u) * std::max(2u >> level, 1u) * 4;
+
+			append(file, imageSize);
+			file.resize(file.size() + imageSize, static_cast<uint8_t>(level));
+		}
+
+		return file;
+	}
+
+	void buildTestProgram(overdrive::render::ShaderProgram& program) {
+		using overdrive::render::eShaderType;
+
+		program.attachShader(std::string(gVertexSource), eShaderType::VERTEX);
+		program.attachShader(std::string(gFragmentSource), eShaderType::FRAGMENT);
+		program.link();
+	}
+}
+
+BOOST_FUSION_ADAPT_STRUCT(Light, (glm::vec3, mDirection)(float, mIntensity))
+BOOST_FUSION_ADAPT_STRUCT(Lighting, (float, mExposure)(Light, mSun)(Float3, mWeights)(glm::mat3, mBasis))
+BOOST_FUSION_ADAPT_STRUCT(Particle, (float, mAge)(Float3, mWeights)(glm::vec2, mVelocity))
+
+namespace OverdriveTest {
+	TEST_CLASS(TestRender) {
+	public:
+		TEST_METHOD(TestUniformLayout) {
+			using namespace overdrive::render;
+			using namespace overdrive::render::layout;
+
+			// std140: structs and array elements are aligned to 16 bytes, matrix columns are padded to a vec4
+			Assert::AreEqual(16u, static_cast<unsigned int>(Block<Lighting, Std140>::Offset<1>::value));
+			Assert::AreEqual(32u, static_cast<unsigned int>(Block<Lighting, Std140>::Offset<2>::value));
+			Assert::AreEqual(80u, static_cast<unsigned int>(Block<Lighting, Std140>::Offset<3>::value));
+			Assert::AreEqual(128u, static_cast<unsigned int>(Block<Lighting, Std140>::size));
+			Assert::IsFalse(IsCompatible<Lighting, Std140>::value);
+
+			// std430: arrays are tightly packed
+			Assert::AreEqual(4u, static_cast<unsigned int>(Block<Particle, Std430>::Offset<1>::value));
+			Assert::AreEqual(16u, static_cast<unsigned int>(Block<Particle, Std430>::Offset<2>::value));
+			Assert::AreEqual(24u, static_cast<unsigned int>(Block<Particle, Std430>::size));
+			Assert::IsTrue(IsCompatible<Particle, Std430>::value);
+			Assert::IsFalse(IsCompatible<Particle, Std140>::value);
+			Assert::IsTrue(matchesOffsets<Particle, Std430>());
+
+			Assert::IsTrue(matchesOffsets<blocks::Frame>());
+			Assert::IsTrue(matchesOffsets<blocks::Camera>());
+			Assert::IsTrue(matchesOffsets<blocks::Object>());
+		}
+
+		TEST_METHOD(TestRangeAllocator) {
+			using overdrive::render::RangeAllocator;
+
+			RangeAllocator allocator(100);
+
+			size_t a, b, c, d;
+
+			// first fit, back to back
+			Assert::IsTrue(allocator.allocate(30, a));
+			Assert::IsTrue(allocator.allocate(30, b));
+			Assert::IsTrue(allocator.allocate(30, c));
+			Assert::AreEqual(size_t(0), a);
+			Assert::AreEqual(size_t(30), b);
+			Assert::AreEqual(size_t(60), c);
+			Assert::AreEqual(size_t(10), allocator.getNumFree());
+
+			// exhaustion; a failed allocation changes nothing
+			Assert::IsFalse(allocator.allocate(20, d));
+			Assert::AreEqual(size_t(10), allocator.getNumFree());
+
+			// the freed block is re-used, the size of the block is reported back
+			Assert::AreEqual(size_t(30), allocator.free(b));
+			Assert::AreEqual(size_t(2), allocator.getNumFreeBlocks());
+			Assert::IsTrue(allocator.allocate(20, d));
+			Assert::AreEqual(size_t(30), d);
+			Assert::AreEqual(size_t(20), allocator.free(d));
+
+			// merges with the following block, then with the preceding one
+			Assert::AreEqual(size_t(30), allocator.free(a));
+			Assert::AreEqual(size_t(2), allocator.getNumFreeBlocks());
+			Assert::IsFalse(allocator.allocate(70, d));
+			Assert::IsTrue(allocator.allocate(60, d));
+			Assert::AreEqual(size_t(0), d);
+			Assert::AreEqual(size_t(60), allocator.free(d));
+
+			Assert::AreEqual(size_t(30), allocator.free(c));
+			Assert::AreEqual(size_t(1), allocator.getNumFreeBlocks());
+			Assert::AreEqual(size_t(100), allocator.getNumFree());
+			Assert::IsTrue(allocator.allocate(100, d));
+			Assert::AreEqual(size_t(0), d);
+
+			// double free
+			Assert::AreEqual(size_t(100), allocator.free(d));
+
+			bool threw = false;
+
+			try {
+				allocator.free(d);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+
+			Assert::IsTrue(threw);
+		}
+
+		TEST_METHOD(TestMaterial) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ShaderProgram program;
+			buildTestProgram(program);
+			Assert::IsTrue(program.isLinked());
+
+			const UniformHandle scale("uScale");
+			const UniformHandle tint("uTint");
+			const UniformHandle missing("uMissing");
+
+			Material material(&program);
+			Material other(&program);
+			Assert::AreNotEqual(material.getID(), other.getID());
+
+			material.addParameter(scale, 1.0f);
+			material.addParameter(tint, glm::vec4(1.0f));
+			Assert::AreEqual(size_t(2), material.getParameters().getNumParameters());
+
+			bool isThrown = false;
+
+			try {
+				material.addParameter(missing, 1.0f);
+			}
+			catch (const std::runtime_error&) {
+				isThrown = true;
+			}
+
+			Assert::IsTrue(isThrown);
+
+			// instances start out with the defaults, and only change their own copy
+			MaterialInstance a(material);
+			MaterialInstance b(material);
+
+			a.set(scale, 2.0f);
+
+			float value = 0.0f;
+			Assert::IsTrue(a.getParameters().get(scale, value));
+			Assert::AreEqual(2.0f, value);
+			Assert::IsTrue(b.getParameters().get(scale, value));
+			Assert::AreEqual(1.0f, value);
+
+			// unknown names and mismatched types both throw
+			isThrown = false;
+
+			try {
+				a.set(missing, 1.0f);
+			}
+			catch (const std::runtime_error&) {
+				isThrown = true;
+			}
+
+			Assert::IsTrue(isThrown);
+
+			isThrown = false;
+
+			try {
+				a.set(scale, glm::vec4(3.0f));
+			}
+			catch (const std::runtime_error&) {
+				isThrown = true;
+			}
+
+			Assert::IsTrue(isThrown);
+			Assert::IsTrue(a.getParameters().get(scale, value));
+			Assert::AreEqual(2.0f, value);
+
+			program.bind();
+			a.apply();
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+			program.unbind();
+		}
+
+		TEST_METHOD(TestMaterialSortID) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ShaderProgram program;
+			buildTestProgram(program);
+
+			// well past the 8 bits per material and instance that the sort ID used to be made of
+			std::vector<std::unique_ptr<Material>> materials;
+			std::vector<std::unique_ptr<MaterialInstance>> instances;
+			std::set<uint16_t> sortIDs;
+
+			for (int i = 0; i < 300; ++i)
+				materials.emplace_back(new Material(&program));
+
+			for (auto& material : materials)
+				for (int i = 0; i < 2; ++i)
+					instances.emplace_back(new MaterialInstance(*material));
+
+			for (int i = 0; i < 300; ++i)
+				instances.emplace_back(new MaterialInstance(*materials.front()));
+
+			for (const auto& instance : instances) {
+				Assert::AreNotEqual(uint16_t(0), instance->getSortID());
+				sortIDs.insert(instance->getSortID());
+			}
+
+			Assert::AreEqual(instances.size(), sortIDs.size());
+		}
+
+		TEST_METHOD(TestRenderQueueKeys) {
+			using namespace overdrive::render;
+
+			uint64_t key = RenderQueue::makeKey(eRenderPass::TRANSLUCENT, 1234, 0x12345, 0xABCD, 7);
+
+			// names are truncated to 16 bits
+			Assert::AreEqual(uint64_t(0x24D22345ABCD0007ull), key);
+			Assert::IsTrue(RenderQueue::getPass(key) == eRenderPass::TRANSLUCENT);
+			Assert::AreEqual(1234u, RenderQueue::getDepthBucket(key));
+
+			uint64_t smallest = RenderQueue::makeKey(eRenderPass::SOLID, 0, 0, 0, 0);
+			uint64_t largest = RenderQueue::makeKey(eRenderPass::OVERLAY, RenderQueue::MAX_DEPTH_BUCKET, 0xFFFF, 0xFFFF, 0xFFFF);
+
+			Assert::AreEqual(uint64_t(0), smallest);
+			Assert::IsTrue(RenderQueue::getPass(largest) == eRenderPass::OVERLAY);
+			Assert::AreEqual(uint32_t(RenderQueue::MAX_DEPTH_BUCKET), RenderQueue::getDepthBucket(largest));
+
+			// every field outranks all of the fields after it
+			uint64_t base = RenderQueue::makeKey(eRenderPass::SOLID, 5, 5, 5, 5);
+
+			Assert::IsTrue(base < RenderQueue::makeKey(eRenderPass::SKY, 0, 0, 0, 0));
+			Assert::IsTrue(base < RenderQueue::makeKey(eRenderPass::SOLID, 6, 0, 0, 0));
+			Assert::IsTrue(base < RenderQueue::makeKey(eRenderPass::SOLID, 5, 6, 0, 0));
+			Assert::IsTrue(base < RenderQueue::makeKey(eRenderPass::SOLID, 5, 5, 6, 0));
+			Assert::IsTrue(base < RenderQueue::makeKey(eRenderPass::SOLID, 5, 5, 5, 6));
+
+			RenderQueue queue;
+			Assert::AreEqual(uint32_t(RenderQueue::DEFAULT_SOLID_BUCKETS), queue.getNumDepthBuckets(eRenderPass::SOLID));
+			Assert::AreEqual(RenderQueue::MAX_DEPTH_BUCKET + 1, queue.getNumDepthBuckets(eRenderPass::TRANSLUCENT));
+
+			queue.setNumDepthBuckets(eRenderPass::SOLID, 0);
+			Assert::AreEqual(1u, queue.getNumDepthBuckets(eRenderPass::SOLID));
+
+			queue.setNumDepthBuckets(eRenderPass::SOLID, 100000);
+			Assert::AreEqual(RenderQueue::MAX_DEPTH_BUCKET + 1, queue.getNumDepthBuckets(eRenderPass::SOLID));
+		}
+
+		TEST_METHOD(TestRenderQueueSort) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ShaderProgram programs[2];
+			VertexArray vaos[3];
+
+			for (auto& program : programs)
+				buildTestProgram(program);
+
+			const eRenderPass passes[] = {
+				eRenderPass::SOLID,
+				eRenderPass::SKY,
+				eRenderPass::TRANSLUCENT,
+				eRenderPass::OVERLAY
+			};
+
+			RenderQueue queue;
+			std::mt19937 rng(42);
+
+			// few distinct states, so plenty of packets share a key; mInstanceData.x records the submission order
+			const int numCommands = 2000;
+
+			for (int i = 0; i < numCommands; ++i) {
+				DrawCommand command;
+				command.mProgram = &programs[rng() % 2];
+				command.mVAO = &vaos[rng() % 3];
+				command.mInstanceData.x = static_cast<float>(i);
+
+				queue.submit(command, passes[rng() % 4], static_cast<float>(rng() % 1000) / 1000.0f);
+			}
+
+			Assert::AreEqual(size_t(numCommands), queue.getNumPackets());
+
+			queue.sort();
+
+			Assert::AreEqual(size_t(numCommands), queue.getNumPackets());
+
+			const RenderQueue::Packet* previous = nullptr;
+
+			for (const auto& packet : queue) {
+				if (previous) {
+					Assert::IsTrue(previous->mKey <= packet.mKey);
+
+					// stable: equal keys keep their submission order
+					if (previous->mKey == packet.mKey)
+						Assert::IsTrue(previous->mCommand->mInstanceData.x < packet.mCommand->mInstanceData.x);
+				}
+
+				// the key matches the command it points to
+				Assert::AreEqual(
+					static_cast<uint64_t>(packet.mCommand->mVAO->getHandle() & 0xFFFF),
+					packet.mKey & 0xFFFF
+				);
+
+				previous = &packet;
+			}
+
+			queue.clear();
+			Assert::IsTrue(queue.isEmpty());
+
+			// solid geometry uses coarse buckets front to back, translucent geometry fine buckets back to front
+			DrawCommand command;
+			command.mProgram = &programs[0];
+			command.mVAO = &vaos[0];
+
+			for (float depth : { 0.5f, 2.0f }) { // the second one is clamped
+				command.mInstanceData.x = depth;
+				queue.submit(command, eRenderPass::SOLID, depth);
+			}
+
+			for (float depth : { 0.25f, 0.75f }) {
+				command.mInstanceData.x = depth;
+				queue.submit(command, eRenderPass::TRANSLUCENT, depth);
+			}
+
+			const auto& packets = queue.getPackets();
+
+			Assert::AreEqual(RenderQueue::DEFAULT_SOLID_BUCKETS / 2, RenderQueue::getDepthBucket(packets[0].mKey));
+			Assert::AreEqual(RenderQueue::DEFAULT_SOLID_BUCKETS - 1, RenderQueue::getDepthBucket(packets[1].mKey));
+			Assert::AreEqual(RenderQueue::MAX_DEPTH_BUCKET - 1024, RenderQueue::getDepthBucket(packets[2].mKey));
+			Assert::AreEqual(RenderQueue::MAX_DEPTH_BUCKET - 3072, RenderQueue::getDepthBucket(packets[3].mKey));
+
+			queue.sort();
+
+			// the near solid draw comes first, the far translucent draw comes first
+			Assert::AreEqual(0.5f, packets[0].mCommand->mInstanceData.x);
+			Assert::AreEqual(2.0f, packets[1].mCommand->mInstanceData.x);
+			Assert::AreEqual(0.75f, packets[2].mCommand->mInstanceData.x);
+			Assert::AreEqual(0.25f, packets[3].mCommand->mInstanceData.x);
+		}
+
+		TEST_METHOD(TestParameterBlock) {
+			using namespace overdrive::render;
+
+			const UniformHandle scale("uScale");
+			const UniformHandle tint("uTint");
+
+			ParameterBlock block;
+			block.set(scale, 1.0f);
+			block.set(tint, glm::vec4(0.5f));
+
+			Assert::AreEqual(size_t(2), block.getNumParameters());
+			Assert::IsTrue(block.holds<float>(scale));
+			Assert::IsFalse(block.holds<int>(scale)); // same size, different type
+			Assert::IsTrue(block.holds<glm::vec4>(tint));
+
+			// alternating between a small and a large type re-uses the storage of the large one
+			for (int i = 0; i < 100; ++i) {
+				block.set(scale, glm::vec4(static_cast<float>(i)));
+				block.set(scale, static_cast<float>(i));
+			}
+
+			Assert::AreEqual(sizeof(glm::vec4) * 2 + sizeof(float), block.getData().size());
+
+			float value = 0.0f;
+			Assert::IsTrue(block.get(scale, value));
+			Assert::AreEqual(99.0f, value);
+
+			glm::vec4 color;
+			Assert::IsTrue(block.get(tint, color));
+			Assert::IsTrue(color == glm::vec4(0.5f));
+			Assert::IsFalse(block.get(scale, color)); // size doesn't match
+
+			block.clear();
+			Assert::AreEqual(size_t(0), block.getNumParameters());
+			Assert::IsTrue(block.getData().empty());
+		}
+
+		TEST_METHOD(TestTextureFileDDS) {
+			using namespace overdrive::render;
+
+			TextureFileView view;
+
+			auto file = makeDDS(5);
+			Assert::IsTrue(parseTextureFile(file.data(), file.size(), view));
+			Assert::AreEqual(size_t(5), view.mLevels.size());
+			Assert::AreEqual(16, view.getWidth());
+			Assert::AreEqual(16, view.getHeight());
+			Assert::AreEqual(size_t(128), view.mLevels[0].mNumBytes);
+			Assert::AreEqual(size_t(32), view.mLevels[1].mNumBytes);
+			Assert::AreEqual(1, view.mLevels[4].mWidth);
+			Assert::AreEqual(size_t(8), view.mLevels[4].mNumBytes);
+			Assert::AreEqual(uint8_t(4), *view.mLevels[4].mData);
+			Assert::IsTrue(view.end() == file.data() + file.size());
+
+			// fewer levels than stored is fine
+			file = makeDDS(2);
+			Assert::IsTrue(parseTextureFile(file.data(), file.size(), view));
+			Assert::AreEqual(size_t(2), view.mLevels.size());
+
+			// more levels than a 16x16 chain has (including counts that would shift past 32 bits)
+			file = makeDDS(6);
+			Assert::IsFalse(parseTextureFile(file.data(), file.size(), view));
+
+			file = makeDDS(40);
+			Assert::IsFalse(parseTextureFile(file.data(), file.size(), view));
+
+			// truncated header, and truncated level data
+			file = makeDDS(5);
+			Assert::IsFalse(parseTextureFile(file.data(), 64, view));
+			Assert::IsFalse(parseTextureFile(file.data(), file.size() - 1, view));
+
+			// not a DDS file at all
+			file[0] = 'X';
+			Assert::IsFalse(parseTextureFile(file.data(), file.size(), view));
+		}
+
+		TEST_METHOD(TestTextureFileKTX) {
+			using namespace overdrive::render;
+
+			TextureFileView view;
+
+			auto file = makeKTX(3);
+			Assert::IsTrue(parseTextureFile(file.data(), file.size(), view));
+			Assert::IsTrue(view.mFormat == gli::FORMAT_RGBA8_UNORM_PACK8);
+			Assert::AreEqual(size_t(3), view.mLevels.size());
+			Assert::AreEqual(4, view.getWidth());
+			Assert::AreEqual(2, view.getHeight());
+			Assert::AreEqual(size_t(32), view.mLevels[0].mNumBytes);
+			Assert::AreEqual(1, view.mLevels[2].mWidth);
+			Assert::AreEqual(1, view.mLevels[2].mHeight);
+			Assert::AreEqual(uint8_t(2), *view.mLevels[2].mData);
+
+			file = makeKTX(4);
+			Assert::IsFalse(parseTextureFile(file.data(), file.size(), view));
+
+			file = makeKTX(33);
+			Assert::IsFalse(parseTextureFile(file.data(), file.size(), view));
+
+			file = makeKTX(3);
+			Assert::IsFalse(parseTextureFile(file.data(), 40, view));
+			Assert::IsFalse(parseTextureFile(file.data(), file.size() - 1, view));
+		}
+
+		TEST_METHOD(TestTextureRestream) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			// a placeholder that is replaced by streamed images, possibly more than once
+			std::vector<uint8_t> pixels(8 * 8 * 4, 0xFF);
+			Texture2D texture(gli::FORMAT_RGBA8_UNORM_PACK8, 2, 2, pixels.data());
+			GLuint handle = texture.getHandle();
+
+			texture.setImage(gli::FORMAT_RGBA8_UNORM_PACK8, 8, 8, pixels.data());
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			TextureFileView view;
+			auto file = makeKTX(3);
+			Assert::IsTrue(parseTextureFile(file.data(), file.size(), view));
+
+			texture.setImage(view, view.begin());
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			texture.setImage(view, view.begin());
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			Assert::AreEqual(handle, texture.getHandle());
+			Assert::AreEqual(4, texture.getWidth());
+			Assert::AreEqual(2, texture.getHeight());
+		}
+
+		TEST_METHOD(TestParameterBlockApply) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ShaderProgram program;
+			buildTestProgram(program);
+
+			const UniformHandle scale("uScale");
+			const UniformHandle tint("uTint");
+			const size_t uniform = static_cast<size_t>(eStateCall::UNIFORM);
+
+			ParameterBlock block;
+			block.set(scale, 2.0f);
+			block.set(tint, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+
+			program.bind();
+
+			auto& cache = StateCache::current();
+			cache.resetStats();
+
+			// the first apply sends everything
+			block.apply(program);
+			Assert::AreEqual(size_t(2), cache.getStats().mNumIssued[uniform]);
+			Assert::AreEqual(size_t(0), cache.getStats().mNumElided[uniform]);
+
+			// re-applying an unchanged block is elided completely
+			block.apply(program);
+			Assert::AreEqual(size_t(2), cache.getStats().mNumIssued[uniform]);
+			Assert::AreEqual(size_t(2), cache.getStats().mNumElided[uniform]);
+
+			// only the changed value is sent again
+			block.set(scale, 3.0f);
+			block.apply(program);
+			Assert::AreEqual(size_t(3), cache.getStats().mNumIssued[uniform]);
+			Assert::AreEqual(size_t(3), cache.getStats().mNumElided[uniform]);
+
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			float value = 0.0f;
+			glGetUniformfv(program.getHandle(), glGetUniformLocation(program.getHandle(), "uScale"), &value);
+			Assert::AreEqual(3.0f, value);
+
+			program.unbind();
+		}
+
+		TEST_METHOD(TestStateCache) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ShaderProgram program;
+			buildTestProgram(program);
+
+			GLuint vaos[2];
+			GLuint buffer;
+			GLuint texture;
+
+			glGenVertexArrays(2, vaos);
+			glGenBuffers(1, &buffer);
+			glGenTextures(1, &texture);
+
+			// a fresh cache knows nothing, so the first call of each kind is always issued
+			StateCache cache;
+
+			auto numIssued = [&](eStateCall call) { return cache.getStats().mNumIssued[static_cast<size_t>(call)]; };
+			auto numElided = [&](eStateCall call) { return cache.getStats().mNumElided[static_cast<size_t>(call)]; };
+
+			cache.useProgram(program.getHandle());
+			cache.useProgram(program.getHandle());
+
+			Assert::AreEqual(size_t(1), numIssued(eStateCall::PROGRAM));
+			Assert::AreEqual(size_t(1), numElided(eStateCall::PROGRAM));
+
+			GLint current = 0;
+			glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+			Assert::AreEqual(program.getHandle(), static_cast<GLuint>(current));
+
+			// the element array binding belongs to the vertex array
+			cache.bindVertexArray(vaos[0]);
+			cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+			cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+
+			Assert::AreEqual(size_t(1), numIssued(eStateCall::BUFFER));
+			Assert::AreEqual(size_t(1), numElided(eStateCall::BUFFER));
+
+			cache.bindVertexArray(vaos[1]);
+			Assert::AreEqual(GLuint(StateCache::UNKNOWN), cache.getBuffer(GL_ELEMENT_ARRAY_BUFFER));
+
+			cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+			Assert::AreEqual(size_t(2), numIssued(eStateCall::BUFFER));
+
+			// binding to a unit switches the active texture first, but only when it differs
+			cache.bindTexture(3, GL_TEXTURE_2D, texture);
+			cache.bindTexture(3, GL_TEXTURE_2D, texture);
+
+			Assert::AreEqual(size_t(1), numIssued(eStateCall::ACTIVE_TEXTURE));
+			Assert::AreEqual(size_t(1), numIssued(eStateCall::TEXTURE));
+			Assert::AreEqual(size_t(1), numElided(eStateCall::TEXTURE));
+
+			glGetIntegerv(GL_ACTIVE_TEXTURE, &current);
+			Assert::AreEqual(GLint(GL_TEXTURE3), current);
+			glGetIntegerv(GL_TEXTURE_BINDING_2D, &current);
+			Assert::AreEqual(texture, static_cast<GLuint>(current));
+
+			// deleted objects are unbound by openGL, the cache follows
+			cache.onDeleteTexture(texture);
+			glDeleteTextures(1, &texture);
+
+			Assert::AreEqual(GLuint(0), cache.getTexture(3, GL_TEXTURE_2D));
+
+			cache.setEnabled(GL_DEPTH_TEST, true);
+			cache.setEnabled(GL_DEPTH_TEST, true);
+
+			Assert::AreEqual(size_t(1), numIssued(eStateCall::CAPABILITY));
+			Assert::AreEqual(size_t(1), numElided(eStateCall::CAPABILITY));
+			Assert::IsTrue(glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+
+			// after talking to openGL directly, nothing is elided until the state is known again
+			glUseProgram(0);
+			cache.invalidate();
+			cache.useProgram(program.getHandle());
+
+			Assert::AreEqual(size_t(2), numIssued(eStateCall::PROGRAM));
+
+			glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+			Assert::AreEqual(program.getHandle(), static_cast<GLuint>(current));
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			cache.setEnabled(GL_DEPTH_TEST, false);
+			cache.useProgram(0);
+			cache.bindVertexArray(0);
+
+			cache.onDeleteBuffer(buffer);
+			glDeleteBuffers(1, &buffer);
+			cache.onDeleteVertexArray(vaos[0]);
+			cache.onDeleteVertexArray(vaos[1]);
+			glDeleteVertexArrays(2, vaos);
+
+			StateCache::current().invalidate(); // this test went around the per-thread cache
+		}
+
+		TEST_METHOD(TestInstanceBuffer) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			// small regions, so that they fill up quickly
+			InstanceBuffer buffer(10, 2);
+
+			Assert::AreEqual(size_t(10), buffer.getRegionSize());
+			Assert::AreEqual(size_t(2), buffer.getNumRegions());
+
+			InstanceRange first = buffer.allocate(4);
+			Assert::AreEqual(GLuint(0), first.mFirst);
+			Assert::AreEqual(GLsizei(4), first.mCount);
+
+			// limited by the space left in the region
+			InstanceRange second = buffer.allocate(100);
+			Assert::AreEqual(GLuint(4), second.mFirst);
+			Assert::AreEqual(GLsizei(6), second.mCount);
+			Assert::IsTrue(second.mInstances == first.mInstances + 4);
+
+			// a full region moves on to the next one, base instances keep counting from the start of the buffer
+			InstanceRange third = buffer.allocate(3);
+			Assert::AreEqual(GLuint(10), third.mFirst);
+			Assert::AreEqual(GLsizei(3), third.mCount);
+			Assert::IsTrue(third.mInstances == first.mInstances + 10);
+
+			for (GLsizei i = 0; i < third.mCount; ++i)
+				third.mInstances[i].mData = glm::vec4(static_cast<float>(i));
+
+			// and wraps around to the first one
+			buffer.advance();
+
+			InstanceRange fourth = buffer.allocate(10);
+			Assert::AreEqual(GLuint(0), fourth.mFirst);
+			Assert::AreEqual(GLsizei(10), fourth.mCount);
+
+			// a single attachment serves every range
+			VertexArray vao;
+			StateCache::current().bindVertexArray(vao.getHandle());
+
+			buffer.bindAttributes();
+
+			for (GLuint location = InstanceBuffer::MODEL_LOCATION; location <= InstanceBuffer::DATA_LOCATION; ++location) {
+				GLint divisor = 0;
+				GLint stride = 0;
+
+				glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+				glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+
+				Assert::AreEqual(1, divisor);
+				Assert::AreEqual(static_cast<GLint>(sizeof(attributes::Instance)), stride);
+			}
+
+			StateCache::current().bindVertexArray(0);
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+		}
+
+		TEST_METHOD(TestStreamBuffer) {
+			using namespace overdrive::render;
+
+			// nothing is created until the first allocation, so the bookkeeping works without a context
+			{
+				StreamBuffer buffer(1024, 3);
+
+				Assert::AreEqual(GLuint(0), buffer.getHandle());
+				Assert::AreEqual(size_t(1024), buffer.getNumAvailable());
+				Assert::AreEqual(size_t(1024), buffer.getNumAvailable(48));
+
+				buffer.advance(); // nothing written, stays in the same region
+				Assert::AreEqual(size_t(1024), buffer.getNumAvailable());
+			}
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			StreamBuffer buffer(1024, 3);
+
+			StreamAllocation a = buffer.allocate(100);
+			Assert::AreEqual(GLintptr(0), a.mOffset);
+			Assert::AreEqual(GLsizeiptr(100), a.mSize);
+			Assert::AreEqual(size_t(924), buffer.getNumAvailable());
+
+			// alignment doesn't have to be a power of two
+			StreamAllocation b = buffer.allocate(10, 48);
+			Assert::AreEqual(GLintptr(144), b.mOffset);
+			Assert::IsTrue(b.as<uint8_t>() == a.as<uint8_t>() + 144);
+			Assert::AreEqual(size_t(1024 - 154), buffer.getNumAvailable());
+
+			// doesn't fit in what is left, continues at the start of the next region
+			StreamAllocation c = buffer.allocate(900);
+			Assert::AreEqual(GLintptr(1024), c.mOffset);
+			Assert::AreEqual(size_t(124), buffer.getNumAvailable());
+
+			buffer.advance();
+
+			StreamAllocation d = buffer.allocate(1024);
+			Assert::AreEqual(GLintptr(2048), d.mOffset);
+			Assert::AreEqual(size_t(0), buffer.getNumAvailable());
+
+			std::memset(d.mMemory, 0xFF, d.mSize); // the whole region is writable
+
+			// wraps around to the first region (after the GPU is done with it)
+			StreamAllocation e = buffer.allocate(1);
+			Assert::AreEqual(GLintptr(0), e.mOffset);
+
+			// larger than a region
+			bool isThrown = false;
+
+			try {
+				buffer.allocate(1025);
+			}
+			catch (const std::runtime_error&) {
+				isThrown = true;
+			}
+
+			Assert::IsTrue(isThrown);
+
+			StreamAllocation range = buffer.allocate(64, StreamBuffer::getUniformAlignment());
+			Assert::AreEqual(GLintptr(0), range.mOffset % static_cast<GLintptr>(StreamBuffer::getUniformAlignment()));
+
+			buffer.bindRange(eBufferTarget::UNIFORM, 0, range);
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+		}
+
+		TEST_METHOD(TestProgramBinaryKey) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			ProgramBinaryCache cache("test_program_binaries.cache");
+
+			std::vector<ShaderSource> sources = {
+				{ eShaderType::VERTEX, gVertexSource },
+				{ eShaderType::FRAGMENT, gFragmentSource }
+			};
+
+			uint64_t key = cache.getKey(sources, { "A", "B" });
+			Assert::IsTrue(key == cache.getKey(sources, { "A", "B" }));
+
+			// defines, their order, the sources and the stages all matter
+			Assert::IsTrue(key != cache.getKey(sources));
+			Assert::IsTrue(key != cache.getKey(sources, { "B", "A" }));
+			Assert::IsTrue(key != cache.getKey(sources, { "A", "C" }));
+
+			auto modified = sources;
+			modified[1].mSource += "\n";
+			Assert::IsTrue(key != cache.getKey(modified, { "A", "B" }));
+
+			modified = sources;
+			modified[0].mType = eShaderType::GEOMETRY;
+			Assert::IsTrue(key != cache.getKey(modified, { "A", "B" }));
+
+			// strings are length prefixed, so moving text from one to the next changes the key
+			Assert::IsTrue(cache.getKey(sources, { "a", "bc" }) != cache.getKey(sources, { "ab", "c" }));
+		}
+
+		TEST_METHOD(TestProgramBinaryCache) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid() || !ProgramBinaryCache::isSupported())
+				return;
+
+			const char* path = "test_program_binaries.cache";
+			boost::filesystem::remove(path);
+
+			std::vector<ShaderSource> sources = {
+				{ eShaderType::VERTEX, gVertexSource },
+				{ eShaderType::FRAGMENT, gFragmentSource }
+			};
+
+			uint64_t driverHash = 0;
+
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(0), cache.getNumEntries());
+
+				driverHash = cache.getKey({}); // nothing else mixed in
+
+				ShaderProgram program;
+				cache.build(program, sources);
+
+				Assert::IsTrue(program.isLinked());
+				Assert::AreEqual(uint32_t(1), cache.getStats().mNumMisses);
+				Assert::AreEqual(size_t(1), cache.getNumEntries());
+
+				cache.save();
+			}
+
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(1), cache.getNumEntries());
+
+				ShaderProgram program;
+				cache.build(program, sources);
+
+				Assert::IsTrue(program.isLinked());
+				Assert::IsTrue(program.getUniformLocation("uTint") >= 0);
+				Assert::AreEqual(uint32_t(1), cache.getStats().mNumHits);
+				Assert::AreEqual(uint32_t(0), cache.getStats().mNumMisses);
+
+				// different defines, different program
+				ShaderProgram other;
+				cache.build(other, sources, { "UNUSED" });
+
+				Assert::AreEqual(uint32_t(1), cache.getStats().mNumMisses);
+				Assert::AreEqual(size_t(2), cache.getNumEntries());
+			}
+
+			// a file from some other program is discarded
+			writeFile(path, makeCacheHeader(0x12345678, driverHash, 0));
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(0), cache.getNumEntries());
+			}
+
+			// as is one written for a different driver
+			writeFile(path, makeCacheHeader(0x4250444F, driverHash + 1, 0));
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(0), cache.getNumEntries());
+			}
+
+			// the entry table runs past the end of the file
+			writeFile(path, makeCacheHeader(0x4250444F, driverHash, 1000));
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(0), cache.getNumEntries());
+			}
+
+			// only the entries that point outside of the file are dropped
+			{
+				auto file = makeCacheHeader(0x4250444F, driverHash, 3);
+
+				uint64_t dataOffset = file.size() + 3 * 24;
+
+				appendCacheEntry(file, 1, dataOffset, 4);
+				appendCacheEntry(file, 2, dataOffset, 100);
+				appendCacheEntry(file, 3, std::numeric_limits<uint64_t>::max() - 1, 8); // offset + size wraps around
+				append(file, uint32_t(0xDEADBEEF));
+
+				writeFile(path, file);
+			}
+			{
+				ProgramBinaryCache cache(path);
+				Assert::AreEqual(size_t(1), cache.getNumEntries());
+			}
+
+			boost::filesystem::remove(path);
+		}
+
+		TEST_METHOD(TestInjectDefines) {
+			using namespace overdrive::render;
+
+			const std::string source = "#version 450 core\nvoid main() {}\n";
+
+			Assert::AreEqual(source.c_str(), injectDefines(source, {}).c_str());
+
+			// right after the #version line
+			Assert::AreEqual(
+				"#version 450 core\n#define A\n#define B 2\nvoid main() {}\n",
+				injectDefines(source, { "A", "B 2" }).c_str()
+			);
+
+			// even if something comes before it
+			Assert::AreEqual(
+				"// shared\n#version 450\n#define A\nvoid main() {}",
+				injectDefines("// shared\n#version 450\nvoid main() {}", { "A" }).c_str()
+			);
+
+			// #version as the last line, without a line break
+			Assert::AreEqual(
+				"#version 450\n#define A\n",
+				injectDefines("#version 450", { "A" }).c_str()
+			);
+
+			// no #version at all
+			Assert::AreEqual(
+				"#define A\nvoid main() {}",
+				injectDefines("void main() {}", { "A" }).c_str()
+			);
+		}
+
+		TEST_METHOD(TestShaderCompiler) {
+			using namespace overdrive::render;
+
+			Assert::IsFalse(ProgramBuild().isValid());
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			std::vector<ShaderSource> sources = {
+				{ eShaderType::VERTEX, gVertexSource },
+				{ eShaderType::FRAGMENT, gFragmentSource }
+			};
+
+			std::vector<ShaderSource> broken = {
+				{ eShaderType::VERTEX, gVertexSource },
+				{ eShaderType::FRAGMENT, "#version 450 core\nvoid main() { undeclared = 1.0; }\n" }
+			};
+
+			const char* path = "test_shader_compiler.cache";
+			boost::filesystem::remove(path);
+
+			{
+				ShaderCompiler compiler;
+
+				ShaderProgram program;
+				ShaderProgram failing;
+				int numFinished = 0;
+
+				ProgramBuild build = compiler.submit(program, sources, {}, [&] { ++numFinished; });
+				ProgramBuild failed = compiler.submit(failing, broken, {}, [&] { ++numFinished; });
+
+				Assert::IsTrue(build.isValid());
+				Assert::IsTrue(build.getProgram() == &program);
+
+				compiler.finishAll();
+
+				Assert::IsTrue(compiler.isIdle());
+				Assert::AreEqual(2, numFinished);
+
+				Assert::IsTrue(build.isReady());
+				Assert::IsTrue(build.getError().empty());
+				Assert::IsTrue(program.isLinked());
+				Assert::IsTrue(program.getUniformLocation("uScale") >= 0);
+
+				Assert::IsTrue(failed.isFailed());
+				Assert::IsFalse(failed.getError().empty());
+			}
+
+			if (!ProgramBinaryCache::isSupported())
+				return;
+
+			{
+				ProgramBinaryCache cache(path);
+				ShaderCompiler compiler(&cache);
+
+				ShaderProgram first;
+				ProgramBuild build = compiler.submit(first, sources, { "CACHED" });
+				compiler.finishAll();
+
+				Assert::IsTrue(build.isReady());
+				Assert::AreEqual(size_t(1), cache.getNumEntries());
+
+				// now it's restored from the cache, and finished before submit returns
+				ShaderProgram second;
+				int numFinished = 0;
+
+				build = compiler.submit(second, sources, { "CACHED" }, [&] { ++numFinished; });
+
+				Assert::IsTrue(build.isReady());
+				Assert::AreEqual(1, numFinished);
+				Assert::AreEqual(uint32_t(1), cache.getStats().mNumHits);
+				Assert::IsTrue(compiler.isIdle());
+			}
+
+			boost::filesystem::remove(path);
+		}
+
+		TEST_METHOD(TestTextureStreamerBudget) {
+			using namespace overdrive::render;
+
+			TestContext context;
+			if (!context.isValid())
+				return;
+
+			// the level data is 184 bytes, which takes up 192 bytes of staging memory
+			const char* files[] = { "test_stream_0.dds", "test_stream_1.dds", "test_stream_2.dds" };
+
+			for (auto file : files)
+				writeFile(file, makeDDS(5));
+
+			overdrive::core::JobSystem jobSystem(1); // only this thread, jobs run when asked to
+
+			// two fit in the staging region, the third one has to wait for the next update
+			{
+				TextureStreamer streamer(jobSystem, 512);
+
+				std::vector<StreamedTexture> textures;
+
+				for (auto file : files)
+					textures.push_back(streamer.load2D(file));
+
+				auto shared = streamer.load2D(files[0]);
+				Assert::AreEqual(textures[0].getHandle(), shared.getHandle());
+
+				Assert::AreEqual(size_t(3), streamer.getStats().mNumRequested);
+				Assert::AreEqual(size_t(1), streamer.getStats().mNumShared);
+				Assert::AreEqual(size_t(3), streamer.getNumPending());
+
+				streamer.update(); // nothing decoded yet
+				Assert::AreEqual(size_t(0), streamer.getStats().mNumBytesLastUpdate);
+
+				while (jobSystem.tryRunJob());
+
+				streamer.update();
+				Assert::AreEqual(size_t(2 * 192), streamer.getStats().mNumBytesLastUpdate);
+				Assert::AreEqual(size_t(1), streamer.getNumPending());
+				Assert::AreEqual(size_t(2), streamer.getStats().mNumCompleted);
+
+				// jobs don't necessarily finish in the order they were requested
+				auto numReady = std::count_if(textures.begin(), textures.end(), [](const StreamedTexture& tex) { return tex.isReady(); });
+				Assert::AreEqual(2, static_cast<int>(numReady));
+
+				streamer.update();
+				Assert::AreEqual(size_t(192), streamer.getStats().mNumBytesLastUpdate);
+				Assert::AreEqual(size_t(3 * 192), streamer.getStats().mNumBytesUploaded);
+				Assert::AreEqual(size_t(3), streamer.getStats().mNumCompleted);
+				Assert::AreEqual(size_t(0), streamer.getNumPending());
+				Assert::IsTrue(textures[0].isReady() && textures[1].isReady() && textures[2].isReady());
+
+				streamer.update();
+				Assert::AreEqual(size_t(0), streamer.getStats().mNumBytesLastUpdate);
+			}
+
+			// larger than the budget: uploaded from client memory, one per update
+			{
+				TextureStreamer streamer(jobSystem, 128);
+
+				auto first = streamer.load2D(files[0]);
+				auto second = streamer.load2D(files[1]);
+
+				while (jobSystem.tryRunJob());
+
+				streamer.update();
+				Assert::AreEqual(size_t(192), streamer.getStats().mNumBytesLastUpdate);
+				Assert::IsTrue(first.isReady() != second.isReady());
+				Assert::AreEqual(size_t(1), streamer.getNumPending());
+
+				streamer.update();
+				Assert::AreEqual(size_t(192), streamer.getStats().mNumBytesLastUpdate);
+				Assert::IsTrue(first.isReady() && second.isReady());
+			}
+
+			// failures don't count towards the budget, and aren't shared
+			{
+				TextureStreamer streamer(jobSystem, 512);
+
+				auto missing = streamer.load2D("test_stream_missing.dds");
+				streamer.finishAll();
+
+				Assert::IsTrue(missing.isFailed());
+				Assert::AreEqual(size_t(1), streamer.getStats().mNumFailed);
+				Assert::AreEqual(size_t(0), streamer.getStats().mNumBytesUploaded);
+
+				auto retry = streamer.load2D("test_stream_missing.dds");
+				Assert::AreEqual(size_t(2), streamer.getStats().mNumRequested);
+				Assert::AreEqual(size_t(0), streamer.getStats().mNumShared);
+
+				streamer.finishAll();
+				Assert::IsTrue(retry.isFailed());
+			}
+
+			Assert::AreEqual(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+			for (auto file : files)
+				boost::filesystem::remove(file);
+		}
+	};
+}
@@ -0,0 +1,586 @@
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+#include "../Overdrive/math/frustum_culling.h"
+#include "../Overdrive/scene/command_buffer.h"
+#include "../Overdrive/scene/registry.h"
+#include "../Overdrive/scene/transform_hierarchy.h"
+#include "../Overdrive/scene/view.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace OverdriveTest {
+	namespace {
+		struct Position {
+			float x;
+			float y;
+		};
+
+		struct Velocity {
+			float dx;
+			float dy;
+		};
+
+		// counts live instances, to check that components are destroyed exactly once when entities move or die
+		struct Tracked {
+			static int sNumAlive;
+
+			int mValue;
+
+			explicit Tracked(int value): mValue(value) { ++sNumAlive; }
+			Tracked(Tracked&& t): mValue(t.mValue) { ++sNumAlive; }
+			Tracked& operator = (Tracked&& t) { mValue = t.mValue; return *this; }
+			~Tracked() { --sNumAlive; }
+		};
+
+		int Tracked::sNumAlive = 0;
+
+		void checkPlane(const overdrive::math::Plane& plane, const glm::vec3& normal, float distance) {
+			const float tolerance = 1e-4f;
+
+			Assert::AreEqual(normal.x, plane.getNormal().x, tolerance);
+			Assert::AreEqual(normal.y, plane.getNormal().y, tolerance);
+			Assert::AreEqual(normal.z, plane.getNormal().z, tolerance);
+			Assert::AreEqual(distance, plane.getDistance(), tolerance * std::max(1.0f, std::abs(distance)));
+		}
+
+		// a component whose constructor can fail
+		struct Fragile {
+			explicit Fragile(bool isBroken) {
+				if (isBroken)
+					throw std::runtime_error("Fragile component failed to construct");
+			}
+		};
+	}
+
+	TEST_CLASS(TestScene) {
+	public:
+		TEST_METHOD(TestRegistryArchetypes) {
+			using namespace overdrive::scene;
+
+			Registry registry;
+
+			auto a = registry.create();
+			auto b = registry.create();
+			auto c = registry.create();
+
+			registry.add<Position>(a, Position{ 1.0f, 2.0f });
+			registry.add<Position>(b, Position{ 3.0f, 4.0f });
+			registry.add<Position>(c, Position{ 5.0f, 6.0f });
+
+			// adding moves the entity to another archetype, the components it already had move along
+			registry.add<Velocity>(b, Velocity{ 7.0f, 8.0f });
+
+			Assert::IsTrue(registry.has<Position>(b));
+			Assert::IsTrue(registry.has<Velocity>(b));
+			Assert::IsFalse(registry.has<Velocity>(a));
+			Assert::AreEqual(3.0f, registry.get<Position>(b)->x);
+			Assert::AreEqual(4.0f, registry.get<Position>(b)->y);
+			Assert::AreEqual(7.0f, registry.get<Velocity>(b)->dx);
+
+			// b left a hole in the { Position } table, the entity that filled it must still be found
+			Assert::AreEqual(1.0f, registry.get<Position>(a)->x);
+			Assert::AreEqual(5.0f, registry.get<Position>(c)->x);
+
+			// { }, { Position } and { Position, Velocity }
+			Assert::AreEqual(size_t(3), registry.getNumArchetypes());
+
+			// adding a component that is already there replaces it in place
+			registry.add<Position>(b, Position{ 9.0f, 10.0f });
+
+			Assert::AreEqual(9.0f, registry.get<Position>(b)->x);
+			Assert::AreEqual(7.0f, registry.get<Velocity>(b)->dx);
+			Assert::AreEqual(size_t(3), registry.getNumArchetypes());
+
+			// removing moves it back
+			registry.remove<Velocity>(b);
+
+			Assert::IsFalse(registry.has<Velocity>(b));
+			Assert::IsTrue(registry.get<Velocity>(b) == nullptr);
+			Assert::AreEqual(9.0f, registry.get<Position>(b)->x);
+			Assert::AreEqual(10.0f, registry.get<Position>(b)->y);
+			Assert::AreEqual(size_t(3), registry.getNumArchetypes());
+
+			// removing a component that isn't there does nothing
+			registry.remove<Velocity>(a);
+
+			Assert::AreEqual(1.0f, registry.get<Position>(a)->x);
+
+			// moves construct the component in the new table and destroy the old one
+			registry.add<Tracked>(a, 42);
+			registry.add<Velocity>(a, Velocity{ 0.0f, 0.0f });
+			registry.remove<Position>(a);
+
+			Assert::AreEqual(1, Tracked::sNumAlive);
+			Assert::AreEqual(42, registry.get<Tracked>(a)->mValue);
+
+			registry.add<Tracked>(a, 43);
+
+			Assert::AreEqual(1, Tracked::sNumAlive);
+			Assert::AreEqual(43, registry.get<Tracked>(a)->mValue);
+
+			registry.remove<Tracked>(a);
+
+			Assert::AreEqual(0, Tracked::sNumAlive);
+		}
+
+		TEST_METHOD(TestRegistryDestroy) {
+			using namespace overdrive::scene;
+
+			Registry registry;
+			std::vector<EntityHandle> entities;
+
+			for (int i = 0; i < 10; ++i) {
+				entities.push_back(registry.create());
+				registry.add<Tracked>(entities.back(), i);
+			}
+
+			Assert::AreEqual(size_t(10), registry.getNumEntities());
+			Assert::AreEqual(10, Tracked::sNumAlive);
+
+			// destroying swaps the last row into the hole
+			registry.destroy(entities[3]);
+			registry.destroy(entities[0]);
+
+			Assert::AreEqual(size_t(8), registry.getNumEntities());
+			Assert::AreEqual(8, Tracked::sNumAlive);
+			Assert::IsFalse(registry.isValid(entities[3]));
+			Assert::IsFalse(registry.has<Tracked>(entities[3]));
+			Assert::IsTrue(registry.get<Tracked>(entities[3]) == nullptr);
+
+			for (int i = 0; i < 10; ++i)
+				if ((i != 0) && (i != 3))
+					Assert::AreEqual(i, registry.get<Tracked>(entities[i])->mValue);
+
+			// stale handles stay stale when the slot is re-used
+			auto reused = registry.create();
+
+			Assert::IsFalse(registry.isValid(entities[0]));
+			Assert::IsFalse(registry.isValid(entities[3]));
+			Assert::IsTrue(registry.isValid(reused));
+			Assert::IsFalse(registry.has<Tracked>(reused));
+
+			bool threw = false;
+
+			try {
+				registry.destroy(entities[3]);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+
+			Assert::IsTrue(threw);
+
+			for (int i = 0; i < 10; ++i)
+				if ((i != 0) && (i != 3))
+					registry.destroy(entities[i]);
+
+			registry.destroy(reused);
+
+			Assert::AreEqual(size_t(0), registry.getNumEntities());
+			Assert::AreEqual(0, Tracked::sNumAlive);
+		}
+
+		TEST_METHOD(TestRegistryReserved) {
+			using namespace overdrive::scene;
+
+			Registry registry;
+			CommandBuffer buffer(&registry);
+
+			// reserved through the buffer but not placed yet
+			auto entity = buffer.create();
+			buffer.add<Tracked>(entity, 1);
+
+			Assert::IsTrue(registry.isValid(entity));
+
+			registry.destroy(entity);
+
+			Assert::IsFalse(registry.isValid(entity));
+
+			// the commands for the destroyed entity are skipped
+			buffer.playback();
+
+			Assert::AreEqual(size_t(0), registry.getNumEntities());
+			Assert::AreEqual(0, Tracked::sNumAlive);
+		}
+
+		TEST_METHOD(TestRegistryAddThrows) {
+			using namespace overdrive::scene;
+
+			Registry registry;
+
+			auto tracked = registry.create();
+			registry.add<Tracked>(tracked, 7);
+
+			auto empty = registry.create();
+
+			for (auto entity : { tracked, empty }) {
+				bool isThrown = false;
+
+				try {
+					registry.add<Fragile>(entity, true);
+				}
+				catch (const std::runtime_error&) {
+					isThrown = true;
+				}
+
+				Assert::IsTrue(isThrown);
+				Assert::IsTrue(registry.isValid(entity));
+				Assert::IsFalse(registry.has<Fragile>(entity));
+			}
+
+			// the entity is back where it was, with its other components intact
+			Assert::AreEqual(1, Tracked::sNumAlive);
+			Assert::AreEqual(7, registry.get<Tracked>(tracked)->mValue);
+			Assert::AreEqual(size_t(0), registry.view<const Fragile>().getNumEntities());
+			Assert::AreEqual(size_t(1), registry.view<const Tracked>().getNumEntities());
+
+			registry.add<Fragile>(tracked, false);
+			Assert::IsTrue(registry.has<Fragile>(tracked));
+			Assert::AreEqual(7, registry.get<Tracked>(tracked)->mValue);
+
+			registry.destroy(tracked);
+			registry.destroy(empty);
+
+			Assert::AreEqual(0, Tracked::sNumAlive);
+		}
+
+		TEST_METHOD(TestRegistryView) {
+			using namespace overdrive::scene;
+
+			Registry registry;
+
+			// enough entities to need several chunks
+			const int numEntities = 5000;
+
+			std::vector<EntityHandle> entities;
+
+			for (int i = 0; i < numEntities; ++i) {
+				entities.push_back(registry.create());
+				registry.add<Position>(entities.back(), Position{ static_cast<float>(i), 0.0f });
+
+				if (i % 2 == 0)
+					registry.add<Velocity>(entities.back(), Velocity{ 1.0f, 2.0f });
+			}
+
+			auto moving = registry.view<Position, const Velocity>();
+
+			Assert::AreEqual(size_t(numEntities / 2), moving.getNumEntities());
+			Assert::AreEqual(size_t(numEntities), registry.view<const Position>().getNumEntities());
+
+			size_t numVisited = 0;
+
+			moving.forEach([&](Position& p, const Velocity& v) {
+				p.x += v.dx;
+				p.y += v.dy;
+				++numVisited;
+			});
+
+			Assert::AreEqual(size_t(numEntities / 2), numVisited);
+
+			for (int i = 0; i < numEntities; ++i) {
+				const Position* p = registry.get<Position>(entities[i]);
+
+				Assert::AreEqual(static_cast<float>(i + ((i % 2 == 0) ? 1 : 0)), p->x);
+				Assert::AreEqual((i % 2 == 0) ? 2.0f : 0.0f, p->y);
+			}
+
+			// the handles match the components
+			registry.view<const Position>().forEachWithEntity([&](EntityHandle entity, const Position& p) {
+				Assert::IsTrue(registry.get<Position>(entity) == &p);
+			});
+
+			// chunks cover every entity exactly once
+			size_t numRows = 0;
+
+			moving.forEachChunk([&](size_t count, const EntityHandle* handles, Position* positions, const Velocity*) {
+				for (size_t i = 0; i < count; ++i)
+					Assert::IsTrue(registry.get<Position>(handles[i]) == positions + i);
+
+				numRows += count;
+			});
+
+			Assert::AreEqual(size_t(numEntities / 2), numRows);
+			Assert::IsTrue(moving.getArchetypes().size() == 1);
+		}
+
+		TEST_METHOD(TestFrustumPlanes) {
+			using namespace overdrive::math;
+
+			// the default frustum is the [-1, 1] cube
+			Frustum cube;
+
+			checkPlane(cube.getPlane(eCubePlane::FRONT),	glm::vec3(0, 0, 1), 1.0f);
+			checkPlane(cube.getPlane(eCubePlane::BACK),		glm::vec3(0, 0, -1), 1.0f);
+			checkPlane(cube.getPlane(eCubePlane::TOP),		glm::vec3(0, -1, 0), 1.0f);
+			checkPlane(cube.getPlane(eCubePlane::BOTTOM),	glm::vec3(0, 1, 0), 1.0f);
+			checkPlane(cube.getPlane(eCubePlane::LEFT),		glm::vec3(1, 0, 0), 1.0f);
+			checkPlane(cube.getPlane(eCubePlane::RIGHT),	glm::vec3(-1, 0, 0), 1.0f);
+
+			// 90 degree perspective, looking down -z from (10, 0, 0); normals point inwards
+			glm::mat4 projection = glm::perspective(glm::half_pi<float>(), 1.0f, 1.0f, 100.0f);
+			glm::mat4 view = glm::lookAt(glm::vec3(10, 0, 0), glm::vec3(10, 0, -1), glm::vec3(0, 1, 0));
+
+			Frustum frustum(projection * view);
+			const float s = std::sqrt(0.5f);
+
+			checkPlane(frustum.getPlane(eCubePlane::FRONT),		glm::vec3(0, 0, -1), -1.0f);
+			checkPlane(frustum.getPlane(eCubePlane::BACK),		glm::vec3(0, 0, 1), 100.0f);
+			checkPlane(frustum.getPlane(eCubePlane::TOP),		glm::vec3(0, -s, -s), 0.0f);
+			checkPlane(frustum.getPlane(eCubePlane::BOTTOM),	glm::vec3(0, s, -s), 0.0f);
+			checkPlane(frustum.getPlane(eCubePlane::LEFT),		glm::vec3(s, 0, -s), -10.0f * s);
+			checkPlane(frustum.getPlane(eCubePlane::RIGHT),		glm::vec3(-s, 0, -s), 10.0f * s);
+
+			Assert::IsTrue(frustum.classifySphere(glm::vec3(10, 0, -50), 1.0f) == eVolumetricIntersection::INSIDE);
+			Assert::IsTrue(frustum.classifySphere(glm::vec3(10, 0, -1), 0.5f) == eVolumetricIntersection::OVERLAPPING);
+			Assert::IsTrue(frustum.classifySphere(glm::vec3(10, 0, 1), 0.5f) == eVolumetricIntersection::OUTSIDE);
+			Assert::IsTrue(frustum.classifySphere(glm::vec3(0, 0, -5), 1.0f) == eVolumetricIntersection::OUTSIDE);
+			Assert::IsTrue(frustum.classifyBox(glm::vec3(10, 0, -101), glm::vec3(2.0f)) == eVolumetricIntersection::OVERLAPPING);
+			Assert::IsTrue(frustum.classifyBox(glm::vec3(10, 0, -110), glm::vec3(2.0f)) == eVolumetricIntersection::OUTSIDE);
+		}
+
+		TEST_METHOD(TestFrustumCulling) {
+			using namespace overdrive::math;
+
+			glm::mat4 projection = glm::perspective(1.0f, 1.5f, 0.5f, 50.0f);
+			glm::mat4 view = glm::lookAt(glm::vec3(3, 2, 1), glm::vec3(0, 0, -10), glm::vec3(0, 1, 0));
+
+			Frustum frustum(projection * view);
+
+			// not a multiple of the SIMD width, so the scalar tail is covered as well
+			const size_t count = 1003;
+
+			std::mt19937 rng(7);
+			std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+			std::uniform_real_distribution<float> size(0.1f, 10.0f);
+
+			std::vector<float> x(count), y(count), z(count), ex(count), ey(count), ez(count);
+
+			for (size_t i = 0; i < count; ++i) {
+				x[i] = position(rng);
+				y[i] = position(rng);
+				z[i] = position(rng);
+				ex[i] = size(rng);
+				ey[i] = size(rng);
+				ez[i] = size(rng);
+			}
+
+			std::vector<uint32_t> visible(getMaskSize(count));
+			std::vector<uint32_t> inside(getMaskSize(count));
+
+			// the batched results agree with classifying one volume at a time
+			size_t numVisible = cullSpheres(
+				frustum,
+				SphereBatch{ x.data(), y.data(), z.data(), ex.data(), count },
+				visible.data(),
+				inside.data()
+			);
+
+			size_t numExpected = 0;
+			size_t numInside = 0;
+
+			for (size_t i = 0; i < count; ++i) {
+				auto expected = frustum.classifySphere(glm::vec3(x[i], y[i], z[i]), ex[i]);
+
+				Assert::IsTrue(getIntersection(visible.data(), inside.data(), i) == expected);
+
+				if (expected != eVolumetricIntersection::OUTSIDE)
+					++numExpected;
+
+				if (expected == eVolumetricIntersection::INSIDE)
+					++numInside;
+			}
+
+			Assert::AreEqual(numExpected, numVisible);
+			Assert::IsTrue((numVisible > 0) && (numVisible < count) && (numInside > 0)); // the data covers all cases
+
+			numVisible = cullBoxes(
+				frustum,
+				BoxBatch{ x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), count },
+				visible.data(),
+				inside.data()
+			);
+
+			numExpected = 0;
+
+			for (size_t i = 0; i < count; ++i) {
+				auto expected = frustum.classifyBox(glm::vec3(x[i], y[i], z[i]), glm::vec3(ex[i], ey[i], ez[i]));
+
+				Assert::IsTrue(getIntersection(visible.data(), inside.data(), i) == expected);
+
+				if (expected != eVolumetricIntersection::OUTSIDE)
+					++numExpected;
+			}
+
+			Assert::AreEqual(numExpected, numVisible);
+
+			// without an inside mask, visible volumes are overlapping
+			cullBoxes(
+				frustum,
+				BoxBatch{ x.data(), y.data(), z.data(), ex.data(), ey.data(), ez.data(), count },
+				visible.data()
+			);
+
+			for (size_t i = 0; i < count; ++i) {
+				auto expected = frustum.classifyBox(glm::vec3(x[i], y[i], z[i]), glm::vec3(ex[i], ey[i], ez[i]));
+				auto result = getIntersection(visible.data(), nullptr, i);
+
+				if (expected == eVolumetricIntersection::OUTSIDE)
+					Assert::IsTrue(result == eVolumetricIntersection::OUTSIDE);
+				else
+					Assert::IsTrue(result == eVolumetricIntersection::OVERLAPPING);
+			}
+		}
+
+		TEST_METHOD(TestRegistryParallelForEach) {
+			using namespace overdrive::scene;
+
+			overdrive::core::JobSystem jobSystem(4);
+			Registry registry;
+
+			// several archetypes, each spanning several chunks
+			const int numEntities = 20000;
+
+			for (int i = 0; i < numEntities; ++i) {
+				auto entity = registry.create();
+				registry.add<Tracked>(entity, 0);
+
+				if (i % 3 == 0)
+					registry.add<Position>(entity, Position{ 0.0f, 0.0f });
+
+				if (i % 5 == 0)
+					registry.add<Velocity>(entity, Velocity{ 0.0f, 0.0f });
+			}
+
+			auto all = registry.view<Tracked>();
+			Assert::IsTrue(all.getArchetypes().size() == 4);
+
+			for (size_t minBatchSize : { size_t(1), size_t(100), Registry::DEFAULT_MIN_BATCH_SIZE, size_t(numEntities) }) {
+				auto jobs = registry.parallelForEach(jobSystem, all, [](Tracked& t) {
+					++t.mValue; // every entity is visited by exactly one job
+				}, minBatchSize);
+
+				jobSystem.wait(jobs);
+			}
+
+			// a conflicting query waits for the first one to finish
+			std::atomic<int> numStale(0);
+
+			auto first = registry.parallelForEach(jobSystem, all, [](Tracked& t) { ++t.mValue; });
+			auto second = registry.parallelForEach(jobSystem, registry.view<const Tracked>(), [&](const Tracked& t) {
+				if (t.mValue != 5)
+					++numStale;
+			});
+
+			jobSystem.wait(first);
+			jobSystem.wait(second);
+
+			Assert::AreEqual(0, numStale.load());
+
+			size_t numVisited = 0;
+
+			all.forEach([&](Tracked& t) {
+				Assert::AreEqual(5, t.mValue);
+				++numVisited;
+			});
+
+			Assert::AreEqual(size_t(numEntities), numVisited);
+		}
+
+		TEST_METHOD(TestTransformHierarchy) {
+			using overdrive::scene::TransformHierarchy;
+
+			TransformHierarchy hierarchy;
+
+			auto root = hierarchy.create();
+			auto child = hierarchy.create(root);
+			auto grandChild = hierarchy.create(child);
+
+			hierarchy.setPosition(root, glm::vec3(1.0f, 0.0f, 0.0f));
+			hierarchy.setPosition(child, glm::vec3(0.0f, 1.0f, 0.0f));
+			hierarchy.setPosition(grandChild, glm::vec3(0.0f, 0.0f, 1.0f));
+			hierarchy.update();
+
+			Assert::AreEqual(3u, static_cast<unsigned int>(hierarchy.getNumUpdated()));
+			Assert::AreEqual(1.0f, hierarchy.getWorldTransform(grandChild)[3].x);
+			Assert::AreEqual(1.0f, hierarchy.getWorldTransform(grandChild)[3].y);
+			Assert::AreEqual(1.0f, hierarchy.getWorldTransform(grandChild)[3].z);
+
+			// moving the root updates the whole subtree, moving a leaf only the leaf
+			hierarchy.setPosition(root, glm::vec3(2.0f, 0.0f, 0.0f));
+			hierarchy.update();
+
+			Assert::AreEqual(3u, static_cast<unsigned int>(hierarchy.getNumUpdated()));
+			Assert::AreEqual(2.0f, hierarchy.getWorldTransform(grandChild)[3].x);
+
+			hierarchy.setPosition(grandChild, glm::vec3(0.0f, 0.0f, 2.0f));
+			hierarchy.update();
+
+			Assert::AreEqual(1u, static_cast<unsigned int>(hierarchy.getNumUpdated()));
+			Assert::AreEqual(2.0f, hierarchy.getWorldTransform(grandChild)[3].z);
+
+			hierarchy.destroy(child);
+
+			Assert::IsFalse(hierarchy.isValid(grandChild));
+			Assert::AreEqual(1u, static_cast<unsigned int>(hierarchy.getNumNodes()));
+		}
+
+		// update time for a random forest of 100k nodes, with 1% and 100% of the nodes modified per frame
+		TEST_METHOD(BenchmarkTransformHierarchy) {
+			using overdrive::scene::TransformHierarchy;
+			using Clock = std::chrono::high_resolution_clock;
+
+			const size_t numNodes = 100000;
+			const size_t numRoots = 100;
+			const int numFrames = 20;
+
+			std::mt19937 rng(1234);
+			TransformHierarchy hierarchy;
+			std::vector<TransformHierarchy::NodeID> nodes;
+
+			for (size_t i = 0; i < numNodes; ++i) {
+				auto parent = (i < numRoots) ? TransformHierarchy::NONE : nodes[rng() % nodes.size()];
+				nodes.push_back(hierarchy.create(parent));
+			}
+
+			hierarchy.update();
+
+			for (double ratio : { 0.01, 1.0 }) {
+				size_t numModified = static_cast<size_t>(numNodes * ratio);
+				double best = 1e9;
+				size_t numUpdated = 0;
+
+				for (int frame = 0; frame < numFrames; ++frame) {
+					for (size_t i = 0; i < numModified; ++i) {
+						auto node = (numModified == numNodes) ? nodes[i] : nodes[rng() % numNodes];
+						hierarchy.setPosition(node, glm::vec3(static_cast<float>(frame), 0.0f, 0.0f));
+					}
+
+					auto start = Clock::now();
+					hierarchy.update();
+					auto elapsed = Clock::now() - start;
+
+					best = std::min(best, std::chrono::duration<double, std::milli>(elapsed).count());
+					numUpdated = hierarchy.getNumUpdated();
+				}
+
+				std::stringstream sstr;
+				sstr
+					<< numNodes << " nodes, " << ratio * 100.0 << "% modified: "
+					<< best << " ms per update ("
+					<< numUpdated << " world transforms recomputed)\n";
+
+				Logger::WriteMessage(sstr.str().c_str());
+			}
+		}
+	};
+}
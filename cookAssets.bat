@@ -0,0 +1,7 @@
+@rem %1 ~> platform target (x64, win32)
+@rem %2 ~> configuration (debug, release)
+@rem %3 ~> project root
+@rem %4 ~> target dir
+
+@rem packs the assets and shaders into a single file (the loose copies remain as a fallback)
+@%4\Cooker.exe %4\assets.pack %3assets=assets %3Overdrive\Shaders=Shaders
\ No newline at end of file